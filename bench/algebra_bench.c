@@ -0,0 +1,1296 @@
+/*
+================================================================================================
+
+Description	:	Micro benchmark and accuracy harness for utils/algebra.h.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+Every ks* function in utils/algebra.h is timed over batches of independent inputs of
+increasing size, so that both the latency bound (small batches that live in L1) and the
+bandwidth bound (large batches that stream from memory) behaviour is visible.
+
+For every function and batch size the report contains the best time per operation,
+the throughput and, when hardware counters are available, the cycles per operation
+and instructions per cycle.
+
+The accuracy harness compares every float result against a double precision reference
+implementation. Errors are measured in ULPs of the largest magnitude component of the
+reference result, so that cancellation in components near zero does not dominate the
+figures. Functions that return booleans report the number of mismatches instead.
+
+USAGE
+=====
+
+algebra_bench [--quick] [--filter <substring>] [--out <file.json>]
+
+================================================================================================
+*/
+
+#include <float.h>
+#include "benchutil.h"
+#include "utils/algebra.h"
+
+#define MAX_BATCH_SIZE		65536
+#define ACCURACY_SAMPLES	MAX_BATCH_SIZE
+#define TIMING_TRIALS		5
+
+static const int batchSizes[] = { 16, 256, 4096, MAX_BATCH_SIZE };
+
+typedef struct
+{
+	float *			fa;
+	float *			fr;
+	bool *			br;
+	ksVector3f *	va;
+	ksVector3f *	vb;
+	ksVector3f *	vr;
+	ksVector3f *	vr2;
+	ksVector4f *	v4a;
+	ksVector4f *	v4r;
+	ksQuatf *		qa;
+	ksQuatf *		qb;
+	ksQuatf *		qr;
+	ksVector3f *	scale;			// uniform scale used to build 'ma'
+	ksMatrix4x4f *	ma;				// translation(rotation(scale)) with rotation 'qa'
+	ksMatrix4x4f *	mb;				// translation(rotation) with rotation 'qb'
+	ksMatrix4x4f *	mvp;			// projection * view * model
+	ksMatrix4x4f *	mr;
+	ksMatrix3x3f *	m3x3r;
+	ksMatrix3x4f *	m3x4r;
+	ksPosef *		pa;				// poses with orientation 'qa' and position 'va'
+	ksPosef *		pr;
+	ksVector3f *	wa;				// angular velocities in radians per second
+	ksQuatf *		qu;				// 'qa' with a random non-unit length
+	ksQuatf32 *		q32;			// 'qa' packed
+	ksQuatf48 *		q48;			// 'qa' packed
+	ksQuatf32 *		q32r;
+	ksQuatf48 *		q48r;
+} ksAlgebraBenchData;
+
+/*
+================================================================================================================================
+
+Input generation
+
+================================================================================================================================
+*/
+
+static unsigned int randomSeed = 0x12345678;
+
+static float RandomFloat( const float min, const float max )
+{
+	randomSeed = randomSeed * 1664525u + 1013904223u;
+	return min + ( max - min ) * ( (float)( randomSeed >> 8 ) * ( 1.0f / 16777216.0f ) );
+}
+
+static void RandomQuaternion( ksQuatf * q )
+{
+	q->x = RandomFloat( -1.0f, 1.0f );
+	q->y = RandomFloat( -1.0f, 1.0f );
+	q->z = RandomFloat( -1.0f, 1.0f );
+	q->w = RandomFloat( -1.0f, 1.0f );
+	const double length = sqrt( (double)q->x * q->x + (double)q->y * q->y + (double)q->z * q->z + (double)q->w * q->w );
+	q->x = (float)( q->x / length );
+	q->y = (float)( q->y / length );
+	q->z = (float)( q->z / length );
+	q->w = (float)( q->w / length );
+}
+
+static void * AllocArray( const size_t elementSize )
+{
+	void * ptr = calloc( MAX_BATCH_SIZE, elementSize );
+	if ( ptr == NULL )
+	{
+		fprintf( stderr, "Out of memory\n" );
+		exit( EXIT_FAILURE );
+	}
+	return ptr;
+}
+
+static void ksAlgebraBenchData_Create( ksAlgebraBenchData * d )
+{
+	d->fa = AllocArray( sizeof( float ) );
+	d->fr = AllocArray( sizeof( float ) );
+	d->br = AllocArray( sizeof( bool ) );
+	d->va = AllocArray( sizeof( ksVector3f ) );
+	d->vb = AllocArray( sizeof( ksVector3f ) );
+	d->vr = AllocArray( sizeof( ksVector3f ) );
+	d->vr2 = AllocArray( sizeof( ksVector3f ) );
+	d->v4a = AllocArray( sizeof( ksVector4f ) );
+	d->v4r = AllocArray( sizeof( ksVector4f ) );
+	d->qa = AllocArray( sizeof( ksQuatf ) );
+	d->qb = AllocArray( sizeof( ksQuatf ) );
+	d->qr = AllocArray( sizeof( ksQuatf ) );
+	d->scale = AllocArray( sizeof( ksVector3f ) );
+	d->ma = AllocArray( sizeof( ksMatrix4x4f ) );
+	d->mb = AllocArray( sizeof( ksMatrix4x4f ) );
+	d->mvp = AllocArray( sizeof( ksMatrix4x4f ) );
+	d->mr = AllocArray( sizeof( ksMatrix4x4f ) );
+	d->m3x3r = AllocArray( sizeof( ksMatrix3x3f ) );
+	d->m3x4r = AllocArray( sizeof( ksMatrix3x4f ) );
+	d->pa = AllocArray( sizeof( ksPosef ) );
+	d->pr = AllocArray( sizeof( ksPosef ) );
+	d->wa = AllocArray( sizeof( ksVector3f ) );
+	d->qu = AllocArray( sizeof( ksQuatf ) );
+	d->q32 = AllocArray( sizeof( ksQuatf32 ) );
+	d->q48 = AllocArray( sizeof( ksQuatf48 ) );
+	d->q32r = AllocArray( sizeof( ksQuatf32 ) );
+	d->q48r = AllocArray( sizeof( ksQuatf48 ) );
+
+	ksMatrix4x4f projection;
+	ksMatrix4x4f_CreateProjectionFov( &projection, 45.0f, 45.0f, 45.0f, 45.0f, 0.1f, 100.0f );
+	ksMatrix4x4f viewTranslation;
+	ksMatrix4x4f_CreateTranslation( &viewTranslation, 0.0f, 0.0f, -20.0f );
+	ksMatrix4x4f viewProjection;
+	ksMatrix4x4f_Multiply( &viewProjection, &projection, &viewTranslation );
+
+	for ( int i = 0; i < MAX_BATCH_SIZE; i++ )
+	{
+		d->fa[i] = RandomFloat( 1e-3f, 1e3f );
+		d->va[i].x = RandomFloat( -10.0f, 10.0f );
+		d->va[i].y = RandomFloat( -10.0f, 10.0f );
+		d->va[i].z = RandomFloat( -10.0f, 10.0f );
+		d->vb[i].x = RandomFloat( 0.01f, 5.0f );
+		d->vb[i].y = RandomFloat( 0.01f, 5.0f );
+		d->vb[i].z = RandomFloat( 0.01f, 5.0f );
+		d->v4a[i].x = d->va[i].x;
+		d->v4a[i].y = d->va[i].y;
+		d->v4a[i].z = d->va[i].z;
+		d->v4a[i].w = 1.0f;
+		RandomQuaternion( &d->qa[i] );
+		RandomQuaternion( &d->qb[i] );
+
+		// Uniform scale keeps the rows orthogonal, which GetRotation/GetScale assert on.
+		ksVector3f_Set( &d->scale[i], RandomFloat( 0.5f, 2.0f ) );
+		const ksVector3f unitScale = { 1.0f, 1.0f, 1.0f };
+		ksMatrix4x4f_CreateTranslationRotationScale( &d->ma[i], &d->va[i], &d->qa[i], &d->scale[i] );
+		ksMatrix4x4f_CreateTranslationRotationScale( &d->mb[i], &d->vb[i], &d->qb[i], &unitScale );
+		ksMatrix4x4f_Multiply( &d->mvp[i], &viewProjection, &d->ma[i] );
+
+		d->pa[i].orientation = d->qa[i];
+		d->pa[i].position = d->va[i];
+		d->wa[i].x = RandomFloat( -10.0f, 10.0f );
+		d->wa[i].y = RandomFloat( -10.0f, 10.0f );
+		d->wa[i].z = RandomFloat( -10.0f, 10.0f );
+
+		const float length = RandomFloat( 0.5f, 2.0f );
+		d->qu[i].x = d->qa[i].x * length;
+		d->qu[i].y = d->qa[i].y * length;
+		d->qu[i].z = d->qa[i].z * length;
+		d->qu[i].w = d->qa[i].w * length;
+	}
+
+	ksQuatf32_Pack( d->q32, d->qa, MAX_BATCH_SIZE );
+	ksQuatf48_Pack( d->q48, d->qa, MAX_BATCH_SIZE );
+}
+
+static void ksAlgebraBenchData_Destroy( ksAlgebraBenchData * d )
+{
+	free( d->fa ); free( d->fr ); free( d->br );
+	free( d->va ); free( d->vb ); free( d->vr ); free( d->vr2 );
+	free( d->v4a ); free( d->v4r );
+	free( d->qa ); free( d->qb ); free( d->qr );
+	free( d->scale );
+	free( d->ma ); free( d->mb ); free( d->mvp ); free( d->mr );
+	free( d->m3x3r ); free( d->m3x4r );
+	free( d->pa ); free( d->pr ); free( d->wa );
+	free( d->qu ); free( d->q32 ); free( d->q48 ); free( d->q32r ); free( d->q48r );
+}
+
+/*
+================================================================================================================================
+
+Double precision reference implementations
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	double m[4][4];
+} ksMatrix4x4d;
+
+static void Ref_FromMatrix4x4f( ksMatrix4x4d * result, const ksMatrix4x4f * src )
+{
+	for ( int c = 0; c < 4; c++ )
+	{
+		for ( int r = 0; r < 4; r++ )
+		{
+			result->m[c][r] = src->m[c][r];
+		}
+	}
+}
+
+static void Ref_Multiply( ksMatrix4x4d * result, const ksMatrix4x4d * a, const ksMatrix4x4d * b )
+{
+	for ( int c = 0; c < 4; c++ )
+	{
+		for ( int r = 0; r < 4; r++ )
+		{
+			result->m[c][r] = a->m[0][r] * b->m[c][0] + a->m[1][r] * b->m[c][1] + a->m[2][r] * b->m[c][2] + a->m[3][r] * b->m[c][3];
+		}
+	}
+}
+
+static double Ref_Minor( const ksMatrix4x4d * m, int r0, int r1, int r2, int c0, int c1, int c2 )
+{
+	return	m->m[r0][c0] * ( m->m[r1][c1] * m->m[r2][c2] - m->m[r2][c1] * m->m[r1][c2] ) -
+			m->m[r0][c1] * ( m->m[r1][c0] * m->m[r2][c2] - m->m[r2][c0] * m->m[r1][c2] ) +
+			m->m[r0][c2] * ( m->m[r1][c0] * m->m[r2][c1] - m->m[r2][c0] * m->m[r1][c1] );
+}
+
+static void Ref_Invert( ksMatrix4x4d * result, const ksMatrix4x4d * src )
+{
+	static const int others[4][3] = { { 1, 2, 3 }, { 0, 2, 3 }, { 0, 1, 3 }, { 0, 1, 2 } };
+	const double det =	src->m[0][0] * Ref_Minor( src, 1, 2, 3, 1, 2, 3 ) -
+						src->m[0][1] * Ref_Minor( src, 1, 2, 3, 0, 2, 3 ) +
+						src->m[0][2] * Ref_Minor( src, 1, 2, 3, 0, 1, 3 ) -
+						src->m[0][3] * Ref_Minor( src, 1, 2, 3, 0, 1, 2 );
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int j = 0; j < 4; j++ )
+		{
+			const double sign = ( ( i + j ) & 1 ) ? -1.0 : 1.0;
+			result->m[i][j] = sign * Ref_Minor( src, others[j][0], others[j][1], others[j][2], others[i][0], others[i][1], others[i][2] ) / det;
+		}
+	}
+}
+
+static void Ref_FromQuaternion( ksMatrix4x4d * result, const ksQuatf * q )
+{
+	const double x = q->x, y = q->y, z = q->z, w = q->w;
+	result->m[0][0] = 1.0 - 2.0 * ( y * y + z * z );
+	result->m[0][1] = 2.0 * ( x * y + w * z );
+	result->m[0][2] = 2.0 * ( x * z - w * y );
+	result->m[0][3] = 0.0;
+	result->m[1][0] = 2.0 * ( x * y - w * z );
+	result->m[1][1] = 1.0 - 2.0 * ( x * x + z * z );
+	result->m[1][2] = 2.0 * ( y * z + w * x );
+	result->m[1][3] = 0.0;
+	result->m[2][0] = 2.0 * ( x * z + w * y );
+	result->m[2][1] = 2.0 * ( y * z - w * x );
+	result->m[2][2] = 1.0 - 2.0 * ( x * x + y * y );
+	result->m[2][3] = 0.0;
+	result->m[3][0] = 0.0;
+	result->m[3][1] = 0.0;
+	result->m[3][2] = 0.0;
+	result->m[3][3] = 1.0;
+}
+
+static void Ref_TranslationRotationScale( ksMatrix4x4d * result, const ksVector3f * t, const ksQuatf * q, const ksVector3f * s )
+{
+	Ref_FromQuaternion( result, q );
+	for ( int r = 0; r < 3; r++ )
+	{
+		result->m[0][r] *= s->x;
+		result->m[1][r] *= s->y;
+		result->m[2][r] *= s->z;
+	}
+	result->m[3][0] = t->x;
+	result->m[3][1] = t->y;
+	result->m[3][2] = t->z;
+}
+
+static void Ref_Rotation( ksMatrix4x4d * result, const double degreesX, const double degreesY, const double degreesZ )
+{
+	const double toRadians = 3.14159265358979323846 / 180.0;
+	const double sx = sin( degreesX * toRadians ), cx = cos( degreesX * toRadians );
+	const double sy = sin( degreesY * toRadians ), cy = cos( degreesY * toRadians );
+	const double sz = sin( degreesZ * toRadians ), cz = cos( degreesZ * toRadians );
+	const ksMatrix4x4d rx = { { { 1, 0, 0, 0 }, { 0, cx, sx, 0 }, { 0, -sx, cx, 0 }, { 0, 0, 0, 1 } } };
+	const ksMatrix4x4d ry = { { { cy, 0, -sy, 0 }, { 0, 1, 0, 0 }, { sy, 0, cy, 0 }, { 0, 0, 0, 1 } } };
+	const ksMatrix4x4d rz = { { { cz, sz, 0, 0 }, { -sz, cz, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+	ksMatrix4x4d rxy;
+	Ref_Multiply( &rxy, &ry, &rx );
+	Ref_Multiply( result, &rz, &rxy );
+}
+
+static void Ref_Projection( ksMatrix4x4d * result, const double tanLeft, const double tanRight, const double tanUp, const double tanDown,
+							const double nearZ, const double farZ )
+{
+	const double width = tanRight - tanLeft;
+	const double height = tanUp - tanDown;
+	memset( result, 0, sizeof( ksMatrix4x4d ) );
+	result->m[0][0] = 2.0 / width;
+	result->m[2][0] = ( tanRight + tanLeft ) / width;
+	result->m[1][1] = 2.0 / height;
+	result->m[2][1] = ( tanUp + tanDown ) / height;
+	result->m[2][3] = -1.0;
+#if GRAPHICS_API_OPENGL == 1 || GRAPHICS_API_OPENGL_ES == 1
+	const double offsetZ = nearZ;
+#else
+	const double offsetZ = 0.0;
+#endif
+	if ( farZ <= nearZ )
+	{
+		result->m[2][2] = -1.0;
+		result->m[3][2] = -( nearZ + offsetZ );
+	}
+	else
+	{
+		result->m[2][2] = -( farZ + offsetZ ) / ( farZ - nearZ );
+		result->m[3][2] = -( farZ * ( nearZ + offsetZ ) ) / ( farZ - nearZ );
+	}
+}
+
+static void Ref_TransformVector4( double result[4], const ksMatrix4x4d * m, const double v[4] )
+{
+	for ( int r = 0; r < 4; r++ )
+	{
+		result[r] = m->m[0][r] * v[0] + m->m[1][r] * v[1] + m->m[2][r] * v[2] + m->m[3][r] * v[3];
+	}
+}
+
+static void Ref_TransformBounds( double resultMins[3], double resultMaxs[3], const ksMatrix4x4d * m, const ksVector3f * mins, const ksVector3f * maxs )
+{
+	for ( int r = 0; r < 3; r++ )
+	{
+		resultMins[r] = resultMaxs[r] = m->m[3][r];
+		for ( int c = 0; c < 3; c++ )
+		{
+			const double lo = m->m[c][r] * ( (const float *)mins )[c];
+			const double hi = m->m[c][r] * ( (const float *)maxs )[c];
+			resultMins[r] += ( lo < hi ) ? lo : hi;
+			resultMaxs[r] += ( lo < hi ) ? hi : lo;
+		}
+	}
+}
+
+static bool Ref_CullBounds( const ksMatrix4x4d * mvp, const ksVector3f * mins, const ksVector3f * maxs )
+{
+	if ( maxs->x <= mins->x && maxs->y <= mins->y && maxs->z <= mins->z )
+	{
+		return false;
+	}
+	double c[8][4];
+	for ( int i = 0; i < 8; i++ )
+	{
+		const double corner[4] = { ( i & 1 ) ? maxs->x : mins->x, ( i & 2 ) ? maxs->y : mins->y, ( i & 4 ) ? maxs->z : mins->z, 1.0 };
+		Ref_TransformVector4( c[i], mvp, corner );
+	}
+	for ( int axis = 0; axis < 3; axis++ )
+	{
+		bool allBelow = true;
+		bool allAbove = true;
+		for ( int i = 0; i < 8; i++ )
+		{
+			allBelow = allBelow && !( c[i][axis] > -c[i][3] );
+			allAbove = allAbove && !( c[i][axis] < c[i][3] );
+		}
+		if ( allBelow || allAbove )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool Ref_IsAffine( const ksMatrix4x4d * m, const double epsilon )
+{
+	return fabs( m->m[0][3] ) <= epsilon && fabs( m->m[1][3] ) <= epsilon && fabs( m->m[2][3] ) <= epsilon && fabs( m->m[3][3] - 1.0 ) <= epsilon;
+}
+
+static bool Ref_IsOrthogonal( const ksMatrix4x4d * m, const double epsilon, const bool normal )
+{
+	for ( int i = 0; i < 3; i++ )
+	{
+		for ( int j = 0; j < 3; j++ )
+		{
+			if ( i == j && !normal )
+			{
+				continue;
+			}
+			const double kd = ( i == j ) ? 1.0 : 0.0;
+			if ( fabs( kd - ( m->m[i][0] * m->m[j][0] + m->m[i][1] * m->m[j][1] + m->m[i][2] * m->m[j][2] ) ) > epsilon ||
+				fabs( kd - ( m->m[0][i] * m->m[0][j] + m->m[1][i] * m->m[1][j] + m->m[2][i] * m->m[2][j] ) ) > epsilon )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/*
+================================================================================================================================
+
+ULP error statistics
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	long long	samples;
+	long long	mismatches;
+	double		maxUlp;
+	double		sumUlp;
+} ksUlpStats;
+
+// Size of one unit in the last place of a float with the given magnitude.
+static double UlpOf( const double magnitude )
+{
+	const float f = (float)fabs( magnitude );
+	if ( f < FLT_MIN )
+	{
+		return (double)FLT_MIN * FLT_EPSILON;
+	}
+	return (double)nextafterf( f, FLT_MAX ) - (double)f;
+}
+
+static void ksUlpStats_Add( ksUlpStats * stats, const float * result, const double * reference, const int count )
+{
+	double magnitude = 0.0;
+	for ( int i = 0; i < count; i++ )
+	{
+		magnitude = ( fabs( reference[i] ) > magnitude ) ? fabs( reference[i] ) : magnitude;
+	}
+	const double ulp = UlpOf( magnitude );
+	for ( int i = 0; i < count; i++ )
+	{
+		const double error = fabs( (double)result[i] - reference[i] ) / ulp;
+		stats->maxUlp = ( error > stats->maxUlp ) ? error : stats->maxUlp;
+		stats->sumUlp += error;
+		stats->samples++;
+	}
+}
+
+static void ksUlpStats_AddBool( ksUlpStats * stats, const bool result, const bool reference )
+{
+	stats->mismatches += ( result != reference ) ? 1 : 0;
+	stats->samples++;
+}
+
+static void ksUlpStats_AddMatrix( ksUlpStats * stats, const ksMatrix4x4f * result, const ksMatrix4x4d * reference )
+{
+	ksUlpStats_Add( stats, &result->m[0][0], &reference->m[0][0], 16 );
+}
+
+static void ksUlpStats_AddVector3( ksUlpStats * stats, const ksVector3f * result, const double x, const double y, const double z )
+{
+	const double reference[3] = { x, y, z };
+	ksUlpStats_Add( stats, &result->x, reference, 3 );
+}
+
+/*
+================================================================================================================================
+
+Benchmark kernels
+
+Each kernel applies one function to 'count' independent inputs. The matching accuracy
+function runs the same inputs through the double precision reference.
+
+================================================================================================================================
+*/
+
+#define BENCH_KERNEL( name, ... ) \
+	static void Bench_##name( ksAlgebraBenchData * d, const int count ) \
+	{ \
+		for ( int i = 0; i < count; i++ ) \
+		{ \
+			__VA_ARGS__; \
+		} \
+	}
+
+#define ACCURACY_KERNEL( name, ... ) \
+	static void Accuracy_##name( ksAlgebraBenchData * d, const int count, ksUlpStats * stats ) \
+	{ \
+		Bench_##name( d, count ); \
+		for ( int i = 0; i < count; i++ ) \
+		{ \
+			__VA_ARGS__; \
+		} \
+	}
+
+BENCH_KERNEL( RcpSqrt, d->fr[i] = ksRcpSqrt( d->fa[i] ) )
+ACCURACY_KERNEL( RcpSqrt, { const double ref = 1.0 / sqrt( (double)d->fa[i] ); ksUlpStats_Add( stats, &d->fr[i], &ref, 1 ); } )
+
+BENCH_KERNEL( Vector3f_Set, ksVector3f_Set( &d->vr[i], d->fa[i] ) )
+ACCURACY_KERNEL( Vector3f_Set, ksUlpStats_AddVector3( stats, &d->vr[i], d->fa[i], d->fa[i], d->fa[i] ) )
+
+BENCH_KERNEL( Vector3f_Add, ksVector3f_Add( &d->vr[i], &d->va[i], &d->vb[i] ) )
+ACCURACY_KERNEL( Vector3f_Add, ksUlpStats_AddVector3( stats, &d->vr[i], (double)d->va[i].x + d->vb[i].x, (double)d->va[i].y + d->vb[i].y, (double)d->va[i].z + d->vb[i].z ) )
+
+BENCH_KERNEL( Vector3f_Sub, ksVector3f_Sub( &d->vr[i], &d->va[i], &d->vb[i] ) )
+ACCURACY_KERNEL( Vector3f_Sub, ksUlpStats_AddVector3( stats, &d->vr[i], (double)d->va[i].x - d->vb[i].x, (double)d->va[i].y - d->vb[i].y, (double)d->va[i].z - d->vb[i].z ) )
+
+BENCH_KERNEL( Vector3f_Min, ksVector3f_Min( &d->vr[i], &d->va[i], &d->vb[i] ) )
+ACCURACY_KERNEL( Vector3f_Min, ksUlpStats_AddVector3( stats, &d->vr[i], fmin( d->va[i].x, d->vb[i].x ), fmin( d->va[i].y, d->vb[i].y ), fmin( d->va[i].z, d->vb[i].z ) ) )
+
+BENCH_KERNEL( Vector3f_Max, ksVector3f_Max( &d->vr[i], &d->va[i], &d->vb[i] ) )
+ACCURACY_KERNEL( Vector3f_Max, ksUlpStats_AddVector3( stats, &d->vr[i], fmax( d->va[i].x, d->vb[i].x ), fmax( d->va[i].y, d->vb[i].y ), fmax( d->va[i].z, d->vb[i].z ) ) )
+
+static double Ref_Decay( const double a, const double value )
+{
+	return ( fabs( a ) > value ) ? ( ( a > 0.0 ) ? ( a - value ) : ( a + value ) ) : 0.0;
+}
+
+BENCH_KERNEL( Vector3f_Decay, ksVector3f_Decay( &d->vr[i], &d->va[i], 1.0f ) )
+ACCURACY_KERNEL( Vector3f_Decay, ksUlpStats_AddVector3( stats, &d->vr[i], Ref_Decay( d->va[i].x, 1.0 ), Ref_Decay( d->va[i].y, 1.0 ), Ref_Decay( d->va[i].z, 1.0 ) ) )
+
+BENCH_KERNEL( Vector3f_Lerp, ksVector3f_Lerp( &d->vr[i], &d->va[i], &d->vb[i], 0.3f ) )
+ACCURACY_KERNEL( Vector3f_Lerp, ksUlpStats_AddVector3( stats, &d->vr[i],
+											d->va[i].x + (double)0.3f * ( (double)d->vb[i].x - d->va[i].x ),
+											d->va[i].y + (double)0.3f * ( (double)d->vb[i].y - d->va[i].y ),
+											d->va[i].z + (double)0.3f * ( (double)d->vb[i].z - d->va[i].z ) ) )
+
+BENCH_KERNEL( Vector3f_Normalize, { d->vr[i] = d->va[i]; ksVector3f_Normalize( &d->vr[i] ); } )
+ACCURACY_KERNEL( Vector3f_Normalize,
+	{
+		const double length = sqrt( (double)d->va[i].x * d->va[i].x + (double)d->va[i].y * d->va[i].y + (double)d->va[i].z * d->va[i].z );
+		ksUlpStats_AddVector3( stats, &d->vr[i], d->va[i].x / length, d->va[i].y / length, d->va[i].z / length );
+	} )
+
+BENCH_KERNEL( Vector3f_Length, d->fr[i] = ksVector3f_Length( &d->va[i] ) )
+ACCURACY_KERNEL( Vector3f_Length,
+	{
+		const double ref = sqrt( (double)d->va[i].x * d->va[i].x + (double)d->va[i].y * d->va[i].y + (double)d->va[i].z * d->va[i].z );
+		ksUlpStats_Add( stats, &d->fr[i], &ref, 1 );
+	} )
+
+BENCH_KERNEL( Quatf_Lerp, ksQuatf_Lerp( &d->qr[i], &d->qa[i], &d->qb[i], 0.3f ) )
+ACCURACY_KERNEL( Quatf_Lerp,
+	{
+		const double dot = (double)d->qa[i].x * d->qb[i].x + (double)d->qa[i].y * d->qb[i].y + (double)d->qa[i].z * d->qb[i].z + (double)d->qa[i].w * d->qb[i].w;
+		const double fa = 1.0 - (double)0.3f;
+		const double fb = ( dot < 0.0 ) ? -(double)0.3f : (double)0.3f;
+		double q[4] =
+		{
+			d->qa[i].x * fa + d->qb[i].x * fb,
+			d->qa[i].y * fa + d->qb[i].y * fb,
+			d->qa[i].z * fa + d->qb[i].z * fb,
+			d->qa[i].w * fa + d->qb[i].w * fb
+		};
+		const double length = sqrt( q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3] );
+		for ( int j = 0; j < 4; j++ ) { q[j] /= length; }
+		ksUlpStats_Add( stats, &d->qr[i].x, q, 4 );
+	} )
+
+BENCH_KERNEL( Matrix3x3f_CreateTransposeFromMatrix4x4f, ksMatrix3x3f_CreateTransposeFromMatrix4x4f( &d->m3x3r[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix3x3f_CreateTransposeFromMatrix4x4f,
+	{
+		double ref[3][3];
+		for ( int c = 0; c < 3; c++ ) { for ( int r = 0; r < 3; r++ ) { ref[c][r] = d->ma[i].m[r][c]; } }
+		ksUlpStats_Add( stats, &d->m3x3r[i].m[0][0], &ref[0][0], 9 );
+	} )
+
+BENCH_KERNEL( Matrix3x4f_CreateFromMatrix4x4f, ksMatrix3x4f_CreateFromMatrix4x4f( &d->m3x4r[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix3x4f_CreateFromMatrix4x4f,
+	{
+		double ref[3][4];
+		for ( int r = 0; r < 3; r++ ) { for ( int c = 0; c < 4; c++ ) { ref[r][c] = d->ma[i].m[c][r]; } }
+		ksUlpStats_Add( stats, &d->m3x4r[i].m[0][0], &ref[0][0], 12 );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_Multiply, ksMatrix4x4f_Multiply( &d->mr[i], &d->ma[i], &d->mb[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_Multiply,
+	{
+		ksMatrix4x4d a, b, ref;
+		Ref_FromMatrix4x4f( &a, &d->ma[i] );
+		Ref_FromMatrix4x4f( &b, &d->mb[i] );
+		Ref_Multiply( &ref, &a, &b );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_Transpose, ksMatrix4x4f_Transpose( &d->mr[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_Transpose,
+	{
+		ksMatrix4x4d ref;
+		for ( int c = 0; c < 4; c++ ) { for ( int r = 0; r < 4; r++ ) { ref.m[c][r] = d->ma[i].m[r][c]; } }
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_Invert, ksMatrix4x4f_Invert( &d->mr[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_Invert,
+	{
+		ksMatrix4x4d src, ref;
+		Ref_FromMatrix4x4f( &src, &d->ma[i] );
+		Ref_Invert( &ref, &src );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_InvertHomogeneous, ksMatrix4x4f_InvertHomogeneous( &d->mr[i], &d->mb[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_InvertHomogeneous,
+	{
+		ksMatrix4x4d src, ref;
+		Ref_FromMatrix4x4f( &src, &d->mb[i] );
+		Ref_Invert( &ref, &src );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateIdentity, ksMatrix4x4f_CreateIdentity( &d->mr[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateIdentity,
+	{
+		const ksMatrix4x4d ref = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateTranslation, ksMatrix4x4f_CreateTranslation( &d->mr[i], d->va[i].x, d->va[i].y, d->va[i].z ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateTranslation,
+	{
+		const ksMatrix4x4d ref = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { d->va[i].x, d->va[i].y, d->va[i].z, 1 } } };
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateRotation, ksMatrix4x4f_CreateRotation( &d->mr[i], d->va[i].x * 18.0f, d->va[i].y * 18.0f, d->va[i].z * 18.0f ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateRotation,
+	{
+		ksMatrix4x4d ref;
+		Ref_Rotation( &ref, d->va[i].x * 18.0f, d->va[i].y * 18.0f, d->va[i].z * 18.0f );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateScale, ksMatrix4x4f_CreateScale( &d->mr[i], d->vb[i].x, d->vb[i].y, d->vb[i].z ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateScale,
+	{
+		const ksMatrix4x4d ref = { { { d->vb[i].x, 0, 0, 0 }, { 0, d->vb[i].y, 0, 0 }, { 0, 0, d->vb[i].z, 0 }, { 0, 0, 0, 1 } } };
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateFromQuaternion, ksMatrix4x4f_CreateFromQuaternion( &d->mr[i], &d->qa[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateFromQuaternion,
+	{
+		ksMatrix4x4d ref;
+		Ref_FromQuaternion( &ref, &d->qa[i] );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateTranslationRotationScale, ksMatrix4x4f_CreateTranslationRotationScale( &d->mr[i], &d->va[i], &d->qa[i], &d->vb[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateTranslationRotationScale,
+	{
+		ksMatrix4x4d ref;
+		Ref_TranslationRotationScale( &ref, &d->va[i], &d->qa[i], &d->vb[i] );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateProjection, ksMatrix4x4f_CreateProjection( &d->mr[i], -d->vb[i].x * 0.2f, d->vb[i].y * 0.2f, d->vb[i].z * 0.2f, -d->vb[i].x * 0.1f, 0.1f, d->fa[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateProjection,
+	{
+		ksMatrix4x4d ref;
+		Ref_Projection( &ref, -d->vb[i].x * 0.2f, d->vb[i].y * 0.2f, d->vb[i].z * 0.2f, -d->vb[i].x * 0.1f, 0.1f, d->fa[i] );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateProjectionFov, ksMatrix4x4f_CreateProjectionFov( &d->mr[i], 40.0f + d->va[i].x, 40.0f + d->va[i].y, 40.0f + d->va[i].z, 40.0f - d->va[i].x, 0.1f, INFINITE_FAR_Z ) )
+ACCURACY_KERNEL( Matrix4x4f_CreateProjectionFov,
+	{
+		const double toRadians = 3.14159265358979323846 / 180.0;
+		ksMatrix4x4d ref;
+		Ref_Projection( &ref,	-tan( ( 40.0f + d->va[i].x ) * toRadians ), tan( ( 40.0f + d->va[i].y ) * toRadians ),
+								tan( ( 40.0f + d->va[i].z ) * toRadians ), -tan( ( 40.0f - d->va[i].x ) * toRadians ), 0.1f, INFINITE_FAR_Z );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CreateOffsetScaleForBounds, { ksVector3f maxs; ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] ); ksMatrix4x4f_CreateOffsetScaleForBounds( &d->mr[i], &d->ma[i], &d->va[i], &maxs ); } )
+ACCURACY_KERNEL( Matrix4x4f_CreateOffsetScaleForBounds,
+	{
+		ksVector3f maxs;
+		ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] );
+		const double offset[3] = { ( (double)maxs.x + d->va[i].x ) * 0.5, ( (double)maxs.y + d->va[i].y ) * 0.5, ( (double)maxs.z + d->va[i].z ) * 0.5 };
+		const double scale[3] = { ( (double)maxs.x - d->va[i].x ) * 0.5, ( (double)maxs.y - d->va[i].y ) * 0.5, ( (double)maxs.z - d->va[i].z ) * 0.5 };
+		ksMatrix4x4d src, ref;
+		Ref_FromMatrix4x4f( &src, &d->ma[i] );
+		for ( int r = 0; r < 4; r++ )
+		{
+			ref.m[0][r] = src.m[0][r] * scale[0];
+			ref.m[1][r] = src.m[1][r] * scale[1];
+			ref.m[2][r] = src.m[2][r] * scale[2];
+			ref.m[3][r] = src.m[3][r] + src.m[0][r] * offset[0] + src.m[1][r] * offset[1] + src.m[2][r] * offset[2];
+		}
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_IsAffine, d->br[i] = ksMatrix4x4f_IsAffine( &d->mvp[i], 1e-4f ) )
+ACCURACY_KERNEL( Matrix4x4f_IsAffine, { ksMatrix4x4d m; Ref_FromMatrix4x4f( &m, &d->mvp[i] ); ksUlpStats_AddBool( stats, d->br[i], Ref_IsAffine( &m, 1e-4f ) ); } )
+
+BENCH_KERNEL( Matrix4x4f_IsOrthogonal, d->br[i] = ksMatrix4x4f_IsOrthogonal( &d->ma[i], 1e-4f ) )
+ACCURACY_KERNEL( Matrix4x4f_IsOrthogonal, { ksMatrix4x4d m; Ref_FromMatrix4x4f( &m, &d->ma[i] ); ksUlpStats_AddBool( stats, d->br[i], Ref_IsOrthogonal( &m, 1e-4f, false ) ); } )
+
+BENCH_KERNEL( Matrix4x4f_IsOrthonormal, d->br[i] = ksMatrix4x4f_IsOrthonormal( &d->mb[i], 1e-4f ) )
+ACCURACY_KERNEL( Matrix4x4f_IsOrthonormal, { ksMatrix4x4d m; Ref_FromMatrix4x4f( &m, &d->mb[i] ); ksUlpStats_AddBool( stats, d->br[i], Ref_IsOrthogonal( &m, 1e-4f, true ) ); } )
+
+BENCH_KERNEL( Matrix4x4f_IsHomogeneous, d->br[i] = ksMatrix4x4f_IsHomogeneous( &d->mb[i], 1e-4f ) )
+ACCURACY_KERNEL( Matrix4x4f_IsHomogeneous,
+	{
+		ksMatrix4x4d m;
+		Ref_FromMatrix4x4f( &m, &d->mb[i] );
+		ksUlpStats_AddBool( stats, d->br[i], Ref_IsAffine( &m, 1e-4f ) && Ref_IsOrthogonal( &m, 1e-4f, true ) );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_GetTranslation, ksMatrix4x4f_GetTranslation( &d->vr[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_GetTranslation, ksUlpStats_AddVector3( stats, &d->vr[i], d->va[i].x, d->va[i].y, d->va[i].z ) )
+
+// The decomposition is checked against the quaternion the matrix was built from, after resolving the sign ambiguity.
+BENCH_KERNEL( Matrix4x4f_GetRotation, ksMatrix4x4f_GetRotation( &d->qr[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_GetRotation,
+	{
+		const ksQuatf * q = &d->qa[i];
+		const double sign = ( q->x * d->qr[i].x + q->y * d->qr[i].y + q->z * d->qr[i].z + q->w * d->qr[i].w < 0.0f ) ? -1.0 : 1.0;
+		const double ref[4] = { sign * q->x, sign * q->y, sign * q->z, sign * q->w };
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_GetScale, ksMatrix4x4f_GetScale( &d->vr[i], &d->ma[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_GetScale, ksUlpStats_AddVector3( stats, &d->vr[i], d->scale[i].x, d->scale[i].y, d->scale[i].z ) )
+
+BENCH_KERNEL( Matrix4x4f_TransformVector3f, ksMatrix4x4f_TransformVector3f( &d->vr[i], &d->mvp[i], &d->va[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_TransformVector3f,
+	{
+		ksMatrix4x4d m;
+		Ref_FromMatrix4x4f( &m, &d->mvp[i] );
+		const double v[4] = { d->va[i].x, d->va[i].y, d->va[i].z, 1.0 };
+		double r[4];
+		Ref_TransformVector4( r, &m, v );
+		ksUlpStats_AddVector3( stats, &d->vr[i], r[0] / r[3], r[1] / r[3], r[2] / r[3] );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_TransformVector4f, ksMatrix4x4f_TransformVector4f( &d->v4r[i], &d->mvp[i], &d->v4a[i] ) )
+ACCURACY_KERNEL( Matrix4x4f_TransformVector4f,
+	{
+		ksMatrix4x4d m;
+		Ref_FromMatrix4x4f( &m, &d->mvp[i] );
+		const double v[4] = { d->v4a[i].x, d->v4a[i].y, d->v4a[i].z, 1.0 };	// the function ignores 'w'
+		double r[4];
+		Ref_TransformVector4( r, &m, v );
+		ksUlpStats_Add( stats, &d->v4r[i].x, r, 4 );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_TransformBounds, { ksVector3f maxs; ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] ); ksMatrix4x4f_TransformBounds( &d->vr[i], &d->vr2[i], &d->ma[i], &d->va[i], &maxs ); } )
+ACCURACY_KERNEL( Matrix4x4f_TransformBounds,
+	{
+		ksVector3f maxs;
+		ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] );
+		ksMatrix4x4d m;
+		Ref_FromMatrix4x4f( &m, &d->ma[i] );
+		double mins[3], maxsRef[3];
+		Ref_TransformBounds( mins, maxsRef, &m, &d->va[i], &maxs );
+		ksUlpStats_Add( stats, &d->vr[i].x, mins, 3 );
+		ksUlpStats_Add( stats, &d->vr2[i].x, maxsRef, 3 );
+	} )
+
+BENCH_KERNEL( Matrix4x4f_CullBounds, { ksVector3f maxs; ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] ); d->br[i] = ksMatrix4x4f_CullBounds( &d->mvp[i], &d->va[i], &maxs ); } )
+ACCURACY_KERNEL( Matrix4x4f_CullBounds,
+	{
+		ksVector3f maxs;
+		ksVector3f_Add( &maxs, &d->va[i], &d->vb[i] );
+		ksMatrix4x4d m;
+		Ref_FromMatrix4x4f( &m, &d->mvp[i] );
+		ksUlpStats_AddBool( stats, d->br[i], Ref_CullBounds( &m, &d->va[i], &maxs ) );
+	} )
+
+/*
+	The batched pose functions process the whole array in one call.
+*/
+
+#define PREDICT_DELTA_SECONDS	0.02f
+
+static void Bench_Matrix4x4f_CreateFromPoses( ksAlgebraBenchData * d, const int count )
+{
+	ksMatrix4x4f_CreateFromPoses( d->mr, d->pa, count );
+}
+
+static void Accuracy_Matrix4x4f_CreateFromPoses( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Matrix4x4f_CreateFromPoses( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksMatrix4x4d ref;
+		Ref_FromQuaternion( &ref, &d->pa[i].orientation );
+		ref.m[3][0] = d->pa[i].position.x;
+		ref.m[3][1] = d->pa[i].position.y;
+		ref.m[3][2] = d->pa[i].position.z;
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	}
+}
+
+static void Bench_Matrix3x4f_CreateFromPoses( ksAlgebraBenchData * d, const int count )
+{
+	ksMatrix3x4f_CreateFromPoses( d->m3x4r, d->pa, count );
+}
+
+static void Accuracy_Matrix3x4f_CreateFromPoses( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Matrix3x4f_CreateFromPoses( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksMatrix4x4d m;
+		Ref_FromQuaternion( &m, &d->pa[i].orientation );
+		const double t[3] = { d->pa[i].position.x, d->pa[i].position.y, d->pa[i].position.z };
+		double ref[3][4];
+		for ( int r = 0; r < 3; r++ ) { for ( int c = 0; c < 3; c++ ) { ref[r][c] = m.m[c][r]; } ref[r][3] = t[r]; }
+		ksUlpStats_Add( stats, &d->m3x4r[i].m[0][0], &ref[0][0], 12 );
+	}
+}
+
+static void Bench_Posef_Predict( ksAlgebraBenchData * d, const int count )
+{
+	ksPosef_Predict( d->pr, d->pa, d->vb, d->wa, count, PREDICT_DELTA_SECONDS );
+}
+
+static void Accuracy_Posef_Predict( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Posef_Predict( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		const double dt = PREDICT_DELTA_SECONDS;
+		const double h[3] = { d->wa[i].x * dt * 0.5, d->wa[i].y * dt * 0.5, d->wa[i].z * dt * 0.5 };
+		const double angle = sqrt( h[0] * h[0] + h[1] * h[1] + h[2] * h[2] );
+		const double s = ( angle > 0.0 ) ? sin( angle ) / angle : 1.0;
+		const double dq[4] = { h[0] * s, h[1] * s, h[2] * s, cos( angle ) };
+		const ksQuatf * q = &d->pa[i].orientation;
+		const double r[4] =
+		{
+			dq[3] * q->x + dq[0] * q->w + dq[1] * q->z - dq[2] * q->y,
+			dq[3] * q->y - dq[0] * q->z + dq[1] * q->w + dq[2] * q->x,
+			dq[3] * q->z + dq[0] * q->y - dq[1] * q->x + dq[2] * q->w,
+			dq[3] * q->w - dq[0] * q->x - dq[1] * q->y - dq[2] * q->z
+		};
+		ksUlpStats_Add( stats, &d->pr[i].orientation.x, r, 4 );
+		ksUlpStats_AddVector3( stats, &d->pr[i].position,
+								d->pa[i].position.x + (double)d->vb[i].x * dt,
+								d->pa[i].position.y + (double)d->vb[i].y * dt,
+								d->pa[i].position.z + (double)d->vb[i].z * dt );
+	}
+}
+
+/*
+	Batched quaternion functions.
+
+	The packed formats are lossy, so the Pack cases report the round trip error against the
+	original quaternion, while the Unpack cases report the decoding error against a double
+	precision decode of the same bits.
+*/
+
+static void Ref_Nlerp( double result[4], const ksQuatf * a, const ksQuatf * b, const double fraction )
+{
+	const double dot = (double)a->x * b->x + (double)a->y * b->y + (double)a->z * b->z + (double)a->w * b->w;
+	const double fa = 1.0 - fraction;
+	const double fb = ( dot < 0.0 ) ? -fraction : fraction;
+	result[0] = a->x * fa + b->x * fb;
+	result[1] = a->y * fa + b->y * fb;
+	result[2] = a->z * fa + b->z * fb;
+	result[3] = a->w * fa + b->w * fb;
+	const double length = sqrt( result[0] * result[0] + result[1] * result[1] + result[2] * result[2] + result[3] * result[3] );
+	for ( int j = 0; j < 4; j++ ) { result[j] /= length; }
+}
+
+static void Ref_Slerp( double result[4], const ksQuatf * a, const ksQuatf * b, const double fraction )
+{
+	double dot = (double)a->x * b->x + (double)a->y * b->y + (double)a->z * b->z + (double)a->w * b->w;
+	const double sign = ( dot < 0.0 ) ? -1.0 : 1.0;
+	dot = ( dot * sign > 1.0 ) ? 1.0 : dot * sign;
+	const double angle = acos( dot );
+	double fa = 1.0 - fraction;
+	double fb = fraction;
+	if ( angle > 1e-9 )
+	{
+		fa = sin( ( 1.0 - fraction ) * angle ) / sin( angle );
+		fb = sin( fraction * angle ) / sin( angle );
+	}
+	fb *= sign;
+	result[0] = a->x * fa + b->x * fb;
+	result[1] = a->y * fa + b->y * fb;
+	result[2] = a->z * fa + b->z * fb;
+	result[3] = a->w * fa + b->w * fb;
+}
+
+// Double precision decode of the smallest three encoding with 'bits' per component.
+static void Ref_FromSmallestThree( double result[4], const int largest, const unsigned int quantized[3], const int bits )
+{
+	const double range = 1.0 / sqrt( 2.0 );
+	double sumSqr = 0.0;
+	for ( int i = 0, j = 0; i < 4; i++ )
+	{
+		if ( i != largest )
+		{
+			result[i] = ( (double)quantized[j++] / ( ( 1 << bits ) - 1 ) * 2.0 - 1.0 ) * range;
+			sumSqr += result[i] * result[i];
+		}
+	}
+	result[largest] = sqrt( ( 1.0 - sumSqr > 0.25 ) ? 1.0 - sumSqr : 0.25 );
+}
+
+// Adds the error of 'result' against unit quaternion 'q', which is negated when needed to match the sign of 'result'.
+static void ksUlpStats_AddQuaternion( ksUlpStats * stats, const ksQuatf * result, const ksQuatf * q )
+{
+	const double sign = ( q->x * result->x + q->y * result->y + q->z * result->z + q->w * result->w < 0.0f ) ? -1.0 : 1.0;
+	const double ref[4] = { sign * q->x, sign * q->y, sign * q->z, sign * q->w };
+	ksUlpStats_Add( stats, &result->x, ref, 4 );
+}
+
+static void Bench_Quatf_NormalizeArray( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf_NormalizeArray( d->qr, d->qu, count );
+}
+
+static void Accuracy_Quatf_NormalizeArray( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf_NormalizeArray( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksQuatf * q = &d->qu[i];
+		const double length = sqrt( (double)q->x * q->x + (double)q->y * q->y + (double)q->z * q->z + (double)q->w * q->w );
+		const double ref[4] = { q->x / length, q->y / length, q->z / length, q->w / length };
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	}
+}
+
+static void Bench_Quatf_NlerpArray( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf_NlerpArray( d->qr, d->qa, d->qb, count, 0.3f );
+}
+
+static void Accuracy_Quatf_NlerpArray( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf_NlerpArray( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		double ref[4];
+		Ref_Nlerp( ref, &d->qa[i], &d->qb[i], 0.3f );
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	}
+}
+
+static void Bench_Quatf_SlerpArray( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf_SlerpArray( d->qr, d->qa, d->qb, count, 0.3f );
+}
+
+static void Accuracy_Quatf_SlerpArray( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf_SlerpArray( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		double ref[4];
+		Ref_Slerp( ref, &d->qa[i], &d->qb[i], 0.3f );
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	}
+}
+
+static void Bench_Matrix4x4f_CreateFromQuaternions( ksAlgebraBenchData * d, const int count )
+{
+	ksMatrix4x4f_CreateFromQuaternions( d->mr, d->qa, count );
+}
+
+static void Accuracy_Matrix4x4f_CreateFromQuaternions( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Matrix4x4f_CreateFromQuaternions( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksMatrix4x4d ref;
+		Ref_FromQuaternion( &ref, &d->qa[i] );
+		ksUlpStats_AddMatrix( stats, &d->mr[i], &ref );
+	}
+}
+
+static void Bench_Quatf32_Pack( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf32_Pack( d->q32r, d->qa, count );
+}
+
+static void Accuracy_Quatf32_Pack( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf32_Pack( d, count );
+	ksQuatf32_Unpack( d->qr, d->q32r, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksUlpStats_AddQuaternion( stats, &d->qr[i], &d->qa[i] );
+	}
+}
+
+static void Bench_Quatf32_Unpack( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf32_Unpack( d->qr, d->q32, count );
+}
+
+static void Accuracy_Quatf32_Unpack( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf32_Unpack( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		const uint32_t p = d->q32[i];
+		const unsigned int quantized[3] = { ( p >> 20 ) & 0x3FF, ( p >> 10 ) & 0x3FF, p & 0x3FF };
+		double ref[4];
+		Ref_FromSmallestThree( ref, (int)( p >> 30 ), quantized, 10 );
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	}
+}
+
+static void Bench_Quatf48_Pack( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf48_Pack( d->q48r, d->qa, count );
+}
+
+static void Accuracy_Quatf48_Pack( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf48_Pack( d, count );
+	ksQuatf48_Unpack( d->qr, d->q48r, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksUlpStats_AddQuaternion( stats, &d->qr[i], &d->qa[i] );
+	}
+}
+
+static void Bench_Quatf48_Unpack( ksAlgebraBenchData * d, const int count )
+{
+	ksQuatf48_Unpack( d->qr, d->q48, count );
+}
+
+static void Accuracy_Quatf48_Unpack( ksAlgebraBenchData * d, const int count, ksUlpStats * stats )
+{
+	Bench_Quatf48_Unpack( d, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksQuatf48 * p = &d->q48[i];
+		const unsigned int quantized[3] = { p->v[0] & 0x7FFFu, p->v[1] & 0x7FFFu, p->v[2] & 0x7FFFu };
+		double ref[4];
+		Ref_FromSmallestThree( ref, ( ( p->v[0] >> 15 ) << 1 ) | ( p->v[1] >> 15 ), quantized, 15 );
+		ksUlpStats_Add( stats, &d->qr[i].x, ref, 4 );
+	}
+}
+
+typedef void (*ksBenchKernel)( ksAlgebraBenchData * d, const int count );
+typedef void (*ksAccuracyKernel)( ksAlgebraBenchData * d, const int count, ksUlpStats * stats );
+
+typedef struct
+{
+	const char *		name;
+	ksBenchKernel		bench;
+	ksAccuracyKernel	accuracy;
+} ksAlgebraBenchCase;
+
+#define BENCH_CASE( name )	{ #name, Bench_##name, Accuracy_##name }
+
+static const ksAlgebraBenchCase benchCases[] =
+{
+	{ "ksRcpSqrt", Bench_RcpSqrt, Accuracy_RcpSqrt },
+	BENCH_CASE( Vector3f_Set ),
+	BENCH_CASE( Vector3f_Add ),
+	BENCH_CASE( Vector3f_Sub ),
+	BENCH_CASE( Vector3f_Min ),
+	BENCH_CASE( Vector3f_Max ),
+	BENCH_CASE( Vector3f_Decay ),
+	BENCH_CASE( Vector3f_Lerp ),
+	BENCH_CASE( Vector3f_Normalize ),
+	BENCH_CASE( Vector3f_Length ),
+	BENCH_CASE( Quatf_Lerp ),
+	BENCH_CASE( Matrix3x3f_CreateTransposeFromMatrix4x4f ),
+	BENCH_CASE( Matrix3x4f_CreateFromMatrix4x4f ),
+	BENCH_CASE( Matrix4x4f_Multiply ),
+	BENCH_CASE( Matrix4x4f_Transpose ),
+	BENCH_CASE( Matrix4x4f_Invert ),
+	BENCH_CASE( Matrix4x4f_InvertHomogeneous ),
+	BENCH_CASE( Matrix4x4f_CreateIdentity ),
+	BENCH_CASE( Matrix4x4f_CreateTranslation ),
+	BENCH_CASE( Matrix4x4f_CreateRotation ),
+	BENCH_CASE( Matrix4x4f_CreateScale ),
+	BENCH_CASE( Matrix4x4f_CreateFromQuaternion ),
+	BENCH_CASE( Matrix4x4f_CreateTranslationRotationScale ),
+	BENCH_CASE( Matrix4x4f_CreateProjection ),
+	BENCH_CASE( Matrix4x4f_CreateProjectionFov ),
+	BENCH_CASE( Matrix4x4f_CreateOffsetScaleForBounds ),
+	BENCH_CASE( Matrix4x4f_IsAffine ),
+	BENCH_CASE( Matrix4x4f_IsOrthogonal ),
+	BENCH_CASE( Matrix4x4f_IsOrthonormal ),
+	BENCH_CASE( Matrix4x4f_IsHomogeneous ),
+	BENCH_CASE( Matrix4x4f_GetTranslation ),
+	BENCH_CASE( Matrix4x4f_GetRotation ),
+	BENCH_CASE( Matrix4x4f_GetScale ),
+	BENCH_CASE( Matrix4x4f_TransformVector3f ),
+	BENCH_CASE( Matrix4x4f_TransformVector4f ),
+	BENCH_CASE( Matrix4x4f_TransformBounds ),
+	BENCH_CASE( Matrix4x4f_CullBounds ),
+	BENCH_CASE( Matrix4x4f_CreateFromPoses ),
+	BENCH_CASE( Matrix3x4f_CreateFromPoses ),
+	BENCH_CASE( Posef_Predict ),
+	BENCH_CASE( Quatf_NormalizeArray ),
+	BENCH_CASE( Quatf_NlerpArray ),
+	BENCH_CASE( Quatf_SlerpArray ),
+	BENCH_CASE( Matrix4x4f_CreateFromQuaternions ),
+	BENCH_CASE( Quatf32_Pack ),
+	BENCH_CASE( Quatf32_Unpack ),
+	BENCH_CASE( Quatf48_Pack ),
+	BENCH_CASE( Quatf48_Unpack ),
+};
+
+/*
+================================================================================================================================
+
+Driver
+
+================================================================================================================================
+*/
+
+// Writes the function name with the "ks" prefix the kernels strip for brevity.
+static void CaseName( char * buffer, const size_t size, const ksAlgebraBenchCase * benchCase )
+{
+	snprintf( buffer, size, "%s%s", ( strncmp( benchCase->name, "ks", 2 ) == 0 ) ? "" : "ks", benchCase->name );
+}
+
+static void RunTiming( ksJsonWriter * writer, ksAlgebraBenchData * data, ksBenchCounters * counters,
+						const ksAlgebraBenchCase * benchCase, const int batchSize, const long long minOpsPerTrial )
+{
+	const long long repeats = ( minOpsPerTrial + batchSize - 1 ) / batchSize;
+
+	// Warm up the caches and the branch predictors.
+	benchCase->bench( data, batchSize );
+
+	double bestNanoseconds = 1e30;
+	double totalNanoseconds = 0.0;
+	unsigned long long cycles = 0;
+	unsigned long long instructions = 0;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		ksBenchCounters_Start( counters );
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( long long r = 0; r < repeats; r++ )
+		{
+			benchCase->bench( data, batchSize );
+			ksBench_ClobberMemory();
+		}
+		const ksNanoseconds end = ksBench_GetTimeNanoseconds();
+		ksBenchCounters_Stop( counters );
+
+		const double nanoseconds = (double)( end - start );
+		bestNanoseconds = ( nanoseconds < bestNanoseconds ) ? nanoseconds : bestNanoseconds;
+		totalNanoseconds += nanoseconds;
+		cycles += counters->cycles;
+		instructions += counters->instructions;
+	}
+
+	const double opsPerTrial = (double)repeats * batchSize;
+	const double nsPerOp = bestNanoseconds / opsPerTrial;
+
+	char name[128];
+	CaseName( name, sizeof( name ), benchCase );
+
+	ksJsonWriter_BeginObject( writer, NULL );
+	ksJsonWriter_String( writer, "name", name );
+	ksJsonWriter_Int( writer, "batch", batchSize );
+	ksJsonWriter_Int( writer, "ops", (long long)opsPerTrial );
+	ksJsonWriter_Double( writer, "ns_per_op", nsPerOp );
+	ksJsonWriter_Double( writer, "mean_ns_per_op", totalNanoseconds / ( TIMING_TRIALS * opsPerTrial ) );
+	ksJsonWriter_Double( writer, "ops_per_sec", 1e9 / nsPerOp );
+	if ( counters->available && cycles > 0 )
+	{
+		ksJsonWriter_Double( writer, "cycles_per_op", (double)cycles / ( TIMING_TRIALS * opsPerTrial ) );
+		ksJsonWriter_Double( writer, "ipc", (double)instructions / (double)cycles );
+	}
+	else
+	{
+		ksJsonWriter_Double( writer, "cycles_per_op", NAN );
+		ksJsonWriter_Double( writer, "ipc", NAN );
+	}
+	ksJsonWriter_EndObject( writer );
+}
+
+static void RunAccuracy( ksJsonWriter * writer, ksAlgebraBenchData * data, const ksAlgebraBenchCase * benchCase )
+{
+	ksUlpStats stats;
+	memset( &stats, 0, sizeof( stats ) );
+	benchCase->accuracy( data, ACCURACY_SAMPLES, &stats );
+
+	char name[128];
+	CaseName( name, sizeof( name ), benchCase );
+
+	ksJsonWriter_BeginObject( writer, NULL );
+	ksJsonWriter_String( writer, "name", name );
+	ksJsonWriter_Int( writer, "samples", stats.samples );
+	ksJsonWriter_Double( writer, "max_ulp", stats.maxUlp );
+	ksJsonWriter_Double( writer, "mean_ulp", ( stats.samples > 0 ) ? stats.sumUlp / stats.samples : 0.0 );
+	ksJsonWriter_Int( writer, "mismatches", stats.mismatches );
+	ksJsonWriter_EndObject( writer );
+}
+
+int main( int argc, char * argv[] )
+{
+	const char * outFileName = NULL;
+	const char * filter = NULL;
+	long long minOpsPerTrial = 1000000;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "--quick" ) == 0 )
+		{
+			minOpsPerTrial = 50000;
+		}
+		else if ( strcmp( argv[i], "--filter" ) == 0 && i + 1 < argc )
+		{
+			filter = argv[++i];
+		}
+		else if ( strcmp( argv[i], "--out" ) == 0 && i + 1 < argc )
+		{
+			outFileName = argv[++i];
+		}
+		else
+		{
+			fprintf( stderr, "Usage: %s [--quick] [--filter <substring>] [--out <file.json>]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE * fp = stdout;
+	if ( outFileName != NULL )
+	{
+		fp = fopen( outFileName, "w" );
+		if ( fp == NULL )
+		{
+			fprintf( stderr, "Failed to open %s\n", outFileName );
+			return EXIT_FAILURE;
+		}
+	}
+
+	ksAlgebraBenchData data;
+	ksAlgebraBenchData_Create( &data );
+
+	ksBenchCounters counters;
+	ksBenchCounters_Create( &counters );
+
+	ksJsonWriter writer;
+	ksJsonWriter_Create( &writer, fp );
+	ksJsonWriter_BeginObject( &writer, NULL );
+	ksBench_WriteHeader( &writer, "algebra" );
+	ksJsonWriter_Bool( &writer, "hardware_counters", counters.available );
+
+	const int caseCount = (int)( sizeof( benchCases ) / sizeof( benchCases[0] ) );
+
+	ksJsonWriter_BeginArray( &writer, "timings" );
+	for ( int c = 0; c < caseCount; c++ )
+	{
+		if ( filter != NULL && strstr( benchCases[c].name, filter ) == NULL )
+		{
+			continue;
+		}
+		for ( int b = 0; b < (int)( sizeof( batchSizes ) / sizeof( batchSizes[0] ) ); b++ )
+		{
+			RunTiming( &writer, &data, &counters, &benchCases[c], batchSizes[b], minOpsPerTrial );
+		}
+	}
+	ksJsonWriter_EndArray( &writer );
+
+	ksJsonWriter_BeginArray( &writer, "accuracy" );
+	for ( int c = 0; c < caseCount; c++ )
+	{
+		if ( filter != NULL && strstr( benchCases[c].name, filter ) == NULL )
+		{
+			continue;
+		}
+		RunAccuracy( &writer, &data, &benchCases[c] );
+	}
+	ksJsonWriter_EndArray( &writer );
+
+	ksJsonWriter_EndObject( &writer );
+
+	ksBenchCounters_Destroy( &counters );
+	ksAlgebraBenchData_Destroy( &data );
+
+	if ( fp != stdout )
+	{
+		fclose( fp );
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,393 @@
+/*
+================================================================================================
+
+Description	:	Shared helpers for the micro benchmarks.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+High resolution timing, hardware performance counters (cycles and retired instructions
+for the IPC figures) and a minimal JSON writer so every benchmark emits the same
+machine readable report for the performance dashboards.
+
+The hardware counters are read through perf_event_open on Linux. When the counters are
+not available (other platforms, containers, perf_event_paranoid) the IPC related fields
+are written as null instead of failing the run.
+
+
+INTERFACE
+=========
+
+static ksNanoseconds ksBench_GetTimeNanoseconds();
+static void ksBench_ClobberMemory();
+
+static void ksBenchCounters_Create( ksBenchCounters * counters );
+static void ksBenchCounters_Destroy( ksBenchCounters * counters );
+static void ksBenchCounters_Start( ksBenchCounters * counters );
+static void ksBenchCounters_Stop( ksBenchCounters * counters );
+
+static void ksJsonWriter_Create( ksJsonWriter * writer, FILE * fp );
+static void ksJsonWriter_BeginObject( ksJsonWriter * writer, const char * key );
+static void ksJsonWriter_EndObject( ksJsonWriter * writer );
+static void ksJsonWriter_BeginArray( ksJsonWriter * writer, const char * key );
+static void ksJsonWriter_EndArray( ksJsonWriter * writer );
+static void ksJsonWriter_String( ksJsonWriter * writer, const char * key, const char * value );
+static void ksJsonWriter_Int( ksJsonWriter * writer, const char * key, const long long value );
+static void ksJsonWriter_Double( ksJsonWriter * writer, const char * key, const double value );
+static void ksJsonWriter_Bool( ksJsonWriter * writer, const char * key, const bool value );
+
+static void ksBench_WriteHeader( ksJsonWriter * writer, const char * benchmarkName );
+
+The report header includes the CPU topology from utils/sysinfo.h.
+
+================================================================================================
+*/
+
+#if !defined( KSBENCHUTIL_H )
+#define KSBENCHUTIL_H
+
+// Must be the first include of a benchmark so this applies to all system headers.
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+	#define _GNU_SOURCE		// for clock_gettime(), syscall(), pthread_setaffinity_np()
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <assert.h>
+
+#include "utils/nanoseconds.h"
+#include "utils/sysinfo.h"
+
+#if !defined( UNUSED_PARM )
+#define UNUSED_PARM( x )				{ (void)(x); }
+#endif
+
+#if defined( OS_LINUX )
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <linux/perf_event.h>
+#endif
+
+/*
+================================================================================================================================
+
+Timing
+
+================================================================================================================================
+*/
+
+// GetTimeNanoseconds() only has microsecond resolution on Linux, which is too coarse for short batches.
+static ksNanoseconds ksBench_GetTimeNanoseconds()
+{
+#if defined( OS_LINUX ) || defined( OS_ANDROID )
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (ksNanoseconds) ts.tv_sec * 1000ULL * 1000ULL * 1000ULL + ts.tv_nsec;
+#else
+	return GetTimeNanoseconds();
+#endif
+}
+
+// Compiler barrier that keeps the optimizer from merging or dropping repeated kernel invocations.
+static inline void ksBench_ClobberMemory()
+{
+#if defined( _MSC_VER )
+	_ReadWriteBarrier();
+#else
+	__asm__ __volatile__( "" : : : "memory" );
+#endif
+}
+
+/*
+================================================================================================================================
+
+Hardware performance counters
+
+ksBenchCounters
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	bool				available;
+	int					fdCycles;
+	int					fdInstructions;
+	unsigned long long	cycles;
+	unsigned long long	instructions;
+} ksBenchCounters;
+
+#if defined( OS_LINUX )
+static int ksBenchCounters_Open( const unsigned long long config, const int groupFd )
+{
+	struct perf_event_attr attr;
+	memset( &attr, 0, sizeof( attr ) );
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof( attr );
+	attr.config = config;
+	attr.disabled = ( groupFd == -1 ) ? 1 : 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	return (int)syscall( __NR_perf_event_open, &attr, 0, -1, groupFd, 0 );
+}
+#endif
+
+static void ksBenchCounters_Create( ksBenchCounters * counters )
+{
+	memset( counters, 0, sizeof( ksBenchCounters ) );
+	counters->fdCycles = -1;
+	counters->fdInstructions = -1;
+#if defined( OS_LINUX )
+	counters->fdCycles = ksBenchCounters_Open( PERF_COUNT_HW_CPU_CYCLES, -1 );
+	if ( counters->fdCycles != -1 )
+	{
+		counters->fdInstructions = ksBenchCounters_Open( PERF_COUNT_HW_INSTRUCTIONS, counters->fdCycles );
+		if ( counters->fdInstructions == -1 )
+		{
+			close( counters->fdCycles );
+			counters->fdCycles = -1;
+		}
+	}
+	counters->available = ( counters->fdCycles != -1 );
+#endif
+}
+
+static void ksBenchCounters_Destroy( ksBenchCounters * counters )
+{
+#if defined( OS_LINUX )
+	if ( counters->fdInstructions != -1 )
+	{
+		close( counters->fdInstructions );
+	}
+	if ( counters->fdCycles != -1 )
+	{
+		close( counters->fdCycles );
+	}
+#endif
+	memset( counters, 0, sizeof( ksBenchCounters ) );
+}
+
+static void ksBenchCounters_Start( ksBenchCounters * counters )
+{
+	counters->cycles = 0;
+	counters->instructions = 0;
+#if defined( OS_LINUX )
+	if ( counters->available )
+	{
+		ioctl( counters->fdCycles, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+		ioctl( counters->fdCycles, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+	}
+#endif
+}
+
+static void ksBenchCounters_Stop( ksBenchCounters * counters )
+{
+#if defined( OS_LINUX )
+	if ( counters->available )
+	{
+		ioctl( counters->fdCycles, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+		unsigned long long values[3] = { 0, 0, 0 };	// nr, cycles, instructions
+		if ( read( counters->fdCycles, values, sizeof( values ) ) == (ssize_t)sizeof( values ) )
+		{
+			counters->cycles = values[1];
+			counters->instructions = values[2];
+		}
+	}
+#else
+	UNUSED_PARM( counters );
+#endif
+}
+
+/*
+================================================================================================================================
+
+Minimal JSON writer
+
+ksJsonWriter
+
+================================================================================================================================
+*/
+
+#define JSON_MAX_DEPTH		16
+
+typedef struct
+{
+	FILE *	fp;
+	int		depth;
+	bool	hasElements[JSON_MAX_DEPTH];
+} ksJsonWriter;
+
+static void ksJsonWriter_Create( ksJsonWriter * writer, FILE * fp )
+{
+	memset( writer, 0, sizeof( ksJsonWriter ) );
+	writer->fp = fp;
+}
+
+static void ksJsonWriter_WriteEscaped( ksJsonWriter * writer, const char * string )
+{
+	fputc( '"', writer->fp );
+	for ( const char * c = string; *c != '\0'; c++ )
+	{
+		switch ( *c )
+		{
+			case '"':	fputs( "\\\"", writer->fp ); break;
+			case '\\':	fputs( "\\\\", writer->fp ); break;
+			case '\n':	fputs( "\\n", writer->fp ); break;
+			case '\t':	fputs( "\\t", writer->fp ); break;
+			default:
+				if ( (unsigned char)*c >= 0x20 )
+				{
+					fputc( *c, writer->fp );
+				}
+				break;
+		}
+	}
+	fputc( '"', writer->fp );
+}
+
+// Writes the separator, indentation and optional key that precede every value.
+static void ksJsonWriter_BeginValue( ksJsonWriter * writer, const char * key )
+{
+	if ( writer->depth > 0 )
+	{
+		fputs( writer->hasElements[writer->depth] ? ",\n" : "\n", writer->fp );
+		writer->hasElements[writer->depth] = true;
+		for ( int i = 0; i < writer->depth; i++ )
+		{
+			fputc( '\t', writer->fp );
+		}
+	}
+	if ( key != NULL )
+	{
+		ksJsonWriter_WriteEscaped( writer, key );
+		fputs( ": ", writer->fp );
+	}
+}
+
+static void ksJsonWriter_Open( ksJsonWriter * writer, const char * key, const char bracket )
+{
+	ksJsonWriter_BeginValue( writer, key );
+	fputc( bracket, writer->fp );
+	assert( writer->depth + 1 < JSON_MAX_DEPTH );
+	writer->depth++;
+	writer->hasElements[writer->depth] = false;
+}
+
+static void ksJsonWriter_Close( ksJsonWriter * writer, const char bracket )
+{
+	const bool hadElements = writer->hasElements[writer->depth];
+	writer->depth--;
+	if ( hadElements )
+	{
+		fputc( '\n', writer->fp );
+		for ( int i = 0; i < writer->depth; i++ )
+		{
+			fputc( '\t', writer->fp );
+		}
+	}
+	fputc( bracket, writer->fp );
+	if ( writer->depth == 0 )
+	{
+		fputc( '\n', writer->fp );
+		fflush( writer->fp );
+	}
+}
+
+static void ksJsonWriter_BeginObject( ksJsonWriter * writer, const char * key ) { ksJsonWriter_Open( writer, key, '{' ); }
+static void ksJsonWriter_EndObject( ksJsonWriter * writer ) { ksJsonWriter_Close( writer, '}' ); }
+static void ksJsonWriter_BeginArray( ksJsonWriter * writer, const char * key ) { ksJsonWriter_Open( writer, key, '[' ); }
+static void ksJsonWriter_EndArray( ksJsonWriter * writer ) { ksJsonWriter_Close( writer, ']' ); }
+
+static void ksJsonWriter_String( ksJsonWriter * writer, const char * key, const char * value )
+{
+	ksJsonWriter_BeginValue( writer, key );
+	ksJsonWriter_WriteEscaped( writer, ( value != NULL ) ? value : "" );
+}
+
+static void ksJsonWriter_Int( ksJsonWriter * writer, const char * key, const long long value )
+{
+	ksJsonWriter_BeginValue( writer, key );
+	fprintf( writer->fp, "%lld", value );
+}
+
+// NaN and infinity are not valid JSON and are written as null.
+static void ksJsonWriter_Double( ksJsonWriter * writer, const char * key, const double value )
+{
+	ksJsonWriter_BeginValue( writer, key );
+	if ( isnan( value ) || isinf( value ) )
+	{
+		fputs( "null", writer->fp );
+	}
+	else
+	{
+		fprintf( writer->fp, "%.6g", value );
+	}
+}
+
+static void ksJsonWriter_Bool( ksJsonWriter * writer, const char * key, const bool value )
+{
+	ksJsonWriter_BeginValue( writer, key );
+	fputs( value ? "true" : "false", writer->fp );
+}
+
+/*
+================================================================================================================================
+
+Report header
+
+================================================================================================================================
+*/
+
+// Writes the fields shared by all benchmark reports. Must be called right after opening the root object.
+static void ksBench_WriteHeader( ksJsonWriter * writer, const char * benchmarkName )
+{
+	ksJsonWriter_String( writer, "benchmark", benchmarkName );
+	ksJsonWriter_String( writer, "os", GetOSVersion() );
+	ksJsonWriter_String( writer, "cpu", GetCPUVersion() );
+#if defined( NDEBUG )
+	ksJsonWriter_String( writer, "build", "release" );
+#else
+	ksJsonWriter_String( writer, "build", "debug" );
+#endif
+
+	// Results only compare between machines with the same core, SMT and cache layout.
+	ksCpuTopology topology;
+	ksCpuTopology_Create( &topology );
+	ksJsonWriter_BeginObject( writer, "topology" );
+	ksJsonWriter_Int( writer, "processors", topology.processorCount );
+	ksJsonWriter_Int( writer, "cores", topology.coreCount );
+	ksJsonWriter_Int( writer, "packages", topology.packageCount );
+	ksJsonWriter_Int( writer, "threads_per_core", topology.threadsPerCore );
+	ksJsonWriter_Int( writer, "fast_cores", topology.fastCoreCount );
+	ksJsonWriter_Int( writer, "last_level_caches", topology.lastLevelCacheCount );
+	if ( topology.maxFrequency > 0 )
+	{
+		ksJsonWriter_Int( writer, "max_frequency_mhz", topology.maxFrequency / 1000 );
+	}
+	else
+	{
+		ksJsonWriter_Double( writer, "max_frequency_mhz", NAN );
+	}
+	ksJsonWriter_BeginArray( writer, "caches" );
+	for ( int i = 0; i < topology.cacheCount; i++ )
+	{
+		ksJsonWriter_BeginObject( writer, NULL );
+		ksJsonWriter_Int( writer, "level", topology.caches[i].level );
+		ksJsonWriter_Int( writer, "size_kb", topology.caches[i].sizeKB );
+		ksJsonWriter_Int( writer, "shared_by", topology.caches[i].sharedBy );
+		ksJsonWriter_EndObject( writer );
+	}
+	ksJsonWriter_EndArray( writer );
+	ksJsonWriter_EndObject( writer );
+	ksCpuTopology_Destroy( &topology );
+}
+
+#endif // !KSBENCHUTIL_H
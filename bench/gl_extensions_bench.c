@@ -0,0 +1,383 @@
+/*
+================================================================================================
+
+Description	:	Startup benchmark for the OpenGL entry point and extension setup in gfxwrapper_opengl.c.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+Compares the two ways of getting the OpenGL entry points and extension flags ready when a
+context is created:
+
+	eager	resolve every entry point in gfxwrapper_opengl_functions.h up front, and answer every
+			extension check by walking the extension strings of the driver again
+	lazy	read the extension strings once into a ksStringSet and answer the checks from it,
+			and only resolve the entry points the application calls during startup, the way
+			the thunks of the lazy dispatch table do
+
+Both run the extension checks GlInitExtensions does on Windows and Linux, against an extension
+list of the size current desktop drivers report. The extension strings come from a driver stand-in,
+because glGetStringi needs a current context. Entry points are resolved through glXGetProcAddressARB
+when libGL can be loaded, which needs no context, and otherwise through a linear search of a table
+of names. The "resolver" field of the report tells the two apart.
+
+Before timing, both approaches must agree on every extension check and on every entry point they
+both resolve, or the process exits with a failure code.
+
+USAGE
+=====
+
+gl_extensions_bench [--quick] [--extensions <count>] [--out <file.json>]
+
+================================================================================================
+*/
+
+#include "benchutil.h"
+#include "utils/stringset.h"
+#include "gfxwrapper_opengl_functions.h"
+
+#if defined( OS_LINUX )
+	#include <dlfcn.h>
+#endif
+
+#define TIMING_TRIALS		5
+#define MAX_EXTENSIONS		4096
+
+/*
+================================================================================================================================
+
+Entry points and extensions
+
+================================================================================================================================
+*/
+
+#define FUNCTION_NAME( type, name, params, args )				#name,
+#define RETURNING_FUNCTION_NAME( type, ret, name, params, args )	#name,
+
+static const char * functionNames[] =
+{
+	GL_LAZY_FUNCTIONS( FUNCTION_NAME, RETURNING_FUNCTION_NAME )
+	GL_LAZY_WINDOWS_FUNCTIONS( FUNCTION_NAME, RETURNING_FUNCTION_NAME )
+};
+
+#define FUNCTION_COUNT		( (int)( sizeof( functionNames ) / sizeof( functionNames[0] ) ) )
+
+// The entry points the application calls before its first frame.
+static const char * startupFunctionNames[] =
+{
+	"glGetStringi",
+	"glGenFramebuffers",
+	"glBindFramebuffer",
+	"glFramebufferTexture2D",
+	"glCheckFramebufferStatus",
+	"glClientWaitSync"
+};
+
+#define STARTUP_FUNCTION_COUNT	( (int)( sizeof( startupFunctionNames ) / sizeof( startupFunctionNames[0] ) ) )
+
+// The checks of GlInitExtensions on Windows and Linux.
+static const char * checkedExtensions[] =
+{
+	"GL_EXT_timer_query",
+	"GL_EXT_buffer_storage",
+	"GL_ARB_texture_storage_multisample",
+	"GL_OVR_multiview2",
+	"GL_EXT_multisampled_render_to_texture",
+	"GL_OVR_multiview_multisampled_render_to_texture"
+};
+
+#define CHECKED_EXTENSION_COUNT	( (int)( sizeof( checkedExtensions ) / sizeof( checkedExtensions[0] ) ) )
+
+/*
+================================================================================================================================
+
+Driver stand-in
+
+================================================================================================================================
+*/
+
+typedef void ( *ksProc )();
+typedef ksProc ( *ksGetProcAddress )( const unsigned char * name );
+typedef const char * ( *ksGetStringi )( int index );
+
+typedef struct
+{
+	char			names[MAX_EXTENSIONS][64];
+	int				count;
+	ksGetProcAddress	getProcAddress;		// NULL when resolving through the table
+	const char *	resolverName;
+} ksDriver;
+
+static ksDriver driver;
+
+static const char * GetExtensionString( int index )
+{
+	return driver.names[index];
+}
+
+// Called through a volatile pointer, like a driver entry point, so the loops cannot be optimized around it.
+static volatile ksGetStringi getExtensionString = GetExtensionString;
+
+static void ksDriver_Create( ksDriver * d, const int extensionCount )
+{
+	static const char * prefixes[] = { "GL_ARB_", "GL_EXT_", "GL_NV_", "GL_AMD_", "GL_KHR_", "GL_INTEL_", "GL_NVX_", "GL_OES_" };
+	static const char * words[] = { "texture", "shader", "buffer", "sparse", "compute", "vertex", "framebuffer", "sample",
+									"image", "query", "draw", "program", "storage", "float", "depth", "stencil" };
+
+	d->count = ( extensionCount < MAX_EXTENSIONS ) ? extensionCount : MAX_EXTENSIONS;
+	for ( int i = 0; i < d->count; i++ )
+	{
+		snprintf( d->names[i], sizeof( d->names[i] ), "%s%s_%s_%d", prefixes[i % 8], words[( i / 8 ) % 16], words[( i * 7 + 3 ) % 16], i );
+	}
+	// Two of the checked extensions are present, in the middle and near the end of the list, the others are missing.
+	snprintf( d->names[d->count / 2], sizeof( d->names[0] ), "%s", "GL_ARB_texture_storage_multisample" );
+	snprintf( d->names[d->count - 3], sizeof( d->names[0] ), "%s", "GL_OVR_multiview2" );
+
+	d->getProcAddress = NULL;
+	d->resolverName = "table";
+#if defined( OS_LINUX )
+	void * libGL = dlopen( "libGL.so.1", RTLD_NOW | RTLD_LOCAL );
+	if ( libGL != NULL )
+	{
+		d->getProcAddress = (ksGetProcAddress)dlsym( libGL, "glXGetProcAddressARB" );
+		d->resolverName = ( d->getProcAddress != NULL ) ? "glXGetProcAddressARB" : "table";
+	}
+#endif
+}
+
+static void TableEntryPoint() {}
+
+static ksProc Resolve( const char * name )
+{
+	if ( driver.getProcAddress != NULL )
+	{
+		return driver.getProcAddress( (const unsigned char *)name );
+	}
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		if ( strcmp( functionNames[i], name ) == 0 )
+		{
+			return TableEntryPoint;
+		}
+	}
+	return NULL;
+}
+
+/*
+================================================================================================================================
+
+Startup
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	ksProc		functions[FUNCTION_COUNT];
+	bool		extensions[CHECKED_EXTENSION_COUNT];
+	ksStringSet	extensionNames;
+} ksStartup;
+
+static int FindFunction( const char * name )
+{
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		if ( strcmp( functionNames[i], name ) == 0 )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+// The previous GlCheckExtension: one walk of the extension strings per check.
+static bool CheckExtensionLinear( const char * extension )
+{
+	const int count = driver.count;
+	for ( int i = 0; i < count; i++ )
+	{
+		if ( strcmp( getExtensionString( i ), extension ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void StartupEager( ksStartup * startup )
+{
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		startup->functions[i] = Resolve( functionNames[i] );
+	}
+	for ( int i = 0; i < CHECKED_EXTENSION_COUNT; i++ )
+	{
+		startup->extensions[i] = CheckExtensionLinear( checkedExtensions[i] );
+	}
+}
+
+static void StartupLazy( ksStartup * startup, const int * startupFunctions )
+{
+	const int count = driver.count;
+	ksStringSet_Destroy( &startup->extensionNames );
+	ksStringSet_Create( &startup->extensionNames, count );
+	for ( int i = 0; i < count; i++ )
+	{
+		ksStringSet_Add( &startup->extensionNames, getExtensionString( i ) );
+	}
+	for ( int i = 0; i < CHECKED_EXTENSION_COUNT; i++ )
+	{
+		startup->extensions[i] = ksStringSet_Contains( &startup->extensionNames, checkedExtensions[i] );
+	}
+	for ( int i = 0; i < STARTUP_FUNCTION_COUNT; i++ )
+	{
+		startup->functions[startupFunctions[i]] = Resolve( functionNames[startupFunctions[i]] );
+	}
+}
+
+static bool Validate( const int * startupFunctions )
+{
+	ksStartup eager;
+	ksStartup lazy;
+	memset( &eager, 0, sizeof( eager ) );
+	memset( &lazy, 0, sizeof( lazy ) );
+	StartupEager( &eager );
+	StartupLazy( &lazy, startupFunctions );
+
+	bool valid = ( ksStringSet_GetCount( &lazy.extensionNames ) == driver.count );
+	for ( int i = 0; i < CHECKED_EXTENSION_COUNT; i++ )
+	{
+		valid = valid && ( eager.extensions[i] == lazy.extensions[i] );
+	}
+	valid = valid && eager.extensions[2] && eager.extensions[3] && !eager.extensions[0];
+	for ( int i = 0; i < STARTUP_FUNCTION_COUNT; i++ )
+	{
+		const int f = startupFunctions[i];
+		valid = valid && ( lazy.functions[f] != NULL ) && ( lazy.functions[f] == eager.functions[f] );
+	}
+	ksStringSet_Destroy( &lazy.extensionNames );
+	return valid;
+}
+
+static double TimeStartup( const bool lazy, const int * startupFunctions, const int rounds )
+{
+	ksStartup startup;
+	memset( &startup, 0, sizeof( startup ) );
+
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			if ( lazy )
+			{
+				StartupLazy( &startup, startupFunctions );
+			}
+			else
+			{
+				StartupEager( &startup );
+			}
+			ksBench_ClobberMemory();
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	ksStringSet_Destroy( &startup.extensionNames );
+	return best;
+}
+
+static void WriteTiming( ksJsonWriter * writer, const char * name, const int resolved, const int rounds, const double bestNanoseconds )
+{
+	ksJsonWriter_BeginObject( writer, NULL );
+	ksJsonWriter_String( writer, "name", name );
+	ksJsonWriter_Int( writer, "resolved_functions", resolved );
+	ksJsonWriter_Int( writer, "extension_checks", CHECKED_EXTENSION_COUNT );
+	ksJsonWriter_Int( writer, "ops", rounds );
+	ksJsonWriter_Double( writer, "ns_per_op", bestNanoseconds / (double)rounds );
+	ksJsonWriter_EndObject( writer );
+}
+
+int main( int argc, char * argv[] )
+{
+	const char * outFileName = NULL;
+	int extensionCount = 400;
+	int rounds = 2000;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "--quick" ) == 0 )
+		{
+			rounds = 200;
+		}
+		else if ( strcmp( argv[i], "--extensions" ) == 0 && i + 1 < argc )
+		{
+			extensionCount = atoi( argv[++i] );
+			extensionCount = ( extensionCount < 8 ) ? 8 : ( ( extensionCount > MAX_EXTENSIONS ) ? MAX_EXTENSIONS : extensionCount );
+		}
+		else if ( strcmp( argv[i], "--out" ) == 0 && i + 1 < argc )
+		{
+			outFileName = argv[++i];
+		}
+		else
+		{
+			fprintf( stderr, "Usage: %s [--quick] [--extensions <count>] [--out <file.json>]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE * fp = stdout;
+	if ( outFileName != NULL )
+	{
+		fp = fopen( outFileName, "w" );
+		if ( fp == NULL )
+		{
+			fprintf( stderr, "Failed to open %s\n", outFileName );
+			return EXIT_FAILURE;
+		}
+	}
+
+	ksDriver_Create( &driver, extensionCount );
+
+	int startupFunctions[STARTUP_FUNCTION_COUNT];
+	bool valid = true;
+	for ( int i = 0; i < STARTUP_FUNCTION_COUNT; i++ )
+	{
+		startupFunctions[i] = FindFunction( startupFunctionNames[i] );
+		valid = valid && ( startupFunctions[i] >= 0 );
+	}
+	valid = valid && Validate( startupFunctions );
+
+	ksJsonWriter writer;
+	ksJsonWriter_Create( &writer, fp );
+	ksJsonWriter_BeginObject( &writer, NULL );
+	ksBench_WriteHeader( &writer, "gl_extensions" );
+	ksJsonWriter_String( &writer, "resolver", driver.resolverName );
+	ksJsonWriter_Int( &writer, "extensions", driver.count );
+	ksJsonWriter_Int( &writer, "functions", FUNCTION_COUNT );
+
+	ksJsonWriter_BeginArray( &writer, "timings" );
+	if ( valid )
+	{
+		WriteTiming( &writer, "eager", FUNCTION_COUNT, rounds, TimeStartup( false, startupFunctions, rounds ) );
+		WriteTiming( &writer, "lazy", STARTUP_FUNCTION_COUNT, rounds, TimeStartup( true, startupFunctions, rounds ) );
+	}
+	ksJsonWriter_EndArray( &writer );
+
+	ksJsonWriter_Bool( &writer, "validated", valid );
+	ksJsonWriter_EndObject( &writer );
+
+	if ( fp != stdout )
+	{
+		fclose( fp );
+	}
+	if ( !valid )
+	{
+		fprintf( stderr, "Eager and lazy startup disagree\n" );
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
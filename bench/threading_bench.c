@@ -0,0 +1,828 @@
+/*
+================================================================================================
+
+Description	:	Micro benchmark and stress test for the job system in utils/threading.h.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+Measures the cost of getting work onto the job system and the scaling of parallel-for
+over frame style workloads:
+
+	submit_wait		submit a single empty job and wait for it, the dispatch round trip
+	empty_jobs		submit a burst of empty jobs against one counter and wait for all of them
+	continuation	release a job through a dependency counter and wait for it
+	parallel_for	transform an array with ksJobSystem_ParallelFor at every thread count,
+					against a serial loop over the same array
+
+and the synchronization primitives the job system is built on:
+
+	signal_raise		raise and consume an auto-reset signal that nobody waits on
+	signal_wake			wake latency, half the round trip of two threads waking each other through signals
+	mutex_uncontended	lock and unlock a mutex from a single thread
+	mutex_contended		all threads increment a shared counter under one mutex, per lock
+
+and the lock-free data exchange primitives, each validated while it is timed:
+
+	spsc_queue			one producer thread streams items to the consumer
+	mpmc_queue			1 to N producer threads stream items to one consumer, which checks that
+						every item arrives exactly once and in order per producer
+	mailbox				a writer publishes snapshots while a reader checks every read for tearing
+	triple_buffer		a writer publishes frames while a reader checks every frame for tearing
+
+On Linux ksSignal and ksMutex use futexes unless THREADING_DISABLE_FUTEX is defined. The build
+also produces threading_bench_pthread with the pthread implementation, and the "sync" field of the
+report tells the two apart.
+
+Before timing, a stress pass validates that every index of a parallel-for is visited
+exactly once and that continuations only run after all jobs of their dependency finished.
+It also checks that a job submitted on a worker thread from another translation unit goes to
+the deque of that worker instead of the shared inject queue.
+The process exits with a failure code if the validation fails.
+
+USAGE
+=====
+
+threading_bench [--quick] [--threads <count>] [--out <file.json>]
+
+================================================================================================
+*/
+
+#include "benchutil.h"
+#include "utils/threading.h"
+
+#define TIMING_TRIALS		5
+#define MAX_ELEMENTS		( 1 << 20 )
+
+/*
+================================================================================================================================
+
+Workloads
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	const float *	input;
+	float *			output;
+	int				iterations;		// arithmetic per element, to model light and heavy frame work
+} ksTransformJob;
+
+static void EmptyJob( void * data )
+{
+	UNUSED_PARM( data );
+}
+
+static void TransformRange( void * data, const int begin, const int end )
+{
+	ksTransformJob * job = (ksTransformJob *)data;
+	for ( int i = begin; i < end; i++ )
+	{
+		float x = job->input[i];
+		for ( int j = 0; j < job->iterations; j++ )
+		{
+			x = x * 0.999f + 0.5f / ( 1.0f + x * x );
+		}
+		job->output[i] = x;
+	}
+}
+
+/*
+================================================================================================================================
+
+Validation
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	ksAtomicInt64 *	visits;
+	ksAtomicInt64	finished;
+	ksAtomicInt64	failures;
+	int				expected;
+} ksValidationJob;
+
+static void CountVisits( void * data, const int begin, const int end )
+{
+	ksValidationJob * job = (ksValidationJob *)data;
+	for ( int i = begin; i < end; i++ )
+	{
+		ksAtomicInt64_Add( &job->visits[i], 1 );
+	}
+}
+
+static void FinishJob( void * data )
+{
+	ksValidationJob * job = (ksValidationJob *)data;
+	ksAtomicInt64_Add( &job->finished, 1 );
+}
+
+static void CheckFinished( void * data )
+{
+	ksValidationJob * job = (ksValidationJob *)data;
+	if ( ksAtomicInt64_LoadAcquire( &job->finished ) != job->expected )
+	{
+		ksAtomicInt64_Add( &job->failures, 1 );
+	}
+}
+
+static bool Validate( ksJobSystem * jobSystem, const int rounds )
+{
+	const int count = 100003;
+	ksValidationJob job;
+	job.visits = (ksAtomicInt64 *)calloc( count, sizeof( ksAtomicInt64 ) );
+	job.failures = 0;
+
+	for ( int round = 0; round < rounds; round++ )
+	{
+		// Every index is visited exactly once, for small and automatic grains.
+		memset( job.visits, 0, count * sizeof( ksAtomicInt64 ) );
+		ksJobSystem_ParallelFor( jobSystem, CountVisits, &job, count, ( round & 1 ) ? 7 : 0, NULL );
+		for ( int i = 0; i < count; i++ )
+		{
+			if ( job.visits[i] != 1 )
+			{
+				job.failures++;
+				break;
+			}
+		}
+
+		// Continuations run after all jobs of their dependency.
+		ksJobCounter dependency;
+		ksJobCounter done;
+		ksJobCounter_Create( &dependency );
+		ksJobCounter_Create( &done );
+		job.finished = 0;
+		job.expected = 64;
+		for ( int i = 0; i < job.expected; i++ )
+		{
+			ksJobSystem_Submit( jobSystem, FinishJob, &job, &dependency );
+		}
+		for ( int i = 0; i < 4; i++ )
+		{
+			ksJobSystem_SubmitAfter( jobSystem, &dependency, CheckFinished, &job, &done );
+		}
+		ksJobSystem_Wait( jobSystem, &done );
+		if ( !ksJobCounter_IsDone( &dependency ) )
+		{
+			job.failures++;
+		}
+	}
+
+	free( job.visits );
+	return ( job.failures == 0 );
+}
+
+// Defined in threading_bench_unit.c.
+void SubmitFromOtherUnit( ksJobSystem * jobSystem, ksJobFunction function, void * data, ksJobCounter * counter );
+
+typedef struct
+{
+	ksJobSystem *	jobSystem;
+	ksJobCounter	counter;
+	ksAtomicInt64	checked;
+	bool			local;
+} ksLocalSubmitJob;
+
+static void SubmitLocal( void * data )
+{
+	ksLocalSubmitJob * job = (ksLocalSubmitJob *)data;
+	// The only worker thread runs this and the main thread does not steal, so the job stays where it was put.
+	ksJobWorker * worker = &job->jobSystem->workers[1];
+	const long long injected = ksAtomicInt64_LoadAcquire( &job->jobSystem->injectCount );
+	SubmitFromOtherUnit( job->jobSystem, EmptyJob, NULL, &job->counter );
+	job->local = !ksJobDeque_IsEmpty( &worker->deque ) && ksAtomicInt64_LoadAcquire( &job->jobSystem->injectCount ) == injected;
+	ksAtomicInt64_StoreRelease( &job->checked, 1 );
+}
+
+static bool ValidateLocalSubmit()
+{
+	ksJobSystem jobSystem;
+	ksJobSystem_Create( &jobSystem, 1, NULL );
+
+	ksLocalSubmitJob job;
+	job.jobSystem = &jobSystem;
+	ksJobCounter_Create( &job.counter );
+	job.checked = 0;
+	job.local = false;
+	ksJobSystem_Submit( &jobSystem, SubmitLocal, &job, &job.counter );
+	while ( ksAtomicInt64_LoadAcquire( &job.checked ) == 0 )
+	{
+		ksAtomic_Pause();
+	}
+	ksJobSystem_Wait( &jobSystem, &job.counter );
+
+	ksJobSystem_Destroy( &jobSystem );
+	return job.local;
+}
+
+/*
+================================================================================================================================
+
+Timing
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	ksSignal		ping;
+	ksSignal		pong;
+	ksMutex			mutex;
+	int				rounds;
+	long long		counter;
+} ksSyncTest;
+
+static void PongThread( void * data )
+{
+	ksSyncTest * test = (ksSyncTest *)data;
+	for ( int i = 0; i < test->rounds; i++ )
+	{
+		ksSignal_Wait( &test->ping, SIGNAL_TIMEOUT_INFINITE );
+		ksSignal_Raise( &test->pong );
+	}
+}
+
+static void LockThread( void * data )
+{
+	ksSyncTest * test = (ksSyncTest *)data;
+	for ( int i = 0; i < test->rounds; i++ )
+	{
+		ksMutex_Lock( &test->mutex, true );
+		test->counter++;
+		ksMutex_Unlock( &test->mutex );
+	}
+}
+
+static void WriteTiming( ksJsonWriter * writer, const char * name, const int threads, const long long ops, const double bestNanoseconds )
+{
+	ksJsonWriter_BeginObject( writer, NULL );
+	ksJsonWriter_String( writer, "name", name );
+	ksJsonWriter_Int( writer, "threads", threads );
+	ksJsonWriter_Int( writer, "ops", ops );
+	ksJsonWriter_Double( writer, "ns_per_op", bestNanoseconds / (double)ops );
+	ksJsonWriter_Double( writer, "ops_per_sec", (double)ops * 1e9 / bestNanoseconds );
+	ksJsonWriter_EndObject( writer );
+}
+
+static double TimeSubmitWait( ksJobSystem * jobSystem, const int rounds )
+{
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			ksJobCounter counter;
+			ksJobCounter_Create( &counter );
+			ksJobSystem_Submit( jobSystem, EmptyJob, NULL, &counter );
+			ksJobSystem_Wait( jobSystem, &counter );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	return best;
+}
+
+static double TimeEmptyJobs( ksJobSystem * jobSystem, const int jobs )
+{
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		ksJobCounter counter;
+		ksJobCounter_Create( &counter );
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < jobs; i++ )
+		{
+			ksJobSystem_Submit( jobSystem, EmptyJob, NULL, &counter );
+		}
+		ksJobSystem_Wait( jobSystem, &counter );
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	return best;
+}
+
+static double TimeContinuation( ksJobSystem * jobSystem, const int rounds )
+{
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			ksJobCounter dependency;
+			ksJobCounter done;
+			ksJobCounter_Create( &dependency );
+			ksJobCounter_Create( &done );
+			ksJobSystem_Submit( jobSystem, EmptyJob, NULL, &dependency );
+			ksJobSystem_SubmitAfter( jobSystem, &dependency, EmptyJob, NULL, &done );
+			ksJobSystem_Wait( jobSystem, &done );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	return best;
+}
+
+static double TimeSignalRaise( const int rounds )
+{
+	ksSignal signal;
+	ksSignal_Create( &signal, true );
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			ksSignal_Raise( &signal );
+			ksSignal_Wait( &signal, 0 );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	ksSignal_Destroy( &signal );
+	return best;
+}
+
+// Returns the time of 'rounds' round trips.
+static double TimeSignalWake( const int rounds )
+{
+	ksSyncTest test;
+	ksSignal_Create( &test.ping, true );
+	ksSignal_Create( &test.pong, true );
+	test.rounds = rounds;
+
+	ksThread thread;
+	ksThread_Create( &thread, "pong", PongThread, &test );
+
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		ksThread_Signal( &thread );
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < rounds; i++ )
+		{
+			ksSignal_Raise( &test.ping );
+			ksSignal_Wait( &test.pong, SIGNAL_TIMEOUT_INFINITE );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+		ksThread_Join( &thread );
+	}
+
+	ksThread_Destroy( &thread );
+	ksSignal_Destroy( &test.ping );
+	ksSignal_Destroy( &test.pong );
+	return best;
+}
+
+// Returns the time for 'threads' threads to each lock the mutex 'rounds' times, and false in 'valid' if an increment was lost.
+static double TimeMutex( const int threads, const int rounds, bool * valid )
+{
+	ksSyncTest test;
+	ksMutex_Create( &test.mutex );
+	test.rounds = rounds;
+
+	ksThread * lockThreads = (ksThread *)malloc( threads * sizeof( ksThread ) );
+	for ( int i = 1; i < threads; i++ )
+	{
+		ksThread_Create( &lockThreads[i], "lock", LockThread, &test );
+	}
+
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		test.counter = 0;
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 1; i < threads; i++ )
+		{
+			ksThread_Signal( &lockThreads[i] );
+		}
+		LockThread( &test );
+		for ( int i = 1; i < threads; i++ )
+		{
+			ksThread_Join( &lockThreads[i] );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+		*valid = ( test.counter == (long long)threads * rounds ) && *valid;
+	}
+
+	for ( int i = 1; i < threads; i++ )
+	{
+		ksThread_Destroy( &lockThreads[i] );
+	}
+	free( lockThreads );
+	ksMutex_Destroy( &test.mutex );
+	return best;
+}
+
+/*
+================================================================================================================================
+
+Lock-free queues
+
+================================================================================================================================
+*/
+
+#define QUEUE_CAPACITY		1024
+#define SNAPSHOT_WORDS		7				// a pose with velocities
+#define FRAME_WORDS			64
+
+typedef struct
+{
+	int		producer;
+	int		sequence;
+} ksQueueItem;
+
+typedef struct
+{
+	ksSpscQueue		spsc;
+	ksMpmcQueue		mpmc;
+	ksMailbox		mailbox;
+	ksTripleBuffer	tripleBuffer;
+	ksAtomicInt64	nextProducer;
+	int				items;					// per producer
+} ksQueueTest;
+
+static void SpscProducer( void * data )
+{
+	ksQueueTest * test = (ksQueueTest *)data;
+	for ( int i = 0; i < test->items; i++ )
+	{
+		const ksQueueItem item = { 0, i };
+		while ( !ksSpscQueue_Push( &test->spsc, &item ) )
+		{
+			ksJobSystem_Yield();
+		}
+	}
+}
+
+static void MpmcProducer( void * data )
+{
+	ksQueueTest * test = (ksQueueTest *)data;
+	const int producer = (int)ksAtomicInt64_Add( &test->nextProducer, 1 ) - 1;
+	for ( int i = 0; i < test->items; i++ )
+	{
+		const ksQueueItem item = { producer, i };
+		while ( !ksMpmcQueue_Push( &test->mpmc, &item ) )
+		{
+			ksJobSystem_Yield();
+		}
+	}
+}
+
+static void MailboxWriter( void * data )
+{
+	ksQueueTest * test = (ksQueueTest *)data;
+	long long snapshot[SNAPSHOT_WORDS];
+	for ( long long i = 1; i <= test->items; i++ )
+	{
+		for ( int j = 0; j < SNAPSHOT_WORDS; j++ )
+		{
+			snapshot[j] = i;
+		}
+		ksMailbox_Publish( &test->mailbox, snapshot );
+	}
+}
+
+static void TripleBufferWriter( void * data )
+{
+	ksQueueTest * test = (ksQueueTest *)data;
+	for ( long long i = 1; i <= test->items; i++ )
+	{
+		long long * frame = (long long *)ksTripleBuffer_GetWriteBuffer( &test->tripleBuffer );
+		for ( int j = 0; j < FRAME_WORDS; j++ )
+		{
+			frame[j] = i;
+		}
+		ksTripleBuffer_Publish( &test->tripleBuffer );
+	}
+}
+
+// Consumes everything the producers push and returns false if an item was lost, duplicated or reordered.
+static bool ConsumeQueue( ksQueueTest * test, const bool multiProducer, const int producers )
+{
+	int * expected = (int *)calloc( producers, sizeof( int ) );
+	bool valid = true;
+	for ( long long remaining = (long long)producers * test->items; remaining > 0; )
+	{
+		ksQueueItem item;
+		const bool popped = multiProducer ? ksMpmcQueue_Pop( &test->mpmc, &item ) : ksSpscQueue_Pop( &test->spsc, &item );
+		if ( !popped )
+		{
+			ksJobSystem_Yield();
+			continue;
+		}
+		if ( item.producer < 0 || item.producer >= producers || item.sequence != expected[item.producer] )
+		{
+			valid = false;
+		}
+		else
+		{
+			expected[item.producer]++;
+		}
+		remaining--;
+	}
+	free( expected );
+	return valid;
+}
+
+// Reads until the last value was seen and returns false if a read was torn or went back in time.
+static bool ReadMailbox( ksQueueTest * test )
+{
+	bool valid = true;
+	long long latest = 0;
+	while ( latest < test->items )
+	{
+		long long snapshot[SNAPSHOT_WORDS];
+		const long long version = ksMailbox_Read( &test->mailbox, snapshot );
+		if ( version == latest )
+		{
+			ksJobSystem_Yield();
+			continue;
+		}
+		for ( int j = 0; j < SNAPSHOT_WORDS; j++ )
+		{
+			valid = ( snapshot[j] == version ) && valid;
+		}
+		valid = ( version > latest ) && valid;
+		latest = version;
+	}
+	return valid;
+}
+
+static bool ReadTripleBuffer( ksQueueTest * test )
+{
+	bool valid = true;
+	long long latest = 0;
+	while ( latest < test->items )
+	{
+		bool isNew = false;
+		const long long * frame = (const long long *)ksTripleBuffer_GetReadBuffer( &test->tripleBuffer, &isNew );
+		if ( !isNew )
+		{
+			ksJobSystem_Yield();
+			continue;
+		}
+		for ( int j = 0; j < FRAME_WORDS; j++ )
+		{
+			valid = ( frame[j] == frame[0] ) && valid;
+		}
+		valid = ( frame[0] > latest ) && valid;
+		latest = frame[0];
+	}
+	return valid;
+}
+
+typedef enum
+{
+	EXCHANGE_SPSC_QUEUE,
+	EXCHANGE_MPMC_QUEUE,
+	EXCHANGE_MAILBOX,
+	EXCHANGE_TRIPLE_BUFFER
+} ksExchangeType;
+
+// Returns the time for 'producers' threads to hand over 'items' items each to the calling thread.
+static double TimeExchange( const ksExchangeType type, const int producers, const int items, bool * valid )
+{
+	ksQueueTest test;
+	ksSpscQueue_Create( &test.spsc, sizeof( ksQueueItem ), QUEUE_CAPACITY );
+	ksMpmcQueue_Create( &test.mpmc, sizeof( ksQueueItem ), QUEUE_CAPACITY );
+	ksMailbox_Create( &test.mailbox, SNAPSHOT_WORDS * sizeof( long long ) );
+	ksTripleBuffer_Create( &test.tripleBuffer, FRAME_WORDS * sizeof( long long ) );
+	test.items = items;
+
+	const ksThreadFunction producerFunctions[] = { SpscProducer, MpmcProducer, MailboxWriter, TripleBufferWriter };
+	ksThread * threads = (ksThread *)malloc( producers * sizeof( ksThread ) );
+	for ( int i = 0; i < producers; i++ )
+	{
+		ksThread_Create( &threads[i], "producer", producerFunctions[type], &test );
+	}
+
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		test.nextProducer = 0;
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < producers; i++ )
+		{
+			ksThread_Signal( &threads[i] );
+		}
+		bool trialValid = true;
+		switch ( type )
+		{
+			case EXCHANGE_SPSC_QUEUE:		trialValid = ConsumeQueue( &test, false, 1 ); break;
+			case EXCHANGE_MPMC_QUEUE:		trialValid = ConsumeQueue( &test, true, producers ); break;
+			case EXCHANGE_MAILBOX:			trialValid = ReadMailbox( &test ); break;
+			case EXCHANGE_TRIPLE_BUFFER:	trialValid = ReadTripleBuffer( &test ); break;
+		}
+		for ( int i = 0; i < producers; i++ )
+		{
+			ksThread_Join( &threads[i] );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+		*valid = trialValid && *valid;
+
+		// The mailbox and triple buffer versions restart from zero.
+		ksMailbox_Destroy( &test.mailbox );
+		ksMailbox_Create( &test.mailbox, SNAPSHOT_WORDS * sizeof( long long ) );
+		ksTripleBuffer_Destroy( &test.tripleBuffer );
+		ksTripleBuffer_Create( &test.tripleBuffer, FRAME_WORDS * sizeof( long long ) );
+	}
+
+	for ( int i = 0; i < producers; i++ )
+	{
+		ksThread_Destroy( &threads[i] );
+	}
+	free( threads );
+	ksTripleBuffer_Destroy( &test.tripleBuffer );
+	ksMailbox_Destroy( &test.mailbox );
+	ksMpmcQueue_Destroy( &test.mpmc );
+	ksSpscQueue_Destroy( &test.spsc );
+	return best;
+}
+
+static double TimeParallelFor( ksJobSystem * jobSystem, ksTransformJob * job, const int count )
+{
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		if ( jobSystem != NULL )
+		{
+			ksJobSystem_ParallelFor( jobSystem, TransformRange, job, count, 0, NULL );
+		}
+		else
+		{
+			TransformRange( job, 0, count );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	return best;
+}
+
+int main( int argc, char * argv[] )
+{
+	const char * outFileName = NULL;
+	int maxThreads = ksJobSystem_GetProcessorCount();
+	int rounds = 20000;
+	int elements = MAX_ELEMENTS;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "--quick" ) == 0 )
+		{
+			rounds = 2000;
+			elements = MAX_ELEMENTS / 8;
+		}
+		else if ( strcmp( argv[i], "--threads" ) == 0 && i + 1 < argc )
+		{
+			maxThreads = atoi( argv[++i] );
+			maxThreads = ( maxThreads > 0 ) ? maxThreads : 1;
+		}
+		else if ( strcmp( argv[i], "--out" ) == 0 && i + 1 < argc )
+		{
+			outFileName = argv[++i];
+		}
+		else
+		{
+			fprintf( stderr, "Usage: %s [--quick] [--threads <count>] [--out <file.json>]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE * fp = stdout;
+	if ( outFileName != NULL )
+	{
+		fp = fopen( outFileName, "w" );
+		if ( fp == NULL )
+		{
+			fprintf( stderr, "Failed to open %s\n", outFileName );
+			return EXIT_FAILURE;
+		}
+	}
+
+	float * input = (float *)malloc( MAX_ELEMENTS * sizeof( float ) );
+	float * output = (float *)malloc( MAX_ELEMENTS * sizeof( float ) );
+	for ( int i = 0; i < MAX_ELEMENTS; i++ )
+	{
+		input[i] = (float)( i % 1000 ) * 0.001f;
+	}
+
+	ksJsonWriter writer;
+	ksJsonWriter_Create( &writer, fp );
+	ksJsonWriter_BeginObject( &writer, NULL );
+	ksBench_WriteHeader( &writer, "threading" );
+	ksJsonWriter_Int( &writer, "processors", ksJobSystem_GetProcessorCount() );
+#if defined( THREADING_FUTEX )
+	ksJsonWriter_String( &writer, "sync", "futex" );
+#else
+	ksJsonWriter_String( &writer, "sync", "pthread" );
+#endif
+
+	// The placement a job system with an automatic worker count would use on this machine.
+	ksCpuTopology topology;
+	ksCpuThreadPlacement placement;
+	ksCpuTopology_Create( &topology );
+	ksCpuThreadPlacement_Create( &placement, &topology );
+	ksJsonWriter_BeginObject( &writer, "placement" );
+	ksJsonWriter_Int( &writer, "frame_processor", placement.frameProcessor );
+	ksJsonWriter_Int( &writer, "pacing_processor", placement.pacingProcessor );
+	ksJsonWriter_BeginArray( &writer, "worker_processors" );
+	for ( int i = 0; i < placement.workerCount; i++ )
+	{
+		ksJsonWriter_Int( &writer, NULL, placement.workerProcessors[i] );
+	}
+	ksJsonWriter_EndArray( &writer );
+	ksJsonWriter_EndObject( &writer );
+	ksCpuThreadPlacement_Destroy( &placement );
+	ksCpuTopology_Destroy( &topology );
+
+	bool valid = true;
+	ksJsonWriter_BeginArray( &writer, "timings" );
+
+	WriteTiming( &writer, "signal_raise", 1, rounds, TimeSignalRaise( rounds ) );
+	WriteTiming( &writer, "signal_wake", 2, 2 * rounds, TimeSignalWake( rounds ) );
+	WriteTiming( &writer, "mutex_uncontended", 1, rounds, TimeMutex( 1, rounds, &valid ) );
+	for ( int threads = 2; ; threads = ( threads * 2 < maxThreads ) ? threads * 2 : maxThreads )
+	{
+		WriteTiming( &writer, "mutex_contended", threads, (long long)threads * rounds, TimeMutex( threads, rounds, &valid ) );
+		if ( threads >= maxThreads )
+		{
+			break;
+		}
+	}
+
+	const int items = rounds * 10;
+	WriteTiming( &writer, "spsc_queue", 2, items, TimeExchange( EXCHANGE_SPSC_QUEUE, 1, items, &valid ) );
+	for ( int producers = 1; ; producers = ( producers * 2 < maxThreads ) ? producers * 2 : maxThreads )
+	{
+		WriteTiming( &writer, "mpmc_queue", producers + 1, (long long)producers * items, TimeExchange( EXCHANGE_MPMC_QUEUE, producers, items, &valid ) );
+		if ( producers >= maxThreads )
+		{
+			break;
+		}
+	}
+	WriteTiming( &writer, "mailbox", 2, items, TimeExchange( EXCHANGE_MAILBOX, 1, items, &valid ) );
+	WriteTiming( &writer, "triple_buffer", 2, items, TimeExchange( EXCHANGE_TRIPLE_BUFFER, 1, items, &valid ) );
+	valid = ValidateLocalSubmit() && valid;
+	for ( int threads = 1; ; threads = ( threads * 2 < maxThreads ) ? threads * 2 : maxThreads )
+	{
+		ksJobSystem jobSystem;
+		ksJobSystem_Create( &jobSystem, threads - 1, NULL );
+
+		valid = Validate( &jobSystem, 8 ) && valid;
+
+		WriteTiming( &writer, "submit_wait", threads, rounds, TimeSubmitWait( &jobSystem, rounds ) );
+		WriteTiming( &writer, "empty_jobs", threads, rounds, TimeEmptyJobs( &jobSystem, rounds ) );
+		WriteTiming( &writer, "continuation", threads, rounds, TimeContinuation( &jobSystem, rounds ) );
+
+		const int workloads[] = { 4, 64 };
+		for ( int w = 0; w < (int)( sizeof( workloads ) / sizeof( workloads[0] ) ); w++ )
+		{
+			ksTransformJob job = { input, output, workloads[w] };
+			char name[64];
+			snprintf( name, sizeof( name ), "parallel_for_%d", workloads[w] );
+			WriteTiming( &writer, name, threads, elements, TimeParallelFor( &jobSystem, &job, elements ) );
+			if ( threads == 1 )
+			{
+				snprintf( name, sizeof( name ), "serial_for_%d", workloads[w] );
+				WriteTiming( &writer, name, 1, elements, TimeParallelFor( NULL, &job, elements ) );
+			}
+		}
+
+		ksJobSystem_Destroy( &jobSystem );
+
+		if ( threads == maxThreads )
+		{
+			break;
+		}
+	}
+	ksJsonWriter_EndArray( &writer );
+
+	ksJsonWriter_Bool( &writer, "validated", valid );
+	ksJsonWriter_EndObject( &writer );
+
+	free( input );
+	free( output );
+
+	if ( fp != stdout )
+	{
+		fclose( fp );
+	}
+	if ( !valid )
+	{
+		fprintf( stderr, "Job system validation failed\n" );
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
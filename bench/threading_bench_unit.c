@@ -0,0 +1,27 @@
+/*
+================================================================================================
+
+Description	:	Second translation unit of threading_bench.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+utils/threading.h only has static functions, so every translation unit that includes it gets
+its own copy of them, and of any static state. Submitting from here checks that a worker thread
+started by threading_bench.c is still recognized by the copy in this translation unit.
+
+================================================================================================
+*/
+
+#include "benchutil.h"
+#include "utils/threading.h"
+
+void SubmitFromOtherUnit( ksJobSystem * jobSystem, ksJobFunction function, void * data, ksJobCounter * counter );
+
+void SubmitFromOtherUnit( ksJobSystem * jobSystem, ksJobFunction function, void * data, ksJobCounter * counter )
+{
+	ksJobSystem_Submit( jobSystem, function, data, counter );
+}
@@ -0,0 +1,437 @@
+/*
+================================================================================================
+
+Description	:	Cost and accuracy of the OpenXR call profiler, against a stand-in runtime.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+The XR_DISPATCH_PROBES build of XRApp points every entry of its dispatch table at a probe that
+times the call and records it in a ksCallProfiler (utils/callprofiler.h). This benchmark builds
+the same kind of table over a stand-in runtime, so it runs without a headset or OpenXR runtime:
+
+	overhead	calls an entry point that returns right away, through the plain table and through
+				the probed table. Without probes the table holds the entry points themselves, so
+				the plain table is also the cost of a build with profiling disabled.
+	frames		runs a frame loop on the probed table: a blocking wait frame on a fixed display
+				period, begin frame, locate views, two swapchain images and end frame, while an
+				input thread syncs actions. One frame stalls in the swapchain image wait.
+
+The frame loop is validated: the call counts of the profiler must match the calls made, the
+stall must show as the longest swapchain image wait and in the per frame statistics of its
+frame, and the percentile bounds must hold the latencies of the stand-in functions.
+
+USAGE
+=====
+
+xr_profiler_bench [--quick] [--out <file.json>]
+
+================================================================================================
+*/
+
+#include "benchutil.h"
+#include "utils/threading.h"
+#include "utils/callprofiler.h"
+
+#define TIMING_TRIALS		5
+#define ACTION_COUNT		4
+#define STALL_PERIODS		3
+
+/*
+================================================================================================================================
+
+Stand-in runtime
+
+All entry points share one signature, the probes only forward the arguments.
+
+================================================================================================================================
+*/
+
+typedef int (*ksXrFunction)( void * handle, const void * info, void * output );
+
+#define STAND_IN_FUNCTIONS( FUNCTION ) \
+	FUNCTION( WaitFrame ) \
+	FUNCTION( BeginFrame ) \
+	FUNCTION( LocateViews ) \
+	FUNCTION( AcquireSwapchainImage ) \
+	FUNCTION( WaitSwapchainImage ) \
+	FUNCTION( ReleaseSwapchainImage ) \
+	FUNCTION( EndFrame ) \
+	FUNCTION( SyncActions ) \
+	FUNCTION( GetActionStateBoolean )
+
+#define FUNCTION_INDEX( name )		FUNCTION_##name,
+#define FUNCTION_NAME( name )		"xr" #name,
+
+enum
+{
+	STAND_IN_FUNCTIONS( FUNCTION_INDEX )
+	FUNCTION_COUNT
+};
+
+static const char * functionNames[FUNCTION_COUNT] =
+{
+	STAND_IN_FUNCTIONS( FUNCTION_NAME )
+};
+
+typedef struct
+{
+	ksNanoseconds	displayPeriod;
+	ksNanoseconds	nextDisplayTime;
+	ksNanoseconds	workNanoseconds;	// of the frame functions that do not block
+	bool			stall;				// the next swapchain image wait blocks for STALL_PERIODS display periods
+} ksStandInRuntime;
+
+static ksStandInRuntime runtime;
+
+static void Spin( const ksNanoseconds nanoseconds )
+{
+	const ksNanoseconds end = ksBench_GetTimeNanoseconds() + nanoseconds;
+	while ( ksBench_GetTimeNanoseconds() < end )
+	{
+	}
+}
+
+static int StandInWaitFrame( void * handle, const void * info, void * output )
+{
+	UNUSED_PARM( handle ); UNUSED_PARM( info ); UNUSED_PARM( output );
+	const ksNanoseconds now = ksBench_GetTimeNanoseconds();
+	if ( now < runtime.nextDisplayTime )
+	{
+		Spin( runtime.nextDisplayTime - now );
+		runtime.nextDisplayTime += runtime.displayPeriod;
+	}
+	else
+	{
+		runtime.nextDisplayTime = now + runtime.displayPeriod;
+	}
+	return 0;
+}
+
+static int StandInWork( void * handle, const void * info, void * output )
+{
+	UNUSED_PARM( handle ); UNUSED_PARM( info ); UNUSED_PARM( output );
+	Spin( runtime.workNanoseconds );
+	return 0;
+}
+
+static int StandInWaitSwapchainImage( void * handle, const void * info, void * output )
+{
+	UNUSED_PARM( handle ); UNUSED_PARM( info ); UNUSED_PARM( output );
+	Spin( runtime.stall ? STALL_PERIODS * runtime.displayPeriod : runtime.workNanoseconds );
+	runtime.stall = false;
+	return 0;
+}
+
+static int StandInReturn( void * handle, const void * info, void * output )
+{
+	UNUSED_PARM( handle ); UNUSED_PARM( info ); UNUSED_PARM( output );
+	return 0;
+}
+
+static const ksXrFunction standInFunctions[FUNCTION_COUNT] =
+{
+	StandInWaitFrame,
+	StandInWork,
+	StandInWork,
+	StandInWork,
+	StandInWaitSwapchainImage,
+	StandInWork,
+	StandInWork,
+	StandInReturn,
+	StandInReturn
+};
+
+/*
+================================================================================================================================
+
+Probed table
+
+================================================================================================================================
+*/
+
+static ksXrFunction targets[FUNCTION_COUNT];
+static ksCallProfiler profiler;
+
+// The probes of XRApp read GetTimeNanoseconds, the performance counter on Windows. On Linux that
+// is gettimeofday, with microsecond resolution, so the probes here read the monotonic clock.
+#define PROBE_FUNCTION( name ) \
+	static int Probe##name( void * handle, const void * info, void * output ) \
+	{ \
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds(); \
+		const int result = targets[FUNCTION_##name]( handle, info, output ); \
+		ksCallProfiler_Record( &profiler, FUNCTION_##name, ksBench_GetTimeNanoseconds() - start ); \
+		return result; \
+	}
+#define PROBE_NAME( name )		Probe##name,
+
+STAND_IN_FUNCTIONS( PROBE_FUNCTION )
+
+static const ksXrFunction probeFunctions[FUNCTION_COUNT] =
+{
+	STAND_IN_FUNCTIONS( PROBE_NAME )
+};
+
+// Like XrDispatch::load, the profiled table replaces the entry points by the probes
+static void LoadTable( ksXrFunction * table, const bool probed )
+{
+	ksCallProfiler_Create( &profiler );
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		ksCallProfiler_AddFunction( &profiler, functionNames[i] );
+		targets[i] = standInFunctions[i];
+		table[i] = probed ? probeFunctions[i] : standInFunctions[i];
+	}
+}
+
+/*
+================================================================================================================================
+
+Overhead
+
+================================================================================================================================
+*/
+
+static double TimeCalls( const bool probed, const int calls )
+{
+	ksXrFunction table[FUNCTION_COUNT];
+	LoadTable( table, probed );
+	ksXrFunction * volatile entries = table;
+
+	int state = 0;
+	double best = 1e30;
+	for ( int trial = 0; trial < TIMING_TRIALS; trial++ )
+	{
+		const ksNanoseconds start = ksBench_GetTimeNanoseconds();
+		for ( int i = 0; i < calls; i++ )
+		{
+			state += entries[FUNCTION_GetActionStateBoolean]( NULL, NULL, &state );
+		}
+		const double ns = (double)( ksBench_GetTimeNanoseconds() - start );
+		best = ( ns < best ) ? ns : best;
+	}
+	return best / calls;
+}
+
+/*
+================================================================================================================================
+
+Frames
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	const ksXrFunction *	table;
+	ksAtomicInt64			stop;
+	long long				syncs;
+	long long				stateQueries;
+} ksInputThread;
+
+static void InputThreadFunction( void * data )
+{
+	ksInputThread * input = (ksInputThread *)data;
+	while ( ksAtomicInt64_LoadAcquire( &input->stop ) == 0 )
+	{
+		input->table[FUNCTION_SyncActions]( NULL, NULL, NULL );
+		input->syncs++;
+		for ( int i = 0; i < ACTION_COUNT; i++ )
+		{
+			input->table[FUNCTION_GetActionStateBoolean]( NULL, NULL, NULL );
+			input->stateQueries++;
+		}
+		Spin( 100 * 1000 );
+	}
+}
+
+typedef struct
+{
+	ksCallStats		stats[FUNCTION_COUNT];
+	ksNanoseconds	stallFrameNanoseconds;		// in the swapchain image waits of the stalled frame
+	long long		syncs;
+	long long		stateQueries;
+} ksFrameResults;
+
+static void RunFrames( const int frameCount, ksFrameResults * results )
+{
+	ksXrFunction table[FUNCTION_COUNT];
+	LoadTable( table, true );
+
+	runtime.displayPeriod = 1000 * 1000;
+	runtime.nextDisplayTime = ksBench_GetTimeNanoseconds();
+	runtime.workNanoseconds = 2 * 1000;
+	runtime.stall = false;
+
+	ksInputThread input;
+	memset( &input, 0, sizeof( input ) );
+	input.table = table;
+	ksThread thread;
+	ksThread_Create( &thread, "input", InputThreadFunction, &input );
+	ksThread_Signal( &thread );
+
+	const int stallFrame = frameCount / 2;
+	for ( int frame = 0; frame < frameCount; frame++ )
+	{
+		table[FUNCTION_WaitFrame]( NULL, NULL, NULL );
+		table[FUNCTION_BeginFrame]( NULL, NULL, NULL );
+		table[FUNCTION_LocateViews]( NULL, NULL, NULL );
+		runtime.stall = ( frame == stallFrame );
+		for ( int eye = 0; eye < 2; eye++ )
+		{
+			table[FUNCTION_AcquireSwapchainImage]( NULL, NULL, NULL );
+			table[FUNCTION_WaitSwapchainImage]( NULL, NULL, NULL );
+			table[FUNCTION_ReleaseSwapchainImage]( NULL, NULL, NULL );
+		}
+		table[FUNCTION_EndFrame]( NULL, NULL, NULL );
+		ksCallProfiler_EndFrame( &profiler );
+
+		if ( frame == stallFrame )
+		{
+			ksCallStats stats;
+			ksCallProfiler_GetStats( &profiler, FUNCTION_WaitSwapchainImage, &stats );
+			results->stallFrameNanoseconds = stats.lastFrameNanoseconds;
+		}
+	}
+
+	ksAtomicInt64_StoreRelease( &input.stop, 1 );
+	ksThread_Join( &thread );
+	ksThread_Destroy( &thread );
+
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		ksCallProfiler_GetStats( &profiler, i, &results->stats[i] );
+	}
+	results->syncs = input.syncs;
+	results->stateQueries = input.stateQueries;
+}
+
+static bool ValidateFrames( const int frameCount, const ksFrameResults * results )
+{
+	const long long expectedCalls[FUNCTION_COUNT] =
+	{
+		frameCount, frameCount, frameCount, 2 * frameCount, 2 * frameCount, 2 * frameCount, frameCount,
+		results->syncs, results->stateQueries
+	};
+	const ksNanoseconds stall = STALL_PERIODS * runtime.displayPeriod;
+
+	bool valid = true;
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		const ksCallStats * stats = &results->stats[i];
+		valid = valid && ( stats->calls == expectedCalls[i] );
+		valid = valid && ( stats->maxNanoseconds <= stats->nanoseconds );
+		// The frame functions are called every frame, the input thread may skip frames
+		valid = valid && ( i >= FUNCTION_SyncActions || stats->frames == frameCount );
+		valid = valid && ( stats->frames == 0 || stats->maxFrameNanoseconds >= stats->frameNanoseconds / stats->frames );
+	}
+
+	const ksCallStats * wait = &results->stats[FUNCTION_WaitSwapchainImage];
+	valid = valid && ( wait->maxNanoseconds >= stall ) && ( wait->maxFrameNanoseconds >= stall );
+	valid = valid && ( results->stallFrameNanoseconds >= stall );
+	// Every wait but the stalled one spins for the work time, so the median is bounded by its bucket or the next one
+	const ksNanoseconds median = ksCallStats_GetPercentile( wait->histogram, 0.5 );
+	valid = valid && ( median > runtime.workNanoseconds ) && ( median <= 4 * runtime.workNanoseconds );
+	valid = valid && ( ksCallStats_GetPercentile( wait->histogram, 1.0 ) > stall );
+	return valid;
+}
+
+static void WriteFunctionStats( ksJsonWriter * writer, const ksCallStats * stats )
+{
+	ksJsonWriter_BeginObject( writer, NULL );
+	ksJsonWriter_String( writer, "name", stats->name );
+	ksJsonWriter_Int( writer, "calls", stats->calls );
+	ksJsonWriter_Double( writer, "avg_ns", ( stats->calls > 0 ) ? (double)stats->nanoseconds / stats->calls : 0.0 );
+	ksJsonWriter_Int( writer, "p50_ns_below", (long long)ksCallStats_GetPercentile( stats->histogram, 0.50 ) );
+	ksJsonWriter_Int( writer, "p99_ns_below", (long long)ksCallStats_GetPercentile( stats->histogram, 0.99 ) );
+	ksJsonWriter_Int( writer, "max_ns", (long long)stats->maxNanoseconds );
+	ksJsonWriter_Int( writer, "frames", stats->frames );
+	ksJsonWriter_Int( writer, "frame_max_ns", (long long)stats->maxFrameNanoseconds );
+	ksJsonWriter_EndObject( writer );
+}
+
+int main( int argc, char * argv[] )
+{
+	const char * outFileName = NULL;
+	int calls = 1000000;
+	int frameCount = 200;
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( strcmp( argv[i], "--quick" ) == 0 )
+		{
+			calls = 100000;
+			frameCount = 40;
+		}
+		else if ( strcmp( argv[i], "--out" ) == 0 && i + 1 < argc )
+		{
+			outFileName = argv[++i];
+		}
+		else
+		{
+			fprintf( stderr, "Usage: %s [--quick] [--out <file.json>]\n", argv[0] );
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE * fp = stdout;
+	if ( outFileName != NULL )
+	{
+		fp = fopen( outFileName, "w" );
+		if ( fp == NULL )
+		{
+			fprintf( stderr, "Failed to open %s\n", outFileName );
+			return EXIT_FAILURE;
+		}
+	}
+
+	const double directNanoseconds = TimeCalls( false, calls );
+	const double probedNanoseconds = TimeCalls( true, calls );
+
+	ksFrameResults results;
+	memset( &results, 0, sizeof( results ) );
+	RunFrames( frameCount, &results );
+	const bool valid = ValidateFrames( frameCount, &results );
+
+	ksJsonWriter writer;
+	ksJsonWriter_Create( &writer, fp );
+	ksJsonWriter_BeginObject( &writer, NULL );
+	ksBench_WriteHeader( &writer, "xr_profiler" );
+
+	ksJsonWriter_BeginObject( &writer, "overhead" );
+	ksJsonWriter_Int( &writer, "ops", calls );
+	ksJsonWriter_Double( &writer, "direct_ns_per_call", directNanoseconds );
+	ksJsonWriter_Double( &writer, "probed_ns_per_call", probedNanoseconds );
+	ksJsonWriter_Double( &writer, "probe_ns", probedNanoseconds - directNanoseconds );
+	ksJsonWriter_EndObject( &writer );
+
+	ksJsonWriter_BeginObject( &writer, "frames" );
+	ksJsonWriter_Int( &writer, "frames", frameCount );
+	ksJsonWriter_Int( &writer, "display_period_ns", (long long)runtime.displayPeriod );
+	ksJsonWriter_Int( &writer, "stall_ns", (long long)( STALL_PERIODS * runtime.displayPeriod ) );
+	ksJsonWriter_Int( &writer, "stall_frame_wait_ns", (long long)results.stallFrameNanoseconds );
+	ksJsonWriter_BeginArray( &writer, "functions" );
+	for ( int i = 0; i < FUNCTION_COUNT; i++ )
+	{
+		WriteFunctionStats( &writer, &results.stats[i] );
+	}
+	ksJsonWriter_EndArray( &writer );
+	ksJsonWriter_EndObject( &writer );
+
+	ksJsonWriter_Bool( &writer, "validated", valid );
+	ksJsonWriter_EndObject( &writer );
+
+	if ( fp != stdout )
+	{
+		fclose( fp );
+	}
+	if ( !valid )
+	{
+		fprintf( stderr, "The profiler statistics do not match the calls made\n" );
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
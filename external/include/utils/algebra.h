@@ -53,6 +53,9 @@ ksVector2f
 ksVector3f
 ksVector4f
 ksQuatf
+ksPosef
+ksQuatf32
+ksQuatf48
 ksMatrix2x2f
 ksMatrix2x3f
 ksMatrix2x4f
@@ -110,14 +113,32 @@ static inline void ksMatrix4x4f_TransformVector4f( ksVector4f * result, const ks
 static inline void ksMatrix4x4f_TransformBounds( ksVector3f * resultMins, ksVector3f * resultMaxs, const ksMatrix4x4f * matrix, const ksVector3f * mins, const ksVector3f * maxs );
 static inline bool ksMatrix4x4f_CullBounds( const ksMatrix4x4f * mvp, const ksVector3f * mins, const ksVector3f * maxs );
 
+static inline void ksPosef_Predict( ksPosef * results, const ksPosef * poses, const ksVector3f * linearVelocities,
+									const ksVector3f * angularVelocities, const int count, const float deltaSeconds );
+static inline void ksMatrix4x4f_CreateFromPoses( ksMatrix4x4f * results, const ksPosef * poses, const int count );
+static inline void ksMatrix3x4f_CreateFromPoses( ksMatrix3x4f * results, const ksPosef * poses, const int count );
+
+static inline float ksRcpSqrtRefined( const float x );
+static inline void ksQuatf_NormalizeArray( ksQuatf * results, const ksQuatf * quats, const int count );
+static inline void ksQuatf_NlerpArray( ksQuatf * results, const ksQuatf * a, const ksQuatf * b, const int count, const float fraction );
+static inline void ksQuatf_SlerpArray( ksQuatf * results, const ksQuatf * a, const ksQuatf * b, const int count, const float fraction );
+static inline void ksMatrix4x4f_CreateFromQuaternions( ksMatrix4x4f * results, const ksQuatf * quats, const int count );
+static inline void ksQuatf32_Pack( ksQuatf32 * results, const ksQuatf * quats, const int count );
+static inline void ksQuatf32_Unpack( ksQuatf * results, const ksQuatf32 * packed, const int count );
+static inline void ksQuatf48_Pack( ksQuatf48 * results, const ksQuatf * quats, const int count );
+static inline void ksQuatf48_Unpack( ksQuatf * results, const ksQuatf48 * packed, const int count );
+
 ================================================================================================
 */
 
 #if !defined( KSALGEBRA_H )
 #define KSALGEBRA_H
 
+#include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
 #define MATH_PI				3.14159265358979323846f
 
@@ -181,6 +202,23 @@ typedef struct
 	float w;
 } ksQuatf;
 
+// Rigid body pose, layout compatible with XrPosef
+typedef struct
+{
+	ksQuatf		orientation;
+	ksVector3f	position;
+} ksPosef;
+
+// Unit quaternion compressed with the smallest three encoding:
+// 2 bits for the index of the dropped largest component and 10 bits for each of the others.
+typedef uint32_t ksQuatf32;
+
+// Same encoding with 15 bits per component, stored as three 16-bit words so it packs without padding.
+typedef struct
+{
+	uint16_t v[3];
+} ksQuatf48;
+
 // Column-major 2x2 matrix
 typedef struct
 {
@@ -526,8 +564,8 @@ static inline void ksMatrix4x4f_CreateScale( ksMatrix4x4f * result, const float
 	result->m[3][0] = 0.0f; result->m[3][1] = 0.0f; result->m[3][2] = 0.0f; result->m[3][3] = 1.0f;
 }
 
-// Creates a matrix from a quaternion.
-static inline void ksMatrix4x4f_CreateFromQuaternion( ksMatrix4x4f * result, const ksQuatf * quat )
+// Rotation part of the matrix created from a quaternion, in the layout of ksMatrix4x4f (transposed for ksMatrix3x4f).
+static inline void ksQuatf_GetRotationMatrix( float rotation[3][3], const ksQuatf * quat )
 {
 	const float x2 = quat->x + quat->x;
 	const float y2 = quat->y + quat->y;
@@ -544,19 +582,38 @@ static inline void ksMatrix4x4f_CreateFromQuaternion( ksMatrix4x4f * result, con
 	const float xz2 = quat->x * z2;
 	const float wy2 = quat->w * y2;
 
-	result->m[0][0] = 1.0f - yy2 - zz2;
-	result->m[0][1] = xy2 + wz2;
-	result->m[0][2] = xz2 - wy2;
+	rotation[0][0] = 1.0f - yy2 - zz2;
+	rotation[0][1] = xy2 + wz2;
+	rotation[0][2] = xz2 - wy2;
+
+	rotation[1][0] = xy2 - wz2;
+	rotation[1][1] = 1.0f - xx2 - zz2;
+	rotation[1][2] = yz2 + wx2;
+
+	rotation[2][0] = xz2 + wy2;
+	rotation[2][1] = yz2 - wx2;
+	rotation[2][2] = 1.0f - xx2 - yy2;
+}
+
+// Creates a matrix from a quaternion.
+static inline void ksMatrix4x4f_CreateFromQuaternion( ksMatrix4x4f * result, const ksQuatf * quat )
+{
+	float rotation[3][3];
+	ksQuatf_GetRotationMatrix( rotation, quat );
+
+	result->m[0][0] = rotation[0][0];
+	result->m[0][1] = rotation[0][1];
+	result->m[0][2] = rotation[0][2];
 	result->m[0][3] = 0.0f;
 
-	result->m[1][0] = xy2 - wz2;
-	result->m[1][1] = 1.0f - xx2 - zz2;
-	result->m[1][2] = yz2 + wx2;
+	result->m[1][0] = rotation[1][0];
+	result->m[1][1] = rotation[1][1];
+	result->m[1][2] = rotation[1][2];
 	result->m[1][3] = 0.0f;
 
-	result->m[2][0] = xz2 + wy2;
-	result->m[2][1] = yz2 - wx2;
-	result->m[2][2] = 1.0f - xx2 - yy2;
+	result->m[2][0] = rotation[2][0];
+	result->m[2][1] = rotation[2][1];
+	result->m[2][2] = rotation[2][2];
 	result->m[2][3] = 0.0f;
 
 	result->m[3][0] = 0.0f;
@@ -968,4 +1025,393 @@ static inline bool ksMatrix4x4f_CullBounds( const ksMatrix4x4f * mvp, const ksVe
 	return false;
 }
 
+/*
+================================================================================================================================
+
+Batched pose operations.
+
+ksPosef_Predict processes the poses in blocks of POSE_BATCH_LANES. Each block is first
+transposed into structure-of-arrays form on the stack, so the arithmetic consists of
+simple loops over the lanes which the compiler turns into SIMD instructions.
+
+The conversions to matrices are bound by the stores of the results, so they are plain
+loops over the poses without the transpose.
+
+================================================================================================================================
+*/
+
+#define POSE_BATCH_LANES	8
+
+// Extrapolates poses with constant linear and angular velocity over 'deltaSeconds'.
+// The velocities are expressed in the same base space as the poses (as returned by xrLocateSpace).
+// Either velocity array may be NULL, in which case that part of the pose is left unchanged.
+// The orientations must be unit quaternions and may rotate by up to half a turn.
+static inline void ksPosef_Predict( ksPosef * results, const ksPosef * poses, const ksVector3f * linearVelocities,
+									const ksVector3f * angularVelocities, const int count, const float deltaSeconds )
+{
+	for ( int base = 0; base < count; base += POSE_BATCH_LANES )
+	{
+		const int laneCount = ( count - base < POSE_BATCH_LANES ) ? count - base : POSE_BATCH_LANES;
+
+		// Unused lanes replicate the last pose so they stay finite.
+		float qx[POSE_BATCH_LANES], qy[POSE_BATCH_LANES], qz[POSE_BATCH_LANES], qw[POSE_BATCH_LANES];
+		float px[POSE_BATCH_LANES], py[POSE_BATCH_LANES], pz[POSE_BATCH_LANES];
+		for ( int l = 0; l < POSE_BATCH_LANES; l++ )
+		{
+			const ksPosef * pose = &poses[base + ( ( l < laneCount ) ? l : laneCount - 1 )];
+			qx[l] = pose->orientation.x;
+			qy[l] = pose->orientation.y;
+			qz[l] = pose->orientation.z;
+			qw[l] = pose->orientation.w;
+			px[l] = pose->position.x;
+			py[l] = pose->position.y;
+			pz[l] = pose->position.z;
+		}
+
+		if ( linearVelocities != NULL )
+		{
+			float vx[POSE_BATCH_LANES], vy[POSE_BATCH_LANES], vz[POSE_BATCH_LANES];
+			for ( int l = 0; l < POSE_BATCH_LANES; l++ )
+			{
+				const ksVector3f * v = &linearVelocities[base + ( ( l < laneCount ) ? l : laneCount - 1 )];
+				vx[l] = v->x;
+				vy[l] = v->y;
+				vz[l] = v->z;
+			}
+			for ( int l = 0; l < POSE_BATCH_LANES; l++ )
+			{
+				px[l] += vx[l] * deltaSeconds;
+				py[l] += vy[l] * deltaSeconds;
+				pz[l] += vz[l] * deltaSeconds;
+			}
+		}
+
+		if ( angularVelocities != NULL )
+		{
+			float hx[POSE_BATCH_LANES], hy[POSE_BATCH_LANES], hz[POSE_BATCH_LANES];
+			const float halfDelta = 0.5f * deltaSeconds;
+			for ( int l = 0; l < POSE_BATCH_LANES; l++ )
+			{
+				const ksVector3f * w = &angularVelocities[base + ( ( l < laneCount ) ? l : laneCount - 1 )];
+				hx[l] = w->x * halfDelta;
+				hy[l] = w->y * halfDelta;
+				hz[l] = w->z * halfDelta;
+			}
+			for ( int l = 0; l < POSE_BATCH_LANES; l++ )
+			{
+				// The delta rotation is ( h * sin(|h|) / |h|, cos(|h|) ) with h the half angle vector.
+				// Both factors are even functions of |h| so they are evaluated as polynomials in |h|^2,
+				// which avoids the square root and the division, and is well behaved for small angles.
+				const float a2 = hx[l] * hx[l] + hy[l] * hy[l] + hz[l] * hz[l];
+				const float sinc = 1.0f + a2 * ( -1.0f / 6.0f + a2 * ( 1.0f / 120.0f + a2 * ( -1.0f / 5040.0f + a2 * ( 1.0f / 362880.0f + a2 * ( -1.0f / 39916800.0f ) ) ) ) );
+				const float cosine = 1.0f + a2 * ( -1.0f / 2.0f + a2 * ( 1.0f / 24.0f + a2 * ( -1.0f / 720.0f + a2 * ( 1.0f / 40320.0f + a2 * ( -1.0f / 3628800.0f ) ) ) ) );
+				const float dx = hx[l] * sinc;
+				const float dy = hy[l] * sinc;
+				const float dz = hz[l] * sinc;
+				const float dw = cosine;
+
+				// Left-multiply because the angular velocity is expressed in the base space.
+				const float x = dw * qx[l] + dx * qw[l] + dy * qz[l] - dz * qy[l];
+				const float y = dw * qy[l] - dx * qz[l] + dy * qw[l] + dz * qx[l];
+				const float z = dw * qz[l] + dx * qy[l] - dy * qx[l] + dz * qw[l];
+				const float w = dw * qw[l] - dx * qx[l] - dy * qy[l] - dz * qz[l];
+
+				// The product of two unit quaternions only drifts from unit length by rounding,
+				// so a single Newton step of the reciprocal square root around 1 renormalizes it.
+				const float lengthRcp = 1.5f - 0.5f * ( x * x + y * y + z * z + w * w );
+				qx[l] = x * lengthRcp;
+				qy[l] = y * lengthRcp;
+				qz[l] = z * lengthRcp;
+				qw[l] = w * lengthRcp;
+			}
+		}
+
+		for ( int l = 0; l < laneCount; l++ )
+		{
+			ksPosef * result = &results[base + l];
+			result->orientation.x = qx[l];
+			result->orientation.y = qy[l];
+			result->orientation.z = qz[l];
+			result->orientation.w = qw[l];
+			result->position.x = px[l];
+			result->position.y = py[l];
+			result->position.z = pz[l];
+		}
+	}
+}
+
+// Creates translation(rotation(object)) matrices from an array of poses.
+static inline void ksMatrix4x4f_CreateFromPoses( ksMatrix4x4f * results, const ksPosef * poses, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksVector3f * p = &poses[i].position;
+
+		ksMatrix4x4f * result = &results[i];
+		ksMatrix4x4f_CreateFromQuaternion( result, &poses[i].orientation );
+		result->m[3][0] = p->x;
+		result->m[3][1] = p->y;
+		result->m[3][2] = p->z;
+	}
+}
+
+// Creates row-major 3x4 transforms (the layout of ksMatrix3x4f_CreateFromMatrix4x4f) from an array of poses.
+static inline void ksMatrix3x4f_CreateFromPoses( ksMatrix3x4f * results, const ksPosef * poses, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksVector3f * p = &poses[i].position;
+
+		float rotation[3][3];
+		ksQuatf_GetRotationMatrix( rotation, &poses[i].orientation );
+
+		ksMatrix3x4f * result = &results[i];
+		result->m[0][0] = rotation[0][0];
+		result->m[0][1] = rotation[1][0];
+		result->m[0][2] = rotation[2][0];
+		result->m[0][3] = p->x;
+
+		result->m[1][0] = rotation[0][1];
+		result->m[1][1] = rotation[1][1];
+		result->m[1][2] = rotation[2][1];
+		result->m[1][3] = p->y;
+
+		result->m[2][0] = rotation[0][2];
+		result->m[2][1] = rotation[1][2];
+		result->m[2][2] = rotation[2][2];
+		result->m[2][3] = p->z;
+	}
+}
+
+/*
+================================================================================================================================
+
+Batched quaternion operations.
+
+These are plain loops over the quaternions without calls into libm, so the compiler
+vectorizes them at the default floating-point settings (sqrtf sets errno, which keeps
+the loops that call it scalar). The reciprocal square root is an integer estimate
+refined with Newton-Raphson iterations instead.
+
+The compressed formats use the smallest three encoding: the largest magnitude
+component is dropped, the quaternion is negated if needed so the dropped component is
+positive, and the remaining three components, which lie in [-1/sqrt(2), 1/sqrt(2)], are
+quantized. The dropped component is recovered from the unit length constraint. The
+largest error per component is about 2e-3 for ksQuatf32 and 6e-5 for ksQuatf48.
+
+================================================================================================================================
+*/
+
+// Reciprocal square root of a positive, normal float to within a few ulp.
+static inline float ksRcpSqrtRefined( const float x )
+{
+	uint32_t i;
+	memcpy( &i, &x, sizeof( i ) );
+	i = 0x5F375A86u - ( i >> 1 );
+	float y;
+	memcpy( &y, &i, sizeof( y ) );
+	const float halfX = 0.5f * x;
+	y = y * ( 1.5f - halfX * y * y );
+	y = y * ( 1.5f - halfX * y * y );
+	y = y * ( 1.5f - halfX * y * y );
+	return y;
+}
+
+static inline void ksQuatf_NormalizeArray( ksQuatf * results, const ksQuatf * quats, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksQuatf * q = &quats[i];
+		const float lengthSqr = q->x * q->x + q->y * q->y + q->z * q->z + q->w * q->w;
+		const float lengthRcp = ksRcpSqrtRefined( lengthSqr );
+		results[i].x = q->x * lengthRcp;
+		results[i].y = q->y * lengthRcp;
+		results[i].z = q->z * lengthRcp;
+		results[i].w = q->w * lengthRcp;
+	}
+}
+
+// Batch version of ksQuatf_Lerp.
+static inline void ksQuatf_NlerpArray( ksQuatf * results, const ksQuatf * a, const ksQuatf * b, const int count, const float fraction )
+{
+	const float fa = 1.0f - fraction;
+	for ( int i = 0; i < count; i++ )
+	{
+		const float s = a[i].x * b[i].x + a[i].y * b[i].y + a[i].z * b[i].z + a[i].w * b[i].w;
+		const float fb = ( s < 0.0f ) ? -fraction : fraction;
+		const float x = a[i].x * fa + b[i].x * fb;
+		const float y = a[i].y * fa + b[i].y * fb;
+		const float z = a[i].z * fa + b[i].z * fb;
+		const float w = a[i].w * fa + b[i].w * fb;
+		const float lengthRcp = ksRcpSqrtRefined( x * x + y * y + z * z + w * w );
+		results[i].x = x * lengthRcp;
+		results[i].y = y * lengthRcp;
+		results[i].z = z * lengthRcp;
+		results[i].w = w * lengthRcp;
+	}
+}
+
+// Spherical linear interpolation along the shortest arc.
+// The weights sin(t*angle)/sin(angle) are evaluated as a polynomial in cos(angle) - 1
+// (D. Eberly, "A Fast and Accurate Algorithm for Computing SLERP"), which avoids acos and sin.
+// The weights are within 2e-5 of the exact ones, with the largest error for rotations close to half a turn.
+static inline void ksQuatf_SlerpArray( ksQuatf * results, const ksQuatf * a, const ksQuatf * b, const int count, const float fraction )
+{
+	#define SLERP_TERMS 8
+	const float mu = 1.85298109240830f;
+	float u[SLERP_TERMS];
+	float v[SLERP_TERMS];
+	for ( int i = 0; i < SLERP_TERMS - 1; i++ )
+	{
+		const float n = (float)( i + 1 );
+		u[i] = 1.0f / ( n * ( 2.0f * n + 1.0f ) );
+		v[i] = n / ( 2.0f * n + 1.0f );
+	}
+	u[SLERP_TERMS - 1] = mu / ( SLERP_TERMS * ( 2.0f * SLERP_TERMS + 1.0f ) );
+	v[SLERP_TERMS - 1] = mu * SLERP_TERMS / ( 2.0f * SLERP_TERMS + 1.0f );
+
+	const float t = fraction;
+	const float d = 1.0f - fraction;
+	const float sqrT = t * t;
+	const float sqrD = d * d;
+
+	for ( int i = 0; i < count; i++ )
+	{
+		const float dot = a[i].x * b[i].x + a[i].y * b[i].y + a[i].z * b[i].z + a[i].w * b[i].w;
+		const float sign = ( dot < 0.0f ) ? -1.0f : 1.0f;
+		const float xm1 = dot * sign - 1.0f;
+
+		float ct = 1.0f;
+		float cd = 1.0f;
+		for ( int j = SLERP_TERMS - 1; j >= 0; j-- )
+		{
+			ct = 1.0f + ( u[j] * sqrT - v[j] ) * xm1 * ct;
+			cd = 1.0f + ( u[j] * sqrD - v[j] ) * xm1 * cd;
+		}
+		const float fa = d * cd;
+		const float fb = t * ct * sign;
+
+		results[i].x = a[i].x * fa + b[i].x * fb;
+		results[i].y = a[i].y * fa + b[i].y * fb;
+		results[i].z = a[i].z * fa + b[i].z * fb;
+		results[i].w = a[i].w * fa + b[i].w * fb;
+	}
+	#undef SLERP_TERMS
+}
+
+// Batch version of ksMatrix4x4f_CreateFromQuaternion.
+static inline void ksMatrix4x4f_CreateFromQuaternions( ksMatrix4x4f * results, const ksQuatf * quats, const int count )
+{
+	for ( int i = 0; i < count; i++ )
+	{
+		ksMatrix4x4f_CreateFromQuaternion( &results[i], &quats[i] );
+	}
+}
+
+#define QUAT_SMALLEST_THREE_RANGE	0.70710678118654752440f		// 1 / sqrt( 2 )
+
+// Splits a unit quaternion into the index of its largest magnitude component and the
+// other three components, mapped from [-1/sqrt(2), 1/sqrt(2)] to [0, 1].
+static inline int ksQuatf_SmallestThree( float smallest[3], const ksQuatf * q )
+{
+	const float c[4] = { q->x, q->y, q->z, q->w };
+	int largest = 0;
+	for ( int i = 1; i < 4; i++ )
+	{
+		largest = ( fabsf( c[i] ) > fabsf( c[largest] ) ) ? i : largest;
+	}
+	const float scale = ( ( c[largest] < 0.0f ) ? -0.5f : 0.5f ) / QUAT_SMALLEST_THREE_RANGE;
+	for ( int i = 0, j = 0; i < 4; i++ )
+	{
+		if ( i != largest )
+		{
+			const float value = c[i] * scale + 0.5f;
+			smallest[j++] = ( value < 0.0f ) ? 0.0f : ( ( value > 1.0f ) ? 1.0f : value );
+		}
+	}
+	return largest;
+}
+
+static inline void ksQuatf_FromSmallestThree( ksQuatf * result, const int largest, const float smallest[3] )
+{
+	float c[4];
+	float sumSqr = 0.0f;
+	for ( int i = 0, j = 0; i < 4; i++ )
+	{
+		if ( i != largest )
+		{
+			c[i] = ( smallest[j++] * 2.0f - 1.0f ) * QUAT_SMALLEST_THREE_RANGE;
+			sumSqr += c[i] * c[i];
+		}
+	}
+	// The largest component is at least 1/2, so the square root argument is at least 1/4.
+	const float largestSqr = ( 1.0f - sumSqr > 0.25f ) ? 1.0f - sumSqr : 0.25f;
+	c[largest] = largestSqr * ksRcpSqrtRefined( largestSqr );
+	result->x = c[0];
+	result->y = c[1];
+	result->z = c[2];
+	result->w = c[3];
+}
+
+static inline void ksQuatf32_Pack( ksQuatf32 * results, const ksQuatf * quats, const int count )
+{
+	const float maxValue = (float)( ( 1 << 10 ) - 1 );
+	for ( int i = 0; i < count; i++ )
+	{
+		float smallest[3];
+		const int largest = ksQuatf_SmallestThree( smallest, &quats[i] );
+		results[i] =	( (uint32_t)largest << 30 ) |
+						( (uint32_t)( smallest[0] * maxValue + 0.5f ) << 20 ) |
+						( (uint32_t)( smallest[1] * maxValue + 0.5f ) << 10 ) |
+						( (uint32_t)( smallest[2] * maxValue + 0.5f ) << 0 );
+	}
+}
+
+static inline void ksQuatf32_Unpack( ksQuatf * results, const ksQuatf32 * packed, const int count )
+{
+	const float scale = 1.0f / (float)( ( 1 << 10 ) - 1 );
+	for ( int i = 0; i < count; i++ )
+	{
+		const uint32_t p = packed[i];
+		const float smallest[3] =
+		{
+			(float)( ( p >> 20 ) & 0x3FF ) * scale,
+			(float)( ( p >> 10 ) & 0x3FF ) * scale,
+			(float)( ( p >> 0 ) & 0x3FF ) * scale
+		};
+		ksQuatf_FromSmallestThree( &results[i], (int)( p >> 30 ), smallest );
+	}
+}
+
+// The index goes in the top bit of the first two words, the components in the low 15 bits of each word.
+static inline void ksQuatf48_Pack( ksQuatf48 * results, const ksQuatf * quats, const int count )
+{
+	const float maxValue = (float)( ( 1 << 15 ) - 1 );
+	for ( int i = 0; i < count; i++ )
+	{
+		float smallest[3];
+		const int largest = ksQuatf_SmallestThree( smallest, &quats[i] );
+		results[i].v[0] = (uint16_t)( ( ( largest >> 1 ) << 15 ) | (uint32_t)( smallest[0] * maxValue + 0.5f ) );
+		results[i].v[1] = (uint16_t)( ( ( largest & 1 ) << 15 ) | (uint32_t)( smallest[1] * maxValue + 0.5f ) );
+		results[i].v[2] = (uint16_t)( (uint32_t)( smallest[2] * maxValue + 0.5f ) );
+	}
+}
+
+static inline void ksQuatf48_Unpack( ksQuatf * results, const ksQuatf48 * packed, const int count )
+{
+	const float scale = 1.0f / (float)( ( 1 << 15 ) - 1 );
+	for ( int i = 0; i < count; i++ )
+	{
+		const ksQuatf48 * p = &packed[i];
+		const int largest = ( ( p->v[0] >> 15 ) << 1 ) | ( p->v[1] >> 15 );
+		const float smallest[3] =
+		{
+			(float)( p->v[0] & 0x7FFF ) * scale,
+			(float)( p->v[1] & 0x7FFF ) * scale,
+			(float)( p->v[2] & 0x7FFF ) * scale
+		};
+		ksQuatf_FromSmallestThree( &results[i], largest, smallest );
+	}
+}
+
 #endif // !KSALGEBRA_H
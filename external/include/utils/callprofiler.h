@@ -0,0 +1,261 @@
+/*
+================================================================================================
+
+Description	:	Call counts and latency histograms of a table of functions.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+Profiles the functions of a table, like the entry points of a runtime, from a shim that times
+every call and records it here. Each function gets a call count, the cumulative and maximum
+time, and a histogram of its call latencies. The histogram buckets are powers of two, enough to
+tell a call that blocks for a display period from one that is merely slow, without keeping the
+samples.
+
+Calls are also accumulated per frame. ksCallProfiler_EndFrame closes the frame: it keeps the
+calls and time of each function in that frame, and adds the time to a second histogram of time
+per frame. Frames without a call to a function are not counted for that function.
+
+Calls can be recorded from any thread without locking. EndFrame and the queries belong to one
+thread, normally the frame thread. A call recorded while EndFrame runs may have its count and
+time split over two frames.
+
+
+INTERFACE
+=========
+
+static void ksCallProfiler_Create( ksCallProfiler * profiler );
+static void ksCallProfiler_Destroy( ksCallProfiler * profiler );
+static int ksCallProfiler_AddFunction( ksCallProfiler * profiler, const char * name );
+static int ksCallProfiler_FindFunction( const ksCallProfiler * profiler, const char * name );
+static int ksCallProfiler_GetFunctionCount( const ksCallProfiler * profiler );
+static void ksCallProfiler_Record( ksCallProfiler * profiler, const int function, const ksNanoseconds latency );
+static void ksCallProfiler_EndFrame( ksCallProfiler * profiler );
+static void ksCallProfiler_GetStats( const ksCallProfiler * profiler, const int function, ksCallStats * stats );
+static void ksCallProfiler_Report( const ksCallProfiler * profiler, FILE * fp );
+
+static ksNanoseconds ksCallStats_GetPercentile( const long long * histogram, const double fraction );
+
+================================================================================================
+*/
+
+#if !defined( KSCALLPROFILER_H )
+#define KSCALLPROFILER_H
+
+#include "threading.h"
+
+#define KS_CALL_PROFILER_MAX_FUNCTIONS	64
+#define KS_CALL_PROFILER_BUCKETS		32		// bucket i counts [2^i, 2^(i+1)) nanoseconds, the first and last one are open
+
+typedef struct
+{
+	const char *	name;
+	long long		calls;
+	ksNanoseconds	nanoseconds;
+	ksNanoseconds	maxNanoseconds;
+	long long		histogram[KS_CALL_PROFILER_BUCKETS];		// calls by latency
+
+	long long		frames;										// closed frames with at least one call
+	ksNanoseconds	frameNanoseconds;							// in those frames
+	ksNanoseconds	maxFrameNanoseconds;
+	long long		lastFrameCalls;								// in the last closed frame
+	ksNanoseconds	lastFrameNanoseconds;
+	long long		frameHistogram[KS_CALL_PROFILER_BUCKETS];	// frames by time spent in the function
+} ksCallStats;
+
+typedef struct
+{
+	// Written by the calls, from any thread
+	ksAtomicInt64	nanoseconds;
+	ksAtomicInt64	maxNanoseconds;
+	ksAtomicInt64	histogram[KS_CALL_PROFILER_BUCKETS];
+	ksAtomicInt64	frameCalls;
+	ksAtomicInt64	frameNanoseconds;
+
+	// Written by EndFrame
+	long long		frames;
+	long long		closedNanoseconds;
+	long long		maxFrameNanoseconds;
+	long long		lastFrameCalls;
+	long long		lastFrameNanoseconds;
+	long long		frameHistogram[KS_CALL_PROFILER_BUCKETS];
+} ksCallCounters;
+
+typedef struct
+{
+	int				functionCount;
+	const char *	names[KS_CALL_PROFILER_MAX_FUNCTIONS];
+	ksCallCounters	counters[KS_CALL_PROFILER_MAX_FUNCTIONS];
+	long long		frameCount;
+} ksCallProfiler;
+
+static void ksCallProfiler_Create( ksCallProfiler * profiler )
+{
+	memset( profiler, 0, sizeof( ksCallProfiler ) );
+}
+
+static void ksCallProfiler_Destroy( ksCallProfiler * profiler )
+{
+	memset( profiler, 0, sizeof( ksCallProfiler ) );
+}
+
+// Returns the index of the function, or -1 if the table is full. The name is not copied.
+static int ksCallProfiler_AddFunction( ksCallProfiler * profiler, const char * name )
+{
+	if ( profiler->functionCount >= KS_CALL_PROFILER_MAX_FUNCTIONS )
+	{
+		return -1;
+	}
+	profiler->names[profiler->functionCount] = name;
+	return profiler->functionCount++;
+}
+
+static int ksCallProfiler_FindFunction( const ksCallProfiler * profiler, const char * name )
+{
+	for ( int i = 0; i < profiler->functionCount; i++ )
+	{
+		if ( strcmp( profiler->names[i], name ) == 0 )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int ksCallProfiler_GetFunctionCount( const ksCallProfiler * profiler )
+{
+	return profiler->functionCount;
+}
+
+static int ksCallProfiler_Bucket( const ksNanoseconds nanoseconds )
+{
+	if ( nanoseconds == 0 )
+	{
+		return 0;
+	}
+#if defined( _MSC_VER )
+	unsigned long bit;
+	_BitScanReverse64( &bit, nanoseconds );
+	const int bucket = (int)bit;
+#else
+	const int bucket = 63 - __builtin_clzll( nanoseconds );
+#endif
+	return ( bucket < KS_CALL_PROFILER_BUCKETS ) ? bucket : KS_CALL_PROFILER_BUCKETS - 1;
+}
+
+static void ksCallProfiler_Record( ksCallProfiler * profiler, const int function, const ksNanoseconds latency )
+{
+	ksCallCounters * counters = &profiler->counters[function];
+	ksAtomicInt64_Add( &counters->histogram[ksCallProfiler_Bucket( latency )], 1 );
+	ksAtomicInt64_Add( &counters->nanoseconds, (long long)latency );
+	ksAtomicInt64_Add( &counters->frameCalls, 1 );
+	ksAtomicInt64_Add( &counters->frameNanoseconds, (long long)latency );
+	// Only a new maximum writes
+	for ( long long max = ksAtomicInt64_LoadRelaxed( &counters->maxNanoseconds ); (long long)latency > max;
+			max = ksAtomicInt64_LoadRelaxed( &counters->maxNanoseconds ) )
+	{
+		if ( ksAtomicInt64_CompareExchange( &counters->maxNanoseconds, max, (long long)latency ) )
+		{
+			break;
+		}
+	}
+}
+
+static void ksCallProfiler_EndFrame( ksCallProfiler * profiler )
+{
+	for ( int i = 0; i < profiler->functionCount; i++ )
+	{
+		ksCallCounters * counters = &profiler->counters[i];
+		const long long calls = ksAtomicInt64_Exchange( &counters->frameCalls, 0 );
+		const long long nanoseconds = ksAtomicInt64_Exchange( &counters->frameNanoseconds, 0 );
+		counters->lastFrameCalls = calls;
+		counters->lastFrameNanoseconds = nanoseconds;
+		if ( calls == 0 )
+		{
+			continue;
+		}
+		counters->frames++;
+		counters->closedNanoseconds += nanoseconds;
+		if ( nanoseconds > counters->maxFrameNanoseconds )
+		{
+			counters->maxFrameNanoseconds = nanoseconds;
+		}
+		counters->frameHistogram[ksCallProfiler_Bucket( (ksNanoseconds)nanoseconds )]++;
+	}
+	profiler->frameCount++;
+}
+
+static void ksCallProfiler_GetStats( const ksCallProfiler * profiler, const int function, ksCallStats * stats )
+{
+	const ksCallCounters * counters = &profiler->counters[function];
+	memset( stats, 0, sizeof( ksCallStats ) );
+	stats->name = profiler->names[function];
+	for ( int i = 0; i < KS_CALL_PROFILER_BUCKETS; i++ )
+	{
+		stats->histogram[i] = ksAtomicInt64_LoadRelaxed( &counters->histogram[i] );
+		stats->calls += stats->histogram[i];
+		stats->frameHistogram[i] = counters->frameHistogram[i];
+	}
+	stats->nanoseconds = (ksNanoseconds)ksAtomicInt64_LoadRelaxed( &counters->nanoseconds );
+	stats->maxNanoseconds = (ksNanoseconds)ksAtomicInt64_LoadRelaxed( &counters->maxNanoseconds );
+	stats->frames = counters->frames;
+	stats->frameNanoseconds = (ksNanoseconds)counters->closedNanoseconds;
+	stats->maxFrameNanoseconds = (ksNanoseconds)counters->maxFrameNanoseconds;
+	stats->lastFrameCalls = counters->lastFrameCalls;
+	stats->lastFrameNanoseconds = (ksNanoseconds)counters->lastFrameNanoseconds;
+}
+
+// Upper bound of the bucket holding the given fraction of the samples, 0 without samples.
+static ksNanoseconds ksCallStats_GetPercentile( const long long * histogram, const double fraction )
+{
+	long long total = 0;
+	for ( int i = 0; i < KS_CALL_PROFILER_BUCKETS; i++ )
+	{
+		total += histogram[i];
+	}
+	if ( total == 0 )
+	{
+		return 0;
+	}
+	const double target = fraction * (double)total;
+	long long count = 0;
+	for ( int i = 0; i < KS_CALL_PROFILER_BUCKETS - 1; i++ )
+	{
+		count += histogram[i];
+		if ( (double)count >= target )
+		{
+			return (ksNanoseconds)2 << i;
+		}
+	}
+	return (ksNanoseconds)2 << ( KS_CALL_PROFILER_BUCKETS - 1 );
+}
+
+// One line per function that was called, in microseconds. Percentiles are bucket upper bounds.
+static void ksCallProfiler_Report( const ksCallProfiler * profiler, FILE * fp )
+{
+	fprintf( fp, "%-32s %10s %10s %9s %9s %9s %9s %11s %11s\n", "function", "calls", "total us", "avg", "p50 <", "p99 <", "max",
+			"frame avg", "frame max" );
+	for ( int i = 0; i < profiler->functionCount; i++ )
+	{
+		ksCallStats stats;
+		ksCallProfiler_GetStats( profiler, i, &stats );
+		if ( stats.calls == 0 )
+		{
+			continue;
+		}
+		fprintf( fp, "%-32s %10lld %10.0f %9.1f %9.1f %9.1f %9.1f %11.1f %11.1f\n", stats.name, stats.calls,
+				stats.nanoseconds * 1e-3,
+				stats.nanoseconds * 1e-3 / stats.calls,
+				ksCallStats_GetPercentile( stats.histogram, 0.50 ) * 1e-3,
+				ksCallStats_GetPercentile( stats.histogram, 0.99 ) * 1e-3,
+				stats.maxNanoseconds * 1e-3,
+				( stats.frames > 0 ) ? stats.frameNanoseconds * 1e-3 / stats.frames : 0.0,
+				stats.maxFrameNanoseconds * 1e-3 );
+	}
+	fprintf( fp, "%lld frames\n", profiler->frameCount );
+}
+
+#endif // !KSCALLPROFILER_H
@@ -0,0 +1,163 @@
+/*
+================================================================================================
+
+Description	:	Hash set of strings.
+Language	:	C99
+Format		:	Real tabs with the tab size equal to 4 spaces.
+
+
+DESCRIPTION
+===========
+
+A set of strings that is filled once and then queried, like the extension list of a graphics
+driver. The strings are copied into a single pool, so the set does not depend on the lifetime
+of the strings it was filled from. Lookups hash the string (FNV-1a) and probe an open
+addressing table that is kept at most half full, so a query costs one hash of the string and
+usually a single string compare, independent of the number of strings in the set.
+
+
+INTERFACE
+=========
+
+static void ksStringSet_Create( ksStringSet * set, const int expectedCount );
+static void ksStringSet_Destroy( ksStringSet * set );
+static bool ksStringSet_Contains( const ksStringSet * set, const char * string );
+static void ksStringSet_Add( ksStringSet * set, const char * string );
+static int ksStringSet_GetCount( const ksStringSet * set );
+
+A zero initialized ksStringSet is an empty set.
+
+================================================================================================
+*/
+
+#if !defined( KSSTRINGSET_H )
+#define KSSTRINGSET_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct
+{
+	uint32_t	hash;
+	uint32_t	offset;				// of the string in the pool, plus one so zero marks an empty slot
+} ksStringSetSlot;
+
+typedef struct
+{
+	ksStringSetSlot *	slots;
+	uint32_t			mask;		// number of slots minus one, the number of slots is a power of two
+	int					count;
+	char *				pool;
+	size_t				poolSize;
+	size_t				poolCapacity;
+} ksStringSet;
+
+static uint32_t ksStringSet_Hash( const char * string )
+{
+	uint32_t hash = 2166136261u;
+	for ( const unsigned char * c = (const unsigned char *)string; *c != '\0'; c++ )
+	{
+		hash = ( hash ^ *c ) * 16777619u;
+	}
+	return hash;
+}
+
+static void ksStringSet_Create( ksStringSet * set, const int expectedCount )
+{
+	memset( set, 0, sizeof( ksStringSet ) );
+	uint32_t slotCount = 16;
+	while ( slotCount < (uint32_t)expectedCount * 2 )
+	{
+		slotCount *= 2;
+	}
+	set->slots = (ksStringSetSlot *)calloc( slotCount, sizeof( ksStringSetSlot ) );
+	set->mask = slotCount - 1;
+	set->poolCapacity = ( expectedCount > 0 ? (size_t)expectedCount : 1 ) * 32;
+	set->pool = (char *)malloc( set->poolCapacity );
+}
+
+static void ksStringSet_Destroy( ksStringSet * set )
+{
+	free( set->slots );
+	free( set->pool );
+	memset( set, 0, sizeof( ksStringSet ) );
+}
+
+static void ksStringSet_Insert( ksStringSetSlot * slots, const uint32_t mask, const uint32_t hash, const uint32_t offset )
+{
+	uint32_t index = hash & mask;
+	while ( slots[index].offset != 0 )
+	{
+		index = ( index + 1 ) & mask;
+	}
+	slots[index].hash = hash;
+	slots[index].offset = offset;
+}
+
+static bool ksStringSet_Contains( const ksStringSet * set, const char * string )
+{
+	if ( set->slots == NULL )
+	{
+		return false;
+	}
+	const uint32_t hash = ksStringSet_Hash( string );
+	for ( uint32_t index = hash & set->mask; set->slots[index].offset != 0; index = ( index + 1 ) & set->mask )
+	{
+		if ( set->slots[index].hash == hash && strcmp( set->pool + set->slots[index].offset - 1, string ) == 0 )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ksStringSet_Add( ksStringSet * set, const char * string )
+{
+	if ( set->slots == NULL )
+	{
+		ksStringSet_Create( set, 0 );
+	}
+	if ( ksStringSet_Contains( set, string ) )
+	{
+		return;
+	}
+
+	if ( (uint32_t)( set->count + 1 ) * 2 > set->mask + 1 )
+	{
+		const uint32_t slotCount = ( set->mask + 1 ) * 2;
+		ksStringSetSlot * slots = (ksStringSetSlot *)calloc( slotCount, sizeof( ksStringSetSlot ) );
+		for ( uint32_t i = 0; i <= set->mask; i++ )
+		{
+			if ( set->slots[i].offset != 0 )
+			{
+				ksStringSet_Insert( slots, slotCount - 1, set->slots[i].hash, set->slots[i].offset );
+			}
+		}
+		free( set->slots );
+		set->slots = slots;
+		set->mask = slotCount - 1;
+	}
+
+	const size_t length = strlen( string ) + 1;
+	if ( set->poolSize + length > set->poolCapacity )
+	{
+		while ( set->poolSize + length > set->poolCapacity )
+		{
+			set->poolCapacity *= 2;
+		}
+		set->pool = (char *)realloc( set->pool, set->poolCapacity );
+	}
+	memcpy( set->pool + set->poolSize, string, length );
+	ksStringSet_Insert( set->slots, set->mask, ksStringSet_Hash( string ), (uint32_t)set->poolSize + 1 );
+	set->poolSize += length;
+	set->count++;
+}
+
+static int ksStringSet_GetCount( const ksStringSet * set )
+{
+	return set->count;
+}
+
+#endif // !KSSTRINGSET_H
@@ -69,11 +69,19 @@ limitations under the License.
 #elif defined( OS_APPLE )
 	#include <Foundation/NSString.h>
 	#include <Foundation/NSProcessInfo.h>
+	#include <sys/sysctl.h>						// for sysctlbyname
 #elif defined( OS_ANDROID )
 	#include <dlfcn.h>							// for dlopen
+	#include <unistd.h>							// for sysconf
+#elif defined( OS_LINUX )
+	#include <unistd.h>							// for sysconf
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>							// for offsetof
+#include <stdbool.h>
 
 static const char * GetOSVersion()
 {
@@ -243,4 +251,557 @@ static const char * GetCPUVersion()
 #endif
 }
 
+/*
+================================================================================================================================
+
+CPU topology.
+
+Describes how the logical processors map onto physical cores, packages and shared caches, and how fast
+each core is. On Linux and Android this is read from /sys/devices/system/cpu, on Windows it comes from
+GetLogicalProcessorInformationEx. Apple platforms only report the processor counts and cache sizes.
+
+Processors are identified by the numbers the operating system uses for thread affinity. On Windows
+with more than one processor group the number is the group times 64 plus the number within the group.
+
+The performance class orders cores of heterogeneous CPUs. It is the kernel's cpu_capacity or else the
+maximum frequency on Linux and Android, and the efficiency class on Windows. Higher is faster.
+
+ksCpuThreadPlacement assigns the latency-critical threads and the worker threads to processors:
+
+	- the frame thread gets the first hardware thread of the fastest physical core
+	- the frame pacing thread gets the first hardware thread of the next fastest physical core
+	- every other physical core gets one worker on its first hardware thread
+
+The SMT siblings of the frame and pacing cores stay idle, so the latency-critical threads never share
+a core with a worker. Workers do not use the siblings of their own core either, because frame work is
+mostly bound by the caches and floating-point units that siblings share. With two physical cores the
+single worker shares the core of the pacing thread, which sleeps most of the time. A processor of -1
+means the thread should not be pinned, which is the case for everything but the frame thread on a
+single core.
+
+ksCpuTopology
+ksCpuThreadPlacement
+
+static void ksCpuTopology_Create( ksCpuTopology * topology );
+static void ksCpuTopology_Destroy( ksCpuTopology * topology );
+
+static void ksCpuThreadPlacement_Create( ksCpuThreadPlacement * placement, const ksCpuTopology * topology );
+static void ksCpuThreadPlacement_Destroy( ksCpuThreadPlacement * placement );
+
+================================================================================================================================
+*/
+
+#define CPU_TOPOLOGY_MAX_PROCESSORS		1024
+#define CPU_TOPOLOGY_MAX_CACHES			4
+
+typedef struct
+{
+	int		processor;			// operating system processor number
+	int		package;			// index of the physical package
+	int		core;				// index of the physical core
+	int		sibling;			// index of the hardware thread within the core, 0 for the first thread
+	int		lastLevelCache;		// index of the last level cache instance used by this processor
+	int		maxFrequency;		// in kHz, 0 if unknown
+	int		performance;		// performance class, higher is faster
+} ksCpuProcessor;
+
+typedef struct
+{
+	int		level;
+	int		sizeKB;
+	int		sharedBy;			// number of logical processors sharing one instance, 0 if unknown
+} ksCpuCache;
+
+typedef struct
+{
+	ksCpuProcessor *	processors;
+	int					processorCount;
+	int					coreCount;
+	int					packageCount;
+	int					threadsPerCore;			// hardware threads of the core with the most threads
+	int					lastLevelCacheCount;
+	int					maxFrequency;			// in kHz of the fastest core, 0 if unknown
+	int					fastCoreCount;			// number of cores in the highest performance class
+	ksCpuCache			caches[CPU_TOPOLOGY_MAX_CACHES];	// data and unified caches seen by the first processor
+	int					cacheCount;
+} ksCpuTopology;
+
+typedef struct
+{
+	int		frameProcessor;
+	int		pacingProcessor;
+	int *	workerProcessors;
+	int		workerCount;
+} ksCpuThreadPlacement;
+
+static ksCpuProcessor * ksCpuTopology_AddProcessor( ksCpuTopology * topology, const int processor )
+{
+	ksCpuProcessor * cpu = &topology->processors[topology->processorCount++];
+	cpu->processor = processor;
+	cpu->package = 0;
+	cpu->core = processor;
+	cpu->sibling = 0;
+	cpu->lastLevelCache = 0;
+	cpu->maxFrequency = 0;
+	cpu->performance = 0;
+	return cpu;
+}
+
+static void ksCpuTopology_AddCache( ksCpuTopology * topology, const int level, const int sizeKB, const int sharedBy )
+{
+	if ( topology->cacheCount < CPU_TOPOLOGY_MAX_CACHES )
+	{
+		ksCpuCache * cache = &topology->caches[topology->cacheCount++];
+		cache->level = level;
+		cache->sizeKB = sizeKB;
+		cache->sharedBy = sharedBy;
+	}
+}
+
+// Replaces the operating system identifiers in a field with indices that count up from zero.
+static int ksCpuTopology_Renumber( ksCpuTopology * topology, const size_t fieldOffset )
+{
+	int * ids = (int *)malloc( topology->processorCount * sizeof( int ) );
+	int idCount = 0;
+	for ( int i = 0; i < topology->processorCount; i++ )
+	{
+		int * field = (int *)( (char *)&topology->processors[i] + fieldOffset );
+		int index = 0;
+		while ( index < idCount && ids[index] != *field )
+		{
+			index++;
+		}
+		if ( index == idCount )
+		{
+			ids[idCount++] = *field;
+		}
+		*field = index;
+	}
+	free( ids );
+	return idCount;
+}
+
+// Called after the platform code stored operating system identifiers for the package, core and last level cache.
+static void ksCpuTopology_Finalize( ksCpuTopology * topology )
+{
+	if ( topology->processorCount == 0 )
+	{
+		ksCpuTopology_AddProcessor( topology, 0 );
+	}
+
+	topology->packageCount = ksCpuTopology_Renumber( topology, offsetof( ksCpuProcessor, package ) );
+	topology->coreCount = ksCpuTopology_Renumber( topology, offsetof( ksCpuProcessor, core ) );
+	topology->lastLevelCacheCount = ksCpuTopology_Renumber( topology, offsetof( ksCpuProcessor, lastLevelCache ) );
+
+	int bestPerformance = 0;
+	for ( int i = 0; i < topology->processorCount; i++ )
+	{
+		const ksCpuProcessor * cpu = &topology->processors[i];
+		topology->threadsPerCore = ( cpu->sibling + 1 > topology->threadsPerCore ) ? cpu->sibling + 1 : topology->threadsPerCore;
+		topology->maxFrequency = ( cpu->maxFrequency > topology->maxFrequency ) ? cpu->maxFrequency : topology->maxFrequency;
+		bestPerformance = ( cpu->performance > bestPerformance ) ? cpu->performance : bestPerformance;
+	}
+	for ( int i = 0; i < topology->processorCount; i++ )
+	{
+		const ksCpuProcessor * cpu = &topology->processors[i];
+		if ( cpu->sibling == 0 && cpu->performance == bestPerformance )
+		{
+			topology->fastCoreCount++;
+		}
+	}
+}
+
+#if defined( OS_LINUX ) || defined( OS_ANDROID )
+
+static bool ksCpuTopology_ReadLine( const char * fileName, char * buffer, const size_t bufferSize )
+{
+	FILE * fp = fopen( fileName, "r" );
+	if ( fp == NULL )
+	{
+		return false;
+	}
+	const bool result = ( fgets( buffer, (int)bufferSize, fp ) != NULL );
+	fclose( fp );
+	return result;
+}
+
+static int ksCpuTopology_ReadInt( const char * fileName, const int defaultValue )
+{
+	char buffer[64];
+	if ( !ksCpuTopology_ReadLine( fileName, buffer, sizeof( buffer ) ) )
+	{
+		return defaultValue;
+	}
+	char * end = NULL;
+	const long value = strtol( buffer, &end, 10 );
+	return ( end != buffer ) ? (int)value : defaultValue;
+}
+
+// Expands a processor list like "0-3,8-11" and returns the number of processors in it. 'processors' may be NULL to only count.
+static int ksCpuTopology_ParseList( const char * list, int * processors, const int maxProcessors )
+{
+	int count = 0;
+	for ( const char * c = list; *c != '\0' && count < maxProcessors; )
+	{
+		if ( *c < '0' || *c > '9' )
+		{
+			c++;
+			continue;
+		}
+		char * end = NULL;
+		const int first = (int)strtol( c, &end, 10 );
+		int last = first;
+		if ( *end == '-' )
+		{
+			last = (int)strtol( end + 1, &end, 10 );
+		}
+		for ( int processor = first; processor <= last && count < maxProcessors; processor++ )
+		{
+			if ( processors != NULL )
+			{
+				processors[count] = processor;
+			}
+			count++;
+		}
+		c = end;
+	}
+	return count;
+}
+
+static void ksCpuTopology_ReadSystem( ksCpuTopology * topology )
+{
+	static const char * path = "/sys/devices/system/cpu";
+	char fileName[256];
+	char buffer[4096];
+
+	int * online = (int *)malloc( CPU_TOPOLOGY_MAX_PROCESSORS * sizeof( int ) );
+	int onlineCount = 0;
+	snprintf( fileName, sizeof( fileName ), "%s/online", path );
+	if ( ksCpuTopology_ReadLine( fileName, buffer, sizeof( buffer ) ) )
+	{
+		onlineCount = ksCpuTopology_ParseList( buffer, online, CPU_TOPOLOGY_MAX_PROCESSORS );
+	}
+	if ( onlineCount == 0 )
+	{
+		const long count = sysconf( _SC_NPROCESSORS_ONLN );
+		for ( onlineCount = 0; onlineCount < count && onlineCount < CPU_TOPOLOGY_MAX_PROCESSORS; onlineCount++ )
+		{
+			online[onlineCount] = onlineCount;
+		}
+	}
+
+	for ( int i = 0; i < onlineCount; i++ )
+	{
+		const int processor = online[i];
+		ksCpuProcessor * cpu = ksCpuTopology_AddProcessor( topology, processor );
+
+		snprintf( fileName, sizeof( fileName ), "%s/cpu%d/topology/physical_package_id", path, processor );
+		cpu->package = ksCpuTopology_ReadInt( fileName, 0 );
+
+		// A core is identified by its first hardware thread, because core_id is only unique within a package or cluster.
+		snprintf( fileName, sizeof( fileName ), "%s/cpu%d/topology/thread_siblings_list", path, processor );
+		if ( ksCpuTopology_ReadLine( fileName, buffer, sizeof( buffer ) ) )
+		{
+			int siblings[64];
+			const int siblingCount = ksCpuTopology_ParseList( buffer, siblings, 64 );
+			for ( int j = 0; j < siblingCount; j++ )
+			{
+				if ( siblings[j] == processor )
+				{
+					cpu->core = siblings[0];
+					cpu->sibling = j;
+					break;
+				}
+			}
+		}
+
+		snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cpufreq/cpuinfo_max_freq", path, processor );
+		cpu->maxFrequency = ksCpuTopology_ReadInt( fileName, 0 );
+		snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cpu_capacity", path, processor );
+		const int capacity = ksCpuTopology_ReadInt( fileName, 0 );
+		cpu->performance = ( capacity > 0 ) ? capacity : cpu->maxFrequency / 1000;
+
+		// The last level cache instance is identified by the first processor that shares it.
+		int lastLevel = 0;
+		for ( int index = 0; ; index++ )
+		{
+			snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cache/index%d/level", path, processor, index );
+			const int level = ksCpuTopology_ReadInt( fileName, 0 );
+			if ( level == 0 )
+			{
+				break;
+			}
+			snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cache/index%d/type", path, processor, index );
+			if ( !ksCpuTopology_ReadLine( fileName, buffer, sizeof( buffer ) ) || strncmp( buffer, "Instruction", 11 ) == 0 )
+			{
+				continue;
+			}
+			snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cache/index%d/shared_cpu_list", path, processor, index );
+			int sharedBy = 0;
+			int firstShared = processor;
+			if ( ksCpuTopology_ReadLine( fileName, buffer, sizeof( buffer ) ) )
+			{
+				sharedBy = ksCpuTopology_ParseList( buffer, NULL, CPU_TOPOLOGY_MAX_PROCESSORS );
+				ksCpuTopology_ParseList( buffer, &firstShared, 1 );
+			}
+			if ( level > lastLevel )
+			{
+				lastLevel = level;
+				cpu->lastLevelCache = firstShared;
+			}
+			if ( i == 0 )
+			{
+				snprintf( fileName, sizeof( fileName ), "%s/cpu%d/cache/index%d/size", path, processor, index );
+				char size[64];
+				int sizeKB = 0;
+				if ( ksCpuTopology_ReadLine( fileName, size, sizeof( size ) ) )
+				{
+					char * unit = NULL;
+					sizeKB = (int)strtol( size, &unit, 10 );
+					sizeKB = ( *unit == 'M' ) ? sizeKB * 1024 : sizeKB;
+				}
+				ksCpuTopology_AddCache( topology, level, sizeKB, sharedBy );
+			}
+		}
+	}
+
+	free( online );
+}
+
+#elif defined( OS_WINDOWS )
+
+static int ksCpuTopology_BitCount( KAFFINITY mask )
+{
+	int count = 0;
+	for ( ; mask != 0; mask &= mask - 1 )
+	{
+		count++;
+	}
+	return count;
+}
+
+static ksCpuProcessor * ksCpuTopology_FindProcessor( ksCpuTopology * topology, const int processor )
+{
+	for ( int i = 0; i < topology->processorCount; i++ )
+	{
+		if ( topology->processors[i].processor == processor )
+		{
+			return &topology->processors[i];
+		}
+	}
+	return NULL;
+}
+
+static int ksCpuTopology_ReadFrequency( const int processor )
+{
+	char keyName[128];
+	snprintf( keyName, sizeof( keyName ), "HARDWARE\\DESCRIPTION\\System\\CentralProcessor\\%d", processor );
+	HKEY hKey = 0;
+	DWORD megaHertz = 0;
+	if ( RegOpenKeyA( HKEY_LOCAL_MACHINE, keyName, &hKey ) == ERROR_SUCCESS )
+	{
+		DWORD length = sizeof( megaHertz );
+		DWORD dwType = REG_DWORD;
+		if ( RegQueryValueExA( hKey, "~MHz", NULL, &dwType, (LPBYTE)&megaHertz, &length ) != ERROR_SUCCESS )
+		{
+			megaHertz = 0;
+		}
+		RegCloseKey( hKey );
+	}
+	return (int)megaHertz * 1000;
+}
+
+static void ksCpuTopology_ReadSystem( ksCpuTopology * topology )
+{
+	DWORD length = 0;
+	GetLogicalProcessorInformationEx( RelationAll, NULL, &length );
+	char * buffer = (char *)malloc( length );
+	if ( length == 0 || !GetLogicalProcessorInformationEx( RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer, &length ) )
+	{
+		free( buffer );
+		return;
+	}
+
+	// The cores come first so the packages and caches can refer to their processors.
+	int coreIndex = 0;
+	for ( DWORD offset = 0; offset < length; )
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX * info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)( buffer + offset );
+		offset += info->Size;
+		if ( info->Relationship != RelationProcessorCore )
+		{
+			continue;
+		}
+		int sibling = 0;
+		for ( int group = 0; group < info->Processor.GroupCount; group++ )
+		{
+			const GROUP_AFFINITY * affinity = &info->Processor.GroupMask[group];
+			for ( int bit = 0; bit < (int)( sizeof( KAFFINITY ) * 8 ); bit++ )
+			{
+				if ( ( affinity->Mask & ( (KAFFINITY)1 << bit ) ) != 0 && topology->processorCount < CPU_TOPOLOGY_MAX_PROCESSORS )
+				{
+					ksCpuProcessor * cpu = ksCpuTopology_AddProcessor( topology, affinity->Group * 64 + bit );
+					cpu->core = coreIndex;
+					cpu->sibling = sibling++;
+					cpu->maxFrequency = ksCpuTopology_ReadFrequency( cpu->processor );
+					cpu->performance = info->Processor.EfficiencyClass;
+				}
+			}
+		}
+		coreIndex++;
+	}
+
+	int * cacheLevels = (int *)calloc( topology->processorCount, sizeof( int ) );
+	int packageIndex = 0;
+	int cacheIndex = 0;
+	for ( DWORD offset = 0; offset < length; )
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX * info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX *)( buffer + offset );
+		offset += info->Size;
+		if ( info->Relationship == RelationProcessorPackage )
+		{
+			for ( int group = 0; group < info->Processor.GroupCount; group++ )
+			{
+				const GROUP_AFFINITY * affinity = &info->Processor.GroupMask[group];
+				for ( int bit = 0; bit < (int)( sizeof( KAFFINITY ) * 8 ); bit++ )
+				{
+					ksCpuProcessor * cpu = ksCpuTopology_FindProcessor( topology, affinity->Group * 64 + bit );
+					if ( ( affinity->Mask & ( (KAFFINITY)1 << bit ) ) != 0 && cpu != NULL )
+					{
+						cpu->package = packageIndex;
+					}
+				}
+			}
+			packageIndex++;
+		}
+		else if ( info->Relationship == RelationCache && info->Cache.Type != CacheInstruction )
+		{
+			const GROUP_AFFINITY * affinity = &info->Cache.GroupMask;
+			for ( int bit = 0; bit < (int)( sizeof( KAFFINITY ) * 8 ); bit++ )
+			{
+				ksCpuProcessor * cpu = ksCpuTopology_FindProcessor( topology, affinity->Group * 64 + bit );
+				if ( ( affinity->Mask & ( (KAFFINITY)1 << bit ) ) != 0 && cpu != NULL && info->Cache.Level > cacheLevels[cpu - topology->processors] )
+				{
+					cacheLevels[cpu - topology->processors] = info->Cache.Level;
+					cpu->lastLevelCache = cacheIndex;
+				}
+			}
+			if ( affinity->Group == 0 && ( affinity->Mask & 1 ) != 0 )
+			{
+				ksCpuTopology_AddCache( topology, info->Cache.Level, (int)( info->Cache.CacheSize / 1024 ), ksCpuTopology_BitCount( affinity->Mask ) );
+			}
+			cacheIndex++;
+		}
+	}
+
+	free( cacheLevels );
+	free( buffer );
+}
+
+#elif defined( OS_APPLE )
+
+static void ksCpuTopology_ReadSystem( ksCpuTopology * topology )
+{
+	int logicalCount = 1;
+	int physicalCount = 1;
+	size_t size = sizeof( int );
+	sysctlbyname( "hw.logicalcpu", &logicalCount, &size, NULL, 0 );
+	size = sizeof( int );
+	sysctlbyname( "hw.physicalcpu", &physicalCount, &size, NULL, 0 );
+	const int threadsPerCore = ( physicalCount > 0 && logicalCount >= physicalCount ) ? logicalCount / physicalCount : 1;
+	for ( int i = 0; i < logicalCount && i < CPU_TOPOLOGY_MAX_PROCESSORS; i++ )
+	{
+		ksCpuProcessor * cpu = ksCpuTopology_AddProcessor( topology, i );
+		cpu->core = i / threadsPerCore;
+		cpu->sibling = i % threadsPerCore;
+	}
+
+	const char * names[] = { "hw.l1dcachesize", "hw.l2cachesize", "hw.l3cachesize" };
+	for ( int level = 1; level <= 3; level++ )
+	{
+		long long cacheSize = 0;
+		size = sizeof( cacheSize );
+		if ( sysctlbyname( names[level - 1], &cacheSize, &size, NULL, 0 ) == 0 && cacheSize > 0 )
+		{
+			ksCpuTopology_AddCache( topology, level, (int)( cacheSize / 1024 ), 0 );
+		}
+	}
+}
+
+#else
+
+static void ksCpuTopology_ReadSystem( ksCpuTopology * topology )
+{
+	ksCpuTopology_AddProcessor( topology, 0 );
+}
+
+#endif
+
+static void ksCpuTopology_Create( ksCpuTopology * topology )
+{
+	memset( topology, 0, sizeof( ksCpuTopology ) );
+	topology->processors = (ksCpuProcessor *)malloc( CPU_TOPOLOGY_MAX_PROCESSORS * sizeof( ksCpuProcessor ) );
+	ksCpuTopology_ReadSystem( topology );
+	ksCpuTopology_Finalize( topology );
+}
+
+static void ksCpuTopology_Destroy( ksCpuTopology * topology )
+{
+	free( topology->processors );
+	memset( topology, 0, sizeof( ksCpuTopology ) );
+}
+
+static void ksCpuThreadPlacement_Create( ksCpuThreadPlacement * placement, const ksCpuTopology * topology )
+{
+	placement->frameProcessor = -1;
+	placement->pacingProcessor = -1;
+	placement->workerProcessors = (int *)malloc( topology->processorCount * sizeof( int ) );
+	placement->workerCount = 0;
+
+	// The first hardware thread of each core, ordered from the fastest to the slowest core.
+	int * cores = (int *)malloc( topology->coreCount * sizeof( int ) );
+	int coreCount = 0;
+	for ( int i = 0; i < topology->processorCount; i++ )
+	{
+		const ksCpuProcessor * cpu = &topology->processors[i];
+		if ( cpu->sibling != 0 )
+		{
+			continue;
+		}
+		int j = coreCount++;
+		for ( ; j > 0 && topology->processors[cores[j - 1]].performance < cpu->performance; j-- )
+		{
+			cores[j] = cores[j - 1];
+		}
+		cores[j] = i;
+	}
+
+	if ( coreCount >= 2 )
+	{
+		placement->frameProcessor = topology->processors[cores[0]].processor;
+		placement->pacingProcessor = topology->processors[cores[1]].processor;
+		for ( int i = ( coreCount >= 3 ) ? 2 : 1; i < coreCount; i++ )
+		{
+			placement->workerProcessors[placement->workerCount++] = topology->processors[cores[i]].processor;
+		}
+	}
+	else if ( topology->processorCount >= 2 )
+	{
+		// A single core with hardware threads only keeps the frame thread to itself.
+		placement->frameProcessor = topology->processors[cores[0]].processor;
+		for ( int i = 1; i < topology->processorCount; i++ )
+		{
+			placement->workerProcessors[placement->workerCount++] = -1;
+		}
+	}
+
+	free( cores );
+}
+
+static void ksCpuThreadPlacement_Destroy( ksCpuThreadPlacement * placement )
+{
+	free( placement->workerProcessors );
+	memset( placement, 0, sizeof( ksCpuThreadPlacement ) );
+}
+
 #endif // !KSSYSINFO_H
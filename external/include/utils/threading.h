@@ -69,9 +69,16 @@ limitations under the License.
 #elif defined( OS_LINUX )
 	#include <time.h>							// for timespec
 	#include <sys/time.h>						// for gettimeofday()
+	#include <unistd.h>							// for sysconf()
+	#include <errno.h>							// for EBUSY, ETIMEDOUT
 	#include <pthread.h>						// for pthread_create() etc.
+	#include <fcntl.h>							// for open()
+	#include <sys/resource.h>					// for setpriority()
+	#include <sys/syscall.h>					// for SYS_gettid
 #elif defined( OS_APPLE )
 	#include <sys/time.h>
+	#include <unistd.h>
+	#include <errno.h>
 	#include <pthread.h>
 #elif defined( OS_ANDROID )
 	#include <time.h>
@@ -80,18 +87,49 @@ limitations under the License.
 	#include <sys/prctl.h>						// for prctl( PR_SET_NAME )
 	#include <sys/stat.h>						// for gettid
 	#include <sys/syscall.h>					// for syscall
+	#include <sys/resource.h>					// for setpriority()
+	#include <fcntl.h>							// for open()
+	#include <errno.h>
 #elif defined( OS_HEXAGON )
 	#include "qurt.h"
 	#include "qurt_atomic_ops.h"
 #endif
 
+#include <stdio.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#if !defined( OS_WINDOWS ) && !defined( OS_HEXAGON )
+	#include <sched.h>							// for sched_yield()
+#endif
+#if defined( _MSC_VER )
+	#include <intrin.h>
+#endif
+#include <stdint.h>							// for intptr_t
+
+// On Linux and Android ksMutex and ksSignal are built directly on futexes.
+// Define THREADING_DISABLE_FUTEX to use the pthread implementation instead.
+#if ( defined( OS_LINUX ) || defined( OS_ANDROID ) ) && !defined( THREADING_DISABLE_FUTEX )
+	#define THREADING_FUTEX
+	#include <limits.h>							// for INT_MAX
+	#include <sys/syscall.h>					// for SYS_futex
+	#include <linux/futex.h>					// for FUTEX_WAIT_PRIVATE, FUTEX_WAKE_PRIVATE
+#endif
 #include "nanoseconds.h"
+#include "sysinfo.h"						// for ksCpuTopology
 
 #if !defined( UNUSED_PARM )
 #define UNUSED_PARM( x )				{ (void)(x); }
 #endif
 
+#if !defined( THREAD_LOCAL )
+	#if defined( _MSC_VER )
+		#define THREAD_LOCAL	__declspec( thread )
+	#else
+		#define THREAD_LOCAL	__thread
+	#endif
+#endif
+
 /*
 ================================================================================================================================
 
@@ -127,11 +165,161 @@ static ksAtomicUint32 ksAtomicUint32_Decrement( ksAtomicUint32 * atomicUint32 )
 /*
 ================================================================================================================================
 
+Atomic operations with explicit memory ordering.
+
+The ksAtomicUint32 functions above are full barriers. The lock-free structures below only need
+the ordering spelled out in the function names: relaxed, acquire for loads, release for stores,
+and sequential consistency for the read-modify-write operations and the full fence.
+
+ksAtomicInt64
+ksAtomicPointer
+
+static long long ksAtomicInt64_LoadRelaxed( const ksAtomicInt64 * atomic );
+static long long ksAtomicInt64_LoadAcquire( const ksAtomicInt64 * atomic );
+static void ksAtomicInt64_StoreRelaxed( ksAtomicInt64 * atomic, const long long value );
+static void ksAtomicInt64_StoreRelease( ksAtomicInt64 * atomic, const long long value );
+static long long ksAtomicInt64_Add( ksAtomicInt64 * atomic, const long long value );
+static long long ksAtomicInt64_Exchange( ksAtomicInt64 * atomic, const long long value );
+static bool ksAtomicInt64_CompareExchange( ksAtomicInt64 * atomic, const long long expected, const long long desired );
+
+static void * ksAtomicPointer_LoadRelaxed( ksAtomicPointer * atomic );
+static void * ksAtomicPointer_LoadAcquire( ksAtomicPointer * atomic );
+static void ksAtomicPointer_StoreRelaxed( ksAtomicPointer * atomic, void * value );
+static void ksAtomicPointer_StoreRelease( ksAtomicPointer * atomic, void * value );
+static void * ksAtomicPointer_Exchange( ksAtomicPointer * atomic, void * value );
+static bool ksAtomicPointer_CompareExchange( ksAtomicPointer * atomic, void * expected, void * desired );
+
+static void ksAtomic_ThreadFenceAcquire();
+static void ksAtomic_ThreadFenceRelease();
+static void ksAtomic_ThreadFenceSeqCst();
+static void ksAtomic_Pause();
+
+================================================================================================================================
+*/
+
+typedef long long ksAtomicInt64;
+typedef void * ksAtomicPointer;
+
+#define THREAD_CACHE_LINE_SIZE		64		// for padding data written by different threads onto separate cache lines
+
+#if defined( _MSC_VER )
+
+// 64-bit targets only. Aligned loads and stores are atomic and x64 only reorders stores after loads.
+static long long ksAtomicInt64_LoadRelaxed( const ksAtomicInt64 * atomic ) { return *(volatile const long long *)atomic; }
+static long long ksAtomicInt64_LoadAcquire( const ksAtomicInt64 * atomic ) { const long long value = *(volatile const long long *)atomic; _ReadWriteBarrier(); return value; }
+static void ksAtomicInt64_StoreRelaxed( ksAtomicInt64 * atomic, const long long value ) { *(volatile long long *)atomic = value; }
+static void ksAtomicInt64_StoreRelease( ksAtomicInt64 * atomic, const long long value ) { _ReadWriteBarrier(); *(volatile long long *)atomic = value; }
+static long long ksAtomicInt64_Add( ksAtomicInt64 * atomic, const long long value ) { return InterlockedExchangeAdd64( (volatile LONG64 *)atomic, value ) + value; }
+static long long ksAtomicInt64_Exchange( ksAtomicInt64 * atomic, const long long value ) { return InterlockedExchange64( (volatile LONG64 *)atomic, value ); }
+static bool ksAtomicInt64_CompareExchange( ksAtomicInt64 * atomic, const long long expected, const long long desired ) { return InterlockedCompareExchange64( (volatile LONG64 *)atomic, desired, expected ) == expected; }
+
+static void * ksAtomicPointer_LoadRelaxed( ksAtomicPointer * atomic ) { return *(void * volatile *)atomic; }
+static void * ksAtomicPointer_LoadAcquire( ksAtomicPointer * atomic ) { void * value = *(void * volatile *)atomic; _ReadWriteBarrier(); return value; }
+static void ksAtomicPointer_StoreRelaxed( ksAtomicPointer * atomic, void * value ) { *(void * volatile *)atomic = value; }
+static void ksAtomicPointer_StoreRelease( ksAtomicPointer * atomic, void * value ) { _ReadWriteBarrier(); *(void * volatile *)atomic = value; }
+static void * ksAtomicPointer_Exchange( ksAtomicPointer * atomic, void * value ) { return InterlockedExchangePointer( atomic, value ); }
+static bool ksAtomicPointer_CompareExchange( ksAtomicPointer * atomic, void * expected, void * desired ) { return InterlockedCompareExchangePointer( atomic, desired, expected ) == expected; }
+
+static void ksAtomic_ThreadFenceAcquire() { _ReadWriteBarrier(); }
+static void ksAtomic_ThreadFenceRelease() { _ReadWriteBarrier(); }
+static void ksAtomic_ThreadFenceSeqCst() { MemoryBarrier(); }
+static void ksAtomic_Pause() { YieldProcessor(); }
+
+#else
+
+static long long ksAtomicInt64_LoadRelaxed( const ksAtomicInt64 * atomic ) { return __atomic_load_n( atomic, __ATOMIC_RELAXED ); }
+static long long ksAtomicInt64_LoadAcquire( const ksAtomicInt64 * atomic ) { return __atomic_load_n( atomic, __ATOMIC_ACQUIRE ); }
+static void ksAtomicInt64_StoreRelaxed( ksAtomicInt64 * atomic, const long long value ) { __atomic_store_n( atomic, value, __ATOMIC_RELAXED ); }
+static void ksAtomicInt64_StoreRelease( ksAtomicInt64 * atomic, const long long value ) { __atomic_store_n( atomic, value, __ATOMIC_RELEASE ); }
+static long long ksAtomicInt64_Add( ksAtomicInt64 * atomic, const long long value ) { return __atomic_add_fetch( atomic, value, __ATOMIC_SEQ_CST ); }
+static long long ksAtomicInt64_Exchange( ksAtomicInt64 * atomic, const long long value ) { return __atomic_exchange_n( atomic, value, __ATOMIC_SEQ_CST ); }
+static bool ksAtomicInt64_CompareExchange( ksAtomicInt64 * atomic, const long long expected, const long long desired )
+{
+	long long expectedCopy = expected;
+	return __atomic_compare_exchange_n( atomic, &expectedCopy, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+}
+
+static void * ksAtomicPointer_LoadRelaxed( ksAtomicPointer * atomic ) { return __atomic_load_n( atomic, __ATOMIC_RELAXED ); }
+static void * ksAtomicPointer_LoadAcquire( ksAtomicPointer * atomic ) { return __atomic_load_n( atomic, __ATOMIC_ACQUIRE ); }
+static void ksAtomicPointer_StoreRelaxed( ksAtomicPointer * atomic, void * value ) { __atomic_store_n( atomic, value, __ATOMIC_RELAXED ); }
+static void ksAtomicPointer_StoreRelease( ksAtomicPointer * atomic, void * value ) { __atomic_store_n( atomic, value, __ATOMIC_RELEASE ); }
+static void * ksAtomicPointer_Exchange( ksAtomicPointer * atomic, void * value ) { return __atomic_exchange_n( atomic, value, __ATOMIC_SEQ_CST ); }
+static bool ksAtomicPointer_CompareExchange( ksAtomicPointer * atomic, void * expected, void * desired )
+{
+	void * expectedCopy = expected;
+	return __atomic_compare_exchange_n( atomic, &expectedCopy, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED );
+}
+
+static void ksAtomic_ThreadFenceAcquire() { __atomic_thread_fence( __ATOMIC_ACQUIRE ); }
+static void ksAtomic_ThreadFenceRelease() { __atomic_thread_fence( __ATOMIC_RELEASE ); }
+static void ksAtomic_ThreadFenceSeqCst() { __atomic_thread_fence( __ATOMIC_SEQ_CST ); }
+static void ksAtomic_Pause()
+{
+#if defined( __i386__ ) || defined( __x86_64__ )
+	__builtin_ia32_pause();
+#elif defined( __aarch64__ ) || defined( __arm__ )
+	__asm__ __volatile__( "yield" );
+#endif
+}
+
+#endif
+
+#if defined( THREADING_FUTEX )
+
+/*
+================================================================================================================================
+
+Futex wait and wake.
+
+A futex wait only blocks if the 32-bit word still holds the expected value, which closes the window
+between checking a condition and going to sleep without a separate lock. Waits may return spuriously,
+so callers always re-check their condition.
+
+================================================================================================================================
+*/
+
+#define FUTEX_SPIN_COUNT		100			// pause iterations before a contended lock parks in the kernel
+
+static int ksFutex_Load( const int * address ) { return __atomic_load_n( address, __ATOMIC_ACQUIRE ); }
+static int ksFutex_Exchange( int * address, const int value ) { return __atomic_exchange_n( address, value, __ATOMIC_ACQ_REL ); }
+static bool ksFutex_CompareExchange( int * address, int expected, const int desired )
+{
+	return __atomic_compare_exchange_n( address, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+}
+
+// Blocks while the word at 'address' equals 'expected'. The 'timeOut' is relative and NULL waits indefinitely.
+static void ksFutex_Wait( int * address, const int expected, const struct timespec * timeOut )
+{
+	syscall( SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, timeOut, NULL, 0 );
+}
+
+static void ksFutex_Wake( int * address, const int count )
+{
+	syscall( SYS_futex, address, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0 );
+}
+
+static ksNanoseconds ksFutex_GetTimeNanoseconds()
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (ksNanoseconds) ts.tv_sec * 1000ULL * 1000ULL * 1000ULL + ts.tv_nsec;
+}
+
+#endif
+
+/*
+================================================================================================================================
+
 Mutex for mutual exclusion on shared resources within a single process.
 
 Equivalent to a Windows Critical Section Object which allows recursive access. This mutex cannot be
 used for mutual-exclusion synchronization between threads from different processes.
 
+With THREADING_FUTEX the mutex is the three state futex lock from Ulrich Drepper, "Futexes Are Tricky".
+An uncontended lock and unlock are a single atomic operation each. A contended lock spins briefly before
+it parks in the kernel, and unlock only makes a system call if a thread may be parked. Recursion is
+handled by the owning thread, so it does not touch the shared word.
+
 ksMutex
 
 static void ksMutex_Create( ksMutex * mutex );
@@ -148,17 +336,39 @@ typedef struct
 	CRITICAL_SECTION	handle;
 #elif defined( OS_HEXAGON )
 	qurt_mutex_t		mutex;
+#elif defined( THREADING_FUTEX )
+	int					state;			// 0 = unlocked, 1 = locked, 2 = locked and threads may be parked
+	int					owner;			// kernel thread id of the owner for recursive locking, 0 if unlocked
+	int					recursion;		// only accessed by the owning thread
 #else
 	pthread_mutex_t		mutex;
 #endif
 } ksMutex;
 
+#if defined( THREADING_FUTEX )
+// The thread id is the same in every translation unit, only the cache of it is not.
+static THREAD_LOCAL int ksMutex_ThreadId;
+
+static inline int ksMutex_GetThreadId()
+{
+	if ( ksMutex_ThreadId == 0 )
+	{
+		ksMutex_ThreadId = (int)syscall( SYS_gettid );
+	}
+	return ksMutex_ThreadId;
+}
+#endif
+
 static void ksMutex_Create( ksMutex * mutex )
 {
 #if defined( OS_WINDOWS )
 	InitializeCriticalSection( &mutex->handle );
 #elif defined( OS_HEXAGON )
 	qurt_rmutex_init( &mutex->mutex );
+#elif defined( THREADING_FUTEX )
+	mutex->state = 0;
+	mutex->owner = 0;
+	mutex->recursion = 0;
 #else
 	pthread_mutexattr_t attr;
 	pthread_mutexattr_init( &attr );
@@ -173,6 +383,8 @@ static void ksMutex_Destroy( ksMutex * mutex )
 	DeleteCriticalSection( &mutex->handle );
 #elif defined( OS_HEXAGON )
 	qurt_rmutex_destroy( &mutex->mutex );
+#elif defined( THREADING_FUTEX )
+	UNUSED_PARM( mutex );
 #else
 	pthread_mutex_destroy( &mutex->mutex );
 #endif
@@ -200,6 +412,37 @@ static bool ksMutex_Lock( ksMutex * mutex, const bool blocking )
 		qurt_rmutex_lock( &mutex->mutex );
 	}
 	return true;
+#elif defined( THREADING_FUTEX )
+	const int self = ksMutex_GetThreadId();
+	if ( __atomic_load_n( &mutex->owner, __ATOMIC_RELAXED ) == self )
+	{
+		mutex->recursion++;
+		return true;
+	}
+	if ( !ksFutex_CompareExchange( &mutex->state, 0, 1 ) )
+	{
+		if ( !blocking )
+		{
+			return false;
+		}
+		bool locked = false;
+		for ( int spin = 0; spin < FUTEX_SPIN_COUNT && !locked; spin++ )
+		{
+			ksAtomic_Pause();
+			locked = ( ksFutex_Load( &mutex->state ) == 0 && ksFutex_CompareExchange( &mutex->state, 0, 1 ) );
+		}
+		if ( !locked )
+		{
+			// Mark the lock contended so the owner wakes a parked thread on unlock.
+			while ( ksFutex_Exchange( &mutex->state, 2 ) != 0 )
+			{
+				ksFutex_Wait( &mutex->state, 2, NULL );
+			}
+		}
+	}
+	__atomic_store_n( &mutex->owner, self, __ATOMIC_RELAXED );
+	mutex->recursion = 1;
+	return true;
 #else
 	if ( pthread_mutex_trylock( &mutex->mutex ) == EBUSY )
 	{
@@ -219,6 +462,16 @@ static void ksMutex_Unlock( ksMutex * mutex )
 	LeaveCriticalSection( &mutex->handle );
 #elif defined( OS_HEXAGON )
 	qurt_rmutex_unlock( &mutex->mutex );
+#elif defined( THREADING_FUTEX )
+	if ( --mutex->recursion > 0 )
+	{
+		return;
+	}
+	__atomic_store_n( &mutex->owner, 0, __ATOMIC_RELAXED );
+	if ( ksFutex_Exchange( &mutex->state, 0 ) == 2 )
+	{
+		ksFutex_Wake( &mutex->state, 1 );
+	}
 #else
 	pthread_mutex_unlock( &mutex->mutex );
 #endif
@@ -272,6 +525,10 @@ state after the APC is complete. If a call to PulseEvent occurs during the time
 been temporarily removed from the wait state, then the thread will not be released, because PulseEvent
 releases only those threads that are in the wait state at the moment PulseEvent is called.
 
+With THREADING_FUTEX the signalled state is a futex word next to a count of parked waiters. Raising a
+signal nobody waits on is a single atomic exchange. Raising a signal with parked waiters makes one wake
+system call. Waiting on a raised signal never enters the kernel.
+
 ksSignal
 
 static void ksSignal_Create( ksSignal * signal, const bool autoReset );
@@ -295,6 +552,10 @@ typedef struct
 	int				waitCount;		// number of threads waiting on the signal
 	bool			autoReset;		// automatically clear the signalled state when a single thread is released
 	bool			signaled;		// in the signalled state if true
+#elif defined( THREADING_FUTEX )
+	int				signaled;		// futex word, 1 in the signalled state
+	int				waiters;		// number of threads that may be parked on 'signaled'
+	bool			autoReset;		// automatically clear the signalled state when a single thread is released
 #else
 	pthread_mutex_t	mutex;
 	pthread_cond_t	cond;
@@ -314,6 +575,10 @@ static void ksSignal_Create( ksSignal * signal, const bool autoReset )
 	signal->waitCount = 0;
 	signal->autoReset = autoReset;
 	signal->signaled = false;
+#elif defined( THREADING_FUTEX )
+	signal->signaled = 0;
+	signal->waiters = 0;
+	signal->autoReset = autoReset;
 #else
 	pthread_mutex_init( &signal->mutex, NULL );
 	pthread_cond_init( &signal->cond, NULL );
@@ -330,6 +595,8 @@ static void ksSignal_Destroy( ksSignal * signal )
 #elif defined( OS_HEXAGON )
 	qurt_cond_destroy( &signal->cond );
 	qurt_mutex_destroy( &signal->mutex );
+#elif defined( THREADING_FUTEX )
+	UNUSED_PARM( signal );
 #else
 	pthread_cond_destroy( &signal->cond );
 	pthread_mutex_destroy( &signal->mutex );
@@ -378,6 +645,46 @@ static bool ksSignal_Wait( ksSignal * signal, const ksNanoseconds timeOutNanosec
 	}
 	qurt_mutex_unlock( &signal->mutex );
 	return released;
+#elif defined( THREADING_FUTEX )
+	bool timedOut = ( timeOutNanoseconds == 0 );
+	const ksNanoseconds deadline = ( timedOut || timeOutNanoseconds == SIGNAL_TIMEOUT_INFINITE ) ? 0 : ksFutex_GetTimeNanoseconds() + timeOutNanoseconds;
+	for ( ; ; )
+	{
+		if ( ksFutex_Load( &signal->signaled ) != 0 )
+		{
+			if ( !signal->autoReset || ksFutex_Exchange( &signal->signaled, 0 ) != 0 )
+			{
+				return true;
+			}
+			continue;
+		}
+		if ( timedOut )
+		{
+			return false;
+		}
+		// Announce the waiter before parking. Either the raising thread sees the waiter and wakes it, or the
+		// wait sees the raised signal and returns right away.
+		__atomic_add_fetch( &signal->waiters, 1, __ATOMIC_SEQ_CST );
+		if ( timeOutNanoseconds == SIGNAL_TIMEOUT_INFINITE )
+		{
+			ksFutex_Wait( &signal->signaled, 0, NULL );
+		}
+		else
+		{
+			const ksNanoseconds now = ksFutex_GetTimeNanoseconds();
+			const ksNanoseconds remaining = ( deadline > now ) ? deadline - now : 0;
+			struct timespec ts;
+			ts.tv_sec = (time_t)( remaining / ( 1000 * 1000 * 1000 ) );
+			ts.tv_nsec = (long)( remaining % ( 1000 * 1000 * 1000 ) );
+			if ( remaining > 0 )
+			{
+				ksFutex_Wait( &signal->signaled, 0, &ts );
+			}
+			// Look at the signal one last time after the deadline, so a raise that raced with the time-out is not lost.
+			timedOut = ( ksFutex_GetTimeNanoseconds() >= deadline );
+		}
+		__atomic_sub_fetch( &signal->waiters, 1, __ATOMIC_RELAXED );
+	}
 #else
 	bool released = false;
 	pthread_mutex_lock( &signal->mutex );
@@ -398,11 +705,12 @@ static bool ksSignal_Wait( ksSignal * signal, const ksNanoseconds timeOutNanosec
 		}
 		else if ( timeOutNanoseconds > 0 )
 		{
-			struct timeval tp;
-			gettimeofday( &tp, NULL );
+			// pthread_cond_timedwait takes an absolute CLOCK_REALTIME time with a normalized nanosecond field.
 			struct timespec ts;
-			ts.tv_sec = (time_t)( tp.tv_sec + timeOutNanoseconds / ( 1000 * 1000 * 1000 ) );
-			ts.tv_nsec = (long)( tp.tv_usec + ( timeOutNanoseconds % ( 1000 * 1000 * 1000 ) ) );
+			clock_gettime( CLOCK_REALTIME, &ts );
+			const ksNanoseconds nanoseconds = (ksNanoseconds)ts.tv_nsec + timeOutNanoseconds % ( 1000 * 1000 * 1000 );
+			ts.tv_sec += (time_t)( timeOutNanoseconds / ( 1000 * 1000 * 1000 ) + nanoseconds / ( 1000 * 1000 * 1000 ) );
+			ts.tv_nsec = (long)( nanoseconds % ( 1000 * 1000 * 1000 ) );
 			do
 			{
 				if ( pthread_cond_timedwait( &signal->cond, &signal->mutex, &ts ) == ETIMEDOUT )
@@ -438,6 +746,11 @@ static void ksSignal_Raise( ksSignal * signal )
 		qurt_cond_broadcast( &signal->cond );
 	}
 	qurt_mutex_unlock( &signal->mutex );
+#elif defined( THREADING_FUTEX )
+	if ( __atomic_exchange_n( &signal->signaled, 1, __ATOMIC_SEQ_CST ) == 0 && __atomic_load_n( &signal->waiters, __ATOMIC_SEQ_CST ) > 0 )
+	{
+		ksFutex_Wake( &signal->signaled, signal->autoReset ? 1 : INT_MAX );
+	}
 #else
 	pthread_mutex_lock( &signal->mutex );
 	signal->signaled = true;
@@ -459,6 +772,8 @@ static void ksSignal_Clear( ksSignal * signal )
 	qurt_mutex_lock( &signal->mutex );
 	signal->signaled = false;
 	qurt_mutex_unlock( &signal->mutex );
+#elif defined( THREADING_FUTEX )
+	__atomic_store_n( &signal->signaled, 0, __ATOMIC_RELEASE );
 #else
 	pthread_mutex_lock( &signal->mutex );
 	signal->signaled = false;
@@ -495,8 +810,13 @@ static void ksThread_Submit( ksThread * thread, ksThreadFunction threadFunction,
 // These must be called from the thread itself.
 static void ksThread_SetName( const char * name );
 static void ksThread_SetAffinity( int mask );
+static void ksThread_SetProcessorAffinity( const int processor );
 static void ksThread_SetRealTimePriority( int priority );
 
+ksThread_SetAffinity takes a mask of the first 32 processors. ksThread_SetProcessorAffinity pins the
+thread to a single processor by its number from ksCpuTopology, which also works for processors past 32
+and, on Windows, in other processor groups.
+
 ================================================================================================================================
 */
 
@@ -596,12 +916,12 @@ static void ksThread_SetAffinity( int mask )
 		return;
 	}
 	cpu_set_t set;
-	memset( &set, 0, sizeof( cpu_set_t ) );
+	CPU_ZERO( &set );
 	for ( int bit = 0; bit < 32; bit++ )
 	{
 		if ( ( mask & ( 1 << bit ) ) != 0 )
 		{
-			set.__bits[bit / sizeof( set.__bits[0] )] |= 1 << ( bit & ( sizeof( set.__bits[0] ) - 1 ) );
+			CPU_SET( bit, &set );
 		}
 	}
 	const int result = pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &set );
@@ -695,6 +1015,40 @@ static void ksThread_SetAffinity( int mask )
 #endif
 }
 
+// Unlike ksThread_SetAffinity this only reports failures, so it can be called for every worker thread.
+static void ksThread_SetProcessorAffinity( const int processor )
+{
+	if ( processor < 0 )
+	{
+		return;
+	}
+#if defined( OS_WINDOWS )
+	GROUP_AFFINITY affinity;
+	memset( &affinity, 0, sizeof( affinity ) );
+	affinity.Group = (WORD)( processor / 64 );
+	affinity.Mask = (KAFFINITY)1 << ( processor % 64 );
+	if ( !SetThreadGroupAffinity( GetCurrentThread(), &affinity, NULL ) )
+	{
+		printf( "Failed to set thread affinity to processor %d: error %lu\n", processor, GetLastError() );
+	}
+#elif defined( OS_LINUX ) || defined( OS_ANDROID )
+	if ( processor >= CPU_SETSIZE )
+	{
+		return;
+	}
+	cpu_set_t set;
+	CPU_ZERO( &set );
+	CPU_SET( processor, &set );
+	if ( sched_setaffinity( 0, sizeof( cpu_set_t ), &set ) != 0 )
+	{
+		const int err = errno;
+		printf( "Failed to set thread affinity to processor %d: %s(%d)\n", processor, strerror( err ), err );
+	}
+#else
+	UNUSED_PARM( processor );
+#endif
+}
+
 static void ksThread_SetRealTimePriority( int priority )
 {
 #if defined( OS_WINDOWS )
@@ -908,75 +1262,1515 @@ static void ksThread_Submit( ksThread * thread, ksThreadFunction threadFunction,
 /*
 ================================================================================================================================
 
-Worker thread pool.
+Thread roles and scheduling policy.
 
-ksThreadPool
+A thread that matters for frame timing declares its role and gets the scheduling policy of that role.
+The frame thread gets the highest real-time priority, then input and workers.
 
-static bool ksThreadPool_Create( ksThreadPool * pool, const int numWorkers );
-static void ksThreadPool_Destroy( ksThreadPool * pool );
-static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData );
-static void ksThreadPool_Join( ksThreadPool * pool );
+Real-time policies (SCHED_FIFO, SCHED_RR) usually need CAP_SYS_NICE or an RLIMIT_RTPRIO grant. Without
+them the policy degrades to the nice level of the role, and without permission for that either the thread
+keeps the default policy. The level that was actually applied is returned so it can be reported.
+
+ksThreadPolicyManager keeps track of the registered threads. ksFrameWatchdog compares every frame with the
+predicted display period. When a frame overruns, it finds the registered thread that spent the most time
+runnable but not running during that frame, from the run queue wait time in /proc/self/task/<tid>/schedstat.
+Only Linux and Android provide this. On other platforms overruns are counted but not attributed to a thread.
+
+ksThreadRole
+ksThreadPolicyLevel
+ksThreadPolicyManager
+ksFrameWatchdog
+
+static const char * ksThreadRole_GetName( const ksThreadRole role );
+static ksThreadPolicyLevel ksThread_SetRolePolicy( const ksThreadRole role );
+
+static void ksThreadPolicyManager_Create( ksThreadPolicyManager * manager );
+static void ksThreadPolicyManager_Destroy( ksThreadPolicyManager * manager );
+static ksThreadPolicyLevel ksThreadPolicyManager_Register( ksThreadPolicyManager * manager, const ksThreadRole role, const char * name );
+
+static void ksFrameWatchdog_Create( ksFrameWatchdog * watchdog, ksThreadPolicyManager * manager );
+static void ksFrameWatchdog_Destroy( ksFrameWatchdog * watchdog );
+static void ksFrameWatchdog_BeginFrame( ksFrameWatchdog * watchdog, const ksNanoseconds period );
+static bool ksFrameWatchdog_EndFrame( ksFrameWatchdog * watchdog );
+
+ksThread_SetRolePolicy and ksThreadPolicyManager_Register must be called from the thread itself.
+The watchdog must be driven by a single thread, normally the frame thread.
 
 ================================================================================================================================
 */
 
-#define MAX_WORKERS		8
+typedef enum
+{
+	KS_THREAD_ROLE_FRAME,
+	KS_THREAD_ROLE_INPUT,
+	KS_THREAD_ROLE_WORKER,
+	KS_THREAD_ROLE_MAX
+} ksThreadRole;
+
+typedef enum
+{
+	KS_THREAD_POLICY_DEFAULT,		// nothing could be changed
+	KS_THREAD_POLICY_NICE,			// time sharing at the nice level (thread priority on Windows) of the role
+	KS_THREAD_POLICY_REALTIME		// the real-time policy of the role
+} ksThreadPolicyLevel;
 
 typedef struct
 {
-	ksThread	threads[MAX_WORKERS];
-	int			threadCount;
-} ksThreadPool;
+	const char *	name;
+	int				realTimePriority;	// SCHED_FIFO/SCHED_RR priority, 0 for time sharing
+	bool			roundRobin;			// SCHED_RR instead of SCHED_FIFO, for roles with several threads
+	int				nice;
+#if defined( OS_WINDOWS )
+	int				windowsPriority;
+#endif
+} ksThreadRolePolicy;
 
-static void PoolThreadStartFuntion( void * data )
+static const ksThreadRolePolicy * ksThreadRole_GetPolicy( const ksThreadRole role )
 {
-	UNUSED_PARM( data );
+	static const ksThreadRolePolicy policies[KS_THREAD_ROLE_MAX] =
+	{
+#if defined( OS_WINDOWS )
+		{ "frame",		3, false, -10, THREAD_PRIORITY_TIME_CRITICAL },
+		{ "input",		2, false,  -8, THREAD_PRIORITY_HIGHEST },
+		{ "worker",		1, true,   -5, THREAD_PRIORITY_ABOVE_NORMAL }
+#else
+		{ "frame",		3, false, -10 },
+		{ "input",		2, false,  -8 },
+		{ "worker",		1, true,   -5 }
+#endif
+	};
+	return &policies[( role >= 0 && role < KS_THREAD_ROLE_MAX ) ? role : KS_THREAD_ROLE_WORKER];
+}
 
-	ksThread_SetAffinity( THREAD_AFFINITY_BIG_CORES );
-	ksThread_SetRealTimePriority( 1 );
+static const char * ksThreadRole_GetName( const ksThreadRole role )
+{
+	return ksThreadRole_GetPolicy( role )->name;
 }
 
-static void ksThreadPool_Create( ksThreadPool * pool, const int numWorkers )
+static ksThreadPolicyLevel ksThread_SetRolePolicy( const ksThreadRole role )
 {
-	pool->threadCount = ( numWorkers <= MAX_WORKERS ) ? numWorkers : MAX_WORKERS;
-#if defined( OS_HEXAGON )
-	qurt_sysenv_max_hthreads_t num_threads;
-	if ( qurt_sysenv_get_max_hw_threads( &num_threads ) == QURT_EOK )
+	const ksThreadRolePolicy * policy = ksThreadRole_GetPolicy( role );
+#if defined( OS_WINDOWS )
+	if ( !SetThreadPriority( GetCurrentThread(), policy->windowsPriority ) )
 	{
-		pool->threadCount = num_threads.max_hthreads;
+		printf( "Failed to set %s thread priority: error %lu\n", policy->name, GetLastError() );
+		return KS_THREAD_POLICY_DEFAULT;
+	}
+	return ( policy->realTimePriority > 0 ) ? KS_THREAD_POLICY_REALTIME : KS_THREAD_POLICY_NICE;
+#elif defined( OS_LINUX ) || defined( OS_ANDROID )
+	int realTimeError = 0;
+	if ( policy->realTimePriority > 0 )
+	{
+		struct sched_param sp;
+		memset( &sp, 0, sizeof( sp ) );
+		sp.sched_priority = policy->realTimePriority;
+		int schedPolicy = policy->roundRobin ? SCHED_RR : SCHED_FIFO;
+#if defined( SCHED_RESET_ON_FORK )
+		schedPolicy |= SCHED_RESET_ON_FORK;		// child processes do not inherit the real-time policy
+#endif
+		// On Linux this applies to the calling thread only.
+		if ( sched_setscheduler( 0, schedPolicy, &sp ) == 0 )
+		{
+			return KS_THREAD_POLICY_REALTIME;
+		}
+		realTimeError = errno;
+	}
+	// With PRIO_PROCESS and a thread id, Linux changes the nice level of that thread only.
+	const int tid = (int)syscall( SYS_gettid );
+	if ( setpriority( PRIO_PROCESS, tid, policy->nice ) == 0 )
+	{
+		if ( realTimeError != 0 )
+		{
+			printf( "No real-time policy for %s thread %d: %s(%d), using nice %d\n",
+					policy->name, tid, strerror( realTimeError ), realTimeError, policy->nice );
+		}
+		return KS_THREAD_POLICY_NICE;
+	}
+	const int err = errno;
+	printf( "No scheduling policy for %s thread %d: %s(%d), using the default\n", policy->name, tid, strerror( err ), err );
+	return KS_THREAD_POLICY_DEFAULT;
+#elif defined( OS_APPLE )
+	// There is no per-thread nice level, so a denied real-time policy falls back to the default.
+	if ( policy->realTimePriority > 0 )
+	{
+		struct sched_param sp;
+		memset( &sp, 0, sizeof( sp ) );
+		sp.sched_priority = policy->realTimePriority;
+		const int err = pthread_setschedparam( pthread_self(), policy->roundRobin ? SCHED_RR : SCHED_FIFO, &sp );
+		if ( err == 0 )
+		{
+			return KS_THREAD_POLICY_REALTIME;
+		}
+		printf( "No real-time policy for %s thread: %s(%d), using the default\n", policy->name, strerror( err ), err );
 	}
+	return KS_THREAD_POLICY_DEFAULT;
+#else
+	UNUSED_PARM( policy );
+	return KS_THREAD_POLICY_DEFAULT;
 #endif
+}
 
-	for ( int i = 0; i < pool->threadCount; i++ )
+#define THREAD_POLICY_MAX_THREADS		64
+
+typedef struct
+{
+	char				name[32];
+	ksThreadRole		role;
+	ksThreadPolicyLevel	level;
+	int					tid;			// kernel thread id on Linux and Android
+	int					schedstat;		// open /proc/self/task/<tid>/schedstat, or -1
+} ksThreadPolicyEntry;
+
+// Threads are never removed. The schedstat of a thread that exited can no longer be read, so it is skipped.
+typedef struct
+{
+	ksMutex				mutex;
+	ksThreadPolicyEntry	threads[THREAD_POLICY_MAX_THREADS];
+	int					threadCount;
+} ksThreadPolicyManager;
+
+static void ksThreadPolicyManager_Create( ksThreadPolicyManager * manager )
+{
+	memset( manager, 0, sizeof( ksThreadPolicyManager ) );
+	ksMutex_Create( &manager->mutex );
+}
+
+static void ksThreadPolicyManager_Destroy( ksThreadPolicyManager * manager )
+{
+#if defined( OS_LINUX ) || defined( OS_ANDROID )
+	for ( int i = 0; i < manager->threadCount; i++ )
 	{
-		ksThread_Create( &pool->threads[i], "worker", PoolThreadStartFuntion, NULL );
-		ksThread_Signal( &pool->threads[i] );
-		ksThread_Join( &pool->threads[i] );
+		if ( manager->threads[i].schedstat >= 0 )
+		{
+			close( manager->threads[i].schedstat );
+		}
 	}
+#endif
+	ksMutex_Destroy( &manager->mutex );
+	manager->threadCount = 0;
 }
 
-static void ksThreadPool_Destroy( ksThreadPool * pool )
+static ksThreadPolicyLevel ksThreadPolicyManager_Register( ksThreadPolicyManager * manager, const ksThreadRole role, const char * name )
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+	const ksThreadPolicyLevel level = ksThread_SetRolePolicy( role );
+
+	ksMutex_Lock( &manager->mutex, true );
+	if ( manager->threadCount < THREAD_POLICY_MAX_THREADS )
 	{
-		ksThread_Destroy( &pool->threads[i] );
+		ksThreadPolicyEntry * entry = &manager->threads[manager->threadCount];
+		snprintf( entry->name, sizeof( entry->name ), "%s", ( name != NULL ) ? name : ksThreadRole_GetName( role ) );
+		entry->role = role;
+		entry->level = level;
+		entry->tid = 0;
+		entry->schedstat = -1;
+#if defined( OS_LINUX ) || defined( OS_ANDROID )
+		// Keep the file open so the watchdog only needs a pread per frame.
+		char path[64];
+		entry->tid = (int)syscall( SYS_gettid );
+		snprintf( path, sizeof( path ), "/proc/self/task/%d/schedstat", entry->tid );
+		entry->schedstat = open( path, O_RDONLY | O_CLOEXEC );
+#endif
+		manager->threadCount++;
 	}
+	ksMutex_Unlock( &manager->mutex );
+
+	return level;
 }
 
-static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData )
+// Returns the total time in nanoseconds the thread was runnable but waiting for a processor.
+static bool ksThreadPolicyManager_ReadRunDelay( const ksThreadPolicyEntry * entry, ksNanoseconds * runDelay )
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+#if defined( OS_LINUX ) || defined( OS_ANDROID )
+	if ( entry->schedstat < 0 )
 	{
-		ksThread_Submit( &pool->threads[i], threadFunction, threadData );
+		return false;
+	}
+	char buffer[128];
+	const ssize_t length = pread( entry->schedstat, buffer, sizeof( buffer ) - 1, 0 );
+	if ( length <= 0 )
+	{
+		return false;
+	}
+	buffer[length] = '\0';
+	// <time on a processor> <time waiting on a run queue> <number of time slices>
+	unsigned long long onProcessor = 0;
+	unsigned long long waiting = 0;
+	if ( sscanf( buffer, "%llu %llu", &onProcessor, &waiting ) != 2 )
+	{
+		return false;
 	}
+	*runDelay = waiting;
+	return true;
+#else
+	UNUSED_PARM( entry );
+	UNUSED_PARM( runDelay );
+	return false;
+#endif
 }
 
-static void ksThreadPool_Join( ksThreadPool * pool )
+typedef struct
 {
-	for ( int i = 0; i < pool->threadCount; i++ )
+	long long		frame;				// frame number, counting from zero
+	ksNanoseconds	frameTime;
+	ksNanoseconds	period;
+	int				thread;				// index into ksThreadPolicyManager::threads, or -1 when unknown
+	ksNanoseconds	runDelay;			// time that thread was runnable but not running during the frame
+} ksFrameOverrun;
+
+typedef struct
+{
+	ksThreadPolicyManager *	manager;
+	ksNanoseconds			frameStart;
+	ksNanoseconds			period;
+	int						threadCount;	// threads with a run delay sample at the start of the frame
+	bool					sampled[THREAD_POLICY_MAX_THREADS];
+	ksNanoseconds			runDelay[THREAD_POLICY_MAX_THREADS];
+	ksNanoseconds			overrunRunDelay[THREAD_POLICY_MAX_THREADS];	// summed over all overrun frames
+	long long				frameCount;
+	long long				overrunCount;
+	ksFrameOverrun			lastOverrun;
+} ksFrameWatchdog;
+
+static void ksFrameWatchdog_Create( ksFrameWatchdog * watchdog, ksThreadPolicyManager * manager )
+{
+	memset( watchdog, 0, sizeof( ksFrameWatchdog ) );
+	watchdog->manager = manager;
+	watchdog->lastOverrun.thread = -1;
+}
+
+static void ksFrameWatchdog_Destroy( ksFrameWatchdog * watchdog )
+{
+	memset( watchdog, 0, sizeof( ksFrameWatchdog ) );
+}
+
+static void ksFrameWatchdog_BeginFrame( ksFrameWatchdog * watchdog, const ksNanoseconds period )
+{
+	ksThreadPolicyManager * manager = watchdog->manager;
+	ksMutex_Lock( &manager->mutex, true );
+	watchdog->threadCount = manager->threadCount;
+	for ( int i = 0; i < watchdog->threadCount; i++ )
 	{
-		ksThread_Join( &pool->threads[i] );
+		watchdog->sampled[i] = ksThreadPolicyManager_ReadRunDelay( &manager->threads[i], &watchdog->runDelay[i] );
+	}
+	ksMutex_Unlock( &manager->mutex );
+
+	watchdog->period = period;
+	watchdog->frameStart = GetTimeNanoseconds();
+}
+
+// Returns true if the frame took longer than the period passed to ksFrameWatchdog_BeginFrame.
+static bool ksFrameWatchdog_EndFrame( ksFrameWatchdog * watchdog )
+{
+	const ksNanoseconds frameTime = GetTimeNanoseconds() - watchdog->frameStart;
+	const long long frame = watchdog->frameCount++;
+	if ( watchdog->period == 0 || frameTime <= watchdog->period )
+	{
+		return false;
+	}
+
+	int worstThread = -1;
+	ksNanoseconds worstRunDelay = 0;
+
+	ksThreadPolicyManager * manager = watchdog->manager;
+	ksMutex_Lock( &manager->mutex, true );
+	for ( int i = 0; i < watchdog->threadCount; i++ )
+	{
+		ksNanoseconds runDelay = 0;
+		if ( !watchdog->sampled[i] || !ksThreadPolicyManager_ReadRunDelay( &manager->threads[i], &runDelay ) )
+		{
+			continue;
+		}
+		const ksNanoseconds delta = runDelay - watchdog->runDelay[i];
+		watchdog->overrunRunDelay[i] += delta;
+		if ( delta > worstRunDelay )
+		{
+			worstRunDelay = delta;
+			worstThread = i;
+		}
+	}
+	ksMutex_Unlock( &manager->mutex );
+
+	watchdog->overrunCount++;
+	watchdog->lastOverrun.frame = frame;
+	watchdog->lastOverrun.frameTime = frameTime;
+	watchdog->lastOverrun.period = watchdog->period;
+	watchdog->lastOverrun.thread = worstThread;
+	watchdog->lastOverrun.runDelay = worstRunDelay;
+	return true;
+}
+
+/*
+================================================================================================================================
+
+Worker thread pool.
+
+ksThreadPool
+
+static bool ksThreadPool_Create( ksThreadPool * pool, const int numWorkers );
+static void ksThreadPool_Destroy( ksThreadPool * pool );
+static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData );
+static void ksThreadPool_Join( ksThreadPool * pool );
+
+================================================================================================================================
+*/
+
+typedef struct
+{
+	ksThread *	threads;
+	int			threadCount;
+} ksThreadPool;
+
+static void PoolThreadStartFuntion( void * data )
+{
+	const int processor = (int)(intptr_t)data;
+	if ( processor >= 0 )
+	{
+		ksThread_SetProcessorAffinity( processor );
+	}
+	else
+	{
+		ksThread_SetAffinity( THREAD_AFFINITY_BIG_CORES );
+	}
+	ksThread_SetRolePolicy( KS_THREAD_ROLE_WORKER );
+}
+
+// A 'numWorkers' of zero or less creates one worker per physical core that is not reserved for
+// the frame and pacing threads by ksCpuThreadPlacement. Workers are pinned to those cores.
+static void ksThreadPool_Create( ksThreadPool * pool, const int numWorkers )
+{
+	ksCpuTopology topology;
+	ksCpuThreadPlacement placement;
+	ksCpuTopology_Create( &topology );
+	ksCpuThreadPlacement_Create( &placement, &topology );
+
+	pool->threadCount = ( numWorkers > 0 ) ? numWorkers : placement.workerCount;
+#if defined( OS_HEXAGON )
+	qurt_sysenv_max_hthreads_t num_threads;
+	if ( qurt_sysenv_get_max_hw_threads( &num_threads ) == QURT_EOK )
+	{
+		pool->threadCount = num_threads.max_hthreads;
+	}
+#endif
+	pool->threads = (ksThread *)malloc( ( ( pool->threadCount > 0 ) ? pool->threadCount : 1 ) * sizeof( ksThread ) );
+
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		const int processor = ( i < placement.workerCount ) ? placement.workerProcessors[i] : -1;
+		ksThread_Create( &pool->threads[i], "worker", PoolThreadStartFuntion, (void *)(intptr_t)processor );
+		ksThread_Signal( &pool->threads[i] );
+		ksThread_Join( &pool->threads[i] );
+	}
+
+	ksCpuThreadPlacement_Destroy( &placement );
+	ksCpuTopology_Destroy( &topology );
+}
+
+static void ksThreadPool_Destroy( ksThreadPool * pool )
+{
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		ksThread_Destroy( &pool->threads[i] );
+	}
+	free( pool->threads );
+	pool->threads = NULL;
+	pool->threadCount = 0;
+}
+
+static void ksThreadPool_Submit( ksThreadPool * pool, ksThreadFunction threadFunction, void * threadData )
+{
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		ksThread_Submit( &pool->threads[i], threadFunction, threadData );
+	}
+}
+
+static void ksThreadPool_Join( ksThreadPool * pool )
+{
+	for ( int i = 0; i < pool->threadCount; i++ )
+	{
+		ksThread_Join( &pool->threads[i] );
+	}
+}
+
+/*
+================================================================================================================================
+
+Job system.
+
+Unlike ksThreadPool, which hands the same function to every worker, the job system runs independent
+jobs on a set of worker threads. Each worker owns a work-stealing deque (Chase and Lev, "Dynamic Circular
+Work-Stealing Deque", with the memory orderings from Le et al., "Correct and Efficient Work-Stealing for
+Weak Memory Models"). A worker pushes and pops jobs at the bottom of its own deque without contention
+and idle workers steal from the top of the other deques. Jobs submitted from threads that are not part
+of the job system go through a mutex protected injection queue.
+
+The thread that creates the job system participates as worker 0, so jobs it submits go straight into
+its own deque and ksJobSystem_Wait runs jobs while waiting instead of blocking.
+
+A ksJobCounter tracks the number of unfinished jobs that were submitted with it. Jobs submitted with
+ksJobSystem_SubmitAfter are held by the dependency counter and released once it reaches zero. A counter
+must not go out of scope while jobs submitted with it are unfinished. ksJobSystem_Wait on the counter,
+or on the counter of a continuation of it, guarantees this.
+
+ksJobSystem_ParallelFor splits the index range into one job per thread. A range job then runs its range
+in chunks of 'grain' indices and, whenever the deque of the thread running it is empty, splits off the
+upper half of its remaining range as a new job (lazy binary splitting). Idle threads therefore always
+find work to steal, while busy threads run their range with a single job and no splitting overhead.
+
+Jobs live in a fixed pool. When the pool is exhausted, the allocating thread runs jobs until a slot frees up.
+
+Idle workers spin for a while before sleeping on a signal. Submitting a job only raises the signal if
+there are sleeping workers, so dispatching to busy workers never makes a system call.
+
+ksJobCounter
+ksJobSystem
+
+static void ksJobCounter_Create( ksJobCounter * counter );
+static bool ksJobCounter_IsDone( ksJobCounter * counter );
+
+static void ksJobSystem_Create( ksJobSystem * jobSystem, const int workerThreadCount, ksThreadPolicyManager * manager );
+static void ksJobSystem_Destroy( ksJobSystem * jobSystem );
+static int ksJobSystem_GetThreadCount( const ksJobSystem * jobSystem );
+static void ksJobSystem_Submit( ksJobSystem * jobSystem, ksJobFunction function, void * data, ksJobCounter * counter );
+static void ksJobSystem_SubmitAfter( ksJobSystem * jobSystem, ksJobCounter * dependency, ksJobFunction function, void * data, ksJobCounter * counter );
+static void ksJobSystem_ParallelFor( ksJobSystem * jobSystem, ksJobRangeFunction function, void * data, const int count, const int grain, ksJobCounter * counter );
+static void ksJobSystem_Wait( ksJobSystem * jobSystem, ksJobCounter * counter );
+
+================================================================================================================================
+*/
+
+#define JOB_DEQUE_SIZE			4096		// must be a power of two
+#define JOB_POOL_SIZE			8192		// must be a power of two
+#define JOB_IDLE_SPIN_COUNT		4096		// pause iterations before an idle worker goes to sleep
+#define JOB_WAIT_SPIN_COUNT		64			// pause iterations before a waiting thread yields
+
+typedef void (*ksJobFunction)( void * data );
+typedef void (*ksJobRangeFunction)( void * data, const int begin, const int end );
+
+typedef struct
+{
+	ksAtomicInt64		pending;			// number of unfinished jobs
+	ksAtomicInt64		finishing;			// number of threads inside ksJobSystem_FinishJob for this counter
+	ksAtomicPointer		continuations;		// list of jobs released when 'pending' reaches zero
+} ksJobCounter;
+
+typedef struct ksJob
+{
+	ksJobFunction		function;
+	ksJobRangeFunction	rangeFunction;
+	void *				data;
+	int					begin;
+	int					end;
+	int					grain;
+	ksJobCounter *		counter;
+	struct ksJob *		next;				// link in the continuation list
+	ksAtomicInt64		inUse;
+} ksJob;
+
+typedef struct
+{
+	ksAtomicInt64		top;
+	char				pad0[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+	ksAtomicInt64		bottom;
+	char				pad1[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+	ksAtomicPointer		jobs[JOB_DEQUE_SIZE];
+} ksJobDeque;
+
+struct ksJobSystem;
+
+typedef struct
+{
+	ksJobDeque				deque;
+	struct ksJobSystem *	jobSystem;
+	ksThread				thread;
+	int						index;
+	int						processor;		// processor the worker is pinned to, -1 if not pinned
+	unsigned int			random;			// for picking steal victims
+	ksAtomicInt64			threadId;		// ksJobSystem_GetThreadId of the worker thread, 0 until it started
+} ksJobWorker;
+
+typedef struct ksJobSystem
+{
+	ksJobWorker *		workers;			// workers[0] is the thread that created the job system
+	int					workerCount;
+	ksJob *				jobPool;
+	ksAtomicInt64		jobPoolNext;
+	ksMutex				injectMutex;
+	ksJob *				injectHead;
+	ksJob *				injectTail;
+	ksAtomicInt64		injectCount;
+	ksAtomicInt64		sleepers;
+	ksAtomicInt64		terminate;
+	ksSignal			wake;
+	ksThreadPolicyManager *	policyManager;	// worker threads register with it, may be NULL
+} ksJobSystem;
+
+// Thread local variables in a header have one copy per translation unit, so a job submitted from another
+// translation unit than the one that started the worker would not find it. The thread id is the same everywhere.
+static long long ksJobSystem_GetThreadId()
+{
+#if defined( OS_WINDOWS )
+	return (long long)GetCurrentThreadId();
+#elif defined( OS_HEXAGON )
+	return (long long)qurt_thread_get_id();
+#elif defined( THREADING_FUTEX )
+	return (long long)ksMutex_GetThreadId();
+#else
+	return (long long)(intptr_t)pthread_self();
+#endif
+}
+
+static void ksJobDeque_Create( ksJobDeque * deque )
+{
+	memset( deque, 0, sizeof( ksJobDeque ) );
+}
+
+// Owner only. Returns false if the deque is full.
+static bool ksJobDeque_Push( ksJobDeque * deque, ksJob * job )
+{
+	const long long b = ksAtomicInt64_LoadRelaxed( &deque->bottom );
+	const long long t = ksAtomicInt64_LoadAcquire( &deque->top );
+	if ( b - t >= JOB_DEQUE_SIZE )
+	{
+		return false;
+	}
+	// Publish the job through the slot itself, so a thief that reads the slot also sees the job contents.
+	ksAtomicPointer_StoreRelease( &deque->jobs[b & ( JOB_DEQUE_SIZE - 1 )], job );
+	ksAtomic_ThreadFenceRelease();
+	ksAtomicInt64_StoreRelaxed( &deque->bottom, b + 1 );
+	return true;
+}
+
+// Owner only.
+static ksJob * ksJobDeque_Pop( ksJobDeque * deque )
+{
+	const long long b = ksAtomicInt64_LoadRelaxed( &deque->bottom ) - 1;
+	ksAtomicInt64_StoreRelaxed( &deque->bottom, b );
+	ksAtomic_ThreadFenceSeqCst();
+	const long long t = ksAtomicInt64_LoadRelaxed( &deque->top );
+	if ( t > b )
+	{
+		ksAtomicInt64_StoreRelaxed( &deque->bottom, b + 1 );
+		return NULL;
+	}
+	ksJob * job = (ksJob *)ksAtomicPointer_LoadRelaxed( &deque->jobs[b & ( JOB_DEQUE_SIZE - 1 )] );
+	if ( t == b )
+	{
+		// Last job, race against the thieves.
+		if ( !ksAtomicInt64_CompareExchange( &deque->top, t, t + 1 ) )
+		{
+			job = NULL;
+		}
+		ksAtomicInt64_StoreRelaxed( &deque->bottom, b + 1 );
+	}
+	return job;
+}
+
+// Any thread. Returns NULL if the deque is empty or another thread won the race for the top job.
+static ksJob * ksJobDeque_Steal( ksJobDeque * deque )
+{
+	const long long t = ksAtomicInt64_LoadAcquire( &deque->top );
+	ksAtomic_ThreadFenceSeqCst();
+	const long long b = ksAtomicInt64_LoadAcquire( &deque->bottom );
+	if ( t >= b )
+	{
+		return NULL;
+	}
+	ksJob * job = (ksJob *)ksAtomicPointer_LoadAcquire( &deque->jobs[t & ( JOB_DEQUE_SIZE - 1 )] );
+	if ( !ksAtomicInt64_CompareExchange( &deque->top, t, t + 1 ) )
+	{
+		return NULL;
+	}
+	return job;
+}
+
+static bool ksJobDeque_IsEmpty( ksJobDeque * deque )
+{
+	return ksAtomicInt64_LoadRelaxed( &deque->bottom ) <= ksAtomicInt64_LoadRelaxed( &deque->top );
+}
+
+static void ksJobCounter_Create( ksJobCounter * counter )
+{
+	counter->pending = 0;
+	counter->finishing = 0;
+	counter->continuations = NULL;
+}
+
+static bool ksJobCounter_IsDone( ksJobCounter * counter )
+{
+	return	ksAtomicInt64_LoadAcquire( &counter->pending ) == 0 &&
+			ksAtomicInt64_LoadAcquire( &counter->finishing ) == 0;
+}
+
+static int ksJobSystem_GetProcessorCount()
+{
+#if defined( OS_WINDOWS )
+	return (int)GetActiveProcessorCount( ALL_PROCESSOR_GROUPS );
+#elif defined( OS_LINUX ) || defined( OS_ANDROID ) || defined( OS_APPLE )
+	const long count = sysconf( _SC_NPROCESSORS_ONLN );
+	return ( count > 0 ) ? (int)count : 1;
+#else
+	return 1;
+#endif
+}
+
+static void ksJobSystem_Yield()
+{
+#if defined( OS_WINDOWS )
+	SwitchToThread();
+#elif defined( OS_HEXAGON )
+	ksAtomic_Pause();
+#else
+	sched_yield();
+#endif
+}
+
+static ksJobWorker * ksJobSystem_GetThreadWorker( ksJobSystem * jobSystem )
+{
+	const long long self = ksJobSystem_GetThreadId();
+	for ( int i = 0; i < jobSystem->workerCount; i++ )
+	{
+		if ( ksAtomicInt64_LoadRelaxed( &jobSystem->workers[i].threadId ) == self )
+		{
+			return &jobSystem->workers[i];
+		}
+	}
+	return NULL;
+}
+
+static ksJob * ksJobSystem_FindJob( ksJobSystem * jobSystem, ksJobWorker * worker )
+{
+	if ( worker != NULL )
+	{
+		ksJob * job = ksJobDeque_Pop( &worker->deque );
+		if ( job != NULL )
+		{
+			return job;
+		}
+	}
+
+	if ( ksAtomicInt64_LoadAcquire( &jobSystem->injectCount ) > 0 )
+	{
+		ksJob * job = NULL;
+		ksMutex_Lock( &jobSystem->injectMutex, true );
+		if ( jobSystem->injectHead != NULL )
+		{
+			job = jobSystem->injectHead;
+			jobSystem->injectHead = job->next;
+			if ( jobSystem->injectHead == NULL )
+			{
+				jobSystem->injectTail = NULL;
+			}
+			ksAtomicInt64_Add( &jobSystem->injectCount, -1 );
+		}
+		ksMutex_Unlock( &jobSystem->injectMutex );
+		if ( job != NULL )
+		{
+			return job;
+		}
+	}
+
+	// Start at a random victim so the thieves spread out over the workers.
+	unsigned int random = 0;
+	if ( worker != NULL )
+	{
+		worker->random = worker->random * 1664525u + 1013904223u;
+		random = worker->random >> 8;
+	}
+	for ( int i = 0; i < jobSystem->workerCount; i++ )
+	{
+		ksJobWorker * victim = &jobSystem->workers[( random + i ) % jobSystem->workerCount];
+		if ( victim == worker )
+		{
+			continue;
+		}
+		ksJob * job = ksJobDeque_Steal( &victim->deque );
+		if ( job != NULL )
+		{
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static void ksJobSystem_WakeWorker( ksJobSystem * jobSystem )
+{
+	// Pairs with the fence between announcing a sleeper and the last look for work in ksJobSystem_WorkerFunction.
+	ksAtomic_ThreadFenceSeqCst();
+	if ( ksAtomicInt64_LoadRelaxed( &jobSystem->sleepers ) > 0 )
+	{
+		ksSignal_Raise( &jobSystem->wake );
+	}
+}
+
+static void ksJobSystem_RunJob( ksJobSystem * jobSystem, ksJobWorker * worker, ksJob * job );
+static void ksJobSystem_Wait( ksJobSystem * jobSystem, ksJobCounter * counter );
+
+static void ksJobSystem_Enqueue( ksJobSystem * jobSystem, ksJobWorker * worker, ksJob * job )
+{
+	if ( worker != NULL )
+	{
+		if ( !ksJobDeque_Push( &worker->deque, job ) )
+		{
+			// The deque is full so there is plenty of work to steal already.
+			ksJobSystem_RunJob( jobSystem, worker, job );
+			return;
+		}
+	}
+	else
+	{
+		job->next = NULL;
+		ksMutex_Lock( &jobSystem->injectMutex, true );
+		if ( jobSystem->injectTail != NULL )
+		{
+			jobSystem->injectTail->next = job;
+		}
+		else
+		{
+			jobSystem->injectHead = job;
+		}
+		jobSystem->injectTail = job;
+		ksAtomicInt64_Add( &jobSystem->injectCount, 1 );
+		ksMutex_Unlock( &jobSystem->injectMutex );
+	}
+	ksJobSystem_WakeWorker( jobSystem );
+}
+
+// Runs one job if there is any. Returns false if no job was found.
+static bool ksJobSystem_Help( ksJobSystem * jobSystem, ksJobWorker * worker )
+{
+	ksJob * job = ksJobSystem_FindJob( jobSystem, worker );
+	if ( job == NULL )
+	{
+		return false;
+	}
+	ksJobSystem_RunJob( jobSystem, worker, job );
+	return true;
+}
+
+static ksJob * ksJobSystem_AllocJob( ksJobSystem * jobSystem, ksJobWorker * worker )
+{
+	for ( int attempt = 0; ; attempt++ )
+	{
+		const long long index = ksAtomicInt64_Add( &jobSystem->jobPoolNext, 1 ) & ( JOB_POOL_SIZE - 1 );
+		ksJob * job = &jobSystem->jobPool[index];
+		if ( ksAtomicInt64_LoadRelaxed( &job->inUse ) == 0 && ksAtomicInt64_CompareExchange( &job->inUse, 0, 1 ) )
+		{
+			return job;
+		}
+		if ( attempt >= JOB_POOL_SIZE && !ksJobSystem_Help( jobSystem, worker ) )
+		{
+			ksAtomic_Pause();
+		}
+	}
+}
+
+static void ksJobSystem_EnqueueList( ksJobSystem * jobSystem, ksJobWorker * worker, ksJob * job )
+{
+	while ( job != NULL )
+	{
+		ksJob * next = job->next;
+		ksJobSystem_Enqueue( jobSystem, worker, job );
+		job = next;
+	}
+}
+
+// Waits until only 'own' threads are still finishing jobs of the counter. The others are at most
+// a few instructions away from their last access to the counter.
+static void ksJobCounter_WaitFinishing( ksJobCounter * counter, const long long own )
+{
+	while ( ksAtomicInt64_LoadAcquire( &counter->finishing ) != own )
+	{
+		ksAtomic_Pause();
+	}
+}
+
+// A continuation only runs once no thread touches the dependency counter anymore, so a thread that
+// waits on the dependency, or on the continuation, may let the dependency counter go out of scope.
+static void ksJobSystem_FinishJob( ksJobSystem * jobSystem, ksJobWorker * worker, ksJobCounter * counter )
+{
+	if ( counter == NULL )
+	{
+		return;
+	}
+	// 'finishing' keeps ksJobSystem_Wait from returning until this thread no longer touches the counter.
+	ksAtomicInt64_Add( &counter->finishing, 1 );
+	ksJob * continuations = NULL;
+	if ( ksAtomicInt64_Add( &counter->pending, -1 ) == 0 )
+	{
+		continuations = (ksJob *)ksAtomicPointer_Exchange( &counter->continuations, NULL );
+		if ( continuations != NULL )
+		{
+			ksJobCounter_WaitFinishing( counter, 1 );
+		}
+	}
+	ksAtomicInt64_Add( &counter->finishing, -1 );
+	ksJobSystem_EnqueueList( jobSystem, worker, continuations );
+}
+
+static void ksJobSystem_RunRange( ksJobSystem * jobSystem, ksJobWorker * worker, ksJob * job )
+{
+	int begin = job->begin;
+	int end = job->end;
+	while ( begin < end )
+	{
+		// Only split when the own deque ran dry, which means the other threads stole everything and want more.
+		if ( worker != NULL && end - begin > job->grain && ksJobDeque_IsEmpty( &worker->deque ) )
+		{
+			const int middle = begin + ( end - begin ) / 2;
+			ksJob * split = ksJobSystem_AllocJob( jobSystem, worker );
+			split->function = NULL;
+			split->rangeFunction = job->rangeFunction;
+			split->data = job->data;
+			split->begin = middle;
+			split->end = end;
+			split->grain = job->grain;
+			split->counter = job->counter;
+			split->next = NULL;
+			if ( split->counter != NULL )
+			{
+				ksAtomicInt64_Add( &split->counter->pending, 1 );
+			}
+			ksJobSystem_Enqueue( jobSystem, worker, split );
+			end = middle;
+		}
+		const int chunkEnd = ( end - begin > job->grain ) ? begin + job->grain : end;
+		job->rangeFunction( job->data, begin, chunkEnd );
+		begin = chunkEnd;
+	}
+}
+
+static void ksJobSystem_RunJob( ksJobSystem * jobSystem, ksJobWorker * worker, ksJob * job )
+{
+	if ( job->rangeFunction != NULL )
+	{
+		ksJobSystem_RunRange( jobSystem, worker, job );
+	}
+	else
+	{
+		job->function( job->data );
+	}
+	ksJobCounter * counter = job->counter;
+	ksAtomicInt64_StoreRelease( &job->inUse, 0 );
+	ksJobSystem_FinishJob( jobSystem, worker, counter );
+}
+
+static void ksJobSystem_WorkerFunction( void * data )
+{
+	ksJobWorker * worker = (ksJobWorker *)data;
+	ksJobSystem * jobSystem = worker->jobSystem;
+	ksAtomicInt64_StoreRelease( &worker->threadId, ksJobSystem_GetThreadId() );
+	ksThread_SetProcessorAffinity( worker->processor );
+	if ( jobSystem->policyManager != NULL )
+	{
+		char name[32];
+		snprintf( name, sizeof( name ), "job worker %d", worker->index );
+		ksThreadPolicyManager_Register( jobSystem->policyManager, KS_THREAD_ROLE_WORKER, name );
+	}
+	else
+	{
+		ksThread_SetRolePolicy( KS_THREAD_ROLE_WORKER );
+	}
+
+	int spins = 0;
+	for ( ; ; )
+	{
+		if ( ksJobSystem_Help( jobSystem, worker ) )
+		{
+			spins = 0;
+			continue;
+		}
+		if ( ksAtomicInt64_LoadAcquire( &jobSystem->terminate ) != 0 )
+		{
+			break;
+		}
+		if ( ++spins < JOB_IDLE_SPIN_COUNT )
+		{
+			ksAtomic_Pause();
+			continue;
+		}
+
+		// Announce the sleeper before the last look for work, so a job submitted concurrently
+		// either is found here or sees the sleeper and raises the signal.
+		ksAtomicInt64_Add( &jobSystem->sleepers, 1 );
+		ksJob * job = ksJobSystem_FindJob( jobSystem, worker );
+		if ( job == NULL && ksAtomicInt64_LoadAcquire( &jobSystem->terminate ) == 0 )
+		{
+			ksSignal_Wait( &jobSystem->wake, SIGNAL_TIMEOUT_INFINITE );
+			job = ksJobSystem_FindJob( jobSystem, worker );
+		}
+		ksAtomicInt64_Add( &jobSystem->sleepers, -1 );
+		if ( job != NULL )
+		{
+			// Raised signals do not accumulate, so pass the wake up on while there may be more work.
+			ksJobSystem_WakeWorker( jobSystem );
+			ksJobSystem_RunJob( jobSystem, worker, job );
+		}
+		spins = 0;
+	}
+
+	// Pass the wake up on to the next sleeping worker.
+	ksSignal_Raise( &jobSystem->wake );
+}
+
+// A negative 'workerThreadCount' sizes the job system from the CPU topology: one worker thread for each
+// physical core that ksCpuThreadPlacement does not reserve for the frame and pacing threads, pinned to
+// that core. The calling thread is expected to be the frame thread. Explicit counts are not pinned.
+// Worker threads get the worker role policy and register with 'manager' if it is not NULL.
+static void ksJobSystem_Create( ksJobSystem * jobSystem, const int workerThreadCount, ksThreadPolicyManager * manager )
+{
+	ksCpuThreadPlacement placement;
+	memset( &placement, 0, sizeof( placement ) );
+	if ( workerThreadCount < 0 )
+	{
+		ksCpuTopology topology;
+		ksCpuTopology_Create( &topology );
+		ksCpuThreadPlacement_Create( &placement, &topology );
+		ksCpuTopology_Destroy( &topology );
+	}
+	const int threadCount = ( workerThreadCount >= 0 ) ? workerThreadCount : placement.workerCount;
+
+	jobSystem->workerCount = 1 + ( ( threadCount > 0 ) ? threadCount : 0 );
+	jobSystem->workers = (ksJobWorker *)malloc( jobSystem->workerCount * sizeof( ksJobWorker ) );
+	jobSystem->jobPool = (ksJob *)calloc( JOB_POOL_SIZE, sizeof( ksJob ) );
+	jobSystem->jobPoolNext = 0;
+	ksMutex_Create( &jobSystem->injectMutex );
+	jobSystem->injectHead = NULL;
+	jobSystem->injectTail = NULL;
+	jobSystem->injectCount = 0;
+	jobSystem->sleepers = 0;
+	jobSystem->terminate = 0;
+	ksSignal_Create( &jobSystem->wake, true );
+	jobSystem->policyManager = manager;
+
+	for ( int i = 0; i < jobSystem->workerCount; i++ )
+	{
+		ksJobWorker * worker = &jobSystem->workers[i];
+		ksJobDeque_Create( &worker->deque );
+		worker->jobSystem = jobSystem;
+		worker->index = i;
+		worker->processor = ( i >= 1 && i <= placement.workerCount ) ? placement.workerProcessors[i - 1] : -1;
+		worker->random = 0x9E3779B9u * (unsigned int)( i + 1 );
+		worker->threadId = 0;
+	}
+	ksCpuThreadPlacement_Destroy( &placement );
+
+	ksAtomicInt64_StoreRelease( &jobSystem->workers[0].threadId, ksJobSystem_GetThreadId() );
+
+	for ( int i = 1; i < jobSystem->workerCount; i++ )
+	{
+		ksJobWorker * worker = &jobSystem->workers[i];
+		char threadName[32];
+		snprintf( threadName, sizeof( threadName ), "job worker %d", i );
+		ksThread_Create( &worker->thread, threadName, ksJobSystem_WorkerFunction, worker );
+		ksThread_Signal( &worker->thread );
+	}
+}
+
+// Must be called from the thread that created the job system, after all jobs finished.
+static void ksJobSystem_Destroy( ksJobSystem * jobSystem )
+{
+	ksAtomicInt64_StoreRelease( &jobSystem->terminate, 1 );
+	ksSignal_Raise( &jobSystem->wake );
+	for ( int i = 1; i < jobSystem->workerCount; i++ )
+	{
+		ksThread_Destroy( &jobSystem->workers[i].thread );
+	}
+	ksSignal_Destroy( &jobSystem->wake );
+	ksMutex_Destroy( &jobSystem->injectMutex );
+	free( jobSystem->jobPool );
+	free( jobSystem->workers );
+	memset( jobSystem, 0, sizeof( ksJobSystem ) );
+}
+
+// Number of threads that run jobs, including the thread that created the job system.
+static int ksJobSystem_GetThreadCount( const ksJobSystem * jobSystem )
+{
+	return jobSystem->workerCount;
+}
+
+// 'counter' may be NULL for fire-and-forget jobs.
+static void ksJobSystem_Submit( ksJobSystem * jobSystem, ksJobFunction function, void * data, ksJobCounter * counter )
+{
+	ksJobWorker * worker = ksJobSystem_GetThreadWorker( jobSystem );
+	ksJob * job = ksJobSystem_AllocJob( jobSystem, worker );
+	job->function = function;
+	job->rangeFunction = NULL;
+	job->data = data;
+	job->begin = 0;
+	job->end = 0;
+	job->grain = 0;
+	job->counter = counter;
+	job->next = NULL;
+	if ( counter != NULL )
+	{
+		ksAtomicInt64_Add( &counter->pending, 1 );
+	}
+	ksJobSystem_Enqueue( jobSystem, worker, job );
+}
+
+// Submits the job once all jobs submitted with 'dependency' have finished.
+// If 'dependency' has no unfinished jobs, the job is submitted right away.
+static void ksJobSystem_SubmitAfter( ksJobSystem * jobSystem, ksJobCounter * dependency, ksJobFunction function, void * data, ksJobCounter * counter )
+{
+	ksJobWorker * worker = ksJobSystem_GetThreadWorker( jobSystem );
+	ksJob * job = ksJobSystem_AllocJob( jobSystem, worker );
+	job->function = function;
+	job->rangeFunction = NULL;
+	job->data = data;
+	job->begin = 0;
+	job->end = 0;
+	job->grain = 0;
+	job->counter = counter;
+	if ( counter != NULL )
+	{
+		ksAtomicInt64_Add( &counter->pending, 1 );
+	}
+	for ( ; ; )
+	{
+		job->next = (ksJob *)ksAtomicPointer_LoadRelaxed( &dependency->continuations );
+		if ( ksAtomicPointer_CompareExchange( &dependency->continuations, job->next, job ) )
+		{
+			break;
+		}
+	}
+	// If the dependency finished before the job was added to the list, release it here.
+	// Both this thread and the finishing thread take the whole list, so every job is released once.
+	if ( ksAtomicInt64_LoadAcquire( &dependency->pending ) == 0 )
+	{
+		ksJob * continuations = (ksJob *)ksAtomicPointer_Exchange( &dependency->continuations, NULL );
+		if ( continuations != NULL )
+		{
+			ksJobCounter_WaitFinishing( dependency, 0 );
+			ksJobSystem_EnqueueList( jobSystem, worker, continuations );
+		}
+	}
+}
+
+// Calls 'function' for consecutive sub-ranges of [0, count) that are at most 'grain' indices long.
+// A 'grain' of zero or less picks a grain that gives each thread several chunks.
+// If 'counter' is NULL, this waits for the whole range to finish.
+static void ksJobSystem_ParallelFor( ksJobSystem * jobSystem, ksJobRangeFunction function, void * data, const int count, const int grain, ksJobCounter * counter )
+{
+	ksJobCounter localCounter;
+	ksJobCounter_Create( &localCounter );
+	ksJobCounter * rangeCounter = ( counter != NULL ) ? counter : &localCounter;
+
+	const int threadCount = jobSystem->workerCount;
+	int rangeGrain = grain;
+	if ( rangeGrain <= 0 )
+	{
+		rangeGrain = count / ( threadCount * 8 );
+		rangeGrain = ( rangeGrain > 0 ) ? rangeGrain : 1;
+	}
+
+	ksJobWorker * worker = ksJobSystem_GetThreadWorker( jobSystem );
+	const int jobCount = ( count / rangeGrain < threadCount ) ? ( count + rangeGrain - 1 ) / rangeGrain : threadCount;
+	for ( int i = 0; i < jobCount; i++ )
+	{
+		ksJob * job = ksJobSystem_AllocJob( jobSystem, worker );
+		job->function = NULL;
+		job->rangeFunction = function;
+		job->data = data;
+		job->begin = (int)( (long long)count * i / jobCount );
+		job->end = (int)( (long long)count * ( i + 1 ) / jobCount );
+		job->grain = rangeGrain;
+		job->counter = rangeCounter;
+		job->next = NULL;
+		ksAtomicInt64_Add( &rangeCounter->pending, 1 );
+		ksJobSystem_Enqueue( jobSystem, worker, job );
+	}
+
+	if ( counter == NULL )
+	{
+		ksJobSystem_Wait( jobSystem, &localCounter );
+	}
+}
+
+// Runs jobs until all jobs submitted with 'counter' have finished.
+static void ksJobSystem_Wait( ksJobSystem * jobSystem, ksJobCounter * counter )
+{
+	ksJobWorker * worker = ksJobSystem_GetThreadWorker( jobSystem );
+	int spins = 0;
+	while ( !ksJobCounter_IsDone( counter ) )
+	{
+		if ( ksJobSystem_Help( jobSystem, worker ) )
+		{
+			spins = 0;
+		}
+		else if ( ++spins < JOB_WAIT_SPIN_COUNT )
+		{
+			ksAtomic_Pause();
+		}
+		else
+		{
+			ksJobSystem_Yield();
+		}
+	}
+}
+
+/*
+================================================================================================================================
+
+Lock-free data exchange between threads.
+
+These hand data between long running threads, for instance from the input thread to the frame thread
+or from the frame thread to the pacing and streaming threads, without locks or system calls. All of
+them copy fixed size elements. The element size and capacity are set at creation.
+
+ksSpscQueue		Bounded ring queue for a single producer and a single consumer thread. The producer and
+				consumer indices live on separate cache lines and each side caches the index of the other
+				side, so a push or pop only touches the shared index when the cached one runs out.
+
+ksMpmcQueue		Bounded ring queue for any number of producer and consumer threads (Dmitry Vyukov,
+				"Bounded MPMC queue"). Every cell has a sequence number that tells producers and consumers
+				whether it is free or filled, so threads only contend on the index they advance.
+
+ksMailbox		Latest value mailbox for a single writer and any number of readers, built as a sequence lock.
+				Publishing never waits and overwrites the previous value. A reader retries if the writer
+				published while it was copying. The payload is copied as relaxed atomic 64-bit words, so a
+				torn copy is never a data race and is always detected and discarded. Meant for small values
+				like pose snapshots that are published far more often than they could be consumed in order.
+
+ksTripleBuffer	Three buffers for a single writer and a single reader of larger data such as per-frame state.
+				The writer fills its back buffer and publishes it by exchanging it with the middle buffer.
+				The reader takes the middle buffer if it was published since the last read. Neither side
+				ever waits or copies.
+
+Push and pop return false when the queue is full or empty.
+
+ksSpscQueue
+ksMpmcQueue
+ksMailbox
+ksTripleBuffer
+
+static void ksSpscQueue_Create( ksSpscQueue * queue, const int elementSize, const int capacity );
+static void ksSpscQueue_Destroy( ksSpscQueue * queue );
+static bool ksSpscQueue_Push( ksSpscQueue * queue, const void * element );
+static bool ksSpscQueue_Pop( ksSpscQueue * queue, void * element );
+
+static void ksMpmcQueue_Create( ksMpmcQueue * queue, const int elementSize, const int capacity );
+static void ksMpmcQueue_Destroy( ksMpmcQueue * queue );
+static bool ksMpmcQueue_Push( ksMpmcQueue * queue, const void * element );
+static bool ksMpmcQueue_Pop( ksMpmcQueue * queue, void * element );
+
+static void ksMailbox_Create( ksMailbox * mailbox, const int size );
+static void ksMailbox_Destroy( ksMailbox * mailbox );
+static void ksMailbox_Publish( ksMailbox * mailbox, const void * value );
+static long long ksMailbox_Read( ksMailbox * mailbox, void * value );
+
+static void ksTripleBuffer_Create( ksTripleBuffer * tripleBuffer, const int size );
+static void ksTripleBuffer_Destroy( ksTripleBuffer * tripleBuffer );
+static void * ksTripleBuffer_GetWriteBuffer( ksTripleBuffer * tripleBuffer );
+static void ksTripleBuffer_Publish( ksTripleBuffer * tripleBuffer );
+static const void * ksTripleBuffer_GetReadBuffer( ksTripleBuffer * tripleBuffer, bool * isNew );
+
+================================================================================================================================
+*/
+
+// Capacities are rounded up to a power of two.
+static long long ksQueue_RoundCapacity( const int capacity )
+{
+	long long rounded = 2;
+	while ( rounded < capacity )
+	{
+		rounded *= 2;
+	}
+	return rounded;
+}
+
+typedef struct
+{
+	unsigned char *		elements;
+	long long			mask;
+	int					elementSize;
+	char				pad0[THREAD_CACHE_LINE_SIZE - sizeof( unsigned char * ) - sizeof( long long ) - sizeof( int )];
+	ksAtomicInt64		tail;				// next element to push, written by the producer
+	long long			cachedHead;			// producer copy of 'head'
+	char				pad1[THREAD_CACHE_LINE_SIZE - 2 * sizeof( long long )];
+	ksAtomicInt64		head;				// next element to pop, written by the consumer
+	long long			cachedTail;			// consumer copy of 'tail'
+	char				pad2[THREAD_CACHE_LINE_SIZE - 2 * sizeof( long long )];
+} ksSpscQueue;
+
+static void ksSpscQueue_Create( ksSpscQueue * queue, const int elementSize, const int capacity )
+{
+	memset( queue, 0, sizeof( ksSpscQueue ) );
+	queue->mask = ksQueue_RoundCapacity( capacity ) - 1;
+	queue->elementSize = elementSize;
+	queue->elements = (unsigned char *)malloc( ( queue->mask + 1 ) * elementSize );
+}
+
+static void ksSpscQueue_Destroy( ksSpscQueue * queue )
+{
+	free( queue->elements );
+	memset( queue, 0, sizeof( ksSpscQueue ) );
+}
+
+// Must only be called from the producer thread.
+static bool ksSpscQueue_Push( ksSpscQueue * queue, const void * element )
+{
+	const long long tail = ksAtomicInt64_LoadRelaxed( &queue->tail );
+	if ( tail - queue->cachedHead > queue->mask )
+	{
+		queue->cachedHead = ksAtomicInt64_LoadAcquire( &queue->head );
+		if ( tail - queue->cachedHead > queue->mask )
+		{
+			return false;
+		}
+	}
+	memcpy( queue->elements + ( tail & queue->mask ) * queue->elementSize, element, queue->elementSize );
+	ksAtomicInt64_StoreRelease( &queue->tail, tail + 1 );
+	return true;
+}
+
+// Must only be called from the consumer thread.
+static bool ksSpscQueue_Pop( ksSpscQueue * queue, void * element )
+{
+	const long long head = ksAtomicInt64_LoadRelaxed( &queue->head );
+	if ( head == queue->cachedTail )
+	{
+		queue->cachedTail = ksAtomicInt64_LoadAcquire( &queue->tail );
+		if ( head == queue->cachedTail )
+		{
+			return false;
+		}
+	}
+	memcpy( element, queue->elements + ( head & queue->mask ) * queue->elementSize, queue->elementSize );
+	ksAtomicInt64_StoreRelease( &queue->head, head + 1 );
+	return true;
+}
+
+typedef struct
+{
+	unsigned char *		cells;				// a sequence number followed by the element
+	long long			mask;
+	int					cellSize;
+	int					elementSize;
+	char				pad0[THREAD_CACHE_LINE_SIZE - sizeof( unsigned char * ) - sizeof( long long ) - 2 * sizeof( int )];
+	ksAtomicInt64		enqueuePosition;
+	char				pad1[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+	ksAtomicInt64		dequeuePosition;
+	char				pad2[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+} ksMpmcQueue;
+
+static ksAtomicInt64 * ksMpmcQueue_GetSequence( ksMpmcQueue * queue, const long long position )
+{
+	return (ksAtomicInt64 *)( queue->cells + ( position & queue->mask ) * queue->cellSize );
+}
+
+static void ksMpmcQueue_Create( ksMpmcQueue * queue, const int elementSize, const int capacity )
+{
+	memset( queue, 0, sizeof( ksMpmcQueue ) );
+	queue->mask = ksQueue_RoundCapacity( capacity ) - 1;
+	queue->elementSize = elementSize;
+	queue->cellSize = (int)( ( sizeof( ksAtomicInt64 ) + elementSize + sizeof( ksAtomicInt64 ) - 1 ) & ~( sizeof( ksAtomicInt64 ) - 1 ) );
+	queue->cells = (unsigned char *)malloc( ( queue->mask + 1 ) * queue->cellSize );
+	for ( long long i = 0; i <= queue->mask; i++ )
+	{
+		ksAtomicInt64_StoreRelaxed( ksMpmcQueue_GetSequence( queue, i ), i );
+	}
+}
+
+static void ksMpmcQueue_Destroy( ksMpmcQueue * queue )
+{
+	free( queue->cells );
+	memset( queue, 0, sizeof( ksMpmcQueue ) );
+}
+
+static bool ksMpmcQueue_Push( ksMpmcQueue * queue, const void * element )
+{
+	long long position = ksAtomicInt64_LoadRelaxed( &queue->enqueuePosition );
+	ksAtomicInt64 * sequence;
+	for ( ; ; )
+	{
+		sequence = ksMpmcQueue_GetSequence( queue, position );
+		const long long difference = ksAtomicInt64_LoadAcquire( sequence ) - position;
+		if ( difference == 0 )
+		{
+			// The cell is free for this position, claim it.
+			if ( ksAtomicInt64_CompareExchange( &queue->enqueuePosition, position, position + 1 ) )
+			{
+				break;
+			}
+			position = ksAtomicInt64_LoadRelaxed( &queue->enqueuePosition );
+		}
+		else if ( difference < 0 )
+		{
+			// The cell still holds the element from one lap ago.
+			return false;
+		}
+		else
+		{
+			position = ksAtomicInt64_LoadRelaxed( &queue->enqueuePosition );
+		}
+	}
+	memcpy( sequence + 1, element, queue->elementSize );
+	ksAtomicInt64_StoreRelease( sequence, position + 1 );
+	return true;
+}
+
+static bool ksMpmcQueue_Pop( ksMpmcQueue * queue, void * element )
+{
+	long long position = ksAtomicInt64_LoadRelaxed( &queue->dequeuePosition );
+	ksAtomicInt64 * sequence;
+	for ( ; ; )
+	{
+		sequence = ksMpmcQueue_GetSequence( queue, position );
+		const long long difference = ksAtomicInt64_LoadAcquire( sequence ) - ( position + 1 );
+		if ( difference == 0 )
+		{
+			if ( ksAtomicInt64_CompareExchange( &queue->dequeuePosition, position, position + 1 ) )
+			{
+				break;
+			}
+			position = ksAtomicInt64_LoadRelaxed( &queue->dequeuePosition );
+		}
+		else if ( difference < 0 )
+		{
+			// The cell has not been filled for this position yet.
+			return false;
+		}
+		else
+		{
+			position = ksAtomicInt64_LoadRelaxed( &queue->dequeuePosition );
+		}
+	}
+	memcpy( element, sequence + 1, queue->elementSize );
+	// Free the cell for the producer one lap ahead.
+	ksAtomicInt64_StoreRelease( sequence, position + queue->mask + 1 );
+	return true;
+}
+
+typedef struct
+{
+	ksAtomicInt64		sequence;			// odd while the writer is copying
+	char				pad0[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+	ksAtomicInt64 *		words;
+	int					wordCount;
+	int					size;
+} ksMailbox;
+
+static void ksMailbox_Create( ksMailbox * mailbox, const int size )
+{
+	memset( mailbox, 0, sizeof( ksMailbox ) );
+	mailbox->size = size;
+	mailbox->wordCount = (int)( ( size + sizeof( ksAtomicInt64 ) - 1 ) / sizeof( ksAtomicInt64 ) );
+	mailbox->words = (ksAtomicInt64 *)calloc( mailbox->wordCount, sizeof( ksAtomicInt64 ) );
+}
+
+static void ksMailbox_Destroy( ksMailbox * mailbox )
+{
+	free( mailbox->words );
+	memset( mailbox, 0, sizeof( ksMailbox ) );
+}
+
+// Must only be called from the writer thread.
+static void ksMailbox_Publish( ksMailbox * mailbox, const void * value )
+{
+	const long long sequence = ksAtomicInt64_LoadRelaxed( &mailbox->sequence );
+	ksAtomicInt64_StoreRelaxed( &mailbox->sequence, sequence + 1 );
+	ksAtomic_ThreadFenceRelease();	// keeps the word stores below from moving before the odd sequence
+	for ( int i = 0; i < mailbox->wordCount; i++ )
+	{
+		long long word = 0;
+		const int offset = i * (int)sizeof( long long );
+		memcpy( &word, (const unsigned char *)value + offset, ( mailbox->size - offset < (int)sizeof( long long ) ) ? mailbox->size - offset : (int)sizeof( long long ) );
+		ksAtomicInt64_StoreRelaxed( &mailbox->words[i], word );
+	}
+	ksAtomicInt64_StoreRelease( &mailbox->sequence, sequence + 2 );
+}
+
+// Copies the latest published value and returns the number of times a value was published,
+// so a reader can tell whether the value changed. Returns zero, and leaves 'value' alone,
+// if nothing was published yet.
+static long long ksMailbox_Read( ksMailbox * mailbox, void * value )
+{
+	for ( ; ; )
+	{
+		const long long before = ksAtomicInt64_LoadAcquire( &mailbox->sequence );
+		if ( before == 0 )
+		{
+			return 0;
+		}
+		if ( ( before & 1 ) != 0 )
+		{
+			ksAtomic_Pause();
+			continue;
+		}
+		for ( int i = 0; i < mailbox->wordCount; i++ )
+		{
+			const long long word = ksAtomicInt64_LoadRelaxed( &mailbox->words[i] );
+			const int offset = i * (int)sizeof( long long );
+			memcpy( (unsigned char *)value + offset, &word, ( mailbox->size - offset < (int)sizeof( long long ) ) ? mailbox->size - offset : (int)sizeof( long long ) );
+		}
+		ksAtomic_ThreadFenceAcquire();	// keeps the word loads above from moving after the second sequence load
+		if ( ksAtomicInt64_LoadRelaxed( &mailbox->sequence ) == before )
+		{
+			return before / 2;
+		}
+	}
+}
+
+#define TRIPLE_BUFFER_NEW		4			// set in 'middle' when it holds a buffer the reader has not seen
+
+typedef struct
+{
+	unsigned char *		buffers;
+	int					size;
+	char				pad0[THREAD_CACHE_LINE_SIZE - sizeof( unsigned char * ) - sizeof( int )];
+	ksAtomicInt64		middle;				// index of the buffer in the middle, with TRIPLE_BUFFER_NEW
+	char				pad1[THREAD_CACHE_LINE_SIZE - sizeof( ksAtomicInt64 )];
+	int					back;				// only accessed by the writer
+	char				pad2[THREAD_CACHE_LINE_SIZE - sizeof( int )];
+	int					front;				// only accessed by the reader
+	char				pad3[THREAD_CACHE_LINE_SIZE - sizeof( int )];
+} ksTripleBuffer;
+
+static void ksTripleBuffer_Create( ksTripleBuffer * tripleBuffer, const int size )
+{
+	memset( tripleBuffer, 0, sizeof( ksTripleBuffer ) );
+	tripleBuffer->buffers = (unsigned char *)calloc( 3, size );
+	tripleBuffer->size = size;
+	tripleBuffer->back = 0;
+	tripleBuffer->middle = 1;
+	tripleBuffer->front = 2;
+}
+
+static void ksTripleBuffer_Destroy( ksTripleBuffer * tripleBuffer )
+{
+	free( tripleBuffer->buffers );
+	memset( tripleBuffer, 0, sizeof( ksTripleBuffer ) );
+}
+
+// Must only be called from the writer thread.
+static void * ksTripleBuffer_GetWriteBuffer( ksTripleBuffer * tripleBuffer )
+{
+	return tripleBuffer->buffers + tripleBuffer->back * tripleBuffer->size;
+}
+
+// Must only be called from the writer thread. The next write buffer may hold any older contents.
+static void ksTripleBuffer_Publish( ksTripleBuffer * tripleBuffer )
+{
+	const long long previous = ksAtomicInt64_Exchange( &tripleBuffer->middle, tripleBuffer->back | TRIPLE_BUFFER_NEW );
+	tripleBuffer->back = (int)( previous & ~TRIPLE_BUFFER_NEW );
+}
+
+// Must only be called from the reader thread. Returns the most recently published buffer, which
+// stays valid until the next call. 'isNew' may be NULL.
+static const void * ksTripleBuffer_GetReadBuffer( ksTripleBuffer * tripleBuffer, bool * isNew )
+{
+	const bool published = ( ksAtomicInt64_LoadRelaxed( &tripleBuffer->middle ) & TRIPLE_BUFFER_NEW ) != 0;
+	if ( published )
+	{
+		const long long previous = ksAtomicInt64_Exchange( &tripleBuffer->middle, tripleBuffer->front );
+		tripleBuffer->front = (int)( previous & ~TRIPLE_BUFFER_NEW );
+	}
+	if ( isNew != NULL )
+	{
+		*isNew = published;
 	}
+	return tripleBuffer->buffers + tripleBuffer->front * tripleBuffer->size;
 }
 
 #endif // !KSTHREADING_H
@@ -0,0 +1,297 @@
+#include "actions.h"
+
+#include <cstring>
+#include <iostream>
+
+
+// Check result of OpenXR API calls (throws an exception in case of failure)
+#define CHK_XR(cmd) \
+{ \
+    XrResult res = cmd; \
+    char err_msg[XR_MAX_RESULT_STRING_SIZE]; \
+    if (XR_SUCCEEDED(res)) { \
+        if (res != XR_SUCCESS) { \
+            xrResultToString(_instance, res, err_msg); \
+            std::cerr << "WARN: " << err_msg << " (" << res << ")" << std::endl; \
+        } \
+    } \
+    else { \
+        xrResultToString(_instance, res, err_msg); \
+        std::cerr << "ERROR: " << err_msg << " (" << res << ") - " << __FILE__ << ":" << __LINE__ << std::endl; \
+        throw res; \
+    } \
+}
+
+
+/**
+ */
+void ActionFrame::update(const ActionStateBlock& block)
+{
+    pressed = 0;
+    released = 0;
+    for (uint32_t i = 0; i < ActionStateBlock::MAX_ACTIONS; i++) {
+        if (block.pressCount[i] != state.pressCount[i]) {
+            pressed |= 1u << i;
+        }
+        if (block.releaseCount[i] != state.releaseCount[i]) {
+            released |= 1u << i;
+        }
+    }
+    profileChanged = (block.interactionProfileChanges != state.interactionProfileChanges);
+    state = block;
+}
+
+
+/**
+ *  Constructor
+ */
+ActionRegistry::ActionRegistry(const XrDispatch& xr, XrInstance instance, XrActionSet actionSet) :
+    _xr(xr),
+    _instance(instance),
+    _actionSet(actionSet)
+{
+}
+
+/**
+ *  Destructor. Actions are destroyed with their action set
+ */
+ActionRegistry::~ActionRegistry()
+{
+    for (XrSpace space : _poseSpaces) {
+        xrDestroySpace(space);
+    }
+}
+
+/**
+ */
+XrAction ActionRegistry::createAction(const char* name, const char* localizedName, XrActionType type)
+{
+    XrActionCreateInfo actioninfo{ XR_TYPE_ACTION_CREATE_INFO };
+    strncpy(actioninfo.actionName, name, XR_MAX_ACTION_NAME_SIZE - 1);
+    actioninfo.actionType = type;
+    strncpy(actioninfo.localizedActionName, localizedName, XR_MAX_LOCALIZED_ACTION_NAME_SIZE - 1);
+    XrAction action;
+    CHK_XR(xrCreateAction(_actionSet, &actioninfo, &action));
+    return action;
+}
+
+/**
+ */
+uint32_t ActionRegistry::add(const char* name, const char* localizedName, XrActionType type)
+{
+    switch (type) {
+    case XR_ACTION_TYPE_BOOLEAN_INPUT:
+        return addBoolean(name, localizedName).index;
+    case XR_ACTION_TYPE_FLOAT_INPUT:
+        return addFloat(name, localizedName).index;
+    case XR_ACTION_TYPE_VECTOR2F_INPUT:
+        return addVector2(name, localizedName).index;
+    case XR_ACTION_TYPE_POSE_INPUT:
+        return addPose(name, localizedName).index;
+    case XR_ACTION_TYPE_VIBRATION_OUTPUT:
+        return addVibration(name, localizedName).index;
+    default:
+        std::cerr << "ERROR: unsupported type " << type << " for action " << name << std::endl;
+        throw -1;
+    }
+}
+
+/**
+ */
+XrAction ActionRegistry::findAction(const char* name) const
+{
+    auto it = _names.find(name);
+    return (it != _names.end()) ? it->second.action : XR_NULL_HANDLE;
+}
+
+/**
+ */
+uint32_t ActionRegistry::find(const char* name, XrActionType type) const
+{
+    auto it = _names.find(name);
+    if (it == _names.end() || it->second.type != type) {
+        std::cerr << "ERROR: no action " << name << " of type " << type << std::endl;
+        throw -1;
+    }
+    return it->second.index;
+}
+
+/**
+ */
+BooleanAction ActionRegistry::addBoolean(const char* name, const char* localizedName)
+{
+    if (_booleans.size() >= ActionStateBlock::MAX_ACTIONS) {
+        std::cerr << "ERROR: too many boolean actions, cannot add " << name << std::endl;
+        throw -1;
+    }
+    _booleans.push_back(createAction(name, localizedName, XR_ACTION_TYPE_BOOLEAN_INPUT));
+    _names[name] = NamedAction{ XR_ACTION_TYPE_BOOLEAN_INPUT, (uint32_t)_booleans.size() - 1, _booleans.back() };
+    return BooleanAction{ (uint32_t)_booleans.size() - 1 };
+}
+
+/**
+ */
+FloatAction ActionRegistry::addFloat(const char* name, const char* localizedName)
+{
+    if (_floats.size() >= ActionStateBlock::MAX_ACTIONS) {
+        std::cerr << "ERROR: too many float actions, cannot add " << name << std::endl;
+        throw -1;
+    }
+    _floats.push_back(createAction(name, localizedName, XR_ACTION_TYPE_FLOAT_INPUT));
+    _names[name] = NamedAction{ XR_ACTION_TYPE_FLOAT_INPUT, (uint32_t)_floats.size() - 1, _floats.back() };
+    return FloatAction{ (uint32_t)_floats.size() - 1 };
+}
+
+/**
+ */
+Vector2Action ActionRegistry::addVector2(const char* name, const char* localizedName)
+{
+    if (_vector2s.size() >= ActionStateBlock::MAX_ACTIONS) {
+        std::cerr << "ERROR: too many vector2 actions, cannot add " << name << std::endl;
+        throw -1;
+    }
+    _vector2s.push_back(createAction(name, localizedName, XR_ACTION_TYPE_VECTOR2F_INPUT));
+    _names[name] = NamedAction{ XR_ACTION_TYPE_VECTOR2F_INPUT, (uint32_t)_vector2s.size() - 1, _vector2s.back() };
+    return Vector2Action{ (uint32_t)_vector2s.size() - 1 };
+}
+
+/**
+ */
+PoseAction ActionRegistry::addPose(const char* name, const char* localizedName)
+{
+    if (_poses.size() >= ActionStateBlock::MAX_POSES) {
+        std::cerr << "ERROR: too many pose actions, cannot add " << name << std::endl;
+        throw -1;
+    }
+    _poses.push_back(createAction(name, localizedName, XR_ACTION_TYPE_POSE_INPUT));
+    _poseNames.push_back(name);
+    _names[name] = NamedAction{ XR_ACTION_TYPE_POSE_INPUT, (uint32_t)_poses.size() - 1, _poses.back() };
+    return PoseAction{ (uint32_t)_poses.size() - 1 };
+}
+
+/**
+ */
+VibrationAction ActionRegistry::addVibration(const char* name, const char* localizedName)
+{
+    _vibrations.push_back(createAction(name, localizedName, XR_ACTION_TYPE_VIBRATION_OUTPUT));
+    _names[name] = NamedAction{ XR_ACTION_TYPE_VIBRATION_OUTPUT, (uint32_t)_vibrations.size() - 1, _vibrations.back() };
+    return VibrationAction{ (uint32_t)_vibrations.size() - 1 };
+}
+
+/**
+ */
+void ActionRegistry::createPoseSpaces(XrSession session)
+{
+    for (size_t i = _poseSpaces.size(); i < _poses.size(); i++) {
+        XrActionSpaceCreateInfo create_info{ XR_TYPE_ACTION_SPACE_CREATE_INFO };
+        create_info.action = _poses[i];
+        create_info.poseInActionSpace.orientation.w = 1.;
+        XrSpace space;
+        CHK_XR(xrCreateActionSpace(session, &create_info, &space));
+        _poseSpaces.push_back(space);
+    }
+}
+
+/**
+ */
+void ActionRegistry::reportFailure(XrResult res, const char* call) const
+{
+    char err_msg[XR_MAX_RESULT_STRING_SIZE];
+    xrResultToString(_instance, res, err_msg);
+    std::cerr << "ERROR: " << call << ": " << err_msg << " (" << res << ")" << std::endl;
+}
+
+/**
+ * Runs on the input thread, so failures are reported instead of thrown
+ */
+void ActionRegistry::query(XrSession session, XrSpace baseSpace, XrTime time, ActionStateBlock& block) const
+{
+    XrResult res;
+    XrActionStateGetInfo get_info{ XR_TYPE_ACTION_STATE_GET_INFO };
+
+    block.time = time;
+
+    const uint32_t previous_down = block.booleanDown;
+    block.booleanDown = 0;
+    block.booleanActive = 0;
+    for (uint32_t i = 0; i < (uint32_t)_booleans.size(); i++) {
+        XrActionStateBoolean state{ XR_TYPE_ACTION_STATE_BOOLEAN };
+        get_info.action = _booleans[i];
+        if (XR_FAILED(res = _xr.GetActionStateBoolean(session, &get_info, &state))) {
+            reportFailure(res, "xrGetActionStateBoolean");
+        }
+        const bool was_down = (previous_down >> i) & 1;
+        if (!state.isActive) {
+            // Held when it became inactive, released as far as the app is concerned
+            if (was_down) {
+                block.releaseCount[i]++;
+            }
+            continue;
+        }
+        block.booleanActive |= 1u << i;
+        block.booleanDown |= (state.currentState ? 1u : 0u) << i;
+        if (state.currentState && !was_down) {
+            block.pressCount[i]++;
+        }
+        else if (!state.currentState && was_down) {
+            block.releaseCount[i]++;
+        }
+        else if (state.changedSinceLastSync) {
+            // Pressed and released (or the reverse) between two syncs
+            block.pressCount[i]++;
+            block.releaseCount[i]++;
+        }
+    }
+
+    block.floatActive = 0;
+    for (uint32_t i = 0; i < (uint32_t)_floats.size(); i++) {
+        XrActionStateFloat state{ XR_TYPE_ACTION_STATE_FLOAT };
+        get_info.action = _floats[i];
+        if (XR_FAILED(res = _xr.GetActionStateFloat(session, &get_info, &state))) {
+            reportFailure(res, "xrGetActionStateFloat");
+        }
+        block.floatActive |= (state.isActive ? 1u : 0u) << i;
+        block.floats[i] = state.isActive ? state.currentState : 0.0f;
+    }
+
+    block.vector2Active = 0;
+    for (uint32_t i = 0; i < (uint32_t)_vector2s.size(); i++) {
+        XrActionStateVector2f state{ XR_TYPE_ACTION_STATE_VECTOR2F };
+        get_info.action = _vector2s[i];
+        if (XR_FAILED(res = _xr.GetActionStateVector2f(session, &get_info, &state))) {
+            reportFailure(res, "xrGetActionStateVector2f");
+        }
+        block.vector2Active |= (state.isActive ? 1u : 0u) << i;
+        block.vector2s[i] = state.isActive ? state.currentState : XrVector2f{ 0.0f, 0.0f };
+    }
+
+    // An inactive pose action locates without valid flags, so its state is not queried separately
+    for (uint32_t i = 0; i < (uint32_t)_poseSpaces.size(); i++) {
+        XrSpaceLocation location{ XR_TYPE_SPACE_LOCATION };
+        if (time != 0 && XR_FAILED(res = _xr.LocateSpace(_poseSpaces[i], baseSpace, time, &location))) {
+            reportFailure(res, "xrLocateSpace");
+        }
+        block.poseFlags[i] = location.locationFlags;
+        block.poses[i] = location.pose;
+    }
+}
+
+/**
+ */
+void ActionRegistry::clear(ActionStateBlock& block)
+{
+    // Actions that were down are released
+    for (uint32_t i = 0; i < ActionStateBlock::MAX_ACTIONS; i++) {
+        if ((block.booleanDown >> i) & 1) {
+            block.releaseCount[i]++;
+        }
+    }
+    block.focused = false;
+    block.booleanDown = 0;
+    block.booleanActive = 0;
+    block.floatActive = 0;
+    block.vector2Active = 0;
+    memset(block.floats, 0, sizeof(block.floats));
+    memset(block.vector2s, 0, sizeof(block.vector2s));
+    memset(block.poseFlags, 0, sizeof(block.poseFlags));
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dispatch.h"
+
+// Stable handles to registered actions: the index of the action among the actions of its type
+struct BooleanAction { uint32_t index; };
+struct FloatAction { uint32_t index; };
+struct Vector2Action { uint32_t index; };
+struct PoseAction { uint32_t index; };
+struct VibrationAction { uint32_t index; };
+
+/**
+ * Packed state of every registered action at one sync.
+ * Boolean states are bit masks indexed by BooleanAction. Trivially copyable, so it can go
+ * through a ksMailbox.
+ */
+struct ActionStateBlock {
+    static const uint32_t MAX_ACTIONS = 32;     // per type, one bit each in the masks
+    static const uint32_t MAX_POSES = 8;
+
+    uint64_t sequence;          // number of the sync, starting at 1
+    XrTime time;                // runtime time the actions were synced and the poses located at
+    bool focused;               // false once the session lost focus, all states are then inactive
+    uint32_t interactionProfileChanges;     // seen so far, bindings may differ after each
+
+    uint32_t booleanDown;
+    uint32_t booleanActive;
+    uint16_t pressCount[MAX_ACTIONS];       // rising edges seen so far, wraps around
+    uint16_t releaseCount[MAX_ACTIONS];     // falling edges seen so far, wraps around
+
+    uint32_t floatActive;
+    float floats[MAX_ACTIONS];
+
+    uint32_t vector2Active;
+    XrVector2f vector2s[MAX_ACTIONS];
+
+    XrSpaceLocationFlags poseFlags[MAX_POSES];
+    XrPosef poses[MAX_POSES];
+
+    bool isActive(BooleanAction action) const { return (booleanActive >> action.index) & 1; }
+    bool isDown(BooleanAction action) const { return (booleanDown >> action.index) & 1; }
+    bool isActive(FloatAction action) const { return (floatActive >> action.index) & 1; }
+    float value(FloatAction action) const { return floats[action.index]; }
+    bool isActive(Vector2Action action) const { return (vector2Active >> action.index) & 1; }
+    XrVector2f value(Vector2Action action) const { return vector2s[action.index]; }
+
+    /// True if both orientation and position of the pose are valid
+    bool hasPose(PoseAction action) const
+    {
+        const XrSpaceLocationFlags valid = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+        return (poseFlags[action.index] & valid) == valid;
+    }
+    const XrPosef& pose(PoseAction action) const { return poses[action.index]; }
+};
+
+/**
+ * Boolean edges between the state blocks seen by two consecutive update calls. The input thread
+ * may sync several times per frame; the edge counters in the blocks make sure a press or release
+ * between two frames is reported exactly once.
+ */
+struct ActionFrame {
+    ActionStateBlock state;
+    uint32_t pressed;
+    uint32_t released;
+    bool profileChanged;
+
+    /// Call once per frame with the freshest state block
+    void update(const ActionStateBlock& block);
+
+    bool wasPressed(BooleanAction action) const { return (pressed >> action.index) & 1; }
+    bool wasReleased(BooleanAction action) const { return (released >> action.index) & 1; }
+};
+
+/**
+ * Creates the actions of an action set and keeps their handles in flat arrays by type.
+ * query fills a whole ActionStateBlock in one pass after each xrSyncActions.
+ */
+class ActionRegistry {
+
+public:
+
+    /// The dispatch table must outlive the registry
+    ActionRegistry(const XrDispatch& xr, XrInstance instance, XrActionSet actionSet);
+    ~ActionRegistry();
+
+    ActionRegistry(const ActionRegistry&) = delete;
+    ActionRegistry& operator=(const ActionRegistry&) = delete;
+
+    /// Actions must be added before the action set is attached to the session
+    BooleanAction addBoolean(const char* name, const char* localizedName);
+    FloatAction addFloat(const char* name, const char* localizedName);
+    Vector2Action addVector2(const char* name, const char* localizedName);
+    PoseAction addPose(const char* name, const char* localizedName);
+    VibrationAction addVibration(const char* name, const char* localizedName);
+    /// Adds an action of any type. Returns its index among the actions of that type
+    uint32_t add(const char* name, const char* localizedName, XrActionType type);
+
+    /// Creates an action space for every pose action
+    void createPoseSpaces(XrSession session);
+
+    XrAction getAction(BooleanAction action) const { return _booleans[action.index]; }
+    XrAction getAction(FloatAction action) const { return _floats[action.index]; }
+    XrAction getAction(Vector2Action action) const { return _vector2s[action.index]; }
+    XrAction getAction(PoseAction action) const { return _poses[action.index]; }
+    XrAction getAction(VibrationAction action) const { return _vibrations[action.index]; }
+    XrSpace getSpace(PoseAction action) const { return _poseSpaces[action.index]; }
+    uint32_t poseCount() const { return (uint32_t)_poses.size(); }
+    const std::string& poseName(PoseAction action) const { return _poseNames[action.index]; }
+
+    /// XR_NULL_HANDLE if there is no action with that name
+    XrAction findAction(const char* name) const;
+
+    /// Handles of actions added by name, for instance from a manifest. Throw if there is no such action
+    BooleanAction findBoolean(const char* name) const { return BooleanAction{ find(name, XR_ACTION_TYPE_BOOLEAN_INPUT) }; }
+    FloatAction findFloat(const char* name) const { return FloatAction{ find(name, XR_ACTION_TYPE_FLOAT_INPUT) }; }
+    Vector2Action findVector2(const char* name) const { return Vector2Action{ find(name, XR_ACTION_TYPE_VECTOR2F_INPUT) }; }
+    PoseAction findPose(const char* name) const { return PoseAction{ find(name, XR_ACTION_TYPE_POSE_INPUT) }; }
+    VibrationAction findVibration(const char* name) const { return VibrationAction{ find(name, XR_ACTION_TYPE_VIBRATION_OUTPUT) }; }
+
+    /**
+     * Reads the state of every action into block, after xrSyncActions. Poses are located in
+     * baseSpace at time, and left invalid if time is 0. The edge counters continue from the
+     * previous contents of block. Failures are reported and leave that state inactive.
+     */
+    void query(XrSession session, XrSpace baseSpace, XrTime time, ActionStateBlock& block) const;
+
+    /// Marks every state inactive, as for an unfocused session. Edge counters are kept
+    static void clear(ActionStateBlock& block);
+
+private:
+
+    struct NamedAction {
+        XrActionType type;
+        uint32_t index;
+        XrAction action;
+    };
+
+    XrAction createAction(const char* name, const char* localizedName, XrActionType type);
+    uint32_t find(const char* name, XrActionType type) const;
+    void reportFailure(XrResult res, const char* call) const;
+
+    const XrDispatch& _xr;
+    XrInstance _instance;
+    XrActionSet _actionSet;
+
+    std::vector<XrAction> _booleans;
+    std::vector<XrAction> _floats;
+    std::vector<XrAction> _vector2s;
+    std::vector<XrAction> _poses;
+    std::vector<XrAction> _vibrations;
+    std::vector<XrSpace> _poseSpaces;
+    std::vector<std::string> _poseNames;
+    std::unordered_map<std::string, NamedAction> _names;
+
+};
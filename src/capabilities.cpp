@@ -0,0 +1,223 @@
+#include "capabilities.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+namespace {
+
+// "XRCC", followed by the format version. Bump it whenever the layout changes
+const uint32_t CACHE_MAGIC = 0x43435258;
+const uint32_t CACHE_VERSION = 1;
+const uint32_t MAX_CACHE_SIZE = 1024 * 1024;
+
+/// FNV-1a over the payload, to reject truncated or damaged files
+uint32_t checksum(const uint8_t* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+class Writer {
+public:
+    std::vector<uint8_t> data;
+
+    template <typename T> void put(const T& value)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+    void putString(const char* s)
+    {
+        const uint32_t length = (uint32_t)strlen(s);
+        put(length);
+        data.insert(data.end(), s, s + length);
+    }
+    template <typename T> void putArray(const std::vector<T>& values)
+    {
+        put((uint32_t)values.size());
+        for (const T& value : values) {
+            put(value);
+        }
+    }
+};
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : _data(data), _size(size), _offset(0), _valid(true) {}
+
+    bool valid() const { return _valid && _offset == _size; }
+
+    template <typename T> T get()
+    {
+        T value{};
+        if (_offset + sizeof(T) > _size) {
+            _valid = false;
+            return value;
+        }
+        memcpy(&value, _data + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return value;
+    }
+    /// Copies into a fixed size array, truncating what does not fit
+    void getString(char* s, size_t capacity)
+    {
+        const uint32_t length = get<uint32_t>();
+        if (_offset + length > _size) {
+            _valid = false;
+            s[0] = '\0';
+            return;
+        }
+        const size_t copied = (length < capacity) ? length : capacity - 1;
+        memcpy(s, _data + _offset, copied);
+        s[copied] = '\0';
+        _offset += length;
+    }
+    std::string getString()
+    {
+        const uint32_t length = get<uint32_t>();
+        if (_offset + length > _size) {
+            _valid = false;
+            return std::string();
+        }
+        std::string s(reinterpret_cast<const char*>(_data + _offset), length);
+        _offset += length;
+        return s;
+    }
+    /// Element count, checked against the bytes left so a damaged count cannot allocate much
+    uint32_t getCount(size_t elementSize)
+    {
+        const uint32_t count = get<uint32_t>();
+        if (count > (_size - _offset) / elementSize) {
+            _valid = false;
+            return 0;
+        }
+        return count;
+    }
+    template <typename T> void getArray(std::vector<T>& values)
+    {
+        values.resize(getCount(sizeof(T)));
+        for (T& value : values) {
+            value = get<T>();
+        }
+    }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _offset;
+    bool _valid;
+};
+
+}
+
+
+/**
+ *  Constructor
+ */
+RuntimeCapabilities::RuntimeCapabilities() :
+    runtimeVersion(0),
+    systemId(XR_NULL_SYSTEM_ID),
+    viewConfigProps{ XR_TYPE_VIEW_CONFIGURATION_PROPERTIES }
+{
+}
+
+/**
+ * Structures are stored field by field, without their type and next members
+ */
+bool RuntimeCapabilities::save(const std::string& fileName) const
+{
+    Writer w;
+    w.putString(runtimeName.c_str());
+    w.put(runtimeVersion);
+    w.put(systemId);
+
+    w.put((uint32_t)extensions.size());
+    for (const XrExtensionProperties& extension : extensions) {
+        w.putString(extension.extensionName);
+        w.put(extension.extensionVersion);
+    }
+    w.putArray(blendModes);
+    w.putArray(viewConfigs);
+    w.put(viewConfigProps.viewConfigurationType);
+    w.put(viewConfigProps.fovMutable);
+    w.put((uint32_t)viewConfigViews.size());
+    for (const XrViewConfigurationView& view : viewConfigViews) {
+        w.put(view.recommendedImageRectWidth);
+        w.put(view.maxImageRectWidth);
+        w.put(view.recommendedImageRectHeight);
+        w.put(view.maxImageRectHeight);
+        w.put(view.recommendedSwapchainSampleCount);
+        w.put(view.maxSwapchainSampleCount);
+    }
+    w.putArray(referenceSpaces);
+    w.putArray(swapchainFormats);
+
+    const uint32_t header[4] = { CACHE_MAGIC, CACHE_VERSION, (uint32_t)w.data.size(), checksum(w.data.data(), w.data.size()) };
+    FILE* file = fopen(fileName.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(w.data.data(), w.data.size(), 1, file) == 1;
+    return (fclose(file) == 0) && written;
+}
+
+/**
+ */
+bool RuntimeCapabilities::load(const std::string& fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint32_t header[4];
+    std::vector<uint8_t> data;
+    bool read = fread(header, sizeof(header), 1, file) == 1 && header[0] == CACHE_MAGIC && header[1] == CACHE_VERSION
+        && header[2] <= MAX_CACHE_SIZE;
+    if (read) {
+        data.resize(header[2]);
+        read = fread(data.data(), 1, data.size(), file) == data.size() && checksum(data.data(), data.size()) == header[3];
+    }
+    fclose(file);
+    if (!read) {
+        return false;
+    }
+
+    RuntimeCapabilities c;
+    Reader r(data.data(), data.size());
+    c.runtimeName = r.getString();
+    c.runtimeVersion = r.get<XrVersion>();
+    c.systemId = r.get<XrSystemId>();
+
+    c.extensions.resize(r.getCount(sizeof(uint32_t) * 2));
+    for (XrExtensionProperties& extension : c.extensions) {
+        extension = { XR_TYPE_EXTENSION_PROPERTIES };
+        r.getString(extension.extensionName, XR_MAX_EXTENSION_NAME_SIZE);
+        extension.extensionVersion = r.get<uint32_t>();
+    }
+    r.getArray(c.blendModes);
+    r.getArray(c.viewConfigs);
+    c.viewConfigProps.viewConfigurationType = r.get<XrViewConfigurationType>();
+    c.viewConfigProps.fovMutable = r.get<XrBool32>();
+    c.viewConfigViews.resize(r.getCount(sizeof(uint32_t) * 6));
+    for (XrViewConfigurationView& view : c.viewConfigViews) {
+        view = { XR_TYPE_VIEW_CONFIGURATION_VIEW };
+        view.recommendedImageRectWidth = r.get<uint32_t>();
+        view.maxImageRectWidth = r.get<uint32_t>();
+        view.recommendedImageRectHeight = r.get<uint32_t>();
+        view.maxImageRectHeight = r.get<uint32_t>();
+        view.recommendedSwapchainSampleCount = r.get<uint32_t>();
+        view.maxSwapchainSampleCount = r.get<uint32_t>();
+    }
+    r.getArray(c.referenceSpaces);
+    r.getArray(c.swapchainFormats);
+
+    if (!r.valid()) {
+        return false;
+    }
+    *this = std::move(c);
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Results of the runtime enumerations done at startup, for one runtime version and system.
+ * Saved to a small binary file so later launches can skip the enumerations; the entry is only
+ * used when the runtime name, version and system ID it was made for still match.
+ */
+struct RuntimeCapabilities {
+
+    // Key
+    std::string runtimeName;
+    XrVersion runtimeVersion;
+    XrSystemId systemId;
+
+    std::vector<XrExtensionProperties> extensions;
+    std::vector<XrEnvironmentBlendMode> blendModes;
+    std::vector<XrViewConfigurationType> viewConfigs;
+    XrViewConfigurationProperties viewConfigProps;          // of the view configuration the app uses
+    std::vector<XrViewConfigurationView> viewConfigViews;
+    std::vector<XrReferenceSpaceType> referenceSpaces;
+    std::vector<int64_t> swapchainFormats;
+
+    RuntimeCapabilities();
+
+    /// False, leaving the capabilities unchanged, if the file is missing, of another format or damaged
+    bool load(const std::string& fileName);
+    bool save(const std::string& fileName) const;
+
+    bool matches(const char* name, XrVersion version) const { return runtimeName == name && runtimeVersion == version; }
+};
@@ -0,0 +1,173 @@
+#include "dispatch.h"
+
+#include <iostream>
+
+#include "utils/callprofiler.h"
+
+
+#if defined(XR_DISPATCH_PROBES)
+namespace {
+
+enum DispatchIndex {
+#define XR_DISPATCH_INDEX(member, command) INDEX_##member,
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_INDEX)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_INDEX)
+#undef XR_DISPATCH_INDEX
+    INDEX_COUNT
+};
+
+const char* const COMMAND_NAMES[INDEX_COUNT] = {
+#define XR_DISPATCH_NAME(member, command) #command,
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_NAME)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_NAME)
+#undef XR_DISPATCH_NAME
+};
+
+// Entry points resolved by load, called by the probes. Function i of the profiler is command i
+PFN_xrVoidFunction targets[INDEX_COUNT];
+ksCallProfiler callProfiler;
+
+/// Has the signature of the command, so it can take its place in the table
+template <int Index, typename Function> struct Probed;
+
+template <int Index, typename... Args> struct Probed<Index, XrResult (XRAPI_PTR*)(Args...)> {
+    static XrResult XRAPI_CALL call(Args... args)
+    {
+        typedef XrResult (XRAPI_PTR* Function)(Args...);
+        const ksNanoseconds start = GetTimeNanoseconds();
+        const XrResult result = reinterpret_cast<Function>(targets[Index])(args...);
+        ksCallProfiler_Record(&callProfiler, Index, GetTimeNanoseconds() - start);
+        return result;
+    }
+};
+
+}
+#endif
+
+
+/**
+ *  Constructor
+ */
+XrDispatch::XrDispatch() :
+#define XR_DISPATCH_INIT(member, command) member(nullptr),
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_INIT)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_INIT)
+#undef XR_DISPATCH_INIT
+    _instance(XR_NULL_HANDLE),
+    _getInstanceProcAddr(nullptr)
+{
+}
+
+/**
+ */
+void XrDispatch::load(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr)
+{
+    _instance = instance;
+    _getInstanceProcAddr = getInstanceProcAddr;
+
+#define XR_DISPATCH_LOAD_CORE(member, command) \
+    if (XR_FAILED(getInstanceProcAddr(instance, #command, reinterpret_cast<PFN_xrVoidFunction*>(&member)))) { \
+        std::cerr << "ERROR: the runtime provides no " #command << std::endl; \
+        throw -1; \
+    }
+#define XR_DISPATCH_LOAD_EXTENSION(member, command) \
+    if (XR_FAILED(getInstanceProcAddr(instance, #command, reinterpret_cast<PFN_xrVoidFunction*>(&member)))) { \
+        member = nullptr; \
+    }
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_LOAD_CORE)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_LOAD_EXTENSION)
+#undef XR_DISPATCH_LOAD_CORE
+#undef XR_DISPATCH_LOAD_EXTENSION
+
+#if defined(XR_DISPATCH_PROBES)
+    // The statistics carry over when the instance is created again
+    if (ksCallProfiler_GetFunctionCount(&callProfiler) == 0) {
+        for (int i = 0; i < INDEX_COUNT; i++) {
+            ksCallProfiler_AddFunction(&callProfiler, COMMAND_NAMES[i]);
+        }
+    }
+#define XR_DISPATCH_PROBE(member, command) \
+    if (member != nullptr) { \
+        targets[INDEX_##member] = reinterpret_cast<PFN_xrVoidFunction>(member); \
+        member = &Probed<INDEX_##member, PFN_##command>::call; \
+    }
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_PROBE)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_PROBE)
+#undef XR_DISPATCH_PROBE
+#endif
+}
+
+/**
+ */
+void XrDispatch::endFrame()
+{
+#if defined(XR_DISPATCH_PROBES)
+    ksCallProfiler_EndFrame(&callProfiler);
+#endif
+}
+
+/**
+ */
+const ksCallProfiler* XrDispatch::profiler() const
+{
+#if defined(XR_DISPATCH_PROBES)
+    return &callProfiler;
+#else
+    return nullptr;
+#endif
+}
+
+/**
+ */
+void XrDispatch::reportProbes() const
+{
+#if defined(XR_DISPATCH_PROBES)
+    std::cout << "OpenXR calls through the dispatch table, in microseconds:" << std::endl;
+    ksCallProfiler_Report(&callProfiler, stdout);
+#endif
+}
+
+/**
+ * The three loops make the same call with the same arguments, so the differences are the cost of
+ * the loader trampoline and of the probe. Each path is called once before it is timed.
+ */
+void XrDispatch::measureCallOverhead(XrSession session, const XrActionStateGetInfo& getInfo, uint32_t iterations) const
+{
+    PFN_xrGetActionStateBoolean direct = nullptr;
+    if (iterations == 0 || XR_FAILED(_getInstanceProcAddr(_instance, "xrGetActionStateBoolean",
+            reinterpret_cast<PFN_xrVoidFunction*>(&direct)))) {
+        return;
+    }
+    XrActionStateBoolean state{ XR_TYPE_ACTION_STATE_BOOLEAN };
+
+    xrGetActionStateBoolean(session, &getInfo, &state);
+    const ksNanoseconds loaderStart = GetTimeNanoseconds();
+    for (uint32_t i = 0; i < iterations; i++) {
+        xrGetActionStateBoolean(session, &getInfo, &state);
+    }
+    const ksNanoseconds loaderTime = GetTimeNanoseconds() - loaderStart;
+
+    direct(session, &getInfo, &state);
+    const ksNanoseconds directStart = GetTimeNanoseconds();
+    for (uint32_t i = 0; i < iterations; i++) {
+        direct(session, &getInfo, &state);
+    }
+    const ksNanoseconds directTime = GetTimeNanoseconds() - directStart;
+
+    GetActionStateBoolean(session, &getInfo, &state);
+    const ksNanoseconds tableStart = GetTimeNanoseconds();
+    for (uint32_t i = 0; i < iterations; i++) {
+        GetActionStateBoolean(session, &getInfo, &state);
+    }
+    const ksNanoseconds tableTime = GetTimeNanoseconds() - tableStart;
+
+#if defined(XR_DISPATCH_PROBES)
+    const char* table = " ns through the probed dispatch table";
+#else
+    const char* table = " ns through the dispatch table";
+#endif
+    std::cout << "xrGetActionStateBoolean, " << iterations << " calls: "
+        << (double)loaderTime / iterations << " ns through the loader, "
+        << (double)directTime / iterations << " ns direct, "
+        << (double)tableTime / iterations << table << std::endl;
+}
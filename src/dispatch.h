@@ -0,0 +1,80 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+
+#include "utils/callprofiler.h"
+
+// Commands called every frame or from the input thread: member name, OpenXR command
+#define XR_DISPATCH_CORE_FUNCTIONS(XR_FUNCTION) \
+    XR_FUNCTION(PollEvent, xrPollEvent) \
+    XR_FUNCTION(WaitFrame, xrWaitFrame) \
+    XR_FUNCTION(BeginFrame, xrBeginFrame) \
+    XR_FUNCTION(EndFrame, xrEndFrame) \
+    XR_FUNCTION(LocateViews, xrLocateViews) \
+    XR_FUNCTION(LocateSpace, xrLocateSpace) \
+    XR_FUNCTION(AcquireSwapchainImage, xrAcquireSwapchainImage) \
+    XR_FUNCTION(WaitSwapchainImage, xrWaitSwapchainImage) \
+    XR_FUNCTION(ReleaseSwapchainImage, xrReleaseSwapchainImage) \
+    XR_FUNCTION(SyncActions, xrSyncActions) \
+    XR_FUNCTION(GetActionStateBoolean, xrGetActionStateBoolean) \
+    XR_FUNCTION(GetActionStateFloat, xrGetActionStateFloat) \
+    XR_FUNCTION(GetActionStateVector2f, xrGetActionStateVector2f) \
+    XR_FUNCTION(ApplyHapticFeedback, xrApplyHapticFeedback) \
+    XR_FUNCTION(StopHapticFeedback, xrStopHapticFeedback)
+
+// Commands of extensions, null unless the extension was enabled on the instance
+#if defined(XR_KHR_locate_spaces)
+#define XR_DISPATCH_EXTENSION_FUNCTIONS(XR_FUNCTION) \
+    XR_FUNCTION(LocateSpacesKHR, xrLocateSpacesKHR)
+#else
+#define XR_DISPATCH_EXTENSION_FUNCTIONS(XR_FUNCTION)
+#endif
+
+/**
+ * Entry points of the frame path, resolved once per instance with xrGetInstanceProcAddr.
+ * Calling them skips the trampolines the loader exports, which look up the dispatch table of
+ * the handle on every call.
+ *
+ * Built with XR_DISPATCH_PROBES, every entry is wrapped by a probe recording its calls in a
+ * ksCallProfiler: counts, time and latency histograms, in total and per frame. Without it the
+ * table holds the entry points themselves, so profiling costs nothing. The probes only see the
+ * entry points, so they work with any runtime, including a stand-in passed to load.
+ */
+struct XrDispatch {
+
+#define XR_DISPATCH_MEMBER(member, command) PFN_##command member;
+    XR_DISPATCH_CORE_FUNCTIONS(XR_DISPATCH_MEMBER)
+    XR_DISPATCH_EXTENSION_FUNCTIONS(XR_DISPATCH_MEMBER)
+#undef XR_DISPATCH_MEMBER
+
+    XrDispatch();
+
+    XrDispatch(const XrDispatch&) = delete;
+    XrDispatch& operator=(const XrDispatch&) = delete;
+
+    /// Call again whenever the instance is created again. Throws if a core command is missing
+    void load(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr = xrGetInstanceProcAddr);
+
+    /// Closes the frame of the per frame statistics. Call after xrEndFrame
+    void endFrame();
+
+    /// Statistics of the probed entries, function i being the i-th command of the lists above.
+    /// nullptr without probes
+    const ksCallProfiler* profiler() const;
+
+    /// Statistics of every probed entry that was called. Nothing without probes
+    void reportProbes() const;
+
+    /**
+     * Average time of xrGetActionStateBoolean called through the loader, directly, and through
+     * this table (probed, if built with probes). The action set of the action must be attached.
+     */
+    void measureCallOverhead(XrSession session, const XrActionStateGetInfo& getInfo, uint32_t iterations) const;
+
+private:
+
+    XrInstance _instance;
+    PFN_xrGetInstanceProcAddr _getInstanceProcAddr;
+
+};
@@ -0,0 +1,73 @@
+#include "events.h"
+
+#include <iostream>
+
+
+/**
+ *  Constructor
+ */
+EventDispatcher::EventDispatcher(const XrDispatch& xr, XrInstance instance, uint32_t capacity) :
+    _xr(xr),
+    _instance(instance),
+    _events(capacity),
+    _count(0),
+    _dropped(0)
+{
+}
+
+/**
+ */
+void EventDispatcher::subscribe(XrStructureType type, Handler handler)
+{
+    _routes[type].handlers.push_back(std::move(handler));
+}
+
+/**
+ */
+void EventDispatcher::forward(XrStructureType type, ksSpscQueue* queue)
+{
+    _routes[type].queues.push_back(queue);
+}
+
+/**
+ */
+XrResult EventDispatcher::drain()
+{
+    while (_count < (uint32_t)_events.size()) {
+        XrEventDataBuffer& event = _events[_count];
+        event.type = XR_TYPE_EVENT_DATA_BUFFER;
+        event.next = nullptr;
+        const XrResult res = _xr.PollEvent(_instance, &event);
+        if (res != XR_SUCCESS) {
+            return XR_FAILED(res) ? res : XR_SUCCESS;
+        }
+        _count++;
+    }
+    return XR_SUCCESS;
+}
+
+/**
+ */
+uint32_t EventDispatcher::dispatch()
+{
+    const uint32_t count = _count;
+    for (uint32_t i = 0; i < count; i++) {
+        const XrEventDataBuffer& event = _events[i];
+        const auto route = _routes.find(event.type);
+        if (route == _routes.end()) {
+            std::cout << "Unhandled event type " << event.type << std::endl;
+            continue;
+        }
+        for (ksSpscQueue* queue : route->second.queues) {
+            if (!ksSpscQueue_Push(queue, &event)) {
+                _dropped++;
+                std::cerr << "ERROR: event queue full, event type " << event.type << " dropped" << std::endl;
+            }
+        }
+        for (const Handler& handler : route->second.handlers) {
+            handler(event);
+        }
+    }
+    _count = 0;
+    return count;
+}
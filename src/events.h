@@ -0,0 +1,61 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/threading.h"
+#include "dispatch.h"
+
+/**
+ * Drains the OpenXR event queue and routes every event by its structure type.
+ *
+ * drain polls the pending events into a buffer of fixed capacity, so a burst of events is handled
+ * before the next frame instead of one per loop iteration; what does not fit stays queued in the
+ * runtime for the next drain. dispatch then calls the handlers subscribed to the type of each
+ * event, in the order the events came, on the calling thread.
+ *
+ * Events can also be forwarded to a queue, for a consumer on another thread. The queue receives
+ * the first elementSize bytes of the event, so it can be sized for the event structures it takes.
+ * A full queue drops the event, which is counted.
+ */
+class EventDispatcher {
+
+public:
+
+    typedef std::function<void(const XrEventDataBuffer&)> Handler;
+
+    EventDispatcher(const XrDispatch& xr, XrInstance instance, uint32_t capacity = 16);
+
+    EventDispatcher(const EventDispatcher&) = delete;
+    EventDispatcher& operator=(const EventDispatcher&) = delete;
+
+    /// Handlers of the same type are called in the order they subscribed
+    void subscribe(XrStructureType type, Handler handler);
+    /// The queue must outlive the dispatcher, and only the dispatching thread may push to it
+    void forward(XrStructureType type, ksSpscQueue* queue);
+
+    /// Polls until the runtime has no event left or the buffer is full. Returns the failure of xrPollEvent, if any
+    XrResult drain();
+    /// Routes the drained events and empties the buffer. Returns the number of events
+    uint32_t dispatch();
+
+    inline uint64_t droppedCount() const { return _dropped; }
+
+private:
+
+    struct Route {
+        std::vector<Handler> handlers;
+        std::vector<ksSpscQueue*> queues;
+    };
+
+    const XrDispatch& _xr;
+    XrInstance _instance;
+    std::unordered_map<XrStructureType, Route> _routes;
+    std::vector<XrEventDataBuffer> _events;     // allocated once, _count of them drained
+    uint32_t _count;
+    uint64_t _dropped;
+
+};
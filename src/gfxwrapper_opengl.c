@@ -6,6 +6,9 @@ SPDX-License-Identifier: Apache-2.0
 */
 
 #include "gfxwrapper_opengl.h"
+#include "gfxwrapper_opengl_functions.h"
+
+#include <utils/stringset.h>
 
 /*
 ================================================================================================================================
@@ -425,149 +428,60 @@ GLint glGetInteger(GLenum pname) {
     return i;
 }
 
-static bool GlCheckExtension(const char *extension) {
-#if defined(OS_WINDOWS) || defined(OS_LINUX)
-    PFNGLGETSTRINGIPROC glGetStringi = (PFNGLGETSTRINGIPROC)GetExtension("glGetStringi");
-#endif
+static ksStringSet glExtensionNames;
+
+// Reads the extension strings of the current context once, so checking for an extension does not query the driver.
+static void GlLoadExtensionNames() {
     GL(const GLint numExtensions = glGetInteger(GL_NUM_EXTENSIONS));
+    ksStringSet_Destroy(&glExtensionNames);
+    ksStringSet_Create(&glExtensionNames, numExtensions);
     for (int i = 0; i < numExtensions; i++) {
         GL(const GLubyte *string = glGetStringi(GL_EXTENSIONS, i));
-        if (strcmp((const char *)string, extension) == 0) {
-            return true;
-        }
+        ksStringSet_Add(&glExtensionNames, (const char *)string);
     }
-    return false;
 }
 
+static bool GlCheckExtension(const char *extension) { return ksStringSet_Contains(&glExtensionNames, extension); }
+
 #if defined(OS_WINDOWS) || defined(OS_LINUX)
 
-PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers;
-PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers;
-PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer;
-PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer;
-PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers;
-PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers;
-PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer;
-PFNGLISRENDERBUFFERPROC glIsRenderbuffer;
-PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage;
-PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC glRenderbufferStorageMultisample;
-PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC glRenderbufferStorageMultisampleEXT;
-PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer;
-PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D;
-PFNGLFRAMEBUFFERTEXTURELAYERPROC glFramebufferTextureLayer;
-PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
-PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC glFramebufferTextureMultiviewOVR;
-PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC glFramebufferTextureMultisampleMultiviewOVR;
-PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus;
-PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC glCheckNamedFramebufferStatus;
-
-PFNGLGENBUFFERSPROC glGenBuffers;
-PFNGLDELETEBUFFERSPROC glDeleteBuffers;
-PFNGLBINDBUFFERPROC glBindBuffer;
-PFNGLBINDBUFFERBASEPROC glBindBufferBase;
-PFNGLBUFFERDATAPROC glBufferData;
-PFNGLBUFFERSUBDATAPROC glBufferSubData;
-PFNGLBUFFERSTORAGEPROC glBufferStorage;
-PFNGLMAPBUFFERPROC glMapBuffer;
-PFNGLMAPBUFFERRANGEPROC glMapBufferRange;
-PFNGLUNMAPBUFFERPROC glUnmapBuffer;
-
-PFNGLGENVERTEXARRAYSPROC glGenVertexArrays;
-PFNGLDELETEVERTEXARRAYSPROC glDeleteVertexArrays;
-PFNGLBINDVERTEXARRAYPROC glBindVertexArray;
-PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
-PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
-PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
-PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
+/*
+The entry points in gfxwrapper_opengl_functions.h are resolved on first use. Each function pointer starts out
+at a thunk with the same signature, which resolves the entry point, stores it in the pointer and forwards the
+call, so only the functions that are actually called are ever looked up. GlInitExtensions points them back at
+the thunks, because a new context may come with different entry points. A missing entry point aborts instead
+of calling through the NULL pointer.
+*/
 
+#define GL_DEFINE_VOID_FUNCTION(type, name, params, args)                        \
+    type name;                                                                   \
+    static void APIENTRY name##_Thunk params {                                   \
+        name = (type)GetExtension(#name);                                        \
+        if (name == NULL) {                                                      \
+            Error("OpenGL entry point " #name " is not available");              \
+            abort();                                                             \
+        }                                                                        \
+        name args;                                                               \
+    }
+#define GL_DEFINE_FUNCTION(type, ret, name, params, args)                        \
+    type name;                                                                   \
+    static ret APIENTRY name##_Thunk params {                                    \
+        name = (type)GetExtension(#name);                                        \
+        if (name == NULL) {                                                      \
+            Error("OpenGL entry point " #name " is not available");              \
+            abort();                                                             \
+        }                                                                        \
+        return name args;                                                        \
+    }
+#define GL_RESET_VOID_FUNCTION(type, name, params, args) name = name##_Thunk;
+#define GL_RESET_FUNCTION(type, ret, name, params, args) name = name##_Thunk;
+
+GL_LAZY_FUNCTIONS(GL_DEFINE_VOID_FUNCTION, GL_DEFINE_FUNCTION)
 #if defined(OS_WINDOWS)
-PFNGLACTIVETEXTUREPROC glActiveTexture;
-PFNGLTEXIMAGE3DPROC glTexImage3D;
-PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
-PFNGLCOMPRESSEDTEXIMAGE3DPROC glCompressedTexImage3D;
-PFNGLTEXSUBIMAGE3DPROC glTexSubImage3D;
-PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC glCompressedTexSubImage2D;
-PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC glCompressedTexSubImage3D;
+GL_LAZY_WINDOWS_FUNCTIONS(GL_DEFINE_VOID_FUNCTION, GL_DEFINE_FUNCTION)
 #endif
-PFNGLTEXSTORAGE2DPROC glTexStorage2D;
-PFNGLTEXSTORAGE3DPROC glTexStorage3D;
-PFNGLTEXIMAGE2DMULTISAMPLEPROC glTexImage2DMultisample;
-PFNGLTEXIMAGE3DMULTISAMPLEPROC glTexImage3DMultisample;
-PFNGLTEXSTORAGE2DMULTISAMPLEPROC glTexStorage2DMultisample;
-PFNGLTEXSTORAGE3DMULTISAMPLEPROC glTexStorage3DMultisample;
-PFNGLGENERATEMIPMAPPROC glGenerateMipmap;
-PFNGLBINDIMAGETEXTUREPROC glBindImageTexture;
-
-PFNGLCREATEPROGRAMPROC glCreateProgram;
-PFNGLDELETEPROGRAMPROC glDeleteProgram;
-PFNGLCREATESHADERPROC glCreateShader;
-PFNGLDELETESHADERPROC glDeleteShader;
-PFNGLSHADERSOURCEPROC glShaderSource;
-PFNGLCOMPILESHADERPROC glCompileShader;
-PFNGLGETSHADERIVPROC glGetShaderiv;
-PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
-PFNGLUSEPROGRAMPROC glUseProgram;
-PFNGLATTACHSHADERPROC glAttachShader;
-PFNGLLINKPROGRAMPROC glLinkProgram;
-PFNGLGETPROGRAMIVPROC glGetProgramiv;
-PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog;
-PFNGLGETATTRIBLOCATIONPROC glGetAttribLocation;
-PFNGLBINDATTRIBLOCATIONPROC glBindAttribLocation;
-PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
-PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
-PFNGLGETPROGRAMRESOURCEINDEXPROC glGetProgramResourceIndex;
-PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
-PFNGLSHADERSTORAGEBLOCKBINDINGPROC glShaderStorageBlockBinding;
-PFNGLPROGRAMUNIFORM1IPROC glProgramUniform1i;
-PFNGLUNIFORM1IPROC glUniform1i;
-PFNGLUNIFORM1IVPROC glUniform1iv;
-PFNGLUNIFORM2IVPROC glUniform2iv;
-PFNGLUNIFORM3IVPROC glUniform3iv;
-PFNGLUNIFORM4IVPROC glUniform4iv;
-PFNGLUNIFORM1FPROC glUniform1f;
-PFNGLUNIFORM1FVPROC glUniform1fv;
-PFNGLUNIFORM2FVPROC glUniform2fv;
-PFNGLUNIFORM3FVPROC glUniform3fv;
-PFNGLUNIFORM4FVPROC glUniform4fv;
-PFNGLUNIFORMMATRIX2FVPROC glUniformMatrix2fv;
-PFNGLUNIFORMMATRIX2X3FVPROC glUniformMatrix2x3fv;
-PFNGLUNIFORMMATRIX2X4FVPROC glUniformMatrix2x4fv;
-PFNGLUNIFORMMATRIX3X2FVPROC glUniformMatrix3x2fv;
-PFNGLUNIFORMMATRIX3FVPROC glUniformMatrix3fv;
-PFNGLUNIFORMMATRIX3X4FVPROC glUniformMatrix3x4fv;
-PFNGLUNIFORMMATRIX4X2FVPROC glUniformMatrix4x2fv;
-PFNGLUNIFORMMATRIX4X3FVPROC glUniformMatrix4x3fv;
-PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
-
-PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
-PFNGLDISPATCHCOMPUTEPROC glDispatchCompute;
-PFNGLMEMORYBARRIERPROC glMemoryBarrier;
-
-PFNGLGENQUERIESPROC glGenQueries;
-PFNGLDELETEQUERIESPROC glDeleteQueries;
-PFNGLISQUERYPROC glIsQuery;
-PFNGLBEGINQUERYPROC glBeginQuery;
-PFNGLENDQUERYPROC glEndQuery;
-PFNGLQUERYCOUNTERPROC glQueryCounter;
-PFNGLGETQUERYIVPROC glGetQueryiv;
-PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv;
-PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuiv;
-PFNGLGETQUERYOBJECTI64VPROC glGetQueryObjecti64v;
-PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v;
-
-PFNGLFENCESYNCPROC glFenceSync;
-PFNGLCLIENTWAITSYNCPROC glClientWaitSync;
-PFNGLDELETESYNCPROC glDeleteSync;
-PFNGLISSYNCPROC glIsSync;
-
-PFNGLBLENDFUNCSEPARATEPROC glBlendFuncSeparate;
-PFNGLBLENDEQUATIONSEPARATEPROC glBlendEquationSeparate;
-
-PFNGLDEBUGMESSAGECONTROLPROC glDebugMessageControl;
-PFNGLDEBUGMESSAGECALLBACKPROC glDebugMessageCallback;
 
 #if defined(OS_WINDOWS)
-PFNGLBLENDCOLORPROC glBlendColor;
 PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB;
 PFNWGLCREATECONTEXTATTRIBSARBPROC wglCreateContextAttribsARB;
 PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT;
@@ -592,137 +506,12 @@ void GlBootstrapExtensions() {
 }
 
 void GlInitExtensions() {
-    glGenFramebuffers = (PFNGLGENFRAMEBUFFERSPROC)GetExtension("glGenFramebuffers");
-    glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSPROC)GetExtension("glDeleteFramebuffers");
-    glBindFramebuffer = (PFNGLBINDFRAMEBUFFERPROC)GetExtension("glBindFramebuffer");
-    glBlitFramebuffer = (PFNGLBLITFRAMEBUFFERPROC)GetExtension("glBlitFramebuffer");
-    glGenRenderbuffers = (PFNGLGENRENDERBUFFERSPROC)GetExtension("glGenRenderbuffers");
-    glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC)GetExtension("glDeleteRenderbuffers");
-    glBindRenderbuffer = (PFNGLBINDRENDERBUFFERPROC)GetExtension("glBindRenderbuffer");
-    glIsRenderbuffer = (PFNGLISRENDERBUFFERPROC)GetExtension("glIsRenderbuffer");
-    glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEPROC)GetExtension("glRenderbufferStorage");
-    glRenderbufferStorageMultisample = (PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC)GetExtension("glRenderbufferStorageMultisample");
-    glRenderbufferStorageMultisampleEXT =
-        (PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC)GetExtension("glRenderbufferStorageMultisampleEXT");
-    glFramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFERPROC)GetExtension("glFramebufferRenderbuffer");
-    glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DPROC)GetExtension("glFramebufferTexture2D");
-    glFramebufferTextureLayer = (PFNGLFRAMEBUFFERTEXTURELAYERPROC)GetExtension("glFramebufferTextureLayer");
-    glFramebufferTexture2DMultisampleEXT =
-        (PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC)GetExtension("glFramebufferTexture2DMultisampleEXT");
-    glFramebufferTextureMultiviewOVR = (PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC)GetExtension("glFramebufferTextureMultiviewOVR");
-    glFramebufferTextureMultisampleMultiviewOVR =
-        (PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC)GetExtension("glFramebufferTextureMultisampleMultiviewOVR");
-    glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSPROC)GetExtension("glCheckFramebufferStatus");
-    glCheckNamedFramebufferStatus = (PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC)GetExtension("glCheckNamedFramebufferStatus");
-
-    glGenBuffers = (PFNGLGENBUFFERSPROC)GetExtension("glGenBuffers");
-    glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)GetExtension("glDeleteBuffers");
-    glBindBuffer = (PFNGLBINDBUFFERPROC)GetExtension("glBindBuffer");
-    glBindBufferBase = (PFNGLBINDBUFFERBASEPROC)GetExtension("glBindBufferBase");
-    glBufferData = (PFNGLBUFFERDATAPROC)GetExtension("glBufferData");
-    glBufferSubData = (PFNGLBUFFERSUBDATAPROC)GetExtension("glBufferSubData");
-    glBufferStorage = (PFNGLBUFFERSTORAGEPROC)GetExtension("glBufferStorage");
-    glMapBuffer = (PFNGLMAPBUFFERPROC)GetExtension("glMapBuffer");
-    glMapBufferRange = (PFNGLMAPBUFFERRANGEPROC)GetExtension("glMapBufferRange");
-    glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)GetExtension("glUnmapBuffer");
-
-    glGenVertexArrays = (PFNGLGENVERTEXARRAYSPROC)GetExtension("glGenVertexArrays");
-    glDeleteVertexArrays = (PFNGLDELETEVERTEXARRAYSPROC)GetExtension("glDeleteVertexArrays");
-    glBindVertexArray = (PFNGLBINDVERTEXARRAYPROC)GetExtension("glBindVertexArray");
-    glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)GetExtension("glVertexAttribPointer");
-    glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)GetExtension("glVertexAttribDivisor");
-    glDisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC)GetExtension("glDisableVertexAttribArray");
-    glEnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC)GetExtension("glEnableVertexAttribArray");
-
+    GL_LAZY_FUNCTIONS(GL_RESET_VOID_FUNCTION, GL_RESET_FUNCTION)
 #if defined(OS_WINDOWS)
-    glActiveTexture = (PFNGLACTIVETEXTUREPROC)GetExtension("glActiveTexture");
-    glTexImage3D = (PFNGLTEXIMAGE3DPROC)GetExtension("glTexImage3D");
-    glCompressedTexImage2D = (PFNGLCOMPRESSEDTEXIMAGE2DPROC)GetExtension("glCompressedTexImage2D ");
-    glCompressedTexImage3D = (PFNGLCOMPRESSEDTEXIMAGE3DPROC)GetExtension("glCompressedTexImage3D ");
-    glTexSubImage3D = (PFNGLTEXSUBIMAGE3DPROC)GetExtension("glTexSubImage3D");
-    glCompressedTexSubImage2D = (PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC)GetExtension("glCompressedTexSubImage2D");
-    glCompressedTexSubImage3D = (PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC)GetExtension("glCompressedTexSubImage3D");
+    GL_LAZY_WINDOWS_FUNCTIONS(GL_RESET_VOID_FUNCTION, GL_RESET_FUNCTION)
 #endif
-    glTexStorage2D = (PFNGLTEXSTORAGE2DPROC)GetExtension("glTexStorage2D");
-    glTexStorage3D = (PFNGLTEXSTORAGE3DPROC)GetExtension("glTexStorage3D");
-    glTexImage2DMultisample = (PFNGLTEXIMAGE2DMULTISAMPLEPROC)GetExtension("glTexImage2DMultisample");
-    glTexImage3DMultisample = (PFNGLTEXIMAGE3DMULTISAMPLEPROC)GetExtension("glTexImage3DMultisample");
-    glTexStorage2DMultisample = (PFNGLTEXSTORAGE2DMULTISAMPLEPROC)GetExtension("glTexStorage2DMultisample");
-    glTexStorage3DMultisample = (PFNGLTEXSTORAGE3DMULTISAMPLEPROC)GetExtension("glTexStorage3DMultisample");
-    glGenerateMipmap = (PFNGLGENERATEMIPMAPPROC)GetExtension("glGenerateMipmap");
-    glBindImageTexture = (PFNGLBINDIMAGETEXTUREPROC)GetExtension("glBindImageTexture");
-
-    glCreateProgram = (PFNGLCREATEPROGRAMPROC)GetExtension("glCreateProgram");
-    glDeleteProgram = (PFNGLDELETEPROGRAMPROC)GetExtension("glDeleteProgram");
-    glCreateShader = (PFNGLCREATESHADERPROC)GetExtension("glCreateShader");
-    glDeleteShader = (PFNGLDELETESHADERPROC)GetExtension("glDeleteShader");
-    glShaderSource = (PFNGLSHADERSOURCEPROC)GetExtension("glShaderSource");
-    glCompileShader = (PFNGLCOMPILESHADERPROC)GetExtension("glCompileShader");
-    glGetShaderiv = (PFNGLGETSHADERIVPROC)GetExtension("glGetShaderiv");
-    glGetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC)GetExtension("glGetShaderInfoLog");
-    glUseProgram = (PFNGLUSEPROGRAMPROC)GetExtension("glUseProgram");
-    glAttachShader = (PFNGLATTACHSHADERPROC)GetExtension("glAttachShader");
-    glLinkProgram = (PFNGLLINKPROGRAMPROC)GetExtension("glLinkProgram");
-    glGetProgramiv = (PFNGLGETPROGRAMIVPROC)GetExtension("glGetProgramiv");
-    glGetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC)GetExtension("glGetProgramInfoLog");
-    glGetAttribLocation = (PFNGLGETATTRIBLOCATIONPROC)GetExtension("glGetAttribLocation");
-    glBindAttribLocation = (PFNGLBINDATTRIBLOCATIONPROC)GetExtension("glBindAttribLocation");
-    glGetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC)GetExtension("glGetUniformLocation");
-    glGetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC)GetExtension("glGetUniformBlockIndex");
-    glProgramUniform1i = (PFNGLPROGRAMUNIFORM1IPROC)GetExtension("glProgramUniform1i");
-    glUniform1i = (PFNGLUNIFORM1IPROC)GetExtension("glUniform1i");
-    glUniform1iv = (PFNGLUNIFORM1IVPROC)GetExtension("glUniform1iv");
-    glUniform2iv = (PFNGLUNIFORM2IVPROC)GetExtension("glUniform2iv");
-    glUniform3iv = (PFNGLUNIFORM3IVPROC)GetExtension("glUniform3iv");
-    glUniform4iv = (PFNGLUNIFORM4IVPROC)GetExtension("glUniform4iv");
-    glUniform1f = (PFNGLUNIFORM1FPROC)GetExtension("glUniform1f");
-    glUniform1fv = (PFNGLUNIFORM1FVPROC)GetExtension("glUniform1fv");
-    glUniform2fv = (PFNGLUNIFORM2FVPROC)GetExtension("glUniform2fv");
-    glUniform3fv = (PFNGLUNIFORM3FVPROC)GetExtension("glUniform3fv");
-    glUniform4fv = (PFNGLUNIFORM4FVPROC)GetExtension("glUniform4fv");
-    glUniformMatrix2fv = (PFNGLUNIFORMMATRIX2FVPROC)GetExtension("glUniformMatrix3fv");
-    glUniformMatrix2x3fv = (PFNGLUNIFORMMATRIX2X3FVPROC)GetExtension("glUniformMatrix2x3fv");
-    glUniformMatrix2x4fv = (PFNGLUNIFORMMATRIX2X4FVPROC)GetExtension("glUniformMatrix2x4fv");
-    glUniformMatrix3x2fv = (PFNGLUNIFORMMATRIX3X2FVPROC)GetExtension("glUniformMatrix3x2fv");
-    glUniformMatrix3fv = (PFNGLUNIFORMMATRIX3FVPROC)GetExtension("glUniformMatrix3fv");
-    glUniformMatrix3x4fv = (PFNGLUNIFORMMATRIX3X4FVPROC)GetExtension("glUniformMatrix3x4fv");
-    glUniformMatrix4x2fv = (PFNGLUNIFORMMATRIX4X2FVPROC)GetExtension("glUniformMatrix4x2fv");
-    glUniformMatrix4x3fv = (PFNGLUNIFORMMATRIX4X3FVPROC)GetExtension("glUniformMatrix4x3fv");
-    glUniformMatrix4fv = (PFNGLUNIFORMMATRIX4FVPROC)GetExtension("glUniformMatrix4fv");
-    glGetProgramResourceIndex = (PFNGLGETPROGRAMRESOURCEINDEXPROC)GetExtension("glGetProgramResourceIndex");
-    glUniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC)GetExtension("glUniformBlockBinding");
-    glShaderStorageBlockBinding = (PFNGLSHADERSTORAGEBLOCKBINDINGPROC)GetExtension("glShaderStorageBlockBinding");
-
-    glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC)GetExtension("glDrawElementsInstanced");
-    glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)GetExtension("glDispatchCompute");
-    glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)GetExtension("glMemoryBarrier");
-
-    glGenQueries = (PFNGLGENQUERIESPROC)GetExtension("glGenQueries");
-    glDeleteQueries = (PFNGLDELETEQUERIESPROC)GetExtension("glDeleteQueries");
-    glIsQuery = (PFNGLISQUERYPROC)GetExtension("glIsQuery");
-    glBeginQuery = (PFNGLBEGINQUERYPROC)GetExtension("glBeginQuery");
-    glEndQuery = (PFNGLENDQUERYPROC)GetExtension("glEndQuery");
-    glQueryCounter = (PFNGLQUERYCOUNTERPROC)GetExtension("glQueryCounter");
-    glGetQueryiv = (PFNGLGETQUERYIVPROC)GetExtension("glGetQueryiv");
-    glGetQueryObjectiv = (PFNGLGETQUERYOBJECTIVPROC)GetExtension("glGetQueryObjectiv");
-    glGetQueryObjectuiv = (PFNGLGETQUERYOBJECTUIVPROC)GetExtension("glGetQueryObjectuiv");
-    glGetQueryObjecti64v = (PFNGLGETQUERYOBJECTI64VPROC)GetExtension("glGetQueryObjecti64v");
-    glGetQueryObjectui64v = (PFNGLGETQUERYOBJECTUI64VPROC)GetExtension("glGetQueryObjectui64v");
-
-    glFenceSync = (PFNGLFENCESYNCPROC)GetExtension("glFenceSync");
-    glClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)GetExtension("glClientWaitSync");
-    glDeleteSync = (PFNGLDELETESYNCPROC)GetExtension("glDeleteSync");
-    glIsSync = (PFNGLISSYNCPROC)GetExtension("glIsSync");
-
-    glBlendFuncSeparate = (PFNGLBLENDFUNCSEPARATEPROC)GetExtension("glBlendFuncSeparate");
-    glBlendEquationSeparate = (PFNGLBLENDEQUATIONSEPARATEPROC)GetExtension("glBlendEquationSeparate");
 
-#if defined(OS_WINDOWS)
-    glBlendColor = (PFNGLBLENDCOLORPROC)GetExtension("glBlendColor");
-#endif
-
-    glDebugMessageControl = (PFNGLDEBUGMESSAGECONTROLPROC)GetExtension("glDebugMessageControl");
-    glDebugMessageCallback = (PFNGLDEBUGMESSAGECALLBACKPROC)GetExtension("glDebugMessageCallback");
+    GlLoadExtensionNames();
 
     glExtensions.timer_query = GlCheckExtension("GL_EXT_timer_query");
     glExtensions.texture_clamp_to_border = true;  // always available
@@ -745,6 +534,8 @@ PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT
 PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC glRenderbufferStorageMultisampleEXT;
 
 void GlInitExtensions() {
+    GlLoadExtensionNames();
+
     glExtensions.timer_query = GlCheckExtension("GL_EXT_timer_query");
     glExtensions.texture_clamp_to_border = true;  // always available
     glExtensions.buffer_storage =
@@ -872,6 +663,8 @@ void GlInitExtensions() {
     glTexStorage3DMultisample = (PFNGLTEXSTORAGE3DMULTISAMPLEPROC)GetExtension("glTexStorage3DMultisample");
 #endif
 
+    GlLoadExtensionNames();
+
     glExtensions.timer_query = GlCheckExtension("GL_EXT_disjoint_timer_query");
     glExtensions.texture_clamp_to_border =
         GlCheckExtension("GL_EXT_texture_border_clamp") || GlCheckExtension("GL_OES_texture_border_clamp");
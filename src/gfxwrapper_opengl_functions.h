@@ -0,0 +1,143 @@
+/*
+Copyright (c) 2016 Oculus VR, LLC.
+
+SPDX-License-Identifier: Apache-2.0
+*/
+
+/*
+================================================================================================================================
+
+OpenGL entry points that are resolved at run time on Windows and Linux.
+
+Every entry is (pointer type, [return type,] name, parameters, arguments) so the list can be expanded into
+the function pointers, the thunks that resolve them on first use and the resets that point them back at the
+thunks. It only names types, so it can also be expanded without any OpenGL headers, for instance into a
+table of the function names.
+
+================================================================================================================================
+*/
+
+#if !defined(KSGRAPHICSWRAPPER_OPENGL_FUNCTIONS_H)
+#define KSGRAPHICSWRAPPER_OPENGL_FUNCTIONS_H
+
+#define GL_LAZY_FUNCTIONS(GL_VOID_FUNCTION, GL_FUNCTION) \
+    GL_FUNCTION(PFNGLGETSTRINGIPROC, const GLubyte *, glGetStringi, (GLenum name, GLuint index), (name, index)) \
+    GL_VOID_FUNCTION(PFNGLGENFRAMEBUFFERSPROC, glGenFramebuffers, (GLsizei n, GLuint *framebuffers), (n, framebuffers)) \
+    GL_VOID_FUNCTION(PFNGLDELETEFRAMEBUFFERSPROC, glDeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers)) \
+    GL_VOID_FUNCTION(PFNGLBINDFRAMEBUFFERPROC, glBindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+    GL_VOID_FUNCTION(PFNGLBLITFRAMEBUFFERPROC, glBlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter)) \
+    GL_VOID_FUNCTION(PFNGLGENRENDERBUFFERSPROC, glGenRenderbuffers, (GLsizei n, GLuint *renderbuffers), (n, renderbuffers)) \
+    GL_VOID_FUNCTION(PFNGLDELETERENDERBUFFERSPROC, glDeleteRenderbuffers, (GLsizei n, const GLuint *renderbuffers), (n, renderbuffers)) \
+    GL_VOID_FUNCTION(PFNGLBINDRENDERBUFFERPROC, glBindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+    GL_FUNCTION(PFNGLISRENDERBUFFERPROC, GLboolean, glIsRenderbuffer, (GLuint renderbuffer), (renderbuffer)) \
+    GL_VOID_FUNCTION(PFNGLRENDERBUFFERSTORAGEPROC, glRenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height)) \
+    GL_VOID_FUNCTION(PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC, glRenderbufferStorageMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), (target, samples, internalformat, width, height)) \
+    GL_VOID_FUNCTION(PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC, glRenderbufferStorageMultisampleEXT, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), (target, samples, internalformat, width, height)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERTEXTURE2DPROC, glFramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERTEXTURELAYERPROC, glFramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer), (target, attachment, texture, level, layer)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC, glFramebufferTexture2DMultisampleEXT, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLsizei samples), (target, attachment, textarget, texture, level, samples)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERTEXTUREMULTIVIEWOVRPROC, glFramebufferTextureMultiviewOVR, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint baseViewIndex, GLsizei numViews), (target, attachment, texture, level, baseViewIndex, numViews)) \
+    GL_VOID_FUNCTION(PFNGLFRAMEBUFFERTEXTUREMULTISAMPLEMULTIVIEWOVRPROC, glFramebufferTextureMultisampleMultiviewOVR, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLsizei samples, GLint baseViewIndex, GLsizei numViews), (target, attachment, texture, level, samples, baseViewIndex, numViews)) \
+    GL_FUNCTION(PFNGLCHECKFRAMEBUFFERSTATUSPROC, GLenum, glCheckFramebufferStatus, (GLenum target), (target)) \
+    GL_FUNCTION(PFNGLCHECKNAMEDFRAMEBUFFERSTATUSPROC, GLenum, glCheckNamedFramebufferStatus, (GLuint framebuffer, GLenum target), (framebuffer, target)) \
+    GL_VOID_FUNCTION(PFNGLGENBUFFERSPROC, glGenBuffers, (GLsizei n, GLuint *buffers), (n, buffers)) \
+    GL_VOID_FUNCTION(PFNGLDELETEBUFFERSPROC, glDeleteBuffers, (GLsizei n, const GLuint *buffers), (n, buffers)) \
+    GL_VOID_FUNCTION(PFNGLBINDBUFFERPROC, glBindBuffer, (GLenum target, GLuint buffer), (target, buffer)) \
+    GL_VOID_FUNCTION(PFNGLBINDBUFFERBASEPROC, glBindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+    GL_VOID_FUNCTION(PFNGLBUFFERDATAPROC, glBufferData, (GLenum target, GLsizeiptr size, const void *data, GLenum usage), (target, size, data, usage)) \
+    GL_VOID_FUNCTION(PFNGLBUFFERSUBDATAPROC, glBufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data)) \
+    GL_VOID_FUNCTION(PFNGLBUFFERSTORAGEPROC, glBufferStorage, (GLenum target, GLsizeiptr size, const void *data, GLbitfield flags), (target, size, data, flags)) \
+    GL_FUNCTION(PFNGLMAPBUFFERPROC, void *, glMapBuffer, (GLenum target, GLenum access), (target, access)) \
+    GL_FUNCTION(PFNGLMAPBUFFERRANGEPROC, void *, glMapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access)) \
+    GL_FUNCTION(PFNGLUNMAPBUFFERPROC, GLboolean, glUnmapBuffer, (GLenum target), (target)) \
+    GL_VOID_FUNCTION(PFNGLGENVERTEXARRAYSPROC, glGenVertexArrays, (GLsizei n, GLuint *arrays), (n, arrays)) \
+    GL_VOID_FUNCTION(PFNGLDELETEVERTEXARRAYSPROC, glDeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays)) \
+    GL_VOID_FUNCTION(PFNGLBINDVERTEXARRAYPROC, glBindVertexArray, (GLuint array), (array)) \
+    GL_VOID_FUNCTION(PFNGLVERTEXATTRIBPOINTERPROC, glVertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer)) \
+    GL_VOID_FUNCTION(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+    GL_VOID_FUNCTION(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray, (GLuint index), (index)) \
+    GL_VOID_FUNCTION(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray, (GLuint index), (index)) \
+    GL_VOID_FUNCTION(PFNGLTEXSTORAGE2DPROC, glTexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+    GL_VOID_FUNCTION(PFNGLTEXSTORAGE3DPROC, glTexStorage3D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth), (target, levels, internalformat, width, height, depth)) \
+    GL_VOID_FUNCTION(PFNGLTEXIMAGE2DMULTISAMPLEPROC, glTexImage2DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, fixedsamplelocations)) \
+    GL_VOID_FUNCTION(PFNGLTEXIMAGE3DMULTISAMPLEPROC, glTexImage3DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, depth, fixedsamplelocations)) \
+    GL_VOID_FUNCTION(PFNGLTEXSTORAGE2DMULTISAMPLEPROC, glTexStorage2DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, fixedsamplelocations)) \
+    GL_VOID_FUNCTION(PFNGLTEXSTORAGE3DMULTISAMPLEPROC, glTexStorage3DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, depth, fixedsamplelocations)) \
+    GL_VOID_FUNCTION(PFNGLGENERATEMIPMAPPROC, glGenerateMipmap, (GLenum target), (target)) \
+    GL_VOID_FUNCTION(PFNGLBINDIMAGETEXTUREPROC, glBindImageTexture, (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format), (unit, texture, level, layered, layer, access, format)) \
+    GL_FUNCTION(PFNGLCREATEPROGRAMPROC, GLuint, glCreateProgram, (void), ()) \
+    GL_VOID_FUNCTION(PFNGLDELETEPROGRAMPROC, glDeleteProgram, (GLuint program), (program)) \
+    GL_FUNCTION(PFNGLCREATESHADERPROC, GLuint, glCreateShader, (GLenum type), (type)) \
+    GL_VOID_FUNCTION(PFNGLDELETESHADERPROC, glDeleteShader, (GLuint shader), (shader)) \
+    GL_VOID_FUNCTION(PFNGLSHADERSOURCEPROC, glShaderSource, (GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length), (shader, count, string, length)) \
+    GL_VOID_FUNCTION(PFNGLCOMPILESHADERPROC, glCompileShader, (GLuint shader), (shader)) \
+    GL_VOID_FUNCTION(PFNGLGETSHADERIVPROC, glGetShaderiv, (GLuint shader, GLenum pname, GLint *params), (shader, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETSHADERINFOLOGPROC, glGetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (shader, bufSize, length, infoLog)) \
+    GL_VOID_FUNCTION(PFNGLUSEPROGRAMPROC, glUseProgram, (GLuint program), (program)) \
+    GL_VOID_FUNCTION(PFNGLATTACHSHADERPROC, glAttachShader, (GLuint program, GLuint shader), (program, shader)) \
+    GL_VOID_FUNCTION(PFNGLLINKPROGRAMPROC, glLinkProgram, (GLuint program), (program)) \
+    GL_VOID_FUNCTION(PFNGLGETPROGRAMIVPROC, glGetProgramiv, (GLuint program, GLenum pname, GLint *params), (program, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETPROGRAMINFOLOGPROC, glGetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog), (program, bufSize, length, infoLog)) \
+    GL_FUNCTION(PFNGLGETATTRIBLOCATIONPROC, GLint, glGetAttribLocation, (GLuint program, const GLchar *name), (program, name)) \
+    GL_VOID_FUNCTION(PFNGLBINDATTRIBLOCATIONPROC, glBindAttribLocation, (GLuint program, GLuint index, const GLchar *name), (program, index, name)) \
+    GL_FUNCTION(PFNGLGETUNIFORMLOCATIONPROC, GLint, glGetUniformLocation, (GLuint program, const GLchar *name), (program, name)) \
+    GL_FUNCTION(PFNGLGETUNIFORMBLOCKINDEXPROC, GLuint, glGetUniformBlockIndex, (GLuint program, const GLchar *uniformBlockName), (program, uniformBlockName)) \
+    GL_VOID_FUNCTION(PFNGLPROGRAMUNIFORM1IPROC, glProgramUniform1i, (GLuint program, GLint location, GLint v0), (program, location, v0)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM1IPROC, glUniform1i, (GLint location, GLint v0), (location, v0)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM1IVPROC, glUniform1iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM2IVPROC, glUniform2iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM3IVPROC, glUniform3iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM4IVPROC, glUniform4iv, (GLint location, GLsizei count, const GLint *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM1FPROC, glUniform1f, (GLint location, GLfloat v0), (location, v0)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM1FVPROC, glUniform1fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM2FVPROC, glUniform2fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM3FVPROC, glUniform3fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORM4FVPROC, glUniform4fv, (GLint location, GLsizei count, const GLfloat *value), (location, count, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX2FVPROC, glUniformMatrix2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX2X3FVPROC, glUniformMatrix2x3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX2X4FVPROC, glUniformMatrix2x4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX3X2FVPROC, glUniformMatrix3x2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX3FVPROC, glUniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX3X4FVPROC, glUniformMatrix3x4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX4X2FVPROC, glUniformMatrix4x2fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX4X3FVPROC, glUniformMatrix4x3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMMATRIX4FVPROC, glUniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value), (location, count, transpose, value)) \
+    GL_FUNCTION(PFNGLGETPROGRAMRESOURCEINDEXPROC, GLuint, glGetProgramResourceIndex, (GLuint program, GLenum programInterface, const GLchar *name), (program, programInterface, name)) \
+    GL_VOID_FUNCTION(PFNGLUNIFORMBLOCKBINDINGPROC, glUniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+    GL_VOID_FUNCTION(PFNGLSHADERSTORAGEBLOCKBINDINGPROC, glShaderStorageBlockBinding, (GLuint program, GLuint storageBlockIndex, GLuint storageBlockBinding), (program, storageBlockIndex, storageBlockBinding)) \
+    GL_VOID_FUNCTION(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount), (mode, count, type, indices, instancecount)) \
+    GL_VOID_FUNCTION(PFNGLDISPATCHCOMPUTEPROC, glDispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z)) \
+    GL_VOID_FUNCTION(PFNGLMEMORYBARRIERPROC, glMemoryBarrier, (GLbitfield barriers), (barriers)) \
+    GL_VOID_FUNCTION(PFNGLGENQUERIESPROC, glGenQueries, (GLsizei n, GLuint *ids), (n, ids)) \
+    GL_VOID_FUNCTION(PFNGLDELETEQUERIESPROC, glDeleteQueries, (GLsizei n, const GLuint *ids), (n, ids)) \
+    GL_FUNCTION(PFNGLISQUERYPROC, GLboolean, glIsQuery, (GLuint id), (id)) \
+    GL_VOID_FUNCTION(PFNGLBEGINQUERYPROC, glBeginQuery, (GLenum target, GLuint id), (target, id)) \
+    GL_VOID_FUNCTION(PFNGLENDQUERYPROC, glEndQuery, (GLenum target), (target)) \
+    GL_VOID_FUNCTION(PFNGLQUERYCOUNTERPROC, glQueryCounter, (GLuint id, GLenum target), (id, target)) \
+    GL_VOID_FUNCTION(PFNGLGETQUERYIVPROC, glGetQueryiv, (GLenum target, GLenum pname, GLint *params), (target, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETQUERYOBJECTIVPROC, glGetQueryObjectiv, (GLuint id, GLenum pname, GLint *params), (id, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETQUERYOBJECTUIVPROC, glGetQueryObjectuiv, (GLuint id, GLenum pname, GLuint *params), (id, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETQUERYOBJECTI64VPROC, glGetQueryObjecti64v, (GLuint id, GLenum pname, GLint64 *params), (id, pname, params)) \
+    GL_VOID_FUNCTION(PFNGLGETQUERYOBJECTUI64VPROC, glGetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64 *params), (id, pname, params)) \
+    GL_FUNCTION(PFNGLFENCESYNCPROC, GLsync, glFenceSync, (GLenum condition, GLbitfield flags), (condition, flags)) \
+    GL_FUNCTION(PFNGLCLIENTWAITSYNCPROC, GLenum, glClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout)) \
+    GL_VOID_FUNCTION(PFNGLDELETESYNCPROC, glDeleteSync, (GLsync sync), (sync)) \
+    GL_FUNCTION(PFNGLISSYNCPROC, GLboolean, glIsSync, (GLsync sync), (sync)) \
+    GL_VOID_FUNCTION(PFNGLBLENDFUNCSEPARATEPROC, glBlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha)) \
+    GL_VOID_FUNCTION(PFNGLBLENDEQUATIONSEPARATEPROC, glBlendEquationSeparate, (GLenum modeRGB, GLenum modeAlpha), (modeRGB, modeAlpha)) \
+    GL_VOID_FUNCTION(PFNGLDEBUGMESSAGECONTROLPROC, glDebugMessageControl, (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled), (source, type, severity, count, ids, enabled)) \
+    GL_VOID_FUNCTION(PFNGLDEBUGMESSAGECALLBACKPROC, glDebugMessageCallback, (GLDEBUGPROC callback, const void *userParam), (callback, userParam))
+
+// Core since OpenGL 1.2 to 1.4, which opengl32.dll does not export
+#define GL_LAZY_WINDOWS_FUNCTIONS(GL_VOID_FUNCTION, GL_FUNCTION) \
+    GL_VOID_FUNCTION(PFNGLACTIVETEXTUREPROC, glActiveTexture, (GLenum texture), (texture)) \
+    GL_VOID_FUNCTION(PFNGLTEXIMAGE3DPROC, glTexImage3D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, depth, border, format, type, pixels)) \
+    GL_VOID_FUNCTION(PFNGLCOMPRESSEDTEXIMAGE2DPROC, glCompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, border, imageSize, data)) \
+    GL_VOID_FUNCTION(PFNGLCOMPRESSEDTEXIMAGE3DPROC, glCompressedTexImage3D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, depth, border, imageSize, data)) \
+    GL_VOID_FUNCTION(PFNGLTEXSUBIMAGE3DPROC, glTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels)) \
+    GL_VOID_FUNCTION(PFNGLCOMPRESSEDTEXSUBIMAGE2DPROC, glCompressedTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data), (target, level, xoffset, yoffset, width, height, format, imageSize, data)) \
+    GL_VOID_FUNCTION(PFNGLCOMPRESSEDTEXSUBIMAGE3DPROC, glCompressedTexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLsizei imageSize, const void *data), (target, level, xoffset, yoffset, zoffset, width, height, depth, format, imageSize, data)) \
+    GL_VOID_FUNCTION(PFNGLBLENDCOLORPROC, glBlendColor, (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha), (red, green, blue, alpha))
+
+#endif  // !KSGRAPHICSWRAPPER_OPENGL_FUNCTIONS_H
@@ -6,6 +6,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cmath>
 
 
 #define CHK_GL(cmd) \
@@ -41,30 +42,44 @@
  */
 GLSystem::GLSystem() :
     _hDC(0),
-    _hGLRC(0)
+    _hGLRC(0),
+    _majorVersion(0),
+    _minorVersion(0),
+    _renderScale(1.0f),
+    _depthStencilBuffer(0),
+    _hiddenAreaProgram(0),
+    _hiddenAreaTangents(-1),
+    _timerFrame(0),
+    _gpuTime(0)
 {
 
 }
 
+// Projects the hidden area from tangent space, tangents holds left, right, down and up. The
+// triangles land on the near plane
+static const char* HIDDEN_AREA_VERTEX_SHADER =
+    "#version 330 core\n"
+    "layout(location = 0) in vec2 position;\n"
+    "uniform vec4 tangents;\n"
+    "void main()\n"
+    "{\n"
+    "    vec2 ndc = (2.0 * position - tangents.xz - tangents.yw) / (tangents.yw - tangents.xz);\n"
+    "    gl_Position = vec4(ndc, -1.0, 1.0);\n"
+    "}\n";
+static const char* HIDDEN_AREA_FRAGMENT_SHADER =
+    "#version 330 core\n"
+    "void main()\n"
+    "{\n"
+    "}\n";
+
 // Dirty stuff, I know...
 ksGpuWindow window{};
 
 /**
- *
+ *  The window belongs to the calling thread, which must keep running and use the context
  */
-void GLSystem::initializeDevice(XrInstance instance, XrSystemId systemId, int width, int height)
+void GLSystem::createContext()
 {
-    _width = width;
-    _height = height;
-
-    // Extension function must be loaded by name
-    PFN_xrGetOpenGLGraphicsRequirementsKHR pfnGetOpenGLGraphicsRequirementsKHR = nullptr;
-    CHK_XR(xrGetInstanceProcAddr(instance, "xrGetOpenGLGraphicsRequirementsKHR",
-        reinterpret_cast<PFN_xrVoidFunction*>(&pfnGetOpenGLGraphicsRequirementsKHR)), instance);
-
-    XrGraphicsRequirementsOpenGLKHR graphicsRequirements{ XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_KHR };
-    CHK_XR(pfnGetOpenGLGraphicsRequirementsKHR(instance, systemId, &graphicsRequirements), instance);
-
     // Initialize the gl extensions. Note we have to open a window.
     ksDriverInstance driverInstance{};
     ksGpuQueueInfo queueInfo{};
@@ -75,20 +90,35 @@ void GLSystem::initializeDevice(XrInstance instance, XrSystemId systemId, int wi
         throw("Unable to create GL context");
     }
 
-    GLint major = 0;
-    GLint minor = 0;
-    glGetIntegerv(GL_MAJOR_VERSION, &major);
-    glGetIntegerv(GL_MINOR_VERSION, &minor);
-
-    const XrVersion desiredApiVersion = XR_MAKE_VERSION(major, minor, 0);
-    if (graphicsRequirements.minApiVersionSupported > desiredApiVersion) {
-        throw("Runtime does not support desired Graphics API and/or version");
-    }
+    glGetIntegerv(GL_MAJOR_VERSION, &_majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &_minorVersion);
 
 #ifdef XR_USE_PLATFORM_WIN32
     _hDC = window.context.hDC;
     _hGLRC = window.context.hGLRC;
 #endif
+}
+
+/**
+ *  The OpenXR spec requires the graphics requirements to be queried before the session is created
+ */
+void GLSystem::initializeDevice(XrInstance instance, XrSystemId systemId, int width, int height)
+{
+    _width = width;
+    _height = height;
+
+    // Extension function must be loaded by name
+    PFN_xrGetOpenGLGraphicsRequirementsKHR pfnGetOpenGLGraphicsRequirementsKHR = nullptr;
+    CHK_XR(xrGetInstanceProcAddr(instance, "xrGetOpenGLGraphicsRequirementsKHR",
+        reinterpret_cast<PFN_xrVoidFunction*>(&pfnGetOpenGLGraphicsRequirementsKHR)), instance);
+
+    XrGraphicsRequirementsOpenGLKHR graphicsRequirements{ XR_TYPE_GRAPHICS_REQUIREMENTS_OPENGL_KHR };
+    CHK_XR(pfnGetOpenGLGraphicsRequirementsKHR(instance, systemId, &graphicsRequirements), instance);
+
+    const XrVersion desiredApiVersion = XR_MAKE_VERSION(_majorVersion, _minorVersion, 0);
+    if (graphicsRequirements.minApiVersionSupported > desiredApiVersion) {
+        throw("Runtime does not support desired Graphics API and/or version");
+    }
 
     initGLStuff();
 }
@@ -244,7 +274,7 @@ int64_t GLSystem::getFormat(const std::vector<int64_t>& supported_swapchain_form
 }
 
 
-void GLSystem::renderToTexture(uint32_t tex)
+void GLSystem::renderToTexture(uint32_t tex, uint32_t view, const XrFovf& fov)
 {
     // TO-DO: implement me!
 
@@ -254,7 +284,7 @@ void GLSystem::renderToTexture(uint32_t tex)
 
     const uint32_t colorTexture = tex;
 
-    CHK_GL(glViewport(0, 0, _width, _height));
+    CHK_GL(glViewport(0, 0, (GLsizei)(_width * _renderScale), (GLsizei)(_height * _renderScale)));
 #if 0
     glViewport(static_cast<GLint>(layerView.subImage.imageRect.offset.x),
         static_cast<GLint>(layerView.subImage.imageRect.offset.y),
@@ -271,7 +301,7 @@ void GLSystem::renderToTexture(uint32_t tex)
     //glBindTexture(GL_TEXTURE_2D, colorTexture);
 
     CHK_GL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0));
-//    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+    CHK_GL(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthStencilBuffer));
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
@@ -281,10 +311,12 @@ void GLSystem::renderToTexture(uint32_t tex)
 
     // Clear swapchain and depth buffer.
     CHK_GL(glClearColor(0., 1., 0., 1.));
-//    glClearDepth(1.0f);
-//    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-//    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    CHK_GL(glClear(GL_COLOR_BUFFER_BIT));
+    CHK_GL(glClearDepth(1.0f));
+    CHK_GL(glClearStencil(0));
+    CHK_GL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT));
+
+    // Before anything is drawn, so a scene drawn here would be rejected by the depth test in the hidden area
+    prefillHiddenArea(view, fov);
 
     CHK_GL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
 
@@ -303,10 +335,162 @@ void GLSystem::renderToTexture(uint32_t tex)
 }
 
 
+void GLSystem::setRenderScale(float scale)
+{
+    _renderScale = scale;
+}
+
+/**
+ *  The buffers of a view are created on its first mesh and kept, a changed mask is only uploaded again
+ */
+void GLSystem::setHiddenAreaMesh(uint32_t view, const std::vector<XrVector2f>& vertices, const std::vector<uint32_t>& indices)
+{
+    if (view >= _hiddenAreaMeshes.size()) {
+        _hiddenAreaMeshes.resize(view + 1, HiddenAreaMesh{ 0, 0, 0, 0, {}, {}, true });
+    }
+    HiddenAreaMesh& mesh = _hiddenAreaMeshes[view];
+    if (mesh.vertexArray == 0) {
+        CHK_GL(glGenVertexArrays(1, &mesh.vertexArray));
+        CHK_GL(glGenBuffers(1, &mesh.vertexBuffer));
+        CHK_GL(glGenBuffers(1, &mesh.indexBuffer));
+        CHK_GL(glBindVertexArray(mesh.vertexArray));
+        CHK_GL(glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer));
+        CHK_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer));
+        CHK_GL(glEnableVertexAttribArray(0));
+        CHK_GL(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(XrVector2f), nullptr));
+        CHK_GL(glBindVertexArray(0));
+    }
+
+    CHK_GL(glBindBuffer(GL_ARRAY_BUFFER, mesh.vertexBuffer));
+    CHK_GL(glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(XrVector2f), vertices.data(), GL_STATIC_DRAW));
+    CHK_GL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    CHK_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexBuffer));
+    CHK_GL(glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW));
+    CHK_GL(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    mesh.indexCount = vertices.empty() ? 0 : (GLsizei)indices.size();
+    mesh.vertices = vertices;
+    mesh.indices = indices;
+    mesh.reported = false;
+}
+
+void GLSystem::createHiddenAreaProgram()
+{
+    const char* sources[] = { HIDDEN_AREA_VERTEX_SHADER, HIDDEN_AREA_FRAGMENT_SHADER };
+    const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    _hiddenAreaProgram = glCreateProgram();
+    for (int i = 0; i < 2; i++) {
+        const GLuint shader = glCreateShader(types[i]);
+        CHK_GL(glShaderSource(shader, 1, &sources[i], nullptr));
+        CHK_GL(glCompileShader(shader));
+        GLint compiled = GL_FALSE;
+        CHK_GL(glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled));
+        if (compiled != GL_TRUE) {
+            std::cerr << "ERROR: hidden area shader does not compile" << std::endl;
+            throw -1;
+        }
+        CHK_GL(glAttachShader(_hiddenAreaProgram, shader));
+        CHK_GL(glDeleteShader(shader));
+    }
+    CHK_GL(glLinkProgram(_hiddenAreaProgram));
+    GLint linked = GL_FALSE;
+    CHK_GL(glGetProgramiv(_hiddenAreaProgram, GL_LINK_STATUS, &linked));
+    if (linked != GL_TRUE) {
+        std::cerr << "ERROR: hidden area program does not link" << std::endl;
+        throw -1;
+    }
+    _hiddenAreaTangents = glGetUniformLocation(_hiddenAreaProgram, "tangents");
+}
+
+/**
+ *  Depth is written at the near plane and stencil set to 1, whatever was there
+ */
+void GLSystem::prefillHiddenArea(uint32_t view, const XrFovf& fov)
+{
+    if (view >= _hiddenAreaMeshes.size() || _hiddenAreaMeshes[view].indexCount == 0) {
+        return;
+    }
+    HiddenAreaMesh& mesh = _hiddenAreaMeshes[view];
+    if (!mesh.reported) {
+        reportHiddenArea(mesh, view, fov);
+    }
+
+    const GLfloat tangents[4] = { tanf(fov.angleLeft), tanf(fov.angleRight), tanf(fov.angleDown), tanf(fov.angleUp) };
+    CHK_GL(glUseProgram(_hiddenAreaProgram));
+    CHK_GL(glUniform4fv(_hiddenAreaTangents, 1, tangents));
+    CHK_GL(glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE));
+    CHK_GL(glEnable(GL_DEPTH_TEST));
+    CHK_GL(glDepthFunc(GL_ALWAYS));
+    CHK_GL(glDepthMask(GL_TRUE));
+    CHK_GL(glEnable(GL_STENCIL_TEST));
+    CHK_GL(glStencilFunc(GL_ALWAYS, 1, 0xFF));
+    CHK_GL(glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE));
+
+    CHK_GL(glBindVertexArray(mesh.vertexArray));
+    CHK_GL(glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, nullptr));
+    CHK_GL(glBindVertexArray(0));
+
+    // A scene pass would test against the prefilled depth
+    CHK_GL(glDisable(GL_STENCIL_TEST));
+    CHK_GL(glDepthFunc(GL_LESS));
+    CHK_GL(glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE));
+    CHK_GL(glUseProgram(0));
+}
+
+/**
+ *  Pixels a depth tested scene pass could skip, from the triangle areas, which do not overlap
+ */
+void GLSystem::reportHiddenArea(HiddenAreaMesh& mesh, uint32_t view, const XrFovf& fov)
+{
+    const float left = tanf(fov.angleLeft);
+    const float right = tanf(fov.angleRight);
+    const float down = tanf(fov.angleDown);
+    const float up = tanf(fov.angleUp);
+    double area = 0.0;
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        const XrVector2f& a = mesh.vertices[mesh.indices[i]];
+        const XrVector2f& b = mesh.vertices[mesh.indices[i + 1]];
+        const XrVector2f& c = mesh.vertices[mesh.indices[i + 2]];
+        area += 0.5 * std::fabs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y));
+    }
+    const double fraction = std::min(1.0, area / ((right - left) * (up - down)));
+    const double pixels = (double)_width * _renderScale * (double)_height * _renderScale;
+    std::cout << "Hidden area of view " << view << ": " << mesh.indices.size() / 3 << " triangles, "
+        << (int)(100.0 * fraction) << "% of the image, " << (uint64_t)(fraction * pixels) << " pixels a depth tested scene could skip" << std::endl;
+    mesh.reported = true;
+}
+
+/**
+ *  The queries of a frame are read back when they are reused, by then the GPU is done with them
+ */
+void GLSystem::beginGpuTimer()
+{
+    GLuint* queries = _timerQueries[_timerFrame % GPU_TIMER_FRAMES_DELAYED];
+    if (_timerFrame >= GPU_TIMER_FRAMES_DELAYED) {
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        CHK_GL(glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin));
+        CHK_GL(glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end));
+        _gpuTime = (end > begin) ? end - begin : 0;
+    }
+    CHK_GL(glQueryCounter(queries[0], GL_TIMESTAMP));
+}
+
+void GLSystem::endGpuTimer()
+{
+    CHK_GL(glQueryCounter(_timerQueries[_timerFrame % GPU_TIMER_FRAMES_DELAYED][1], GL_TIMESTAMP));
+    _timerFrame++;
+}
+
 void GLSystem::initGLStuff()
 {
     // Create FBO
     CHK_GL(glGenFramebuffers(1, &_swapchainFramebuffer));
+    CHK_GL(glGenRenderbuffers(1, &_depthStencilBuffer));
+    CHK_GL(glBindRenderbuffer(GL_RENDERBUFFER, _depthStencilBuffer));
+    CHK_GL(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, _width, _height));
+    CHK_GL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+    createHiddenAreaProgram();
+    CHK_GL(glGenQueries(GPU_TIMER_FRAMES_DELAYED * 2, &_timerQueries[0][0]));
 
 #if 0
     // Create depth texture
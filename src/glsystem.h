@@ -13,6 +13,9 @@ public:
     /// Constructor
     GLSystem();
 
+    /// Opens the window and creates the GL context, current on the calling thread. Needs no OpenXR instance
+    void createContext();
+    /// Checks the runtime requirements against the context and creates the GL objects
     void initializeDevice(XrInstance instance, XrSystemId systemId, int width, int height);
 
     inline HDC getHDC() { return _hDC; }
@@ -23,16 +26,61 @@ public:
     std::string textureInternalFormatToString(uint32_t fmt);
     int64_t getFormat(const std::vector<int64_t> &supported_swapchain_formats);
 
-    void renderToTexture(uint32_t tex);
+    /// view selects the hidden area mesh, fov projects it
+    void renderToTexture(uint32_t tex, uint32_t view, const XrFovf& fov);
+    /// Renders to that fraction of the image size, per axis
+    void setRenderScale(float scale);
+
+    /**
+     * Replaces the hidden area mesh of a view, from XR_KHR_visibility_mask. Its triangles are written
+     * to depth at the near plane and to stencil before the view is rendered, so a depth tested scene
+     * pass would shade nothing behind them. Vertices are in the view's tangent space, as the runtime returns them. Empty
+     * vertices remove the mesh
+     */
+    void setHiddenAreaMesh(uint32_t view, const std::vector<XrVector2f>& vertices, const std::vector<uint32_t>& indices);
+
+    /// Bracket the GL commands of a frame with timestamp queries
+    void beginGpuTimer();
+    void endGpuTimer();
+    /// GPU time in nanoseconds of the frame timed GPU_TIMER_FRAMES_DELAYED frames ago, so reading it never stalls. 0 before
+    inline uint64_t getGpuTime() const { return _gpuTime; }
 
 private:
 
+    static const int GPU_TIMER_FRAMES_DELAYED = 2;
+
+    struct HiddenAreaMesh {
+        GLuint vertexArray;
+        GLuint vertexBuffer;
+        GLuint indexBuffer;
+        GLsizei indexCount;
+        std::vector<XrVector2f> vertices;       // kept to report the hidden area once the fov is known
+        std::vector<uint32_t> indices;
+        bool reported;
+    };
+
+    void createHiddenAreaProgram();
+    void prefillHiddenArea(uint32_t view, const XrFovf& fov);
+    void reportHiddenArea(HiddenAreaMesh& mesh, uint32_t view, const XrFovf& fov);
+
     HDC _hDC;
     HGLRC _hGLRC;
 
+    GLint _majorVersion;
+    GLint _minorVersion;
     GLsizei _width;
     GLsizei _height;
+    float _renderScale;
     GLuint _swapchainFramebuffer;
     uint32_t _depthTexture;
+    GLuint _depthStencilBuffer;
+
+    GLuint _hiddenAreaProgram;
+    GLint _hiddenAreaTangents;      // uniform location
+    std::vector<HiddenAreaMesh> _hiddenAreaMeshes;     // by view
+
+    GLuint _timerQueries[GPU_TIMER_FRAMES_DELAYED][2];     // begin and end timestamp
+    uint64_t _timerFrame;
+    uint64_t _gpuTime;
 
 };
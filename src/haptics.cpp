@@ -0,0 +1,216 @@
+#include "haptics.h"
+
+#include <iostream>
+
+// Duration assumed for XR_MIN_HAPTIC_DURATION pulses when deciding whether a device still plays
+static const ksNanoseconds MIN_PULSE_NANOSECONDS = 10 * 1000 * 1000;
+
+
+/**
+ *  Constructor
+ */
+HapticsScheduler::HapticsScheduler(const XrDispatch& xr, XrInstance instance, XrSession session, const ActionRegistry& actions,
+        int capacity) :
+    _xr(xr),
+    _instance(instance),
+    _session(session),
+    _actions(actions),
+    _dropped(0),
+    _stats{ 0, 0, 0, 0 }
+{
+    ksMpmcQueue_Create(&_queue, sizeof(HapticEvent), capacity);
+}
+
+/**
+ *  Destructor
+ */
+HapticsScheduler::~HapticsScheduler()
+{
+    ksMpmcQueue_Destroy(&_queue);
+}
+
+/**
+ */
+bool HapticsScheduler::enqueue(const HapticEvent& event)
+{
+    if (!ksMpmcQueue_Push(&_queue, &event)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+/**
+ */
+void HapticsScheduler::vibrate(VibrationAction action, float amplitude, XrDuration duration, int priority, XrPath subactionPath)
+{
+    enqueue(HapticEvent{ action, subactionPath, amplitude, XR_FREQUENCY_UNSPECIFIED, duration, priority });
+}
+
+/**
+ */
+void HapticsScheduler::stop(VibrationAction action, int priority, XrPath subactionPath)
+{
+    enqueue(HapticEvent{ action, subactionPath, 0.0f, XR_FREQUENCY_UNSPECIFIED, 0, priority });
+}
+
+/**
+ */
+void HapticsScheduler::update(bool focused)
+{
+    const ksNanoseconds now = GetTimeNanoseconds();
+    _stats = FrameStats{ 0, 0, 0, _dropped.exchange(0, std::memory_order_relaxed) };
+
+    for (Device& d : _devices) {
+        if (d.playing && (!focused || now >= d.end)) {
+            d.playing = false;
+        }
+        d.pending = false;
+    }
+
+    HapticEvent event;
+    while (ksMpmcQueue_Pop(&_queue, &event)) {
+        _stats.events++;
+        if (focused) {
+            merge(device(event.action, event.subactionPath), event, now);
+        }
+    }
+    if (!focused) {
+        return;
+    }
+
+    for (Device& d : _devices) {
+        if (d.pending) {
+            submit(d, now);
+        }
+    }
+}
+
+/**
+ * Devices are few, so they are kept in a vector and found by a linear search
+ */
+HapticsScheduler::Device& HapticsScheduler::device(VibrationAction action, XrPath subactionPath)
+{
+    for (Device& d : _devices) {
+        if (d.action.index == action.index && d.subactionPath == subactionPath) {
+            return d;
+        }
+    }
+    _devices.push_back(Device{ action, subactionPath, false, 0.0f, XR_FREQUENCY_UNSPECIFIED, 0, 0,
+        false, false, false, false, 0.0f, XR_FREQUENCY_UNSPECIFIED, 0, 0 });
+    return _devices.back();
+}
+
+/**
+ */
+void HapticsScheduler::merge(Device& d, const HapticEvent& event, ksNanoseconds now)
+{
+    // A vibration of higher priority keeps playing
+    if (d.playing && event.priority < d.priority) {
+        return;
+    }
+    const bool stop = (event.amplitude <= 0.0f);
+    const bool pulse = (event.duration == XR_MIN_HAPTIC_DURATION);
+    const ksNanoseconds end = now + (pulse ? MIN_PULSE_NANOSECONDS : event.duration);
+
+    // Events of the same priority as the playing vibration are merged with it
+    if (!d.pending && d.playing && event.priority == d.priority) {
+        d.pending = true;
+        d.pendingStop = false;
+        d.pendingPulse = false;
+        d.pendingRestart = false;
+        d.pendingAmplitude = d.amplitude;
+        d.pendingFrequency = d.frequency;
+        d.pendingPriority = d.priority;
+        d.pendingEnd = d.end;
+    }
+
+    if (!d.pending || event.priority > d.pendingPriority) {
+        d.pending = true;
+        d.pendingStop = stop;
+        d.pendingPulse = pulse;
+        d.pendingRestart = stop;
+        d.pendingAmplitude = event.amplitude;
+        d.pendingFrequency = event.frequency;
+        d.pendingPriority = event.priority;
+        d.pendingEnd = stop ? now : end;
+        return;
+    }
+    if (event.priority < d.pendingPriority) {
+        return;
+    }
+    // Same priority: a stop cancels what came before it, a vibration overrides an earlier stop
+    if (stop) {
+        d.pendingStop = true;
+        d.pendingRestart = true;
+        d.pendingAmplitude = 0.0f;
+        d.pendingEnd = now;
+    }
+    else if (d.pendingStop) {
+        d.pendingStop = false;
+        d.pendingPulse = pulse;
+        d.pendingAmplitude = event.amplitude;
+        d.pendingFrequency = event.frequency;
+        d.pendingEnd = end;
+    }
+    else {
+        if (event.amplitude > d.pendingAmplitude) {
+            d.pendingAmplitude = event.amplitude;
+            d.pendingFrequency = event.frequency;
+        }
+        if (end > d.pendingEnd) {
+            d.pendingPulse = pulse;
+            d.pendingEnd = end;
+        }
+    }
+}
+
+/**
+ */
+void HapticsScheduler::submit(Device& d, ksNanoseconds now)
+{
+    XrHapticActionInfo haptic_info{ XR_TYPE_HAPTIC_ACTION_INFO };
+    haptic_info.action = _actions.getAction(d.action);
+    haptic_info.subactionPath = d.subactionPath;
+    XrResult res;
+
+    if (d.pendingStop) {
+        if (d.playing) {
+            _stats.stopCalls++;
+            if (XR_FAILED(res = _xr.StopHapticFeedback(_session, &haptic_info))) {
+                reportFailure(res, "xrStopHapticFeedback");
+            }
+            d.playing = false;
+        }
+        return;
+    }
+
+    // Already playing the same vibration for at least as long
+    if (d.playing && !d.pendingRestart && d.amplitude == d.pendingAmplitude && d.frequency == d.pendingFrequency && d.end >= d.pendingEnd) {
+        return;
+    }
+
+    XrHapticVibration vibration{ XR_TYPE_HAPTIC_VIBRATION };
+    vibration.amplitude = d.pendingAmplitude;
+    vibration.frequency = d.pendingFrequency;
+    vibration.duration = d.pendingPulse ? XR_MIN_HAPTIC_DURATION : (XrDuration)(d.pendingEnd - now);
+    _stats.applyCalls++;
+    if (XR_FAILED(res = _xr.ApplyHapticFeedback(_session, &haptic_info, (const XrHapticBaseHeader*)&vibration))) {
+        reportFailure(res, "xrApplyHapticFeedback");
+        return;
+    }
+    d.playing = true;
+    d.amplitude = d.pendingAmplitude;
+    d.frequency = d.pendingFrequency;
+    d.priority = d.pendingPriority;
+    d.end = d.pendingEnd;
+}
+
+/**
+ */
+void HapticsScheduler::reportFailure(XrResult res, const char* call) const
+{
+    char err_msg[XR_MAX_RESULT_STRING_SIZE];
+    xrResultToString(_instance, res, err_msg);
+    std::cerr << "ERROR: " << call << ": " << err_msg << " (" << res << ")" << std::endl;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "utils/threading.h"
+#include "dispatch.h"
+#include "actions.h"
+
+/**
+ * A vibration request. A zero amplitude stops the device instead.
+ */
+struct HapticEvent {
+    VibrationAction action;
+    XrPath subactionPath;       // XR_NULL_PATH for every device bound to the action
+    float amplitude;            // 0 to 1
+    float frequency;            // XR_FREQUENCY_UNSPECIFIED lets the runtime choose
+    XrDuration duration;        // nanoseconds, or XR_MIN_HAPTIC_DURATION for a short pulse
+    int priority;               // higher wins while it plays
+};
+
+/**
+ * Vibrations requested from any thread, applied once per frame from the frame thread.
+ *
+ * Events go through a lock-free queue. update drains it and coalesces the events of each device
+ * (action and subaction path): the highest priority wins, and among equal priorities the
+ * strongest amplitude, lasting until the latest end. A device is only called again when the
+ * result differs from what it is playing, or plays longer. Lower priorities are ignored until a
+ * higher priority vibration ends. A stop only stops a device that is playing.
+ */
+class HapticsScheduler {
+
+public:
+
+    struct FrameStats {
+        uint32_t events;            // events drained
+        uint32_t applyCalls;        // xrApplyHapticFeedback calls
+        uint32_t stopCalls;         // xrStopHapticFeedback calls
+        uint32_t dropped;           // events lost because the queue was full, since the last update
+    };
+
+    HapticsScheduler(const XrDispatch& xr, XrInstance instance, XrSession session, const ActionRegistry& actions,
+        int capacity = 256);
+    ~HapticsScheduler();
+
+    HapticsScheduler(const HapticsScheduler&) = delete;
+    HapticsScheduler& operator=(const HapticsScheduler&) = delete;
+
+    /// Can be called from any thread. Returns false and drops the event if the queue is full
+    bool enqueue(const HapticEvent& event);
+    void vibrate(VibrationAction action, float amplitude, XrDuration duration, int priority = 0,
+        XrPath subactionPath = XR_NULL_PATH);
+    void stop(VibrationAction action, int priority = 0, XrPath subactionPath = XR_NULL_PATH);
+
+    /**
+     * Frame thread. Coalesces the queued events and applies them. Unless the session is focused
+     * the runtime ignores haptics, so events are discarded and devices are considered idle.
+     */
+    void update(bool focused);
+
+    inline const FrameStats& frameStats() const { return _stats; }
+
+private:
+
+    struct Device {
+        VibrationAction action;
+        XrPath subactionPath;
+        bool playing;
+        float amplitude;
+        float frequency;
+        int priority;
+        ksNanoseconds end;          // on the GetTimeNanoseconds clock
+
+        // Coalesced events of the current update
+        bool pending;
+        bool pendingStop;
+        bool pendingPulse;          // submitted as XR_MIN_HAPTIC_DURATION
+        bool pendingRestart;        // a stop came before, so the playing vibration cannot be kept
+        float pendingAmplitude;
+        float pendingFrequency;
+        int pendingPriority;
+        ksNanoseconds pendingEnd;
+    };
+
+    Device& device(VibrationAction action, XrPath subactionPath);
+    void merge(Device& device, const HapticEvent& event, ksNanoseconds now);
+    void submit(Device& device, ksNanoseconds now);
+    void reportFailure(XrResult res, const char* call) const;
+
+    const XrDispatch& _xr;
+    XrInstance _instance;
+    XrSession _session;
+    const ActionRegistry& _actions;
+    ksMpmcQueue _queue;
+    std::atomic<uint32_t> _dropped;
+    std::vector<Device> _devices;
+    FrameStats _stats;
+
+};
@@ -0,0 +1,96 @@
+#include "idle.h"
+
+#include <iostream>
+
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+
+/**
+ *  Constructor
+ */
+IdleBackoff::IdleBackoff(ksNanoseconds minSleep, ksNanoseconds maxSleep) :
+    _minSleep(minSleep),
+    _maxSleep(maxSleep),
+    _sleep(minSleep),
+    _idle(false),
+    _idleStart(0),
+    _processTimeStart(0),
+    _waits(0)
+{
+    // Sleep would round up to the system timer resolution, 15.6 ms unless some process raised it
+    _timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (_timer == NULL) {
+        _timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+}
+
+/**
+ *  Destructor
+ */
+IdleBackoff::~IdleBackoff()
+{
+    if (_timer != NULL) {
+        CloseHandle(_timer);
+    }
+}
+
+/**
+ */
+void IdleBackoff::wait()
+{
+    if (!_idle) {
+        _idle = true;
+        _idleStart = GetTimeNanoseconds();
+        _processTimeStart = processTime();
+        _waits = 0;
+    }
+
+    LARGE_INTEGER due;
+    due.QuadPart = -(LONGLONG)(_sleep / 100);     // relative, in 100 ns units
+    if (_timer != NULL && SetWaitableTimer(_timer, &due, 0, NULL, NULL, FALSE)) {
+        WaitForSingleObject(_timer, INFINITE);
+    }
+    else {
+        Sleep((DWORD)(_sleep / 1000000));
+    }
+    _waits++;
+    _sleep = (_sleep * 2 < _maxSleep) ? _sleep * 2 : _maxSleep;
+}
+
+/**
+ */
+void IdleBackoff::reset()
+{
+    _sleep = _minSleep;
+}
+
+/**
+ */
+void IdleBackoff::end()
+{
+    _sleep = _minSleep;
+    if (!_idle) {
+        return;
+    }
+    _idle = false;
+
+    const ksNanoseconds wall = GetTimeNanoseconds() - _idleStart;
+    const ksNanoseconds cpu = processTime() - _processTimeStart;
+    std::cout << "Idle for " << wall / 1000000 << " ms, " << _waits << " waits, "
+        << ((wall > 0) ? 100.0 * (double)cpu / (double)wall : 0.0) << "% of a processor" << std::endl;
+}
+
+/**
+ */
+ksNanoseconds IdleBackoff::processTime()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    const uint64_t kernel_ticks = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    const uint64_t user_ticks = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (kernel_ticks + user_ticks) * 100;     // 100 ns units
+}
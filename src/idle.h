@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include <windows.h>
+
+#include "utils/threading.h"
+
+/**
+ * Sleeps a loop that has nothing to do, instead of letting it spin. The sleep starts at
+ * minSleep and doubles on every wait up to maxSleep, so whatever the loop waits for is seen
+ * within maxSleep. reset goes back to minSleep, for when something happened and more may follow.
+ *
+ * Consecutive waits form an idle period, ended by end. Every idle period is reported with the
+ * processor time the process used during it.
+ */
+class IdleBackoff {
+
+public:
+
+    IdleBackoff(ksNanoseconds minSleep, ksNanoseconds maxSleep);
+    ~IdleBackoff();
+
+    IdleBackoff(const IdleBackoff&) = delete;
+    IdleBackoff& operator=(const IdleBackoff&) = delete;
+
+    /// Sleeps for the current backoff, starting an idle period if none is running
+    void wait();
+    /// The next wait sleeps minSleep again
+    void reset();
+    /// Ends and reports the idle period, if one is running
+    void end();
+
+    inline bool isIdle() const { return _idle; }
+
+private:
+
+    /// User and kernel time of every thread of the process
+    static ksNanoseconds processTime();
+
+    HANDLE _timer;
+    ksNanoseconds _minSleep;
+    ksNanoseconds _maxSleep;
+    ksNanoseconds _sleep;
+
+    bool _idle;
+    ksNanoseconds _idleStart;
+    ksNanoseconds _processTimeStart;
+    uint32_t _waits;
+
+};
@@ -0,0 +1,255 @@
+#include "input.h"
+
+#include <cstring>
+#include <iostream>
+
+#if !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+static const uint32_t EVENT_QUEUE_CAPACITY = 4;
+
+
+/**
+ *  Constructor
+ */
+InputThread::InputThread(const XrDispatch& xr, XrInstance instance, XrSession session, XrActionSet actionSet,
+        const ActionRegistry& actions, XrSpace poseBaseSpace) :
+    _xr(xr),
+    _instance(instance),
+    _session(session),
+    _actionSet(actionSet),
+    _actions(actions),
+    _poseBaseSpace(poseBaseSpace),
+    _convertTime(nullptr),
+    _policies(nullptr),
+    _processor(-1),
+    _timer(NULL),
+    _period(0),
+    _stop(false),
+    _running(false),
+    _focused(false),
+    _sequence(0),
+    _syncResult(XR_SUCCESS),
+    _syncFailures(0)
+{
+    // Only available if the extension was enabled on the instance
+    if (XR_FAILED(xrGetInstanceProcAddr(_instance, "xrConvertWin32PerformanceCounterToTimeKHR",
+            reinterpret_cast<PFN_xrVoidFunction*>(&_convertTime)))) {
+        _convertTime = nullptr;
+    }
+
+    ksMailbox_Create(&_states, sizeof(ActionStateBlock));
+    ksMailbox_Create(&_timeAnchor, sizeof(TimeAnchor));
+    ksSpscQueue_Create(&_events, sizeof(XrEventDataInteractionProfileChanged), EVENT_QUEUE_CAPACITY);
+    ksSignal_Create(&_wake, true);
+    memset(&_scratch, 0, sizeof(_scratch));
+}
+
+/**
+ *  Destructor
+ */
+InputThread::~InputThread()
+{
+    stop();
+    ksSignal_Destroy(&_wake);
+    ksSpscQueue_Destroy(&_events);
+    ksMailbox_Destroy(&_timeAnchor);
+    ksMailbox_Destroy(&_states);
+}
+
+/**
+ */
+void InputThread::start(float rateHz, ksThreadPolicyManager* policies, int processor)
+{
+    if (_running) {
+        return;
+    }
+    setRate(rateHz);
+    _policies = policies;
+    _processor = processor;
+    _stop = false;
+
+    // A high resolution timer keeps the rate without raising the system timer resolution
+    _timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (_timer == NULL) {
+        _timer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+    }
+
+    ksThread_Create(&_thread, "input", threadFunction, this);
+    ksThread_Signal(&_thread);
+    _running = true;
+}
+
+/**
+ */
+void InputThread::stop()
+{
+    if (!_running) {
+        return;
+    }
+    _stop = true;
+    ksSignal_Raise(&_wake);
+    ksThread_Destroy(&_thread);
+    CloseHandle(_timer);
+    _timer = NULL;
+    _running = false;
+    if (_syncFailures > 0) {
+        std::cerr << "WARN: input thread xrSyncActions failed " << _syncFailures << " times" << std::endl;
+    }
+}
+
+/**
+ */
+void InputThread::setRate(float rateHz)
+{
+    _period = (ksNanoseconds)(1e9 / rateHz);
+}
+
+/**
+ */
+void InputThread::setFocused(bool focused)
+{
+    {
+        std::lock_guard<std::mutex> lock(_syncMutex);
+        _focused = focused;
+    }
+    if (focused) {
+        ksSignal_Raise(&_wake);
+    }
+}
+
+/**
+ */
+void InputThread::setFrameTime(XrTime predictedDisplayTime)
+{
+    const TimeAnchor anchor = { predictedDisplayTime, GetTimeNanoseconds() };
+    ksMailbox_Publish(&_timeAnchor, &anchor);
+}
+
+/**
+ */
+bool InputThread::read(ActionStateBlock& block)
+{
+    return ksMailbox_Read(&_states, &block) != 0;
+}
+
+/**
+ */
+void InputThread::threadFunction(void* data)
+{
+    static_cast<InputThread*>(data)->run();
+}
+
+/**
+ */
+void InputThread::run()
+{
+    ksThread_SetProcessorAffinity(_processor);
+    if (_policies != nullptr) {
+        ksThreadPolicyManager_Register(_policies, KS_THREAD_ROLE_INPUT, "input");
+    }
+
+    while (!_stop) {
+        const ksNanoseconds start = GetTimeNanoseconds();
+        if (!sample()) {
+            // Nothing to sync until the session is focused again. A raise that came before
+            // the wait keeps the signal set, so it is not missed
+            ksSignal_Wait(&_wake, SIGNAL_TIMEOUT_INFINITE);
+            continue;
+        }
+        const ksNanoseconds elapsed = GetTimeNanoseconds() - start;
+        const ksNanoseconds period = _period;
+        if (elapsed < period) {
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)((period - elapsed) / 100);     // relative, in 100 ns units
+            if (_timer != NULL && SetWaitableTimer(_timer, &due, 0, NULL, NULL, FALSE)) {
+                WaitForSingleObject(_timer, INFINITE);
+            }
+            else {
+                Sleep(1);
+            }
+        }
+    }
+}
+
+/**
+ * Syncs the actions and publishes their state. Runtime calls only happen under _syncMutex
+ * while the session is focused. Returns false if the session is not focused.
+ */
+bool InputThread::sample()
+{
+    std::lock_guard<std::mutex> lock(_syncMutex);
+
+    // Counted even while unfocused, the profile often changes while the user is away. Changes
+    // that come in while the thread sleeps are counted once focus returns
+    XrEventDataInteractionProfileChanged event;
+    while (ksSpscQueue_Pop(&_events, &event)) {
+        _scratch.interactionProfileChanges++;
+    }
+
+    if (!_focused) {
+        if (_scratch.focused) {
+            publishUnfocused();
+        }
+        return false;
+    }
+
+    XrActiveActionSet active_action_set{ _actionSet, XR_NULL_PATH };
+    XrActionsSyncInfo sync_info{ XR_TYPE_ACTIONS_SYNC_INFO };
+    sync_info.countActiveActionSets = 1;
+    sync_info.activeActionSets = &active_action_set;
+    const XrResult res = _xr.SyncActions(_session, &sync_info);
+    // At the sampling rate a failing session would flood the log, so only changes are reported
+    if (XR_FAILED(res) && res != _syncResult) {
+        char err_msg[XR_MAX_RESULT_STRING_SIZE];
+        xrResultToString(_instance, res, err_msg);
+        std::cerr << "ERROR: input thread xrSyncActions: " << err_msg << " (" << res << ")" << std::endl;
+    }
+    else if (XR_SUCCEEDED(res) && XR_FAILED(_syncResult)) {
+        std::cout << "Input thread xrSyncActions succeeds again, " << _syncFailures << " failures so far" << std::endl;
+    }
+    _syncResult = res;
+    if (XR_FAILED(res)) {
+        _syncFailures++;
+        return true;
+    }
+
+    _actions.query(_session, _poseBaseSpace, now(), _scratch);
+    _scratch.focused = (res == XR_SUCCESS);
+    _scratch.sequence = ++_sequence;
+    ksMailbox_Publish(&_states, &_scratch);
+    return true;
+}
+
+/**
+ * Publishes a block with every action inactive, so readers do not act on stale state
+ */
+void InputThread::publishUnfocused()
+{
+    ActionRegistry::clear(_scratch);
+    _scratch.sequence = ++_sequence;
+    ksMailbox_Publish(&_states, &_scratch);
+}
+
+/**
+ * Current runtime time. Converted from the performance counter when the runtime supports it,
+ * otherwise extrapolated from the last frame's predicted display time. Returns 0 when neither
+ * is available yet.
+ */
+XrTime InputThread::now()
+{
+    if (_convertTime != nullptr) {
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        XrTime time;
+        if (XR_SUCCEEDED(_convertTime(_instance, &counter, &time))) {
+            return time;
+        }
+    }
+    TimeAnchor anchor;
+    if (ksMailbox_Read(&_timeAnchor, &anchor) == 0) {
+        return 0;
+    }
+    return anchor.time + (XrTime)(GetTimeNanoseconds() - anchor.clock);
+}
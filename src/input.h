@@ -0,0 +1,102 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#if !defined(XR_USE_PLATFORM_WIN32)
+#define XR_USE_PLATFORM_WIN32
+#endif
+#include <windows.h>
+#include <openxr/openxr_platform.h>
+
+#include "utils/threading.h"
+#include "dispatch.h"
+#include "actions.h"
+
+/**
+ * Syncs the actions of an action set on its own thread at a fixed rate, independent of the
+ * display rate, and publishes the state of every action in the registry as an ActionStateBlock.
+ * Readers take the freshest block without blocking the input thread or each other.
+ *
+ * Actions are only synced while the session is focused, the thread sleeps until focus returns.
+ * setFocused serializes with the input thread, so once it returned with false no runtime call
+ * of the input thread is in flight and the session may be ended.
+ */
+class InputThread {
+
+public:
+
+    /// poseBaseSpace is the space action poses are located in. The table and registry must outlive the thread
+    InputThread(const XrDispatch& xr, XrInstance instance, XrSession session, XrActionSet actionSet,
+        const ActionRegistry& actions, XrSpace poseBaseSpace);
+    ~InputThread();
+
+    InputThread(const InputThread&) = delete;
+    InputThread& operator=(const InputThread&) = delete;
+
+    /// Starts sampling at rateHz. The thread registers itself with policies as the input role, if given, and is pinned to processor unless -1
+    void start(float rateHz, ksThreadPolicyManager* policies, int processor = -1);
+    void stop();
+    /// Takes effect from the next sample, from any thread
+    void setRate(float rateHz);
+
+    /// Called on session state changes
+    void setFocused(bool focused);
+
+    /**
+     * Called by the frame thread with the predicted display time of every frame. Used to derive
+     * the runtime time when XR_KHR_win32_convert_performance_counter_time is not enabled, in which
+     * case state block times run ahead by the display latency and poses are predicted that far.
+     */
+    void setFrameTime(XrTime predictedDisplayTime);
+
+    /// Copies the freshest state block. Returns false if none was published yet
+    bool read(ActionStateBlock& block);
+
+    /// Takes XrEventDataInteractionProfileChanged events, pushed by the thread dispatching events
+    inline ksSpscQueue* eventQueue() { return &_events; }
+
+private:
+
+    struct TimeAnchor {
+        XrTime time;
+        ksNanoseconds clock;
+    };
+
+    static void threadFunction(void* data);
+    void run();
+    bool sample();
+    void publishUnfocused();
+    XrTime now();
+
+    const XrDispatch& _xr;
+    XrInstance _instance;
+    XrSession _session;
+    XrActionSet _actionSet;
+    const ActionRegistry& _actions;
+    XrSpace _poseBaseSpace;
+    PFN_xrConvertWin32PerformanceCounterToTimeKHR _convertTime;
+
+    ksThread _thread;
+    ksThreadPolicyManager* _policies;
+    int _processor;
+    HANDLE _timer;
+    std::atomic<ksNanoseconds> _period;
+    std::atomic<bool> _stop;
+    bool _running;
+    ksSignal _wake;             // raised on focus and on stop
+
+    std::mutex _syncMutex;      // held by the input thread around its runtime calls
+    bool _focused;
+    uint64_t _sequence;
+    XrResult _syncResult;       // of the last xrSyncActions, only logged when it changes
+    uint64_t _syncFailures;
+
+    ksMailbox _states;
+    ksMailbox _timeAnchor;
+    ksSpscQueue _events;
+    ActionStateBlock _scratch;
+
+};
@@ -0,0 +1,234 @@
+#include "manifest.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+
+namespace {
+
+/**
+ * Splits a manifest line into words. Quoted words may contain spaces, '#' starts a comment.
+ * Returns false on an unterminated quote.
+ */
+bool tokenize(const std::string& line, std::vector<std::string>& words)
+{
+    words.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        if (isspace((unsigned char)line[i])) {
+            i++;
+        }
+        else if (line[i] == '#') {
+            break;
+        }
+        else if (line[i] == '"') {
+            const size_t end = line.find('"', i + 1);
+            if (end == std::string::npos) {
+                return false;
+            }
+            words.push_back(line.substr(i + 1, end - i - 1));
+            i = end + 1;
+        }
+        else {
+            size_t end = i;
+            while (end < line.size() && !isspace((unsigned char)line[end]) && line[end] != '#') {
+                end++;
+            }
+            words.push_back(line.substr(i, end - i));
+            i = end;
+        }
+    }
+    return true;
+}
+
+bool parseActionType(const std::string& word, XrActionType& type)
+{
+    static const struct { const char* name; XrActionType type; } types[] = {
+        { "boolean", XR_ACTION_TYPE_BOOLEAN_INPUT },
+        { "float", XR_ACTION_TYPE_FLOAT_INPUT },
+        { "vector2", XR_ACTION_TYPE_VECTOR2F_INPUT },
+        { "pose", XR_ACTION_TYPE_POSE_INPUT },
+        { "vibration", XR_ACTION_TYPE_VIBRATION_OUTPUT },
+    };
+    for (const auto& t : types) {
+        if (word == t.name) {
+            type = t.type;
+            return true;
+        }
+    }
+    return false;
+}
+
+XrResult suggest(XrInstance instance, XrPath profile, const std::vector<XrActionSuggestedBinding>& bindings)
+{
+    XrInteractionProfileSuggestedBinding suggested_bindings{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
+    suggested_bindings.interactionProfile = profile;
+    suggested_bindings.suggestedBindings = bindings.data();
+    suggested_bindings.countSuggestedBindings = (uint32_t)bindings.size();
+    return xrSuggestInteractionProfileBindings(instance, &suggested_bindings);
+}
+
+}
+
+
+/**
+ *  Constructor
+ */
+PathCache::PathCache(XrInstance instance) :
+    _instance(instance)
+{
+}
+
+/**
+ */
+XrPath PathCache::get(const std::string& path)
+{
+    auto it = _paths.find(path);
+    if (it != _paths.end()) {
+        return it->second;
+    }
+    XrPath xr_path = XR_NULL_PATH;
+    XrResult res = xrStringToPath(_instance, path.c_str(), &xr_path);
+    if (XR_FAILED(res)) {
+        char err_msg[XR_MAX_RESULT_STRING_SIZE];
+        xrResultToString(_instance, res, err_msg);
+        std::cerr << "ERROR: invalid path " << path << ": " << err_msg << " (" << res << ")" << std::endl;
+        throw res;
+    }
+    _paths.emplace(path, xr_path);
+    return xr_path;
+}
+
+
+/**
+ */
+ActionManifest ActionManifest::load(const std::string& fileName)
+{
+    std::ifstream file(fileName);
+    if (!file) {
+        std::cerr << "ERROR: cannot open action manifest " << fileName << std::endl;
+        throw -1;
+    }
+
+    ActionManifest manifest;
+    manifest.priority = 0;
+
+    std::string line;
+    std::vector<std::string> words;
+    int line_number = 0;
+    bool valid = true;
+    auto error = [&](const char* message) {
+        std::cerr << "ERROR: " << fileName << ":" << line_number << ": " << message << std::endl;
+        valid = false;
+    };
+
+    while (std::getline(file, line)) {
+        line_number++;
+        if (!tokenize(line, words)) {
+            error("unterminated quote");
+            continue;
+        }
+        if (words.empty()) {
+            continue;
+        }
+        const std::string& directive = words[0];
+        if (directive == "action_set" && (words.size() == 3 || words.size() == 4)) {
+            manifest.actionSetName = words[1];
+            manifest.localizedActionSetName = words[2];
+            manifest.priority = (words.size() == 4) ? (uint32_t)strtoul(words[3].c_str(), nullptr, 10) : 0;
+        }
+        else if (directive == "action" && words.size() == 4) {
+            Action action{ words[1], words[3], XR_ACTION_TYPE_BOOLEAN_INPUT };
+            if (!parseActionType(words[2], action.type)) {
+                error("unknown action type");
+                continue;
+            }
+            // The sizes include the terminating null
+            if (action.name.size() >= XR_MAX_ACTION_NAME_SIZE) {
+                error("action name too long");
+                continue;
+            }
+            if (action.localizedName.size() >= XR_MAX_LOCALIZED_ACTION_NAME_SIZE) {
+                error("localized action name too long");
+                continue;
+            }
+            manifest.actions.push_back(action);
+        }
+        else if (directive == "profile" && words.size() == 2) {
+            manifest.profiles.push_back(Profile{ words[1], {} });
+        }
+        else if (directive == "binding" && words.size() == 3) {
+            if (manifest.profiles.empty()) {
+                error("binding outside of a profile");
+                continue;
+            }
+            manifest.profiles.back().bindings.push_back(Binding{ words[1], words[2], line_number });
+        }
+        else {
+            error("syntax error");
+        }
+    }
+
+    if (manifest.actionSetName.empty()) {
+        error("no action_set");
+    }
+    if (!valid) {
+        throw -1;
+    }
+    return manifest;
+}
+
+/**
+ * Each profile takes a single xrSuggestInteractionProfileBindings call. Only when the runtime
+ * rejects a path are the bindings of that profile tried one by one to find the supported ones.
+ */
+uint32_t ActionManifest::compile(XrInstance instance, ActionRegistry& registry, PathCache& paths) const
+{
+    for (const Action& action : actions) {
+        registry.add(action.name.c_str(), action.localizedName.c_str(), action.type);
+    }
+
+    uint32_t suggested_count = 0;
+    std::vector<XrActionSuggestedBinding> bindings;
+    std::vector<XrActionSuggestedBinding> supported;
+    std::vector<const Binding*> sources;
+    for (const Profile& profile : profiles) {
+        const XrPath profile_path = paths.get(profile.path);
+
+        bindings.clear();
+        sources.clear();
+        for (const Binding& binding : profile.bindings) {
+            const XrAction action = registry.findAction(binding.action.c_str());
+            if (action == XR_NULL_HANDLE) {
+                std::cerr << "WARN: binding of unknown action " << binding.action << " (line " << binding.line << ")" << std::endl;
+                continue;
+            }
+            bindings.push_back({ action, paths.get(binding.path) });
+            sources.push_back(&binding);
+        }
+
+        XrResult res = suggest(instance, profile_path, bindings);
+        if (res == XR_ERROR_PATH_UNSUPPORTED) {
+            supported.clear();
+            for (size_t i = 0; i < bindings.size(); i++) {
+                if (XR_SUCCEEDED(suggest(instance, profile_path, { bindings[i] }))) {
+                    supported.push_back(bindings[i]);
+                }
+                else {
+                    std::cerr << "WARN: " << profile.path << " does not support " << sources[i]->path
+                        << " (line " << sources[i]->line << "), skipped" << std::endl;
+                }
+            }
+            bindings.swap(supported);
+            res = bindings.empty() ? XR_ERROR_PATH_UNSUPPORTED : suggest(instance, profile_path, bindings);
+        }
+        if (XR_FAILED(res)) {
+            std::cerr << "WARN: no bindings suggested for " << profile.path << " (" << res << ")" << std::endl;
+            continue;
+        }
+        suggested_count += (uint32_t)bindings.size();
+    }
+    return suggested_count;
+}
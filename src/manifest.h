@@ -0,0 +1,78 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "actions.h"
+
+/**
+ * Converts path strings to XrPath once and keeps the result
+ */
+class PathCache {
+
+public:
+
+    explicit PathCache(XrInstance instance);
+
+    /// Throws if the runtime rejects the path
+    XrPath get(const std::string& path);
+
+    inline size_t size() const { return _paths.size(); }
+
+private:
+
+    XrInstance _instance;
+    std::unordered_map<std::string, XrPath> _paths;
+
+};
+
+/**
+ * Action set, actions and suggested bindings per interaction profile, as read from a manifest file.
+ *
+ * One directive per line, '#' starts a comment, localized names are quoted:
+ *
+ *   action_set <name> "<localized name>" [priority]
+ *   action <name> boolean|float|vector2|pose|vibration "<localized name>"
+ *   profile <interaction profile path>
+ *   binding <action name> <input or output path>
+ *
+ * Bindings belong to the last profile before them.
+ */
+struct ActionManifest {
+
+    struct Action {
+        std::string name;
+        std::string localizedName;
+        XrActionType type;
+    };
+
+    struct Binding {
+        std::string action;
+        std::string path;
+        int line;
+    };
+
+    struct Profile {
+        std::string path;
+        std::vector<Binding> bindings;
+    };
+
+    std::string actionSetName;
+    std::string localizedActionSetName;
+    uint32_t priority;
+    std::vector<Action> actions;
+    std::vector<Profile> profiles;
+
+    /// Throws if the file cannot be read or has errors
+    static ActionManifest load(const std::string& fileName);
+
+    /**
+     * Adds the actions to the registry and suggests the bindings of every profile. Bindings the
+     * runtime does not support are skipped with a warning, as are whole profiles it does not know.
+     * Must be called before the action set is attached. Returns the number of bindings suggested.
+     */
+    uint32_t compile(XrInstance instance, ActionRegistry& registry, PathCache& paths) const;
+};
@@ -0,0 +1,188 @@
+#include "perf.h"
+
+#include <iostream>
+
+// As WorkloadLevel, with the input rate as a fraction of the configured one
+static const struct {
+    const char* name;
+    float renderScale;
+    float inputRate;
+    uint64_t readBytesPerFrame;
+} WORKLOAD_LEVELS[] = {
+    { "full", 1.0f, 1.0f, 0 },
+    { "reduced", 0.8f, 0.5f, 4 * 1024 * 1024 },
+    { "minimal", 0.6f, 0.25f, 1024 * 1024 },
+};
+static_assert(sizeof(WORKLOAD_LEVELS) / sizeof(WORKLOAD_LEVELS[0]) == PerformanceGovernor::LEVEL_COUNT, "workload level count");
+
+// Time the notifications must allow a higher workload before it is taken
+static const ksNanoseconds RECOVERY_TIME = 5000ULL * 1000 * 1000;
+
+static const char* domainName(XrPerfSettingsDomainEXT domain)
+{
+    return (domain == XR_PERF_SETTINGS_DOMAIN_CPU_EXT) ? "CPU" : "GPU";
+}
+
+static const char* subDomainName(XrPerfSettingsSubDomainEXT subDomain)
+{
+    switch (subDomain) {
+    case XR_PERF_SETTINGS_SUB_DOMAIN_COMPOSITING_EXT:
+        return "compositing";
+    case XR_PERF_SETTINGS_SUB_DOMAIN_RENDERING_EXT:
+        return "rendering";
+    case XR_PERF_SETTINGS_SUB_DOMAIN_THERMAL_EXT:
+        return "thermal";
+    default:
+        return "unknown";
+    }
+}
+
+static const char* notificationName(XrPerfSettingsNotificationLevelEXT level)
+{
+    switch (level) {
+    case XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT:
+        return "normal";
+    case XR_PERF_SETTINGS_NOTIF_LEVEL_WARNING_EXT:
+        return "warning";
+    case XR_PERF_SETTINGS_NOTIF_LEVEL_IMPAIRED_EXT:
+        return "impaired";
+    default:
+        return "unknown";
+    }
+}
+
+
+/**
+ *  Constructor
+ */
+PerformanceGovernor::PerformanceGovernor(XrInstance instance, XrSession session, float inputRateHz) :
+    _instance(instance),
+    _session(session),
+    _setLevel(nullptr),
+    _rendering(false),
+    _level(0),
+    _transitionTime(0)
+{
+    for (uint32_t i = 0; i < LEVEL_COUNT; i++) {
+        _levels[i] = { WORKLOAD_LEVELS[i].name, WORKLOAD_LEVELS[i].renderScale,
+            WORKLOAD_LEVELS[i].inputRate * inputRateHz, WORKLOAD_LEVELS[i].readBytesPerFrame };
+    }
+    for (uint32_t i = 0; i < DOMAIN_COUNT; i++) {
+        for (uint32_t j = 0; j < SUB_DOMAIN_COUNT; j++) {
+            _notifications[i][j] = XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT;
+        }
+    }
+
+    // Only available if the extension was enabled on the instance
+    if (XR_FAILED(xrGetInstanceProcAddr(_instance, "xrPerfSettingsSetPerformanceLevelEXT",
+            reinterpret_cast<PFN_xrVoidFunction*>(&_setLevel)))) {
+        _setLevel = nullptr;
+        return;
+    }
+    // Nothing is rendered before the session runs
+    setLevels(XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT);
+}
+
+/**
+ */
+const WorkloadLevel& PerformanceGovernor::level() const
+{
+    return _levels[_level];
+}
+
+/**
+ */
+void PerformanceGovernor::addListener(Listener listener)
+{
+    _listeners.push_back(std::move(listener));
+}
+
+/**
+ */
+void PerformanceGovernor::setRendering(bool rendering)
+{
+    if (rendering == _rendering || _setLevel == nullptr) {
+        return;
+    }
+    _rendering = rendering;
+    setLevels(rendering ? XR_PERF_SETTINGS_LEVEL_SUSTAINED_HIGH_EXT : XR_PERF_SETTINGS_LEVEL_POWER_SAVINGS_EXT);
+}
+
+/**
+ */
+void PerformanceGovernor::onPerfSettings(const XrEventDataPerfSettingsEXT& event)
+{
+    const uint32_t domain = (uint32_t)event.domain - 1;
+    const uint32_t sub_domain = (uint32_t)event.subDomain - 1;
+    if (domain >= DOMAIN_COUNT || sub_domain >= SUB_DOMAIN_COUNT) {
+        return;
+    }
+    std::cout << "Performance " << domainName(event.domain) << " " << subDomainName(event.subDomain) << ": "
+        << notificationName(event.fromLevel) << " -> " << notificationName(event.toLevel) << std::endl;
+    _notifications[domain][sub_domain] = event.toLevel;
+
+    // Stepping down does not wait for the next frame
+    const uint32_t target = targetLevel();
+    if (target > _level) {
+        transition(target);
+    }
+}
+
+/**
+ */
+void PerformanceGovernor::update()
+{
+    const uint32_t target = targetLevel();
+    if (target < _level && GetTimeNanoseconds() - _transitionTime >= RECOVERY_TIME) {
+        transition(_level - 1);
+    }
+}
+
+/**
+ */
+void PerformanceGovernor::setLevels(XrPerfSettingsLevelEXT level)
+{
+    for (XrPerfSettingsDomainEXT domain : { XR_PERF_SETTINGS_DOMAIN_CPU_EXT, XR_PERF_SETTINGS_DOMAIN_GPU_EXT }) {
+        const XrResult res = _setLevel(_session, domain, level);
+        if (XR_FAILED(res)) {
+            char err_msg[XR_MAX_RESULT_STRING_SIZE];
+            xrResultToString(_instance, res, err_msg);
+            std::cerr << "ERROR: xrPerfSettingsSetPerformanceLevelEXT " << domainName(domain) << ": "
+                << err_msg << " (" << res << ")" << std::endl;
+        }
+    }
+}
+
+/**
+ * Workload level allowed by the worst notification
+ */
+uint32_t PerformanceGovernor::targetLevel() const
+{
+    XrPerfSettingsNotificationLevelEXT worst = XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT;
+    for (uint32_t i = 0; i < DOMAIN_COUNT; i++) {
+        for (uint32_t j = 0; j < SUB_DOMAIN_COUNT; j++) {
+            if (_notifications[i][j] > worst) {
+                worst = _notifications[i][j];
+            }
+        }
+    }
+    switch (worst) {
+    case XR_PERF_SETTINGS_NOTIF_LEVEL_NORMAL_EXT:
+        return 0;
+    case XR_PERF_SETTINGS_NOTIF_LEVEL_WARNING_EXT:
+        return 1;
+    default:
+        return LEVEL_COUNT - 1;
+    }
+}
+
+/**
+ */
+void PerformanceGovernor::transition(uint32_t level)
+{
+    _level = level;
+    _transitionTime = GetTimeNanoseconds();
+    for (const Listener& listener : _listeners) {
+        listener(_levels[_level]);
+    }
+}
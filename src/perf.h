@@ -0,0 +1,75 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "utils/threading.h"
+
+/// What the app may spend per frame, from the full workload down
+struct WorkloadLevel {
+    const char* name;
+    float renderScale;              // of the recommended image size, per axis
+    float inputRateHz;
+    uint64_t readBytesPerFrame;     // of completed file reads resumed per frame, 0 for no limit
+};
+
+/**
+ * Sets the CPU and GPU performance levels and scales the workload on the runtime's performance
+ * notifications, with XR_EXT_performance_settings.
+ *
+ * setRendering picks the levels for the load: sustained high while frames are rendered, power
+ * savings otherwise. The notifications of every domain and sub domain are kept, and the worst of
+ * them selects the workload level: full when all are normal, one step down on a warning, two on
+ * impaired. Stepping down happens right away, stepping back up one level at a time once the
+ * notifications allowed it for a few seconds, so a recovering device is not pushed back over.
+ *
+ * Listeners are notified of every workload change, on the frame thread. Without the extension
+ * the workload stays full.
+ */
+class PerformanceGovernor {
+
+public:
+
+    typedef std::function<void(const WorkloadLevel& level)> Listener;
+
+    static const uint32_t LEVEL_COUNT = 3;
+
+    /// inputRateHz is the input sampling rate of the full workload, the lower levels take fractions of it
+    PerformanceGovernor(XrInstance instance, XrSession session, float inputRateHz);
+
+    PerformanceGovernor(const PerformanceGovernor&) = delete;
+    PerformanceGovernor& operator=(const PerformanceGovernor&) = delete;
+
+    inline bool isSupported() const { return _setLevel != nullptr; }
+    const WorkloadLevel& level() const;
+    void addListener(Listener listener);
+
+    /// Frame thread, on session state changes
+    void setRendering(bool rendering);
+    void onPerfSettings(const XrEventDataPerfSettingsEXT& event);
+    /// Frame thread, once per frame
+    void update();
+
+private:
+
+    static const uint32_t DOMAIN_COUNT = 2;         // CPU, GPU
+    static const uint32_t SUB_DOMAIN_COUNT = 3;     // compositing, rendering, thermal
+
+    void setLevels(XrPerfSettingsLevelEXT level);
+    uint32_t targetLevel() const;
+    void transition(uint32_t level);
+
+    XrInstance _instance;
+    XrSession _session;
+    PFN_xrPerfSettingsSetPerformanceLevelEXT _setLevel;
+
+    WorkloadLevel _levels[LEVEL_COUNT];
+    XrPerfSettingsNotificationLevelEXT _notifications[DOMAIN_COUNT][SUB_DOMAIN_COUNT];
+    std::vector<Listener> _listeners;
+    bool _rendering;
+    uint32_t _level;                    // index in the workload levels, 0 is full
+    ksNanoseconds _transitionTime;      // of the last workload change
+
+};
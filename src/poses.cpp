@@ -0,0 +1,78 @@
+#include "poses.h"
+
+#include <algorithm>
+
+// Velocities are gathered from the XrSpaceVelocity structures in chunks of this size
+static const uint32_t VELOCITY_CHUNK = 64;
+
+
+/**
+ */
+void posesToMatrices(const XrPosef* poses, uint32_t count, ksMatrix4x4f* matrices)
+{
+    ksMatrix4x4f_CreateFromPoses(matrices, reinterpret_cast<const ksPosef*>(poses), (int)count);
+}
+
+/**
+ */
+void posesToMatrices(const XrPosef* poses, uint32_t count, ksMatrix3x4f* transforms)
+{
+    ksMatrix3x4f_CreateFromPoses(transforms, reinterpret_cast<const ksPosef*>(poses), (int)count);
+}
+
+/**
+ */
+void predictPoses(const XrPosef* poses, const XrSpaceVelocity* velocities, uint32_t count,
+    XrTime poseTime, XrTime targetTime, XrPosef* predicted)
+{
+    const float deltaSeconds = (float)((double)(targetTime - poseTime) * 1e-9);
+    const ksPosef* src = reinterpret_cast<const ksPosef*>(poses);
+    ksPosef* dst = reinterpret_cast<ksPosef*>(predicted);
+
+    if (velocities == nullptr) {
+        if (dst != src) {
+            std::copy(src, src + count, dst);
+        }
+        return;
+    }
+
+    ksVector3f linear[VELOCITY_CHUNK];
+    ksVector3f angular[VELOCITY_CHUNK];
+    for (uint32_t base = 0; base < count; base += VELOCITY_CHUNK) {
+        const uint32_t n = std::min(VELOCITY_CHUNK, count - base);
+        bool anyLinear = false;
+        bool anyAngular = false;
+        for (uint32_t i = 0; i < n; i++) {
+            const XrSpaceVelocity& v = velocities[base + i];
+            if (v.velocityFlags & XR_SPACE_VELOCITY_LINEAR_VALID_BIT) {
+                linear[i] = { v.linearVelocity.x, v.linearVelocity.y, v.linearVelocity.z };
+                anyLinear = true;
+            }
+            else {
+                linear[i] = { 0.0f, 0.0f, 0.0f };
+            }
+            if (v.velocityFlags & XR_SPACE_VELOCITY_ANGULAR_VALID_BIT) {
+                angular[i] = { v.angularVelocity.x, v.angularVelocity.y, v.angularVelocity.z };
+                anyAngular = true;
+            }
+            else {
+                angular[i] = { 0.0f, 0.0f, 0.0f };
+            }
+        }
+        ksPosef_Predict(dst + base, src + base, anyLinear ? linear : nullptr, anyAngular ? angular : nullptr,
+            (int)n, deltaSeconds);
+    }
+}
+
+/**
+ */
+void predictPosesToMatrices(const XrPosef* poses, const XrSpaceVelocity* velocities, uint32_t count,
+    XrTime poseTime, XrTime targetTime, ksMatrix4x4f* matrices)
+{
+    XrPosef predicted[VELOCITY_CHUNK];
+    for (uint32_t base = 0; base < count; base += VELOCITY_CHUNK) {
+        const uint32_t n = std::min(VELOCITY_CHUNK, count - base);
+        predictPoses(poses + base, velocities ? velocities + base : nullptr, n, poseTime, targetTime, predicted);
+        posesToMatrices(predicted, n, matrices + base);
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstddef>
+
+#include "utils/algebra.h"
+
+// ksPosef is used as a view over XrPosef arrays, so both layouts must match
+static_assert(sizeof(ksPosef) == sizeof(XrPosef), "ksPosef must match XrPosef");
+static_assert(offsetof(ksPosef, orientation) == offsetof(XrPosef, orientation), "ksPosef must match XrPosef");
+static_assert(offsetof(ksPosef, position) == offsetof(XrPosef, position), "ksPosef must match XrPosef");
+static_assert(sizeof(ksVector3f) == sizeof(XrVector3f), "ksVector3f must match XrVector3f");
+
+/// Converts poses into translation * rotation matrices
+void posesToMatrices(const XrPosef* poses, uint32_t count, ksMatrix4x4f* matrices);
+
+/// Converts poses into row-major 3x4 transforms
+void posesToMatrices(const XrPosef* poses, uint32_t count, ksMatrix3x4f* transforms);
+
+/**
+ * Extrapolates poses located at poseTime to targetTime assuming constant linear and
+ * angular velocity. velocities may be NULL; components whose velocity valid bit is not
+ * set are left unchanged.
+ */
+void predictPoses(const XrPosef* poses, const XrSpaceVelocity* velocities, uint32_t count,
+    XrTime poseTime, XrTime targetTime, XrPosef* predicted);
+
+/// Extrapolates poses to targetTime and converts them into matrices
+void predictPosesToMatrices(const XrPosef* poses, const XrSpaceVelocity* velocities, uint32_t count,
+    XrTime poseTime, XrTime targetTime, ksMatrix4x4f* matrices);
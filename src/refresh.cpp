@@ -0,0 +1,176 @@
+#include "refresh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Lowering reacts fast, a missed frame costs more than a lower rate
+static const float LOWER_AFTER_SECONDS = 0.5f;
+static const float RAISE_AFTER_SECONDS = 5.0f;
+// Fraction of the higher rate's period that must be left to raise
+static const float RAISE_HEADROOM = 0.2f;
+// The runtime may ignore a request without any event
+static const float REQUEST_TIMEOUT_SECONDS = 2.0f;
+// Weight of the newest frame in the average
+static const int AVERAGE_SHIFT = 4;
+
+// Check result of OpenXR API calls (throws an exception in case of failure)
+#define CHK_XR(cmd) \
+{ \
+    XrResult res = cmd; \
+    char err_msg[XR_MAX_RESULT_STRING_SIZE]; \
+    if (XR_SUCCEEDED(res)) { \
+        if (res != XR_SUCCESS) { \
+            xrResultToString(_instance, res, err_msg); \
+            std::cerr << "WARN: " << err_msg << " (" << res << ")" << std::endl; \
+        } \
+    } \
+    else { \
+        xrResultToString(_instance, res, err_msg); \
+        std::cerr << "ERROR: " << err_msg << " (" << res << ") - " << __FILE__ << ":" << __LINE__ << std::endl; \
+        throw res; \
+    } \
+}
+
+
+/**
+ *  Constructor
+ */
+RefreshRateController::RefreshRateController(XrInstance instance, XrSession session) :
+    _instance(instance),
+    _session(session),
+    _requestRate(nullptr),
+    _index(0),
+    _rate(0.0f)
+{
+    restart();
+
+    // Only available if the extension was enabled on the instance
+    PFN_xrEnumerateDisplayRefreshRatesFB enumerate_rates = nullptr;
+    PFN_xrGetDisplayRefreshRateFB get_rate = nullptr;
+    if (XR_FAILED(xrGetInstanceProcAddr(_instance, "xrEnumerateDisplayRefreshRatesFB",
+            reinterpret_cast<PFN_xrVoidFunction*>(&enumerate_rates))) ||
+        XR_FAILED(xrGetInstanceProcAddr(_instance, "xrGetDisplayRefreshRateFB",
+            reinterpret_cast<PFN_xrVoidFunction*>(&get_rate))) ||
+        XR_FAILED(xrGetInstanceProcAddr(_instance, "xrRequestDisplayRefreshRateFB",
+            reinterpret_cast<PFN_xrVoidFunction*>(&_requestRate)))) {
+        _requestRate = nullptr;
+        return;
+    }
+
+    uint32_t count = 0;
+    CHK_XR(enumerate_rates(_session, 0, &count, nullptr));
+    _rates.resize(count);
+    CHK_XR(enumerate_rates(_session, count, &count, _rates.data()));
+    _rates.resize(count);
+    std::sort(_rates.begin(), _rates.end());
+    if (_rates.empty()) {
+        return;
+    }
+
+    float rate = 0.0f;
+    CHK_XR(get_rate(_session, &rate));
+    XrEventDataDisplayRefreshRateChangedFB event{ XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB };
+    event.toDisplayRefreshRate = rate;
+    onRateChanged(event);
+
+    std::cout << "Display refresh rates:";
+    for (float r : _rates) {
+        std::cout << " " << r;
+    }
+    std::cout << " Hz, running at " << _rate << " Hz" << std::endl;
+}
+
+/**
+ */
+void RefreshRateController::addListener(Listener listener)
+{
+    _listeners.push_back(std::move(listener));
+}
+
+/**
+ */
+void RefreshRateController::update(ksNanoseconds cpuTime, ksNanoseconds gpuTime)
+{
+    if (_rates.size() < 2 || _rate <= 0.0f) {
+        return;
+    }
+
+    const ksNanoseconds frame_time = std::max(cpuTime, gpuTime);
+    _average = (_average == 0) ? frame_time :
+        (ksNanoseconds)((int64_t)_average + ((int64_t)frame_time - (int64_t)_average) / (1 << AVERAGE_SHIFT));
+
+    if (_pendingFrames > 0) {
+        if (++_pendingFrames > framesFor(REQUEST_TIMEOUT_SECONDS)) {
+            std::cerr << "WARN: display refresh rate request ignored by the runtime" << std::endl;
+            restart();
+        }
+        return;
+    }
+
+    const ksNanoseconds period = (ksNanoseconds)(1e9f / _rate);
+    _overFrames = (_average > period) ? _overFrames + 1 : 0;
+    if (_index + 1 < _rates.size()) {
+        const ksNanoseconds higher_period = (ksNanoseconds)(1e9f / _rates[_index + 1]);
+        _underFrames = (_average < (ksNanoseconds)((1.0f - RAISE_HEADROOM) * higher_period)) ? _underFrames + 1 : 0;
+    }
+
+    if (_index > 0 && _overFrames >= framesFor(LOWER_AFTER_SECONDS)) {
+        request(_index - 1);
+    }
+    else if (_index + 1 < _rates.size() && _underFrames >= framesFor(RAISE_AFTER_SECONDS)) {
+        request(_index + 1);
+    }
+}
+
+/**
+ */
+void RefreshRateController::onRateChanged(const XrEventDataDisplayRefreshRateChangedFB& event)
+{
+    _rate = event.toDisplayRefreshRate;
+    _index = 0;
+    for (uint32_t i = 1; i < _rates.size(); i++) {
+        if (std::fabs(_rates[i] - _rate) < std::fabs(_rates[_index] - _rate)) {
+            _index = i;
+        }
+    }
+    // Frame times measured at the previous rate say little about the new one
+    restart();
+    for (const Listener& listener : _listeners) {
+        listener(_rate);
+    }
+}
+
+/**
+ */
+void RefreshRateController::request(uint32_t index)
+{
+    std::cout << "Requesting display refresh rate " << _rates[index] << " Hz, average frame time "
+        << _average / 1000 << " us at " << _rate << " Hz" << std::endl;
+    const XrResult res = _requestRate(_session, _rates[index]);
+    if (XR_FAILED(res)) {
+        char err_msg[XR_MAX_RESULT_STRING_SIZE];
+        xrResultToString(_instance, res, err_msg);
+        std::cerr << "ERROR: xrRequestDisplayRefreshRateFB: " << err_msg << " (" << res << ")" << std::endl;
+        restart();
+        return;
+    }
+    _pendingFrames = 1;
+}
+
+/**
+ */
+void RefreshRateController::restart()
+{
+    _average = 0;
+    _overFrames = 0;
+    _underFrames = 0;
+    _pendingFrames = 0;
+}
+
+/**
+ */
+uint32_t RefreshRateController::framesFor(float seconds) const
+{
+    return (uint32_t)(seconds * _rate);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "utils/threading.h"
+
+/**
+ * Picks the display refresh rate from the frame times, with XR_FB_display_refresh_rate.
+ *
+ * update takes the CPU and GPU time of every rendered frame. The slower of both is averaged and
+ * compared with the frame period: when the average stays over the period the next lower rate is
+ * requested, when it stays well under the period of the next higher rate that one is requested.
+ * Lowering reacts within half a second, raising needs seconds of headroom and a margin, so the
+ * rate does not flip back and forth around a threshold. Nothing is requested while a request
+ * has not been answered by a rate change.
+ *
+ * The rate only changes on the change event, passed to onRateChanged, which notifies the
+ * listeners with the new rate. Without the extension the controller is inert.
+ */
+class RefreshRateController {
+
+public:
+
+    typedef std::function<void(float rateHz)> Listener;
+
+    RefreshRateController(XrInstance instance, XrSession session);
+
+    RefreshRateController(const RefreshRateController&) = delete;
+    RefreshRateController& operator=(const RefreshRateController&) = delete;
+
+    inline bool isSupported() const { return !_rates.empty(); }
+    /// Current rate in Hz, 0 if unknown
+    inline float rate() const { return _rate; }
+    /// Called on every rate change, on the thread calling onRateChanged
+    void addListener(Listener listener);
+
+    /// Frame thread, once per rendered frame. gpuTime may be 0 if not measured
+    void update(ksNanoseconds cpuTime, ksNanoseconds gpuTime);
+    void onRateChanged(const XrEventDataDisplayRefreshRateChangedFB& event);
+
+private:
+
+    void request(uint32_t index);
+    void restart();
+    uint32_t framesFor(float seconds) const;
+
+    XrInstance _instance;
+    XrSession _session;
+    PFN_xrRequestDisplayRefreshRateFB _requestRate;
+
+    std::vector<float> _rates;          // ascending
+    std::vector<Listener> _listeners;
+    uint32_t _index;                    // of the current rate in _rates
+    float _rate;
+
+    ksNanoseconds _average;             // of the slower of CPU and GPU time, 0 until the first frame
+    uint32_t _overFrames;               // consecutive frames the average was over the period
+    uint32_t _underFrames;              // consecutive frames the average fit the next higher rate
+    uint32_t _pendingFrames;            // since the unanswered request, 0 if none
+
+};
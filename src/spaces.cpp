@@ -0,0 +1,152 @@
+#include "spaces.h"
+#include "poses.h"
+
+#include <cstring>
+#include <iostream>
+
+
+/**
+ */
+void PoseHistory::push(XrTime time, XrSpaceLocationFlags locationFlag, const XrPosef& pose,
+    XrSpaceVelocityFlags velocityFlag, const XrVector3f& linearVelocity, const XrVector3f& angularVelocity)
+{
+    const XrSpaceLocationFlags valid = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_POSITION_VALID_BIT;
+    if ((locationFlag & valid) != valid) {
+        invalid++;
+        return;
+    }
+    if (written > 0 && time <= newestTime()) {
+        return;
+    }
+    const uint32_t i = (uint32_t)written & MASK;
+    times[i] = time;
+    locationFlags[i] = locationFlag;
+    orientations[i] = pose.orientation;
+    positions[i] = pose.position;
+    velocityFlags[i] = velocityFlag;
+    linearVelocities[i] = linearVelocity;
+    angularVelocities[i] = angularVelocity;
+    written++;
+}
+
+/**
+ * Queries are mostly for recent times, so the search walks back from the newest sample
+ */
+bool PoseHistory::sample(XrTime time, XrPosef& pose) const
+{
+    const uint32_t n = count();
+    if (n == 0) {
+        return false;
+    }
+
+    const uint32_t newest = recent(0);
+    if (time >= times[newest]) {
+        XrSpaceVelocity velocity{ XR_TYPE_SPACE_VELOCITY };
+        velocity.velocityFlags = velocityFlags[newest];
+        velocity.linearVelocity = linearVelocities[newest];
+        velocity.angularVelocity = angularVelocities[newest];
+        const XrPosef last = { orientations[newest], positions[newest] };
+        predictPoses(&last, &velocity, 1, times[newest], time, &pose);
+        return true;
+    }
+
+    for (uint32_t k = 1; k < n; k++) {
+        const uint32_t before = recent(k);
+        if (times[before] <= time) {
+            const uint32_t after = recent(k - 1);
+            const float fraction = (float)((double)(time - times[before]) / (double)(times[after] - times[before]));
+            ksQuatf_Lerp(reinterpret_cast<ksQuatf*>(&pose.orientation), reinterpret_cast<const ksQuatf*>(&orientations[before]),
+                reinterpret_cast<const ksQuatf*>(&orientations[after]), fraction);
+            ksVector3f_Lerp(reinterpret_cast<ksVector3f*>(&pose.position), reinterpret_cast<const ksVector3f*>(&positions[before]),
+                reinterpret_cast<const ksVector3f*>(&positions[after]), fraction);
+            return true;
+        }
+    }
+
+    const uint32_t oldest = recent(n - 1);
+    pose.orientation = orientations[oldest];
+    pose.position = positions[oldest];
+    return true;
+}
+
+
+/**
+ *  Constructor
+ */
+SpaceTracker::SpaceTracker(const XrDispatch& xr, XrInstance instance, XrSession session, XrSpace baseSpace) :
+    _xr(xr),
+    _instance(instance),
+    _session(session),
+    _baseSpace(baseSpace)
+{
+    std::cout << "Space tracking: " << (isBatched() ? "xrLocateSpacesKHR" : "xrLocateSpace per space") << std::endl;
+}
+
+/**
+ */
+uint32_t SpaceTracker::add(XrSpace space, const std::string& name)
+{
+    _spaces.push_back(space);
+    _names.push_back(name);
+    _histories.emplace_back();      // value-initialized, so empty
+#if defined(XR_KHR_locate_spaces)
+    _locations.push_back({ 0, { { 0.0f, 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } } });
+    _velocities.push_back({ 0, { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } });
+#endif
+    return (uint32_t)_spaces.size() - 1;
+}
+
+/**
+ */
+void SpaceTracker::locate(XrTime time)
+{
+    XrResult res;
+#if defined(XR_KHR_locate_spaces)
+    if (_xr.LocateSpacesKHR != nullptr && !_spaces.empty()) {
+        XrSpacesLocateInfoKHR locate_info{ XR_TYPE_SPACES_LOCATE_INFO_KHR };
+        locate_info.baseSpace = _baseSpace;
+        locate_info.time = time;
+        locate_info.spaceCount = (uint32_t)_spaces.size();
+        locate_info.spaces = _spaces.data();
+
+        XrSpaceVelocitiesKHR velocities{ XR_TYPE_SPACE_VELOCITIES_KHR };
+        velocities.velocityCount = (uint32_t)_velocities.size();
+        velocities.velocities = _velocities.data();
+        XrSpaceLocationsKHR locations{ XR_TYPE_SPACE_LOCATIONS_KHR };
+        locations.next = &velocities;
+        locations.locationCount = (uint32_t)_locations.size();
+        locations.locations = _locations.data();
+
+        if (XR_FAILED(res = _xr.LocateSpacesKHR(_session, &locate_info, &locations))) {
+            reportFailure(res, "xrLocateSpacesKHR");
+            return;
+        }
+        for (size_t i = 0; i < _spaces.size(); i++) {
+            _histories[i].push(time, _locations[i].locationFlags, _locations[i].pose,
+                _velocities[i].velocityFlags, _velocities[i].linearVelocity, _velocities[i].angularVelocity);
+        }
+        return;
+    }
+#endif
+
+    for (size_t i = 0; i < _spaces.size(); i++) {
+        XrSpaceVelocity velocity{ XR_TYPE_SPACE_VELOCITY };
+        XrSpaceLocation location{ XR_TYPE_SPACE_LOCATION };
+        location.next = &velocity;
+        if (XR_FAILED(res = _xr.LocateSpace(_spaces[i], _baseSpace, time, &location))) {
+            reportFailure(res, "xrLocateSpace");
+            continue;
+        }
+        _histories[i].push(time, location.locationFlags, location.pose,
+            velocity.velocityFlags, velocity.linearVelocity, velocity.angularVelocity);
+    }
+}
+
+/**
+ */
+void SpaceTracker::reportFailure(XrResult res, const char* call) const
+{
+    char err_msg[XR_MAX_RESULT_STRING_SIZE];
+    xrResultToString(_instance, res, err_msg);
+    std::cerr << "ERROR: " << call << ": " << err_msg << " (" << res << ")" << std::endl;
+}
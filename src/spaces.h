@@ -0,0 +1,94 @@
+#pragma once
+
+#include <openxr/openxr.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dispatch.h"
+
+/**
+ * Fixed-size ring of the located poses of one space, the oldest overwritten first. Kept as
+ * a structure of arrays, so searching by time only walks the timestamps.
+ * Only samples with both a valid orientation and position are recorded.
+ */
+struct PoseHistory {
+    static const uint32_t SIZE = 64;            // power of two
+    static const uint32_t MASK = SIZE - 1;
+
+    uint64_t written;                           // samples recorded so far, the next one goes at written & MASK
+    uint64_t invalid;                           // locations dropped because the space was not tracked
+    XrTime times[SIZE];
+    XrSpaceLocationFlags locationFlags[SIZE];
+    XrQuaternionf orientations[SIZE];
+    XrVector3f positions[SIZE];
+    XrSpaceVelocityFlags velocityFlags[SIZE];
+    XrVector3f linearVelocities[SIZE];
+    XrVector3f angularVelocities[SIZE];
+
+    uint32_t count() const { return (written < SIZE) ? (uint32_t)written : SIZE; }
+    /// Ring index of the i-th most recent sample, 0 being the newest
+    uint32_t recent(uint32_t i) const { return (uint32_t)(written - 1 - i) & MASK; }
+    XrTime newestTime() const { return (written > 0) ? times[recent(0)] : 0; }
+    XrTime oldestTime() const { return (written > 0) ? times[recent(count() - 1)] : 0; }
+
+    /// Records a location, ignored if not valid or not newer than the newest sample
+    void push(XrTime time, XrSpaceLocationFlags locationFlag, const XrPosef& pose,
+        XrSpaceVelocityFlags velocityFlag, const XrVector3f& linearVelocity, const XrVector3f& angularVelocity);
+
+    /**
+     * Pose at time. Between two samples it is interpolated, after the newest one it is
+     * extrapolated with the newest velocities, and before the oldest one it is the oldest pose.
+     * Returns false if there are no samples.
+     */
+    bool sample(XrTime time, XrPosef& pose) const;
+};
+
+/**
+ * Locates a set of spaces relative to a base space once per frame, in a single
+ * xrLocateSpacesKHR call when XR_KHR_locate_spaces is enabled and with one xrLocateSpace
+ * call per space otherwise. Every space gets a PoseHistory.
+ * The spaces and the dispatch table are not owned: they must outlive the tracker.
+ */
+class SpaceTracker {
+
+public:
+
+    SpaceTracker(const XrDispatch& xr, XrInstance instance, XrSession session, XrSpace baseSpace);
+
+    SpaceTracker(const SpaceTracker&) = delete;
+    SpaceTracker& operator=(const SpaceTracker&) = delete;
+
+    /// Returns the index of the space
+    uint32_t add(XrSpace space, const std::string& name);
+
+    /// Locates every space at time and records the results. Failures are reported, not thrown
+    void locate(XrTime time);
+
+    inline uint32_t count() const { return (uint32_t)_spaces.size(); }
+    inline const std::string& name(uint32_t index) const { return _names[index]; }
+    inline const PoseHistory& history(uint32_t index) const { return _histories[index]; }
+#if defined(XR_KHR_locate_spaces)
+    inline bool isBatched() const { return _xr.LocateSpacesKHR != nullptr; }
+#else
+    inline bool isBatched() const { return false; }
+#endif
+
+private:
+
+    void reportFailure(XrResult res, const char* call) const;
+
+    const XrDispatch& _xr;
+    XrInstance _instance;
+    XrSession _session;
+    XrSpace _baseSpace;
+#if defined(XR_KHR_locate_spaces)
+    std::vector<XrSpaceLocationDataKHR> _locations;
+    std::vector<XrSpaceVelocityDataKHR> _velocities;
+#endif
+
+    std::vector<XrSpace> _spaces;
+    std::vector<std::string> _names;
+    std::vector<PoseHistory> _histories;
+
+};
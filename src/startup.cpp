@@ -0,0 +1,135 @@
+#include "startup.h"
+
+#include <iomanip>
+#include <iostream>
+
+
+/**
+ *  Constructor
+ */
+StartupScheduler::StartupScheduler(ksJobSystem* jobSystem) :
+    _jobSystem(jobSystem),
+    _startTime(0),
+    _endTime(0),
+    _running(0),
+    _finished(0)
+{
+}
+
+/**
+ */
+StartupScheduler::Step StartupScheduler::add(const char* name, Thread thread, std::function<void()> function,
+    std::initializer_list<Step> after)
+{
+    const Step step = (Step)_steps.size();
+    _steps.push_back(StepInfo{ this, name, thread, std::move(function), {}, (uint32_t)after.size(), 0, 0 });
+    for (Step before : after) {
+        _steps[before].dependents.push_back(step);
+    }
+    return step;
+}
+
+/**
+ */
+void StartupScheduler::run()
+{
+    _startTime = GetTimeNanoseconds();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (Step step = 0; step < (Step)_steps.size(); step++) {
+        if (_steps[step].waitCount == 0) {
+            release(step);
+        }
+    }
+
+    while (true) {
+        _changed.wait(lock, [this] { return !_mainThreadSteps.empty() || _running == 0; });
+        if (_mainThreadSteps.empty()) {
+            break;
+        }
+        const Step step = _mainThreadSteps.back();
+        _mainThreadSteps.pop_back();
+        lock.unlock();
+        execute(_steps[step]);
+        lock.lock();
+    }
+    _endTime = GetTimeNanoseconds();
+
+    if (_error) {
+        std::rethrow_exception(_error);
+    }
+    if (_finished != _steps.size()) {
+        std::cerr << "ERROR: " << _steps.size() - _finished << " startup steps never became ready" << std::endl;
+        throw -1;
+    }
+}
+
+/**
+ */
+void StartupScheduler::release(Step step)
+{
+    _running++;
+    if (_steps[step].thread == MAIN_THREAD) {
+        _mainThreadSteps.push_back(step);
+        _changed.notify_all();
+    }
+    else {
+        ksJobSystem_Submit(_jobSystem, runJob, &_steps[step], NULL);
+    }
+}
+
+/**
+ */
+void StartupScheduler::runJob(void* data)
+{
+    StepInfo* step = static_cast<StepInfo*>(data);
+    step->scheduler->execute(*step);
+}
+
+/**
+ * Releases the dependents of the step once it finished, unless a step failed
+ */
+void StartupScheduler::execute(StepInfo& step)
+{
+    std::exception_ptr error;
+    step.start = GetTimeNanoseconds();
+    try {
+        step.function();
+    }
+    catch (...) {
+        error = std::current_exception();
+    }
+    step.end = GetTimeNanoseconds();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (error && !_error) {
+        std::cerr << "ERROR: startup step " << step.name << " failed" << std::endl;
+        _error = error;
+    }
+    if (!_error) {
+        for (Step dependent : step.dependents) {
+            if (--_steps[dependent].waitCount == 0) {
+                release(dependent);
+            }
+        }
+    }
+    _finished++;
+    _running--;
+    _changed.notify_all();
+}
+
+/**
+ */
+void StartupScheduler::report() const
+{
+    ksNanoseconds busy = 0;
+    std::cout << "Startup steps (start, duration in ms):" << std::endl;
+    for (const StepInfo& step : _steps) {
+        busy += step.end - step.start;
+        std::cout << "  " << std::left << std::setw(20) << step.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(9) << (step.start - _startTime) * 1e-6 << std::setw(9) << (step.end - step.start) * 1e-6
+            << ((step.thread == MAIN_THREAD) ? "  main" : "") << std::endl;
+    }
+    std::cout << "Startup took " << (_endTime - _startTime) * 1e-6 << " ms for " << busy * 1e-6 << " ms of steps"
+        << std::defaultfloat << std::endl;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils/threading.h"
+
+/**
+ * Runs initialization steps as a dependency graph. A step starts once every step it comes
+ * after finished: on a job system worker, or on the thread calling run for steps bound to
+ * that thread (anything that needs the GL context or owns a window).
+ * Every step is timed, report prints when each ran and for how long.
+ */
+class StartupScheduler {
+
+public:
+
+    typedef uint32_t Step;
+
+    enum Thread {
+        ANY_THREAD,
+        MAIN_THREAD         // the thread calling run
+    };
+
+    explicit StartupScheduler(ksJobSystem* jobSystem);
+
+    StartupScheduler(const StartupScheduler&) = delete;
+    StartupScheduler& operator=(const StartupScheduler&) = delete;
+
+    /// Steps can only come after steps added before them, so the graph has no cycles
+    Step add(const char* name, Thread thread, std::function<void()> function, std::initializer_list<Step> after = {});
+
+    /**
+     * Runs every step and returns once all finished. If a step throws, no further steps are
+     * started and the exception is rethrown once the running ones finished.
+     */
+    void run();
+
+    /// Prints the start time and duration of every step
+    void report() const;
+
+    inline ksNanoseconds getStartTime() const { return _startTime; }
+
+private:
+
+    struct StepInfo {
+        StartupScheduler* scheduler;
+        std::string name;
+        Thread thread;
+        std::function<void()> function;
+        std::vector<Step> dependents;
+        uint32_t waitCount;         // unfinished steps it comes after
+        ksNanoseconds start;
+        ksNanoseconds end;
+    };
+
+    static void runJob(void* data);
+    void execute(StepInfo& step);
+    void release(Step step);        // with _mutex locked
+
+    ksJobSystem* _jobSystem;
+    std::vector<StepInfo> _steps;
+    ksNanoseconds _startTime;
+    ksNanoseconds _endTime;
+
+    std::mutex _mutex;
+    std::condition_variable _changed;
+    std::vector<Step> _mainThreadSteps;    // ready to run on the main thread
+    uint32_t _running;                     // released and not finished yet
+    uint32_t _finished;
+    std::exception_ptr _error;
+
+};
@@ -0,0 +1,240 @@
+#include "tasks.h"
+
+#include "gfxwrapper_opengl.h"
+
+#include <algorithm>
+#include <iostream>
+
+
+namespace {
+
+/**
+ * Hops onto a worker and runs the task to completion. The coroutine frame of this function
+ * keeps the task alive and frees both once the task completes.
+ */
+detail::DetachedTask runDetached(TaskScheduler& scheduler, Task<void> task)
+{
+    co_await scheduler.schedule();
+    try {
+        co_await task;
+    }
+    catch (...) {
+        std::cerr << "ERROR: unhandled exception in spawned task" << std::endl;
+    }
+}
+
+}
+
+
+/**
+ */
+void TaskScheduler::ScheduleAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    _scheduler->resume(handle);
+}
+
+/**
+ */
+void TaskScheduler::NextFrameAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(_scheduler->_mutex);
+    _scheduler->_nextFrameWaiters.push_back(handle);
+}
+
+/**
+ */
+void TaskScheduler::GLFenceAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    _handle = handle;
+    std::lock_guard<std::mutex> lock(_scheduler->_mutex);
+    _scheduler->_fenceWaiters.push_back(this);
+}
+
+/**
+ * Opens the file and starts the read. Does not suspend if this already failed or the
+ * read completed synchronously.
+ */
+bool TaskScheduler::FileReadAwaiter::await_ready()
+{
+    _succeeded = false;
+    _file = CreateFileA(_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (_file == INVALID_HANDLE_VALUE) {
+        std::cerr << "ERROR: cannot open " << _path << std::endl;
+        return true;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size) || size.QuadPart > MAXDWORD) {
+        std::cerr << "ERROR: cannot read " << _path << " (too large?)" << std::endl;
+        return true;
+    }
+    _data.resize((size_t)size.QuadPart);
+    if (_data.empty()) {
+        _succeeded = true;
+        return true;
+    }
+
+    ZeroMemory(&_overlapped, sizeof(_overlapped));
+    if (ReadFile(_file, _data.data(), (DWORD)_data.size(), NULL, &_overlapped)) {
+        _succeeded = true;
+        return true;
+    }
+    if (GetLastError() != ERROR_IO_PENDING) {
+        std::cerr << "ERROR: cannot read " << _path << std::endl;
+        return true;
+    }
+    return false;
+}
+
+/**
+ */
+void TaskScheduler::FileReadAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    _handle = handle;
+    std::lock_guard<std::mutex> lock(_scheduler->_mutex);
+    _scheduler->_readWaiters.push_back(this);
+}
+
+/**
+ */
+std::optional<std::vector<uint8_t> > TaskScheduler::FileReadAwaiter::await_resume()
+{
+    if (_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+    if (!_succeeded) {
+        return std::nullopt;
+    }
+    return std::move(_data);
+}
+
+/**
+ */
+void TaskScheduler::JobGroupAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    // The job system holds the continuation and submits it when the counter reaches zero
+    ksJobSystem_SubmitAfter(&_scheduler->_jobSystem, _counter, resumeJob, handle.address(), NULL);
+}
+
+
+/**
+ */
+TaskScheduler::TaskScheduler(ksThreadPolicyManager* policies, int workerThreads) :
+    _frameIndex(0),
+    _readBudget(0)
+{
+    ksJobSystem_Create(&_jobSystem, workerThreads, policies);
+    // The frame thread only runs jobs while it waits, so tasks need at least one worker to make progress
+    if (ksJobSystem_GetThreadCount(&_jobSystem) < 2) {
+        ksJobSystem_Destroy(&_jobSystem);
+        ksJobSystem_Create(&_jobSystem, 1, policies);
+    }
+}
+
+/**
+ */
+TaskScheduler::~TaskScheduler()
+{
+    ksJobSystem_Destroy(&_jobSystem);
+}
+
+/**
+ */
+void TaskScheduler::spawn(Task<void> task)
+{
+    runDetached(*this, std::move(task));
+}
+
+/**
+ */
+void TaskScheduler::beginFrame()
+{
+    _frameIndex++;
+
+    _resumeList.clear();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::swap(_resumeList, _nextFrameWaiters);
+    }
+    for (std::coroutine_handle<> handle : _resumeList) {
+        resume(handle);
+    }
+
+    pollFences();
+    pollReads();
+}
+
+/**
+ */
+void TaskScheduler::setReadBudget(uint64_t bytesPerFrame)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _readBudget = bytesPerFrame;
+}
+
+/**
+ */
+TaskScheduler::FileReadAwaiter TaskScheduler::readFile(const std::string& path)
+{
+    return FileReadAwaiter{ this, path, INVALID_HANDLE_VALUE, {}, {}, false, {} };
+}
+
+/**
+ */
+void TaskScheduler::resumeJob(void* data)
+{
+    std::coroutine_handle<>::from_address(data).resume();
+}
+
+/**
+ */
+void TaskScheduler::resume(std::coroutine_handle<> handle)
+{
+    ksJobSystem_Submit(&_jobSystem, resumeJob, handle.address(), NULL);
+}
+
+/**
+ * Must run on the thread that owns the GL context
+ */
+void TaskScheduler::pollFences()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto signalled = std::partition(_fenceWaiters.begin(), _fenceWaiters.end(), [](GLFenceAwaiter* waiter) {
+        const GLenum status = glClientWaitSync(waiter->_fence, 0, 0);
+        return status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED && status != GL_WAIT_FAILED;
+    });
+    for (auto it = signalled; it != _fenceWaiters.end(); ++it) {
+        resume((*it)->_handle);
+    }
+    _fenceWaiters.erase(signalled, _fenceWaiters.end());
+}
+
+/**
+ */
+void TaskScheduler::pollReads()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto completed = std::partition(_readWaiters.begin(), _readWaiters.end(), [](FileReadAwaiter* waiter) {
+        return !HasOverlappedIoCompleted(&waiter->_overlapped);
+    });
+    // Reads over the budget stay completed until the next frame
+    uint64_t budget_used = 0;
+    auto it = completed;
+    for (; it != _readWaiters.end(); ++it) {
+        FileReadAwaiter* waiter = *it;
+        if (_readBudget != 0 && it != completed && budget_used + waiter->_data.size() > _readBudget) {
+            break;
+        }
+        budget_used += waiter->_data.size();
+        DWORD bytes = 0;
+        waiter->_succeeded = GetOverlappedResult(waiter->_file, &waiter->_overlapped, &bytes, FALSE) &&
+            bytes == waiter->_data.size();
+        if (!waiter->_succeeded) {
+            std::cerr << "ERROR: cannot read " << waiter->_path << std::endl;
+        }
+        resume(waiter->_handle);
+    }
+    _readWaiters.erase(completed, it);
+}
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <windows.h>
+
+#include "utils/threading.h"
+
+typedef struct __GLsync *GLsync;    // as declared by glext.h
+
+class TaskScheduler;
+template <typename T = void> class Task;
+
+namespace detail {
+
+struct TaskPromiseBase {
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            // Continue with the awaiting coroutine on this thread, without growing the stack
+            std::coroutine_handle<> continuation = handle.promise()._continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { _exception = std::current_exception(); }
+
+    std::coroutine_handle<> _continuation;
+    std::exception_ptr _exception;
+};
+
+template <typename T>
+struct TaskPromise : TaskPromiseBase {
+    Task<T> get_return_object();
+    void return_value(T value) { _value = std::move(value); }
+    T result()
+    {
+        if (_exception) {
+            std::rethrow_exception(_exception);
+        }
+        return std::move(*_value);
+    }
+
+    std::optional<T> _value;
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result()
+    {
+        if (_exception) {
+            std::rethrow_exception(_exception);
+        }
+    }
+};
+
+/// Coroutine that starts right away and frees itself when it completes
+struct DetachedTask {
+    struct promise_type {
+        DetachedTask get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+}
+
+/**
+ * Coroutine that produces a T.
+ * A task starts suspended and runs when another task awaits it (co_await) or when it is handed to
+ * TaskScheduler::spawn. Exceptions thrown by the task are rethrown in the awaiting task.
+ */
+template <typename T>
+class Task {
+
+public:
+
+    using promise_type = detail::TaskPromise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+    Task(Task&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task()
+    {
+        if (_handle) {
+            _handle.destroy();
+        }
+    }
+
+    /// Starts the task and resumes the awaiting coroutine with its result once it completes
+    auto operator co_await() noexcept
+    {
+        struct Awaiter {
+            bool await_ready() noexcept { return !_handle || _handle.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                _handle.promise()._continuation = awaiting;
+                return _handle;
+            }
+            T await_resume() { return _handle.promise().result(); }
+
+            std::coroutine_handle<promise_type> _handle;
+        };
+        return Awaiter{ _handle };
+    }
+
+private:
+
+    std::coroutine_handle<promise_type> _handle;
+
+};
+
+template <typename T>
+Task<T> detail::TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T> >::from_promise(*this));
+}
+
+inline Task<void> detail::TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void> >::from_promise(*this));
+}
+
+/**
+ * Runs tasks on the worker threads of a ksJobSystem.
+ *
+ * A suspended task is only a coroutine frame on one of the wait lists below, it holds no thread.
+ * Awaitables that complete asynchronously hand the task back to the job system when they complete.
+ * Next frame waits, GL fences and file reads are checked by beginFrame, so they resume at most one
+ * frame late. Job groups resume as soon as their last job finishes.
+ *
+ * The scheduler must be created and driven by the frame thread, which owns the GL context and runs
+ * as worker 0 of the job system. Spawned tasks must have completed before it is destroyed.
+ */
+class TaskScheduler {
+
+public:
+
+    /// Continues the awaiting task on a worker thread
+    struct ScheduleAwaiter {
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() noexcept {}
+
+        TaskScheduler* _scheduler;
+    };
+
+    /// Resumes the awaiting task on a worker thread after the next call to beginFrame
+    struct NextFrameAwaiter {
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() noexcept {}
+
+        TaskScheduler* _scheduler;
+    };
+
+    /// Resumes the awaiting task on a worker thread once the GPU passed the fence, which must have been flushed
+    struct GLFenceAwaiter {
+        bool await_ready() noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() noexcept {}
+
+        TaskScheduler* _scheduler;
+        GLsync _fence;
+        std::coroutine_handle<> _handle;
+    };
+
+    /**
+     * Reads a whole file with overlapped I/O and resumes the awaiting task on a worker thread once
+     * the read completed. Yields the contents, or nothing if the file could not be read.
+     */
+    struct FileReadAwaiter {
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> handle);
+        std::optional<std::vector<uint8_t> > await_resume();
+
+        TaskScheduler* _scheduler;
+        std::string _path;
+        HANDLE _file;
+        OVERLAPPED _overlapped;
+        std::vector<uint8_t> _data;
+        bool _succeeded;
+        std::coroutine_handle<> _handle;
+    };
+
+    /// Resumes the awaiting task on a worker thread once all jobs submitted with the counter finished
+    struct JobGroupAwaiter {
+        bool await_ready() noexcept { return ksJobCounter_IsDone(_counter); }
+        void await_suspend(std::coroutine_handle<> handle);
+        void await_resume() noexcept {}
+
+        TaskScheduler* _scheduler;
+        ksJobCounter* _counter;
+    };
+
+    /// A negative workerThreads sizes the pool from the CPU topology, with at least one worker.
+    /// The workers register with the policy manager, if any
+    explicit TaskScheduler(ksThreadPolicyManager* policies, int workerThreads = -1);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /// Starts the task on a worker thread and lets it run to completion on its own
+    void spawn(Task<void> task);
+
+    /// Called by the frame thread once per frame. Resumes next frame waiters, signalled fences and completed reads
+    void beginFrame();
+    /// Bytes of completed file reads resumed per frame, at least one read. 0 for no limit
+    void setReadBudget(uint64_t bytesPerFrame);
+
+    ScheduleAwaiter schedule() { return ScheduleAwaiter{ this }; }
+    NextFrameAwaiter nextFrame() { return NextFrameAwaiter{ this }; }
+    GLFenceAwaiter glFence(GLsync fence) { return GLFenceAwaiter{ this, fence, {} }; }
+    FileReadAwaiter readFile(const std::string& path);
+    JobGroupAwaiter jobGroup(ksJobCounter* counter) { return JobGroupAwaiter{ this, counter }; }
+
+    inline ksJobSystem* getJobSystem() { return &_jobSystem; }
+    inline uint64_t getFrameIndex() const { return _frameIndex; }
+
+private:
+
+    static void resumeJob(void* data);
+    void resume(std::coroutine_handle<> handle);
+    void pollFences();
+    void pollReads();
+
+    ksJobSystem _jobSystem;
+    uint64_t _frameIndex;
+
+    std::mutex _mutex;
+    std::vector<std::coroutine_handle<> > _nextFrameWaiters;
+    std::vector<GLFenceAwaiter*> _fenceWaiters;
+    std::vector<FileReadAwaiter*> _readWaiters;
+    uint64_t _readBudget;
+
+    // Scratch lists so beginFrame does not allocate
+    std::vector<std::coroutine_handle<> > _resumeList;
+
+};
@@ -1,4 +1,6 @@
 #include "xrapp.h"
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
 
@@ -20,6 +22,23 @@
     } \
 }
 
+// Enumeration results of the last runtime used, in the local application data directory
+static const char* CAPABILITY_CACHE_FILE = "XRApp_capabilities.bin";
+
+// Actions and bindings, next to the executable
+static const char* ACTION_MANIFEST_FILE = "actions.manifest";
+
+// Rate at which the input thread syncs actions
+static const float INPUT_RATE_HZ = 500.0f;
+
+// Sleep of the main loop while the session does not render, doubling from the first to the
+// second while no event arrives. The second bounds how late a state change is seen
+static const ksNanoseconds IDLE_MIN_SLEEP = 1000 * 1000;
+static const ksNanoseconds IDLE_MAX_SLEEP = 10 * 1000 * 1000;
+
+// Calls per path when measuring the loader overhead, in builds with XR_DISPATCH_PROBES
+static const uint32_t CALL_OVERHEAD_ITERATIONS = 10000;
+
 std::string XRApp::resultString(XrResult res)
 {
     char err_msg[XR_MAX_RESULT_STRING_SIZE];
@@ -32,43 +51,223 @@ std::string XRApp::resultString(XrResult res)
  */
 XRApp::XRApp() :
     _done(false),
+    _capabilitiesCached(false),
     _appName("XRApp"),
-    _viewConfType(XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO)
+    _tasks(nullptr),
+    _pacingProcessor(-1),
+    _sstate(XR_SESSION_STATE_UNKNOWN),
+    _viewConfType(XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO),
+    _paths(nullptr),
+    _inputFrame(),
+    _haptics(nullptr),
+    _events(nullptr),
+    _refresh(nullptr),
+    _perf(nullptr),
+    _getVisibilityMask(nullptr),
+    _visibilityMaskDirty(0),
+    _spaces(nullptr),
+    _idle(IDLE_MIN_SLEEP, IDLE_MAX_SLEEP),
+    _startTime(0),
+    _firstFrameDone(false),
+    _frameCount(0),
+    _noRenderFrames(0),
+    _readyTime(0)
+{
+    // The frame thread gets the fastest core to itself, the input thread, which paces the action
+    // syncs, the next one. Job workers are kept off both cores
+    ksCpuTopology topology;
+    ksCpuTopology_Create(&topology);
+    ksCpuThreadPlacement placement;
+    ksCpuThreadPlacement_Create(&placement, &topology);
+    ksCpuTopology_Destroy(&topology);
+    ksThread_SetProcessorAffinity(placement.frameProcessor);
+    _pacingProcessor = placement.pacingProcessor;
+    ksCpuThreadPlacement_Destroy(&placement);
+
+    ksThreadPolicyManager_Create(&_threadPolicies);
+    ksThreadPolicyManager_Register(&_threadPolicies, KS_THREAD_ROLE_FRAME, "frame");
+    ksFrameWatchdog_Create(&_frameWatchdog, &_threadPolicies);
+    // Job workers register with the manager, so it must exist first
+    _tasks = new TaskScheduler(&_threadPolicies);
+
+    // Independent steps run concurrently on the job system. The GL window and context belong to
+    // this thread, so the steps that need them run here: context creation overlaps instance
+    // creation and enumeration, and the session waits for both.
+    typedef StartupScheduler S;
+    StartupScheduler startup(_tasks->getJobSystem());
+    const S::Step capabilities = startup.add("capabilities", S::ANY_THREAD, [this] { loadCapabilities(); });
+    const S::Step extensions = startup.add("extensions", S::ANY_THREAD, [this] { showPropertiesAndExtensions(); }, { capabilities });
+    const S::Step manifest = startup.add("action_manifest", S::ANY_THREAD, [this] { loadActionManifest(); });
+    const S::Step context = startup.add("gl_context", S::MAIN_THREAD, [this] { createGraphicsContext(); });
+    // The cache is checked against the runtime as soon as it is known, before any step uses it
+    const S::Step instance = startup.add("instance", S::ANY_THREAD, [this] {
+        try {
+            createInstance();
+        }
+        catch (XrResult res) {
+            if (!_capabilitiesCached || res != XR_ERROR_EXTENSION_NOT_PRESENT) {
+                throw;
+            }
+            invalidateCapabilities("cached extension not present");
+            showPropertiesAndExtensions();
+            createInstance();
+        }
+        if (_capabilitiesCached && !_capabilities.matches(_instanceProps.runtimeName, _instanceProps.runtimeVersion)) {
+            // Another runtime may offer other extensions, so the instance is created again with the actual ones
+            invalidateCapabilities("runtime changed");
+            CHK_XR(xrDestroyInstance(_instance));
+            showPropertiesAndExtensions();
+            createInstance();
+        }
+        _xr.load(_instance);
+        _paths = new PathCache(_instance);
+    }, { extensions });
+    const S::Step system = startup.add("system", S::ANY_THREAD, [this] {
+        createSystem();
+        if (_capabilitiesCached && _capabilities.systemId != _systemID) {
+            invalidateCapabilities("system changed");
+        }
+    }, { instance });
+    startup.add("blend_modes", S::ANY_THREAD, [this] { enumEnvironmentBlendModes(); }, { system });
+    const S::Step view_configs = startup.add("view_configs", S::ANY_THREAD, [this] {
+        enumViewConfigurations();
+        enumViewConfigProps();
+        enumViewConfigViews();
+    }, { system });
+    // ActionSets, Actions, InteractionProfileBindings ...
+    const S::Step interaction = startup.add("interaction", S::ANY_THREAD, [this] { configureInteraction(); }, { instance, manifest });
+    const S::Step session = startup.add("session", S::MAIN_THREAD, [this] { createSession(); }, { context, view_configs });
+    const S::Step reference_spaces = startup.add("reference_spaces", S::ANY_THREAD, [this] {
+        enumerateReferenceSpaces();
+        createReferenceSpace(XR_REFERENCE_SPACE_TYPE_VIEW, &_viewSpace, &_viewSpaceBounds);
+        createReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL, &_localSpace, &_localSpaceBounds);
+        createReferenceSpace(XR_REFERENCE_SPACE_TYPE_STAGE, &_stageSpace, &_stageSpaceBounds);
+    }, { session });
+    // Action spaces can be created before the action set is attached, bindings must be suggested before
+    const S::Step action_spaces = startup.add("action_spaces", S::ANY_THREAD, [this] { createActionSpace(); }, { session, interaction });
+    const S::Step attach = startup.add("attach_actions", S::ANY_THREAD, [this] { attachActionSets(); }, { session, interaction });
+    startup.add("input", S::ANY_THREAD, [this] {
+        createSpaceTracker();
+#if defined(XR_DISPATCH_PROBES)
+        measureCallOverhead();
+#endif
+        startInputThread();
+        _haptics = new HapticsScheduler(_xr, _instance, _session, *_actions);
+    }, { reference_spaces, action_spaces, attach });
+    // Swapchains are created with the GL context current
+    startup.add("refresh_rate", S::ANY_THREAD, [this] { _refresh = new RefreshRateController(_instance, _session); }, { session });
+    startup.add("performance", S::ANY_THREAD, [this] { _perf = new PerformanceGovernor(_instance, _session, INPUT_RATE_HZ); }, { session });
+    const S::Step swapchain_formats = startup.add("swapchain_formats", S::ANY_THREAD, [this] { enumerateSwapChainFormats(); }, { session });
+    startup.add("swapchains", S::MAIN_THREAD, [this] { createSwapchains(); }, { swapchain_formats });
+
+    startup.run();
+    if (!_capabilitiesCached) {
+        saveCapabilities();
+    }
+    if (_swapChains.size() < _viewConfigViews.size()) {
+        // A cached swapchain format was rejected. Enumerating again has to wait until no step runs
+        invalidateCapabilities("cached swapchain format unsupported");
+        refreshCapabilities();
+        createSwapchains();
+    }
+    startup.report();
+    _startTime = startup.getStartTime();
+    subscribeEvents();
+}
+
+/**
+ *  Destructor
+ */
+XRApp::~XRApp()
+{
+    _xr.reportProbes();
+    std::cout << _noRenderFrames << " of " << _frameCount << " frames not rendered" << std::endl;
+    delete _events;
+    delete _refresh;
+    delete _perf;
+    delete _haptics;
+    delete _input;
+    delete _spaces;
+    delete _actions;
+    delete _paths;
+    delete _tasks;
+    ksFrameWatchdog_Destroy(&_frameWatchdog);
+    ksThreadPolicyManager_Destroy(&_threadPolicies);
+}
+
+
+/**
+ *  The enumeration results of the previous launch, used if they match the runtime and system
+ */
+void XRApp::loadCapabilities()
+{
+    const ksNanoseconds start = GetTimeNanoseconds();
+    _capabilitiesCached = _capabilities.load(capabilityCacheFile());
+    if (_capabilitiesCached) {
+        std::cout << "Runtime capabilities of " << _capabilities.runtimeName << " loaded from cache in "
+            << (GetTimeNanoseconds() - start) / 1000 << " us" << std::endl;
+    }
+}
+
+/**
+ */
+void XRApp::saveCapabilities()
+{
+    _capabilities.runtimeName = _instanceProps.runtimeName;
+    _capabilities.runtimeVersion = _instanceProps.runtimeVersion;
+    _capabilities.systemId = _systemID;
+    if (!_capabilities.save(capabilityCacheFile())) {
+        std::cerr << "WARN: cannot write " << capabilityCacheFile() << std::endl;
+    }
+}
+
+/**
+ *  From now on every enumeration asks the runtime again
+ */
+void XRApp::invalidateCapabilities(const char* reason)
+{
+    std::cout << "Runtime capability cache out of date (" << reason << "), enumerating" << std::endl;
+    _capabilitiesCached = false;
+    remove(capabilityCacheFile().c_str());
+}
+
+/**
+ *  Enumerates everything again once the runtime rejected a cached value, and rewrites the cache
+ */
+void XRApp::refreshCapabilities()
 {
     showPropertiesAndExtensions();
-    createInstance();
-    createSystem();
     enumEnvironmentBlendModes();
     enumViewConfigurations();
     enumViewConfigProps();
     enumViewConfigViews();
-    configureInteraction(); // ActionSets, Actions, InteractionProfileBindings ...
-    createSession();
     enumerateReferenceSpaces();
-    createReferenceSpace(XR_REFERENCE_SPACE_TYPE_VIEW, &_viewSpace, &_viewSpaceBounds);
-    createReferenceSpace(XR_REFERENCE_SPACE_TYPE_LOCAL, &_localSpace, &_localSpaceBounds);
-    createReferenceSpace(XR_REFERENCE_SPACE_TYPE_STAGE, &_stageSpace, &_stageSpaceBounds);
-
-    createActionSpace();
-    attachActionSets();
-
     enumerateSwapChainFormats();
-    createSwapchains();
+    saveCapabilities();
 }
 
 /**
- *  Destructor
  */
-XRApp::~XRApp()
+std::string XRApp::capabilityCacheFile()
 {
+    const char* directory = getenv("LOCALAPPDATA");
+    if (directory == nullptr) {
+        return executableDirectory() + CAPABILITY_CACHE_FILE;
+    }
+    return std::string(directory) + "\\" + CAPABILITY_CACHE_FILE;
 }
 
-
 /**
  *
  */
 void XRApp::showPropertiesAndExtensions()
 {
+    if (_capabilitiesCached) {
+        _instanceExtensionProperties = _capabilities.extensions;
+        std::cout << _instanceExtensionProperties.size() << " instance extensions (cached)" << std::endl;
+        return;
+    }
+
     XrResult res;
 
     uint32_t api_layer_props_count = 0;
@@ -90,6 +289,7 @@ void XRApp::showPropertiesAndExtensions()
     else {
         std::cerr << "ERROR calling xrEnumerateInstanceExtensionProperties : " << res << std::endl;
     }
+    _capabilities.extensions = _instanceExtensionProperties;
 }
 
 /**
@@ -99,6 +299,30 @@ XrResult XRApp::createInstance()
 {
     std::vector<const char*> extensions;
     extensions.push_back(XR_KHR_OPENGL_ENABLE_EXTENSION_NAME);  // "XR_KHR_opengl_enable"
+    // Lets the input thread get the runtime time between frames
+    for (const XrExtensionProperties& extension : _instanceExtensionProperties) {
+        if (strcmp(extension.extensionName, XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_KHR_WIN32_CONVERT_PERFORMANCE_COUNTER_TIME_EXTENSION_NAME);
+        }
+        // Lets the display rate follow the frame times
+        if (strcmp(extension.extensionName, XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_FB_DISPLAY_REFRESH_RATE_EXTENSION_NAME);
+        }
+        // Lets the renderer skip the pixels hidden by the lenses
+        if (strcmp(extension.extensionName, XR_KHR_VISIBILITY_MASK_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_KHR_VISIBILITY_MASK_EXTENSION_NAME);
+        }
+        // Scales the workload down when the device runs hot or the compositor falls behind
+        if (strcmp(extension.extensionName, XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_EXT_PERFORMANCE_SETTINGS_EXTENSION_NAME);
+        }
+#if defined(XR_KHR_locate_spaces)
+        // Locates all tracked spaces in one call per frame
+        if (strcmp(extension.extensionName, XR_KHR_LOCATE_SPACES_EXTENSION_NAME) == 0) {
+            extensions.push_back(XR_KHR_LOCATE_SPACES_EXTENSION_NAME);
+        }
+#endif
+    }
     
     XrInstanceCreateInfo create_info;
     memset(&create_info, 0, sizeof(create_info));
@@ -157,6 +381,12 @@ void XRApp::createSystem()
  */
 void XRApp::enumEnvironmentBlendModes()
 {
+    if (_capabilitiesCached) {
+        _envBlendModes = _capabilities.blendModes;
+        _envBlendMode = _envBlendModes[0];
+        return;
+    }
+
     uint32_t cap_input = 0;
     uint32_t count_output = 0;
     CHK_XR( xrEnumerateEnvironmentBlendModes(_instance, _systemID, _viewConfType, cap_input, &count_output, nullptr) );
@@ -182,6 +412,7 @@ void XRApp::enumEnvironmentBlendModes()
 
     // Set the first supported one (probably the only supported one) as the selected blend mode
     _envBlendMode = _envBlendModes[0];
+    _capabilities.blendModes = _envBlendModes;
 }
 
 /**
@@ -189,6 +420,11 @@ void XRApp::enumEnvironmentBlendModes()
  */
 void XRApp::enumViewConfigurations()
 {
+    if (_capabilitiesCached) {
+        _viewConfigs = _capabilities.viewConfigs;
+        return;
+    }
+
     uint32_t cap_input = 0;
     uint32_t count_output = 0;
     CHK_XR( xrEnumerateViewConfigurations(_instance, _systemID, cap_input, &count_output, NULL) );
@@ -214,6 +450,7 @@ void XRApp::enumViewConfigurations()
         }
         std::cout << std::endl;
     }
+    _capabilities.viewConfigs = _viewConfigs;
 }
 
 /**
@@ -221,9 +458,14 @@ void XRApp::enumViewConfigurations()
  */
 void XRApp::enumViewConfigProps()
 {
+    if (_capabilitiesCached && _capabilities.viewConfigProps.viewConfigurationType == _viewConfType) {
+        _viewConfProps = _capabilities.viewConfigProps;
+        return;
+    }
     _viewConfProps = {XR_TYPE_VIEW_CONFIGURATION_PROPERTIES};
     CHK_XR( xrGetViewConfigurationProperties(_instance, _systemID, _viewConfType, &_viewConfProps) );
     std::cout << "FOV mutable: " << _viewConfProps.fovMutable << std::endl;
+    _capabilities.viewConfigProps = _viewConfProps;
 }
 
 /**
@@ -231,6 +473,11 @@ void XRApp::enumViewConfigProps()
  */
 void XRApp::enumViewConfigViews()
 {
+    if (_capabilitiesCached && _capabilities.viewConfigProps.viewConfigurationType == _viewConfType) {
+        _viewConfigViews = _capabilities.viewConfigViews;
+        return;
+    }
+
     uint32_t cap_input = 0;
     uint32_t count_output = 0;
     CHK_XR(xrEnumerateViewConfigurationViews(_instance, _systemID, _viewConfType, cap_input, &count_output, NULL));
@@ -249,6 +496,7 @@ void XRApp::enumViewConfigViews()
         std::cout << "  Max swapchain sample count " << view_conf_view.maxSwapchainSampleCount << std::endl;
         std::cout << "  next: " << view_conf_view.next << std::endl;
     }
+    _capabilities.viewConfigViews = _viewConfigViews;
 }
 
 /**
@@ -258,7 +506,6 @@ void XRApp::createSession()
 {
     _gfxBinding = { XR_TYPE_GRAPHICS_BINDING_OPENGL_WIN32_KHR };
     _gfxBinding.next = nullptr;
-    _gfxStuff = new GLSystem();
     // to-do: get wxh in systemProps and viewConfigViews
     // Let's suppose that all views (both eyes) have the same dimensions
 #if 0
@@ -281,64 +528,55 @@ void XRApp::createSession()
 /**
  *
  */
-void XRApp::configureInteraction()
+void XRApp::createGraphicsContext()
 {
-    _mainActionSetInfo.type = XR_TYPE_ACTION_SET_CREATE_INFO;
-    strcpy(_mainActionSetInfo.actionSetName, "gameplay");
-    strcpy(_mainActionSetInfo.localizedActionSetName, "Gameplay");
-    _mainActionSetInfo.priority = 0;
-    CHK_XR(xrCreateActionSet(_instance, &_mainActionSetInfo, &_mainActionSet));
+    _gfxStuff = new GLSystem();
+    _gfxStuff->createContext();
+}
 
-    // ...some example actions (TO-DO: fixme!)
+/**
+ *  Reading the manifest needs no instance, so it can happen while the instance is created
+ */
+void XRApp::loadActionManifest()
+{
+    _manifest = ActionManifest::load(executableDirectory() + ACTION_MANIFEST_FILE);
+}
 
-    // create a "teleport" input action
-    XrActionCreateInfo actioninfo{ XR_TYPE_ACTION_CREATE_INFO };
-    strcpy(actioninfo.actionName, "teleport");
-    actioninfo.actionType = XR_ACTION_TYPE_BOOLEAN_INPUT;
-    strcpy(actioninfo.localizedActionName, "Teleport");
-    XrAction teleportAction;
-    CHK_XR(xrCreateAction(_mainActionSet, &actioninfo, &teleportAction));
+/**
+ *
+ */
+void XRApp::configureInteraction()
+{
+    const ksNanoseconds start = GetTimeNanoseconds();
+    const ActionManifest& manifest = _manifest;
 
-    // create a "player_hit" output action
-    XrActionCreateInfo hapticsactioninfo{ XR_TYPE_ACTION_CREATE_INFO };
-    strcpy(hapticsactioninfo.actionName, "player_hit");
-    hapticsactioninfo.actionType = XR_ACTION_TYPE_VIBRATION_OUTPUT;
-    strcpy(hapticsactioninfo.localizedActionName, "Player hit");
-    XrAction hapticsAction;
-    CHK_XR(xrCreateAction(_mainActionSet, &hapticsactioninfo, &hapticsAction));
+    _mainActionSetInfo.type = XR_TYPE_ACTION_SET_CREATE_INFO;
+    strncpy(_mainActionSetInfo.actionSetName, manifest.actionSetName.c_str(), XR_MAX_ACTION_SET_NAME_SIZE - 1);
+    strncpy(_mainActionSetInfo.localizedActionSetName, manifest.localizedActionSetName.c_str(), XR_MAX_LOCALIZED_ACTION_SET_NAME_SIZE - 1);
+    _mainActionSetInfo.priority = manifest.priority;
+    CHK_XR(xrCreateActionSet(_instance, &_mainActionSetInfo, &_mainActionSet));
 
-    XrPath triggerClickPath, hapticPath;
-    CHK_XR(xrStringToPath(_instance, "/user/hand/right/input/trigger/click", &triggerClickPath));   // <-- This path is UNSUPPORTED! WTF!!??
-    CHK_XR(xrStringToPath(_instance, "/user/hand/right/output/haptic", &hapticPath));
+    _actions = new ActionRegistry(_xr, _instance, _mainActionSet);
+    const uint32_t binding_count = manifest.compile(_instance, *_actions, *_paths);
 
-    XrPath interactionProfilePath;
+    _teleportAction = _actions->findBoolean("teleport");
+    _hapticsAction = _actions->findVibration("player_hit");
 
-    //    CHK_XR(xrStringToPath(_instance, "/interaction_profiles/oculus/touch_controller", &interactionProfilePath));
-    CHK_XR(xrStringToPath(_instance, "/interaction_profiles/khr/simple_controller", &interactionProfilePath));
+    std::cout << "Action manifest: " << manifest.actions.size() << " actions, " << binding_count << " bindings in "
+        << manifest.profiles.size() << " profiles, " << _paths->size() << " paths, "
+        << (GetTimeNanoseconds() - start) / 1000 << " us" << std::endl;
+}
 
-#if 0
-    XrActionSuggestedBinding bindings[2];
-    bindings[0].action = teleportAction;
-    bindings[0].binding = triggerClickPath;
-    bindings[1].action = hapticsAction;
-    bindings[1].binding = hapticPath;
-
-    XrInteractionProfileSuggestedBinding suggestedBindings{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
-    suggestedBindings.interactionProfile = interactionProfilePath;
-    suggestedBindings.suggestedBindings = bindings;
-    suggestedBindings.countSuggestedBindings = 2;
-    CHK_XR(xrSuggestInteractionProfileBindings(_instance, &suggestedBindings));
-#else
-    std::vector<XrActionSuggestedBinding> bindings;
-//    bindings.push_back({teleportAction, triggerClickPath});   // <-- This path is UNSUPPORTED! WTF!!??
-    bindings.push_back({ hapticsAction, hapticPath });
-
-    XrInteractionProfileSuggestedBinding suggestedBindings{ XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING };
-    suggestedBindings.interactionProfile = interactionProfilePath;
-    suggestedBindings.suggestedBindings = bindings.data();
-    suggestedBindings.countSuggestedBindings = bindings.size();
-    CHK_XR(xrSuggestInteractionProfileBindings(_instance, &suggestedBindings));
-#endif
+/**
+ *  Directory of the executable, with a trailing separator
+ */
+std::string XRApp::executableDirectory()
+{
+    char path[MAX_PATH];
+    const DWORD length = GetModuleFileNameA(NULL, path, MAX_PATH);
+    std::string directory(path, length);
+    const size_t separator = directory.find_last_of("\\/");
+    return (separator != std::string::npos) ? directory.substr(0, separator + 1) : std::string();
 }
 
 /**
@@ -358,6 +596,11 @@ void XRApp::attachActionSets()
  */
 void XRApp::enumerateReferenceSpaces()
 {
+    if (_capabilitiesCached) {
+        _referenceSpaces = _capabilities.referenceSpaces;
+        return;
+    }
+
     uint32_t cap_input = 0;
     uint32_t count_output = 0;
     CHK_XR(xrEnumerateReferenceSpaces(_session, cap_input, &count_output, nullptr));
@@ -382,6 +625,7 @@ void XRApp::enumerateReferenceSpaces()
             break;
         }
     }
+    _capabilities.referenceSpaces = _referenceSpaces;
 }
 
 /**
@@ -400,28 +644,47 @@ void XRApp::createReferenceSpace(XrReferenceSpaceType ref_space_type, XrSpace *s
 
 void XRApp::createActionSpace()
 {
-    XrActionCreateInfo actioninfo{ XR_TYPE_ACTION_CREATE_INFO };
-    strcpy(actioninfo.actionName, "right_aim");
-    actioninfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
-    strcpy(actioninfo.localizedActionName, "Right Aim");
-    XrAction poseAction;
-    CHK_XR(xrCreateAction(_mainActionSet, &actioninfo, &poseAction));
-
-    XrPath rightHandAimInteractionProfilePath;
-    CHK_XR(xrStringToPath(_instance, "/user/hand/right/input/aim", &rightHandAimInteractionProfilePath));
+    _actions->createPoseSpaces(_session);
+}
 
-    XrSpace action_space;
-    XrActionSpaceCreateInfo create_info{ XR_TYPE_ACTION_SPACE_CREATE_INFO };
-    create_info.next = nullptr;
-    create_info.action = poseAction;
-    create_info.poseInActionSpace.orientation.w = 1.;
-    CHK_XR(xrCreateActionSpace(_session, &create_info, &action_space));
+/**
+ *  Head and every pose action are located in stage space once per frame
+ */
+void XRApp::createSpaceTracker()
+{
+    _spaces = new SpaceTracker(_xr, _instance, _session, _stageSpace);
+    _spaces->add(_viewSpace, "head");
+    for (uint32_t i = 0; i < _actions->poseCount(); i++) {
+        _spaces->add(_actions->getSpace(PoseAction{ i }), _actions->poseName(PoseAction{ i }));
+    }
+}
 
+/**
+ *  Actions are synced by the input thread, independent of the frame rate
+ */
+void XRApp::startInputThread()
+{
+    _input = new InputThread(_xr, _instance, _session, _mainActionSet, *_actions, _stageSpace);
+    _input->start(INPUT_RATE_HZ, &_threadPolicies, _pacingProcessor);
+}
 
+/**
+ *  Cost of the loader trampolines, measured on an action state query before the input thread runs
+ */
+void XRApp::measureCallOverhead()
+{
+    XrActionStateGetInfo get_info{ XR_TYPE_ACTION_STATE_GET_INFO };
+    get_info.action = _actions->getAction(_teleportAction);
+    _xr.measureCallOverhead(_session, get_info, CALL_OVERHEAD_ITERATIONS);
 }
 
 void XRApp::enumerateSwapChainFormats()
 {
+    if (_capabilitiesCached) {
+        _swapchainFormats = _capabilities.swapchainFormats;
+        return;
+    }
+
     uint32_t cap_input = 0;
     uint32_t count_output = 0;
     CHK_XR(xrEnumerateSwapchainFormats(_session, cap_input, &count_output, nullptr));
@@ -432,6 +695,7 @@ void XRApp::enumerateSwapChainFormats()
     for (const int64_t& swapchain_format : _swapchainFormats) {
         std::cout << "Swapchain format: 0x" << std::hex << swapchain_format << std::dec << " " << _gfxStuff->textureInternalFormatToString(swapchain_format) << std::endl;
     }
+    _capabilities.swapchainFormats = _swapchainFormats;
 }
 
 /**
@@ -439,7 +703,9 @@ void XRApp::enumerateSwapChainFormats()
  */
 void XRApp::createSwapchains()
 {
-    for ( const XrViewConfigurationView &view : _viewConfigViews) {
+    // Continues after the swapchains already created when called again for a stale capability cache
+    for (size_t i = _swapChains.size(); i < _viewConfigViews.size(); i++) {
+        const XrViewConfigurationView& view = _viewConfigViews[i];
 
         XrSwapchainCreateInfo create_info{ XR_TYPE_SWAPCHAIN_CREATE_INFO };
         /*
@@ -468,7 +734,12 @@ void XRApp::createSwapchains()
         create_info.arraySize = 1;
         create_info.mipCount = 1;
         XrSwapchain swapchain;
-        CHK_XR(xrCreateSwapchain(_session, &create_info, &swapchain));
+        const XrResult create_res = xrCreateSwapchain(_session, &create_info, &swapchain);
+        if (create_res == XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED && _capabilitiesCached) {
+            // Left to the constructor: other startup steps may still read the enumerations
+            return;
+        }
+        CHK_XR(create_res);
         std::cout << "Created swapchain: " << create_info.width << "x" << create_info.height << std::endl;
         _swapChains.push_back(swapchain);
         enumerateSwapchainImages(swapchain);
@@ -499,93 +770,17 @@ void XRApp::mainLoop()
 {
     while (!_done) {
 
-        // 1. Event processing
+        // 1. Event processing, every pending event before the frame
 
-        XrEventDataBuffer event{ XR_TYPE_EVENT_DATA_BUFFER };
-        XrResult res = xrPollEvent(_instance, &event);
+        const XrResult res = _events->drain();
         if (XR_FAILED(res)) {
             std::cerr << "Error polling event : " << resultString(res) << std::endl;
             _done = true;
             break;
         }
-        else {
-            switch (res) {
-            case XR_SUCCESS:
-                std::cout << "Event type " << event.type << std::endl;
-                switch (event.type) {
-                case XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB:
-                {
-                    XrEventDataDisplayRefreshRateChangedFB* ev = (XrEventDataDisplayRefreshRateChangedFB*)&event;
-                    break;
-                }
-                break;
-                case XR_TYPE_EVENT_DATA_EVENTS_LOST:
-                {
-                    XrEventDataEventsLost* ev = (XrEventDataEventsLost*)&event;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING:
-                {
-                    XrEventDataInstanceLossPending* ev = (XrEventDataInstanceLossPending*)&event;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED:
-                {
-                    XrEventDataInteractionProfileChanged* ev = (XrEventDataInteractionProfileChanged*) &event;
-                    std::cout << "INTERACTION_PROFILE_CHANGED" << std::endl;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_MAIN_SESSION_VISIBILITY_CHANGED_EXTX:
-                {
-                    XrEventDataMainSessionVisibilityChangedEXTX* ev = (XrEventDataMainSessionVisibilityChangedEXTX*)&event;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT:
-                {
-                    XrEventDataPerfSettingsEXT* ev = (XrEventDataPerfSettingsEXT*)&event;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_REFERENCE_SPACE_CHANGE_PENDING:
-                {
-                    XrEventDataReferenceSpaceChangePending* ev = (XrEventDataReferenceSpaceChangePending*)&event;
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED:
-                {
-                    XrEventDataSessionStateChanged* ev = (XrEventDataSessionStateChanged*)&event;
-                    _sstate = ev->state;
-                    std::cout << "Session state " << ev->state << std::endl;
-                    switch (ev->state) {
-                    case XR_SESSION_STATE_IDLE:
-                        std::cout << "IDLE. Waiting to be ready..." << std::endl;
-                        break;
-                    case XR_SESSION_STATE_READY:
-                        std::cout << "READY. Starting session..." << std::endl;
-                        beginSession();
-                        break;
-                    case XR_SESSION_STATE_SYNCHRONIZED:
-                        std::cout << "SYNCHRONIZED" << std::endl;
-                        break;
-                    case XR_SESSION_STATE_VISIBLE:
-                        std::cout << "VISIBLE" << std::endl;
-                        break;
-                    case XR_SESSION_STATE_FOCUSED:
-                        std::cout << "FOCUSED" << std::endl;
-                        break;
-                    }
-                    break;
-                }
-                case XR_TYPE_EVENT_DATA_VISIBILITY_MASK_CHANGED_KHR:
-                {
-                    XrEventDataVisibilityMaskChangedKHR* ev = (XrEventDataVisibilityMaskChangedKHR*)&event;
-                    break;
-                }
-                }
-                break;
-            case XR_EVENT_UNAVAILABLE:
-                // No event yet
-                break;
-            }
+        if (_events->dispatch() > 0) {
+            // Events tend to come in bursts, like the state changes up to FOCUSED
+            _idle.reset();
         }
 
         // 2. Frame processing
@@ -594,10 +789,126 @@ void XRApp::mainLoop()
         case XR_SESSION_STATE_SYNCHRONIZED:
         case XR_SESSION_STATE_VISIBLE:
         case XR_SESSION_STATE_FOCUSED:
+            _idle.end();
             frame();
             break;
+        default:
+            // Nothing to render until the state changes, which only an event tells
+            _idle.wait();
+            break;
         }
     }
+    _idle.end();
+}
+
+/**
+ *  Events are routed by type. The ones no subsystem subscribed to are only logged
+ */
+void XRApp::subscribeEvents()
+{
+    _events = new EventDispatcher(_xr, _instance);
+    _events->subscribe(XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED, [this](const XrEventDataBuffer& event) {
+        onSessionStateChanged(reinterpret_cast<const XrEventDataSessionStateChanged&>(event));
+    });
+    _events->subscribe(XR_TYPE_EVENT_DATA_EVENTS_LOST, [](const XrEventDataBuffer& event) {
+        const XrEventDataEventsLost& lost = reinterpret_cast<const XrEventDataEventsLost&>(event);
+        std::cerr << "WARN: the runtime event queue overflowed, " << lost.lostEventCount << " events lost" << std::endl;
+    });
+    _events->subscribe(XR_TYPE_EVENT_DATA_INSTANCE_LOSS_PENDING, [](const XrEventDataBuffer&) {
+        std::cout << "INSTANCE_LOSS_PENDING" << std::endl;
+    });
+    // The input thread takes interaction profile changes itself, bindings may differ afterwards
+    _events->forward(XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED, _input->eventQueue());
+    _events->subscribe(XR_TYPE_EVENT_DATA_INTERACTION_PROFILE_CHANGED, [](const XrEventDataBuffer&) {
+        std::cout << "INTERACTION_PROFILE_CHANGED" << std::endl;
+    });
+    if (_refresh->isSupported()) {
+        _events->subscribe(XR_TYPE_EVENT_DATA_DISPLAY_REFRESH_RATE_CHANGED_FB, [this](const XrEventDataBuffer& event) {
+            _refresh->onRateChanged(reinterpret_cast<const XrEventDataDisplayRefreshRateChangedFB&>(event));
+        });
+        _refresh->addListener([](float rate) {
+            std::cout << "Display refresh rate " << rate << " Hz, frame budget " << (int)(1e6f / rate) << " us" << std::endl;
+        });
+    }
+    // Only available if the extension was enabled on the instance. Meshes are fetched by the frame thread
+    if (XR_SUCCEEDED(xrGetInstanceProcAddr(_instance, "xrGetVisibilityMaskKHR",
+            reinterpret_cast<PFN_xrVoidFunction*>(&_getVisibilityMask)))) {
+        _visibilityMaskDirty = (1u << _viewConfigViews.size()) - 1;
+        _events->subscribe(XR_TYPE_EVENT_DATA_VISIBILITY_MASK_CHANGED_KHR, [this](const XrEventDataBuffer& event) {
+            const XrEventDataVisibilityMaskChangedKHR& changed = reinterpret_cast<const XrEventDataVisibilityMaskChangedKHR&>(event);
+            if (changed.viewConfigurationType == _viewConfType) {
+                _visibilityMaskDirty |= 1u << changed.viewIndex;
+            }
+        });
+    }
+    else {
+        _getVisibilityMask = nullptr;
+    }
+    if (_perf->isSupported()) {
+        _events->subscribe(XR_TYPE_EVENT_DATA_PERF_SETTINGS_EXT, [this](const XrEventDataBuffer& event) {
+            _perf->onPerfSettings(reinterpret_cast<const XrEventDataPerfSettingsEXT&>(event));
+        });
+        _perf->addListener([this](const WorkloadLevel& level) {
+            std::cout << "Frame " << _tasks->getFrameIndex() << " workload " << level.name << ": render scale "
+                << level.renderScale << ", input " << level.inputRateHz << " Hz, reads "
+                << level.readBytesPerFrame / 1024 << " KiB per frame" << std::endl;
+            _gfxStuff->setRenderScale(level.renderScale);
+            _input->setRate(level.inputRateHz);
+            _tasks->setReadBudget(level.readBytesPerFrame);
+        });
+    }
+}
+
+/**
+ *  Hidden triangles of every view marked dirty, on startup and when the runtime changed them
+ */
+void XRApp::updateHiddenAreaMeshes()
+{
+    for (uint32_t i = 0; i < (uint32_t)_viewConfigViews.size(); i++) {
+        if (((_visibilityMaskDirty >> i) & 1) == 0) {
+            continue;
+        }
+        XrVisibilityMaskKHR mask{ XR_TYPE_VISIBILITY_MASK_KHR };
+        CHK_XR(_getVisibilityMask(_session, _viewConfType, i, XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &mask));
+        std::vector<XrVector2f> vertices(mask.vertexCountOutput);
+        std::vector<uint32_t> indices(mask.indexCountOutput);
+        mask.vertexCapacityInput = (uint32_t)vertices.size();
+        mask.vertices = vertices.data();
+        mask.indexCapacityInput = (uint32_t)indices.size();
+        mask.indices = indices.data();
+        CHK_XR(_getVisibilityMask(_session, _viewConfType, i, XR_VISIBILITY_MASK_TYPE_HIDDEN_TRIANGLE_MESH_KHR, &mask));
+        vertices.resize(mask.vertexCountOutput);
+        indices.resize(mask.indexCountOutput);
+        _gfxStuff->setHiddenAreaMesh(i, vertices, indices);
+    }
+    _visibilityMaskDirty = 0;
+}
+
+void XRApp::onSessionStateChanged(const XrEventDataSessionStateChanged& event)
+{
+    _sstate = event.state;
+    _input->setFocused(_sstate == XR_SESSION_STATE_FOCUSED);
+    _perf->setRendering(_sstate == XR_SESSION_STATE_VISIBLE || _sstate == XR_SESSION_STATE_FOCUSED);
+    std::cout << "Session state " << event.state << std::endl;
+    switch (event.state) {
+    case XR_SESSION_STATE_IDLE:
+        std::cout << "IDLE. Waiting to be ready..." << std::endl;
+        break;
+    case XR_SESSION_STATE_READY:
+        std::cout << "READY. Starting session..." << std::endl;
+        _readyTime = GetTimeNanoseconds();
+        beginSession();
+        break;
+    case XR_SESSION_STATE_SYNCHRONIZED:
+        std::cout << "SYNCHRONIZED" << std::endl;
+        break;
+    case XR_SESSION_STATE_VISIBLE:
+        std::cout << "VISIBLE" << std::endl;
+        break;
+    case XR_SESSION_STATE_FOCUSED:
+        std::cout << "FOCUSED" << std::endl;
+        break;
+    }
 }
 
 
@@ -612,7 +923,14 @@ void XRApp::frame()
 {
     XrFrameState frame_state{XR_TYPE_FRAME_STATE};
     XrFrameWaitInfo frame_wait_info{ XR_TYPE_FRAME_WAIT_INFO };
-    CHK_XR(xrWaitFrame(_session, &frame_wait_info, &frame_state));
+    CHK_XR(_xr.WaitFrame(_session, &frame_wait_info, &frame_state));
+    const ksNanoseconds cpu_start = GetTimeNanoseconds();
+    ksNanoseconds runtime_wait = 0;     // of the frame time, spent blocked in the runtime
+    ksFrameWatchdog_BeginFrame(&_frameWatchdog, frame_state.predictedDisplayPeriod);
+    _input->setFrameTime(frame_state.predictedDisplayTime);
+    _spaces->locate(frame_state.predictedDisplayTime);
+    _tasks->beginFrame();
+    _perf->update();
 #if 0
     std::cout << "Frame state - pred. disp. period: " << frame_state.predictedDisplayPeriod
         << " pred. disp. time: " << frame_state.predictedDisplayTime
@@ -621,7 +939,9 @@ void XRApp::frame()
 #endif
 
     XrFrameBeginInfo frame_begin_info{XR_TYPE_FRAME_BEGIN_INFO};
-    CHK_XR(xrBeginFrame(_session, &frame_begin_info));
+    const ksNanoseconds begin_start = GetTimeNanoseconds();
+    CHK_XR(_xr.BeginFrame(_session, &frame_begin_info));
+    runtime_wait += GetTimeNanoseconds() - begin_start;
 #if 0
     std::cout << ((_sstate == XR_SESSION_STATE_VISIBLE) ? "VISIBLE " : "")
         << ((_sstate == XR_SESSION_STATE_FOCUSED) ? "FOCUSED " : "") 
@@ -633,14 +953,24 @@ void XRApp::frame()
     if (_sstate == XR_SESSION_STATE_FOCUSED) {
         processActions();
     }
+    _haptics->update(_sstate == XR_SESSION_STATE_FOCUSED);
+    const HapticsScheduler::FrameStats& haptic_stats = _haptics->frameStats();
+    if (haptic_stats.applyCalls + haptic_stats.stopCalls + haptic_stats.dropped > 0) {
+        std::cout << "Haptics: " << haptic_stats.events << " events, " << haptic_stats.applyCalls << " apply, "
+            << haptic_stats.stopCalls << " stop, " << haptic_stats.dropped << " dropped" << std::endl;
+    }
 
     std::vector<XrCompositionLayerBaseHeader*> layers;
     std::vector<XrCompositionLayerProjectionView> projViews;
     XrCompositionLayerProjection layerProj{ XR_TYPE_COMPOSITION_LAYER_PROJECTION };
 
-    if ( _sstate == XR_SESSION_STATE_VISIBLE || _sstate == XR_SESSION_STATE_FOCUSED ) {
-//    if ( frame_state.shouldRender ) {
-
+    _frameCount++;
+    if (!frame_state.shouldRender) {
+        // The runtime does not show the frame, begin and end without layers is all it needs. The
+        // simulation above still ran for this display time
+        _noRenderFrames++;
+    }
+    else {
         // Get camera information (for both eyes) - calls xrLocateViews
         XrViewState view_state{ XR_TYPE_VIEW_STATE };
         std::vector<XrView> views = getViews( frame_state.predictedDisplayTime, view_state);
@@ -655,6 +985,11 @@ void XRApp::frame()
                 throw -1;
             }
 
+            if (_visibilityMaskDirty != 0) {
+                updateHiddenAreaMeshes();
+            }
+            _gfxStuff->beginGpuTimer();
+
             // For each swapchain AND view (one per eye)
             for (int i = 0; i < _swapChains.size(); i++) {
 
@@ -664,20 +999,22 @@ void XRApp::frame()
 
                 XrSwapchainImageAcquireInfo acquire_info{ XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO };
                 uint32_t idx;
-                CHK_XR(xrAcquireSwapchainImage(swapchain, &acquire_info, &idx));
+                const ksNanoseconds acquire_start = GetTimeNanoseconds();
+                CHK_XR(_xr.AcquireSwapchainImage(swapchain, &acquire_info, &idx));
 //                std::cout << "idx: " << idx << std::endl;
 
                 XrSwapchainImageWaitInfo wait_info{ XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO };
                 wait_info.timeout = 0;
-                CHK_XR(xrWaitSwapchainImage(swapchain, &wait_info));
+                CHK_XR(_xr.WaitSwapchainImage(swapchain, &wait_info));
+                runtime_wait += GetTimeNanoseconds() - acquire_start;
 
                 // Render to texture #idx (GL stuff)
                 uint32_t tex_gl_id = _swapchainImages[swapchain][idx].image;
 //                std::cout << "Rendering to texture ID " << tex_gl_id << std::endl;
-                _gfxStuff->renderToTexture(tex_gl_id);
+                _gfxStuff->renderToTexture(tex_gl_id, i, view.fov);
 
                 XrSwapchainImageReleaseInfo release_info{ XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO };
-                CHK_XR(xrReleaseSwapchainImage(swapchain, &release_info));
+                CHK_XR(_xr.ReleaseSwapchainImage(swapchain, &release_info));
 
                 // Assemble composition layers structure
                 XrCompositionLayerProjectionView proj_view{ XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW };
@@ -685,10 +1022,14 @@ void XRApp::frame()
                 proj_view.fov = view.fov;
                 proj_view.subImage.imageArrayIndex = 0;
                 proj_view.subImage.imageRect.offset = {0,0};
-                proj_view.subImage.imageRect.extent = { (int32_t)view_cfg.recommendedImageRectWidth, (int32_t)view_cfg.recommendedImageRectHeight };
+                const float render_scale = _perf->level().renderScale;
+                proj_view.subImage.imageRect.extent = { (int32_t)(view_cfg.recommendedImageRectWidth * render_scale),
+                    (int32_t)(view_cfg.recommendedImageRectHeight * render_scale) };
                 proj_view.subImage.swapchain = swapchain;
                 projViews.push_back(proj_view);
             }
+            _gfxStuff->endGpuTimer();
+
             layerProj.layerFlags = XR_COMPOSITION_LAYER_BLEND_TEXTURE_SOURCE_ALPHA_BIT;
             layerProj.space = _stageSpace;
             layerProj.viewCount = projViews.size();
@@ -702,8 +1043,50 @@ void XRApp::frame()
     frame_end_info.displayTime = frame_state.predictedDisplayTime;
     frame_end_info.layerCount = layers.size();
     frame_end_info.layers = layers.data();
+    if (!layers.empty()) {
+        // Only the app's own work counts: the runtime blocks in xrBeginFrame, while acquiring the
+        // images and in xrEndFrame to pace the frames. The GPU time lags by a few frames
+        _refresh->update(GetTimeNanoseconds() - cpu_start - runtime_wait, _gfxStuff->getGpuTime());
+    }
     std::cout << "### END FRAME ###" << std::endl;
-    CHK_XR(xrEndFrame(_session, &frame_end_info));
+    XrResult end_res = _xr.EndFrame(_session, &frame_end_info);
+    if (end_res == XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED && _capabilitiesCached) {
+        invalidateCapabilities("cached blend mode unsupported");
+        refreshCapabilities();
+        frame_end_info.environmentBlendMode = _envBlendMode;
+        end_res = _xr.EndFrame(_session, &frame_end_info);
+    }
+    CHK_XR(end_res);
+    _xr.endFrame();
+
+    if (!_firstFrameDone) {
+        _firstFrameDone = true;
+        std::cout << "Time to first frame: " << (GetTimeNanoseconds() - _startTime) / 1000000 << " ms" << std::endl;
+    }
+    if (_readyTime != 0) {
+        // Includes the idle wait that saw the READY event
+        std::cout << "First frame " << (GetTimeNanoseconds() - _readyTime) / 1000 << " us after READY" << std::endl;
+        _readyTime = 0;
+    }
+
+    if (ksFrameWatchdog_EndFrame(&_frameWatchdog)) {
+        const ksFrameOverrun& overrun = _frameWatchdog.lastOverrun;
+        std::cerr << "Frame " << overrun.frame << " overran: " << overrun.frameTime / 1000 << " us for a "
+            << overrun.period / 1000 << " us period";
+        if (overrun.thread >= 0) {
+            std::cerr << ", " << _threadPolicies.threads[overrun.thread].name << " thread waited "
+                << overrun.runDelay / 1000 << " us for a processor";
+        }
+        // Tells the runtime blocking the frame thread from our own code
+        if (const ksCallProfiler* profiler = _xr.profiler()) {
+            for (const char* command : { "xrBeginFrame", "xrWaitSwapchainImage", "xrEndFrame" }) {
+                ksCallStats stats;
+                ksCallProfiler_GetStats(profiler, ksCallProfiler_FindFunction(profiler, command), &stats);
+                std::cerr << ", " << command << " " << stats.lastFrameNanoseconds / 1000 << " us";
+            }
+        }
+        std::cerr << std::endl;
+    }
 }
 
 std::vector<XrView> XRApp::getViews(XrTime display_time, XrViewState &view_state)
@@ -714,11 +1097,11 @@ std::vector<XrView> XRApp::getViews(XrTime display_time, XrViewState &view_state
     view_locate_info.viewConfigurationType = _viewConfType;
     view_locate_info.displayTime = display_time;
     view_locate_info.space = _stageSpace;
-    CHK_XR(xrLocateViews(_session, &view_locate_info, &view_state, cap_input, &count_output, nullptr));
+    CHK_XR(_xr.LocateViews(_session, &view_locate_info, &view_state, cap_input, &count_output, nullptr));
     //std::cout << count_output << " view(s)" << std::endl;
     cap_input = count_output;
     std::vector<XrView> views(count_output, {XR_TYPE_VIEW});
-    CHK_XR(xrLocateViews(_session, &view_locate_info, &view_state, cap_input, &count_output, views.data()));
+    CHK_XR(_xr.LocateViews(_session, &view_locate_info, &view_state, cap_input, &count_output, views.data()));
 #if 0
     for (XrView& view : views) {
         std::cout << "View state: "
@@ -738,9 +1121,19 @@ std::vector<XrView> XRApp::getViews(XrTime display_time, XrViewState &view_state
 
 void XRApp::processActions()
 {
-    XrActionsSyncInfo sync_info{ XR_TYPE_ACTIONS_SYNC_INFO };
-    sync_info.countActiveActionSets = 1;
-    XrActiveActionSet activeActionSet{ _mainActionSet, XR_NULL_PATH };
-    sync_info.activeActionSets = &activeActionSet;
-    CHK_XR(xrSyncActions(_session, &sync_info));
+    // Freshest state synced by the input thread
+    ActionStateBlock state;
+    if (!_input->read(state)) {
+        return;
+    }
+    _inputFrame.update(state);
+
+    if (_inputFrame.profileChanged) {
+        std::cout << "Interaction profile changed, " << state.interactionProfileChanges << " changes so far" << std::endl;
+    }
+
+    if (_inputFrame.wasPressed(_teleportAction)) {
+        std::cout << "Teleport" << std::endl;
+        _haptics->vibrate(_hapticsAction, 0.5f, 100 * 1000 * 1000);
+    }
 }
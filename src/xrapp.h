@@ -11,6 +11,18 @@
 #include <openxr/openxr_platform.h>
 
 #include "glsystem.h"
+#include "tasks.h"
+#include "input.h"
+#include "manifest.h"
+#include "spaces.h"
+#include "haptics.h"
+#include "startup.h"
+#include "capabilities.h"
+#include "dispatch.h"
+#include "idle.h"
+#include "events.h"
+#include "refresh.h"
+#include "perf.h"
 
 
 class XRApp {
@@ -24,6 +36,11 @@ public:
 
 private:
 
+    void loadCapabilities();
+    void saveCapabilities();
+    void invalidateCapabilities(const char* reason);
+    void refreshCapabilities();
+    static std::string capabilityCacheFile();
     void showPropertiesAndExtensions();
 
     XrResult createInstance();
@@ -32,18 +49,27 @@ private:
     void enumViewConfigurations();
     void enumViewConfigProps();
     void enumViewConfigViews();
+    void createGraphicsContext();
+    void loadActionManifest();
     void configureInteraction();
     void createSession();
     void attachActionSets();
     void enumerateReferenceSpaces();
     void createReferenceSpace(XrReferenceSpaceType ref_space_type, XrSpace* space, XrExtent2Df* bounds);
     void createActionSpace();
+    void createSpaceTracker();
+    void startInputThread();
+    void measureCallOverhead();
     void enumerateSwapChainFormats();
     void createSwapchains();
     void enumerateSwapchainImages(XrSwapchain& swapchain);
 
     std::string resultString(XrResult res);
+    static std::string executableDirectory();
 
+    void subscribeEvents();
+    void updateHiddenAreaMeshes();
+    void onSessionStateChanged(const XrEventDataSessionStateChanged& event);
     void beginSession();
     std::vector<XrView> getViews(XrTime display_time, XrViewState &view_state);
     void frame();
@@ -51,6 +77,9 @@ private:
 
     bool _done;
 
+    RuntimeCapabilities _capabilities;
+    bool _capabilitiesCached;           // the enumerations below come from the cache file
+
     std::vector<XrExtensionProperties> _instanceExtensionProperties;
     std::vector<XrEnvironmentBlendMode> _envBlendModes;
     std::vector<XrViewConfigurationType> _viewConfigs;
@@ -60,10 +89,15 @@ private:
 
     std::string _appName;
     XrInstance _instance;
+    XrDispatch _xr;                     // frame path entry points of _instance
     XrInstanceProperties _instanceProps;
     XrSystemId _systemID;
     XrSystemProperties _systemProps;
     GLSystem *_gfxStuff;
+    TaskScheduler *_tasks;
+    int _pacingProcessor;               // of the input thread, -1 to leave it unpinned
+    ksThreadPolicyManager _threadPolicies;
+    ksFrameWatchdog _frameWatchdog;
     XrGraphicsBindingOpenGLWin32KHR _gfxBinding;
     XrSession _session;
     XrSessionState _sstate;
@@ -74,6 +108,20 @@ private:
 
     XrActionSetCreateInfo _mainActionSetInfo;
     XrActionSet _mainActionSet;
+    ActionManifest _manifest;
+    PathCache *_paths;
+    ActionRegistry *_actions;
+    BooleanAction _teleportAction;
+    VibrationAction _hapticsAction;
+
+    InputThread *_input;
+    ActionFrame _inputFrame;
+    HapticsScheduler *_haptics;
+    EventDispatcher *_events;
+    RefreshRateController *_refresh;
+    PerformanceGovernor *_perf;
+    PFN_xrGetVisibilityMaskKHR _getVisibilityMask;
+    uint32_t _visibilityMaskDirty;      // bit per view whose hidden area mesh must be fetched
 
     XrSpace _viewSpace;
     XrExtent2Df _viewSpaceBounds;
@@ -82,6 +130,16 @@ private:
     XrSpace _stageSpace;
     XrExtent2Df _stageSpaceBounds;
 
+    SpaceTracker *_spaces;
+
+    IdleBackoff _idle;                  // of the main loop while the session does not render
+
+    ksNanoseconds _startTime;           // of the startup, for the time to first frame
+    bool _firstFrameDone;
+    uint64_t _frameCount;
+    uint64_t _noRenderFrames;           // frames the runtime said not to render, ended without layers
+    ksNanoseconds _readyTime;           // of the last READY event, until its first frame
+
     std::vector<XrSwapchain> _swapChains;
     std::map<XrSwapchain, std::vector<XrSwapchainImageOpenGLKHR> > _swapchainImages;
 